@@ -0,0 +1,787 @@
+//Contour_Boolean_Operations_Snapped.cc.
+
+// These functions perform Boolean and offset operations on (2D) polygon contours using snapped integer coordinates.
+// Unlike ContourBoolean(), they do not depend on CGAL.
+
+#include <list>
+#include <functional>
+#include <limits>
+#include <map>
+#include <cmath>
+#include <any>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "YgorMisc.h"
+#include "YgorMath.h"
+
+#include "Contour_Boolean_Operations.h"
+
+
+namespace {
+
+// An orthonormal basis spanning a plane. Vectors are expressed in the basis as (x, y, 0).
+struct planar_basis {
+    plane<double> p;
+    vec3<double> U_x;
+    vec3<double> U_y;
+
+    explicit planar_basis(const plane<double> &p_in) : p(p_in) {
+        // Identify an orthonormal set that spans the 2D plane.
+        const auto U_z = this->p.N_0.unit();
+        this->U_y = vec3<double>(1.0, 0.0, 0.0); //Candidate vector.
+        if(this->U_y.Dot(U_z) > 0.25){
+            this->U_y = U_z.rotate_around_x(M_PI * 0.5);
+        }
+        this->U_x = U_z.Cross(this->U_y);
+        if(!U_z.GramSchmidt_orthogonalize(this->U_y, this->U_x)){
+            throw std::runtime_error("Unable to find planar basis vectors.");
+        }
+        this->U_x = this->U_x.unit();  // U_x and U_y now form an in-plane basis.
+        this->U_y = this->U_y.unit();
+    }
+
+    // Projects a vector from the R^3 origin onto the plane and expresses it in the plane's basis.
+    // (Our convention in this representation will be to use a vec3 but enforce z=0 everywhere.)
+    vec3<double> to_plane(const vec3<double> &R) const {
+        const auto proj = this->p.Project_Onto_Plane_Orthogonally(R);
+        const auto dR = (proj - this->p.R_0);  // in-plane vector from plane's pinning vector.
+        return vec3<double>(dR.Dot(this->U_x), dR.Dot(this->U_y), 0.0);
+    }
+
+    // Converts from the plane's basis back to R^3. Note that we cannot un-project the vertices off the plane, so we
+    // assume they were already exactly coincident with the plane.
+    vec3<double> from_plane(const vec3<double> &R) const {
+        return this->p.R_0 + (this->U_x * R.x) + (this->U_y * R.y);
+    }
+};
+
+// Boolean operations on polygons with snapped integer coordinates.
+//
+// Input rings are snapped to an integer lattice. All segment intersections are then computed exactly (as rationals)
+// in a single sweep, which makes the resulting planar arrangement exact: there are no tolerances and no failures due
+// to floating-point rounding. The winding numbers of both polygon sets are propagated across the faces of the
+// arrangement, each arrangement edge is classified by comparing the faces on either side, and boundary edges are
+// linked into rings. Holes are then joined to their enclosing ring with a seam.
+//
+// Coordinates are limited to +-2^22 lattice units so that all exact predicates fit within 128-bit integers.
+using int128 = __int128;
+
+constexpr int64_t snapped_coordinate_limit = (static_cast<int64_t>(1) << 22);
+
+struct snapped_point {
+    int64_t x = 0;
+    int64_t y = 0;
+};
+
+// An exact rational point (x/d, y/d) in lowest terms with d > 0.
+struct rational_point {
+    int128 x = 0;
+    int128 y = 0;
+    int128 d = 1;
+
+    bool operator<(const rational_point &rhs) const {
+        return std::tie(this->x, this->y, this->d) < std::tie(rhs.x, rhs.y, rhs.d);
+    }
+    bool operator==(const rational_point &rhs) const {
+        return (this->x == rhs.x) && (this->y == rhs.y) && (this->d == rhs.d);
+    }
+};
+
+int128 abs128(int128 a){
+    return (a < 0) ? -a : a;
+}
+
+int128 gcd128(int128 a, int128 b){
+    a = abs128(a);
+    b = abs128(b);
+    while(b != 0){
+        const auto t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+rational_point make_rational(int128 x, int128 y, int128 d){
+    if(d < 0){
+        x = -x;
+        y = -y;
+        d = -d;
+    }
+    const auto g = gcd128(gcd128(x, y), d);
+    if(1 < g){
+        x /= g;
+        y /= g;
+        d /= g;
+    }
+    return { x, y, d };
+}
+
+int64_t cross(const snapped_point &a, const snapped_point &b){
+    return a.x * b.y - a.y * b.x;
+}
+
+snapped_point operator-(const snapped_point &a, const snapped_point &b){
+    return { a.x - b.x, a.y - b.y };
+}
+
+// Orders directions counter-clockwise, starting from the +x axis.
+bool direction_less(const snapped_point &a, const snapped_point &b){
+    const auto half = [](const snapped_point &d) -> int {
+        return ((d.y < 0) || ((d.y == 0) && (d.x < 0))) ? 1 : 0;
+    };
+    const auto h_a = half(a);
+    const auto h_b = half(b);
+    if(h_a != h_b) return (h_a < h_b);
+    return (0 < cross(a, b));
+}
+
+using snapped_ring = std::vector<snapped_point>;
+using output_ring = std::vector<std::array<double,2>>;
+
+// Finds the vertex at which a hole should be seamed to the enclosing ring, following Eberly's method: a ray is cast
+// from the hole's rightmost vertex towards +x and a vertex of the ring that is visible from the hole is selected.
+bool seam_hole(output_ring &outer, const output_ring &hole){
+    const auto N_h = hole.size();
+    size_t i_M = 0;
+    for(size_t i = 1; i < N_h; ++i){
+        if(hole[i_M][0] < hole[i][0]) i_M = i;
+    }
+    const auto M = hole[i_M];
+
+    const auto N_o = outer.size();
+    double best_x = std::numeric_limits<double>::infinity();
+    size_t i_P = N_o;
+    for(size_t i = 0; i < N_o; ++i){
+        const auto &a = outer[i];
+        const auto &b = outer[(i + 1) % N_o];
+        if( (a[1] == b[1])
+        ||  (M[1] < std::min(a[1], b[1]))
+        ||  (std::max(a[1], b[1]) < M[1]) ) continue;
+        const auto x = a[0] + (M[1] - a[1]) * (b[0] - a[0]) / (b[1] - a[1]);
+        if( (x < M[0]) || (best_x <= x) ) continue;
+        best_x = x;
+        if(a[1] == M[1]){
+            i_P = i;
+        }else if(b[1] == M[1]){
+            i_P = (i + 1) % N_o;
+        }else{
+            i_P = (a[0] < b[0]) ? (i + 1) % N_o : i;
+        }
+    }
+    if(i_P == N_o) return false;
+
+    // Prefer reflex vertices within the triangle (M, I, P), which could otherwise occlude P.
+    const std::array<double,2> I = {{ best_x, M[1] }};
+    const auto P = outer[i_P];
+    const auto in_triangle = [&](const std::array<double,2> &r) -> bool {
+        const auto s = [](const std::array<double,2> &a, const std::array<double,2> &b, const std::array<double,2> &c){
+            return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+        };
+        const auto d1 = s(M, I, r);
+        const auto d2 = s(I, P, r);
+        const auto d3 = s(P, M, r);
+        const bool neg = (d1 < 0.0) || (d2 < 0.0) || (d3 < 0.0);
+        const bool pos = (0.0 < d1) || (0.0 < d2) || (0.0 < d3);
+        return !(neg && pos);
+    };
+    double best_angle = std::numeric_limits<double>::infinity();
+    double best_dist = std::numeric_limits<double>::infinity();
+    for(size_t i = 0; i < N_o; ++i){
+        if(i == i_P) continue;
+        const auto &prev = outer[(i + N_o - 1) % N_o];
+        const auto &r = outer[i];
+        const auto &next = outer[(i + 1) % N_o];
+        const auto turn = (r[0] - prev[0]) * (next[1] - r[1]) - (r[1] - prev[1]) * (next[0] - r[0]);
+        if( (0.0 <= turn) || (r[0] < M[0]) || !in_triangle(r) ) continue;
+        const auto dx = r[0] - M[0];
+        const auto dy = r[1] - M[1];
+        const auto angle = std::abs(std::atan2(dy, dx));
+        const auto dist = std::hypot(dx, dy);
+        if( (angle < best_angle) || ((angle == best_angle) && (dist < best_dist)) ){
+            best_angle = angle;
+            best_dist = dist;
+            i_P = i;
+        }
+    }
+
+    // Splice the hole in: ..., P, M, ..., (hole) ..., M, P, ...
+    output_ring joined;
+    joined.reserve(N_o + N_h + 2);
+    joined.insert(std::end(joined), std::begin(outer), std::next(std::begin(outer), i_P + 1));
+    for(size_t i = 0; i <= N_h; ++i) joined.emplace_back( hole[(i_M + i) % N_h] );
+    joined.insert(std::end(joined), std::next(std::begin(outer), i_P), std::end(outer));
+    outer = std::move(joined);
+    return true;
+}
+
+// Evaluates op(A, B) on snapped rings. Rings are treated as counter-clockwise and each set is the union of its rings.
+// Returns rings (in lattice units) where holes have been seamed to their enclosing ring. If holes are not seamed, they
+// are returned as separate clockwise rings after all counter-clockwise rings, so the interior is always on the left.
+// If nested_holes_A is set, set A is instead formed with the even-odd rule, so rings nested within an odd number of
+// other rings of A are treated as holes.
+std::vector<output_ring>
+snapped_boolean(const std::vector<snapped_ring> &A,
+                const std::vector<snapped_ring> &B,
+                ContourBooleanMethod op,
+                bool seam_holes = true,
+                bool nested_holes_A = false){
+
+    struct segment {
+        snapped_point p;
+        snapped_point q;
+        int set;
+        // Points where the segment is split, parameterized by t = n / d along the segment.
+        std::vector<std::tuple<int128, int128, rational_point>> splits;
+    };
+    std::vector<segment> segs;
+    for(int set = 0; set < 2; ++set){
+        for(const auto &r : (set == 0) ? A : B){
+            const auto N = r.size();
+            if(N < 3) continue;
+            int128 area = 0;
+            for(size_t i = 0; i < N; ++i) area += cross(r[i], r[(i + 1) % N]);
+            if(area == 0) continue;
+            for(size_t i = 0; i < N; ++i){
+                auto p = r[i];
+                auto q = r[(i + 1) % N];
+                if( (p.x == q.x) && (p.y == q.y) ) continue;
+                if(area < 0) std::swap(p, q);
+                segs.push_back( { p, q, set, {} } );
+            }
+        }
+    }
+
+    // Locate all intersections, sweeping along x.
+    const auto add_split = [](segment &s, int128 n, int128 d, const rational_point &rp){
+        s.splits.emplace_back(n, d, rp);
+    };
+    {
+        std::vector<size_t> order(segs.size());
+        std::iota(std::begin(order), std::end(order), static_cast<size_t>(0));
+        std::sort(std::begin(order), std::end(order), [&](size_t a, size_t b){
+            return std::min(segs[a].p.x, segs[a].q.x) < std::min(segs[b].p.x, segs[b].q.x);
+        });
+        std::vector<size_t> active;
+        for(const auto &i : order){
+            auto &s1 = segs[i];
+            const auto x_min = std::min(s1.p.x, s1.q.x);
+            const auto y_min = std::min(s1.p.y, s1.q.y);
+            const auto y_max = std::max(s1.p.y, s1.q.y);
+            active.erase( std::remove_if(std::begin(active), std::end(active), [&](size_t j){
+                              return (std::max(segs[j].p.x, segs[j].q.x) < x_min);
+                          }), std::end(active) );
+            for(const auto &j : active){
+                auto &s2 = segs[j];
+                if( (std::max(s2.p.y, s2.q.y) < y_min) || (y_max < std::min(s2.p.y, s2.q.y)) ) continue;
+
+                const auto r = s1.q - s1.p;
+                const auto s = s2.q - s2.p;
+                const auto qp = s2.p - s1.p;
+                auto denom = static_cast<int128>(cross(r, s));
+                if(denom != 0){
+                    auto tn = static_cast<int128>(cross(qp, s));
+                    auto un = static_cast<int128>(cross(qp, r));
+                    if(denom < 0){
+                        denom = -denom;
+                        tn = -tn;
+                        un = -un;
+                    }
+                    if( (tn < 0) || (denom < tn) || (un < 0) || (denom < un) ) continue;
+                    const auto rp = make_rational( static_cast<int128>(s1.p.x) * denom + static_cast<int128>(r.x) * tn,
+                                                   static_cast<int128>(s1.p.y) * denom + static_cast<int128>(r.y) * tn,
+                                                   denom );
+                    add_split(s1, tn, denom, rp);
+                    add_split(s2, un, denom, rp);
+
+                }else if(cross(qp, r) == 0){
+                    // Collinear. Split each segment at the other's endpoints where they overlap.
+                    const auto split_at = [&](segment &a, const snapped_point &e){
+                        const auto d = a.q - a.p;
+                        const auto n = static_cast<int128>((e.x - a.p.x) * d.x + (e.y - a.p.y) * d.y);
+                        const auto dd = static_cast<int128>(d.x * d.x + d.y * d.y);
+                        if( (0 < n) && (n < dd) ) add_split(a, n, dd, make_rational(e.x, e.y, 1));
+                    };
+                    split_at(s1, s2.p);
+                    split_at(s1, s2.q);
+                    split_at(s2, s1.p);
+                    split_at(s2, s1.q);
+                }
+            }
+            active.emplace_back(i);
+        }
+    }
+
+    // Build the arrangement. Edges are stored once, from lower to higher vertex index, with the change in each set's
+    // winding number when crossing from the edge's right to its left.
+    std::map<rational_point, size_t> vert_index;
+    std::vector<rational_point> verts;
+    const auto get_vert = [&](const rational_point &rp) -> size_t {
+        auto it = vert_index.find(rp);
+        if(it != std::end(vert_index)) return it->second;
+        vert_index[rp] = verts.size();
+        verts.emplace_back(rp);
+        return verts.size() - 1;
+    };
+    struct edge {
+        size_t u;
+        size_t v;
+        snapped_point dir; // Direction from u to v.
+        std::array<int64_t,2> w = {{ 0, 0 }};
+    };
+    std::map<std::pair<size_t,size_t>, edge> edge_map;
+    for(auto &s : segs){
+        add_split(s, 0, 1, make_rational(s.p.x, s.p.y, 1));
+        add_split(s, 1, 1, make_rational(s.q.x, s.q.y, 1));
+        std::sort(std::begin(s.splits), std::end(s.splits), [](const auto &a, const auto &b){
+            return (std::get<0>(a) * std::get<1>(b)) < (std::get<0>(b) * std::get<1>(a));
+        });
+        const auto dir = s.q - s.p;
+        size_t prev = get_vert(std::get<2>(s.splits.front()));
+        for(const auto &sp : s.splits){
+            const auto curr = get_vert(std::get<2>(sp));
+            if(curr == prev) continue;
+            const bool forward = (prev < curr);
+            auto &e = edge_map[ std::minmax(prev, curr) ];
+            e.u = std::min(prev, curr);
+            e.v = std::max(prev, curr);
+            e.dir = (forward) ? dir : snapped_point{ -dir.x, -dir.y };
+            e.w[s.set] += (forward) ? 1 : -1;
+            prev = curr;
+        }
+        s.splits.clear();
+    }
+    std::vector<edge> edges;
+    edges.reserve(edge_map.size());
+    for(const auto &p : edge_map){
+        if( (p.second.w[0] != 0) || (p.second.w[1] != 0) ) edges.emplace_back(p.second);
+    }
+    edge_map.clear();
+
+    // Half-edges 2e and 2e+1 traverse edge e forward and backward, respectively.
+    const auto N_v = verts.size();
+    const auto N_h = 2 * edges.size();
+    const auto origin = [&](size_t h) -> size_t { return (h % 2 == 0) ? edges[h / 2].u : edges[h / 2].v; };
+    const auto direction = [&](size_t h) -> snapped_point {
+        const auto &d = edges[h / 2].dir;
+        return (h % 2 == 0) ? d : snapped_point{ -d.x, -d.y };
+    };
+    std::vector<std::vector<size_t>> outgoing(N_v);
+    for(size_t h = 0; h < N_h; ++h) outgoing[origin(h)].emplace_back(h);
+    std::vector<size_t> slot(N_h);
+    for(auto &o : outgoing){
+        std::sort(std::begin(o), std::end(o), [&](size_t a, size_t b){ return direction_less(direction(a), direction(b)); });
+        for(size_t i = 0; i < o.size(); ++i) slot[o[i]] = i;
+    }
+
+    // Trace faces. The successor of a half-edge is the clockwise neighbour of its twin, which keeps the face on the left.
+    const auto next_of = [&](size_t h) -> size_t {
+        const auto t = h ^ 1;
+        const auto &o = outgoing[origin(t)];
+        return o[(slot[t] + o.size() - 1) % o.size()];
+    };
+    constexpr auto npos = std::numeric_limits<size_t>::max();
+    std::vector<size_t> face(N_h, npos);
+    std::vector<std::vector<size_t>> face_edges;
+    for(size_t h = 0; h < N_h; ++h){
+        if(face[h] != npos) continue;
+        face_edges.emplace_back();
+        for(auto g = h; face[g] == npos; g = next_of(g)){
+            face[g] = face_edges.size() - 1;
+            face_edges.back().emplace_back(g);
+        }
+    }
+
+    // Seed the winding numbers of each connected component's outer face by casting a ray from the component's
+    // lowest-leftmost vertex, then propagate across edges.
+    std::vector<size_t> comp(N_v);
+    std::iota(std::begin(comp), std::end(comp), static_cast<size_t>(0));
+    const std::function<size_t(size_t)> find = [&](size_t i) -> size_t {
+        while(comp[i] != i){
+            comp[i] = comp[comp[i]];
+            i = comp[i];
+        }
+        return i;
+    };
+    for(const auto &e : edges) comp[find(e.u)] = find(e.v);
+
+    const auto lex_less = [&](size_t a, size_t b) -> bool {
+        const auto &A_ = verts[a];
+        const auto &B_ = verts[b];
+        const auto xa = A_.x * B_.d;
+        const auto xb = B_.x * A_.d;
+        if(xa != xb) return (xa < xb);
+        return (A_.y * B_.d) < (B_.y * A_.d);
+    };
+    std::map<size_t, size_t> comp_seed;
+    for(size_t i = 0; i < N_v; ++i){
+        if(outgoing[i].empty()) continue;
+        const auto c = find(i);
+        auto it = comp_seed.find(c);
+        if(it == std::end(comp_seed)){
+            comp_seed[c] = i;
+        }else if(lex_less(i, it->second)){
+            it->second = i;
+        }
+    }
+
+    std::vector<std::array<int64_t,2>> winding(face_edges.size(), {{ 0, 0 }});
+    std::vector<uint8_t> visited(face_edges.size(), 0);
+    for(const auto &cs : comp_seed){
+        const auto &v = verts[cs.second];
+
+        // Winding numbers of a point infinitesimally to the left of v, via a ray cast towards -x.
+        std::array<int64_t,2> w = {{ 0, 0 }};
+        for(const auto &s : segs){
+            if(s.p.y == s.q.y) continue;
+            const auto lo = static_cast<int128>(std::min(s.p.y, s.q.y));
+            const auto hi = static_cast<int128>(std::max(s.p.y, s.q.y));
+            if( !((lo * v.d <= v.y) && (v.y < hi * v.d)) ) continue;
+            const auto dx = static_cast<int128>(s.q.x - s.p.x);
+            const auto dy = static_cast<int128>(s.q.y - s.p.y);
+            const auto lhs = static_cast<int128>(s.p.x) * dy * v.d + (v.y - static_cast<int128>(s.p.y) * v.d) * dx;
+            const auto rhs = v.x * dy;
+            const bool left_of_v = (0 < dy) ? (lhs < rhs) : (rhs < lhs);
+            if(left_of_v) w[s.set] += (dy < 0) ? 1 : -1;
+        }
+
+        // The outer face lies in the angular sector containing the -x direction.
+        const auto &o = outgoing[cs.second];
+        size_t h_outer = o.back();
+        for(const auto &h : o){
+            const auto d = direction(h);
+            if( (0 < d.y) || ((d.y == 0) && (0 < d.x)) ) h_outer = h;
+        }
+
+        std::vector<size_t> queue = { face[h_outer] };
+        visited[face[h_outer]] = 1;
+        winding[face[h_outer]] = w;
+        while(!queue.empty()){
+            const auto f = queue.back();
+            queue.pop_back();
+            for(const auto &h : face_edges[f]){
+                const auto g = face[h ^ 1];
+                if(visited[g] != 0) continue;
+                const auto &e = edges[h / 2];
+                const int64_t sgn = (h % 2 == 0) ? 1 : -1;
+                winding[g] = {{ winding[f][0] - sgn * e.w[0], winding[f][1] - sgn * e.w[1] }};
+                visited[g] = 1;
+                queue.emplace_back(g);
+            }
+        }
+    }
+
+    const auto inside = [&](const std::array<int64_t,2> &w) -> bool {
+        const bool a = (nested_holes_A) ? ((w[0] % 2) != 0) : (w[0] != 0);
+        const bool b = (w[1] != 0);
+        if(op == ContourBooleanMethod::noop) return a;
+        if(op == ContourBooleanMethod::join) return a || b;
+        if(op == ContourBooleanMethod::intersection) return a && b;
+        if(op == ContourBooleanMethod::difference) return a && !b;
+        if(op == ContourBooleanMethod::symmetric_difference) return a != b;
+        throw std::logic_error("Requested Boolean operation is not supported.");
+    };
+
+    // Select the boundary half-edges, which have the interior on their left, and link them into rings.
+    std::vector<uint8_t> is_boundary(N_h, 0);
+    for(size_t h = 0; h < N_h; ++h){
+        is_boundary[h] = ( inside(winding[face[h]]) && !inside(winding[face[h ^ 1]]) ) ? 1 : 0;
+    }
+    const auto next_boundary = [&](size_t h) -> size_t {
+        const auto t = h ^ 1;
+        const auto &o = outgoing[origin(t)];
+        auto i = slot[t];
+        do{
+            i = (i + o.size() - 1) % o.size();
+        }while(is_boundary[o[i]] == 0);
+        return o[i];
+    };
+
+    std::vector<output_ring> outers;
+    std::vector<output_ring> holes;
+    std::vector<double> outer_areas;
+    std::vector<uint8_t> used(N_h, 0);
+    for(size_t h = 0; h < N_h; ++h){
+        if( (is_boundary[h] == 0) || (used[h] != 0) ) continue;
+        output_ring r;
+        for(auto g = h; used[g] == 0; g = next_boundary(g)){
+            used[g] = 1;
+            const auto &v = verts[origin(g)];
+            r.push_back( {{ static_cast<double>(v.x) / static_cast<double>(v.d),
+                            static_cast<double>(v.y) / static_cast<double>(v.d) }} );
+        }
+        if(r.size() < 3) continue;
+        double area = 0.0;
+        for(size_t i = 0; i < r.size(); ++i){
+            const auto &a = r[i];
+            const auto &b = r[(i + 1) % r.size()];
+            area += a[0] * b[1] - a[1] * b[0];
+        }
+        if(0.0 < area){
+            outers.emplace_back(std::move(r));
+            outer_areas.emplace_back(0.5 * area);
+        }else if(area < 0.0){
+            holes.emplace_back(std::move(r));
+        }
+    }
+
+    if(!seam_holes){
+        outers.insert(std::end(outers), std::make_move_iterator(std::begin(holes)), std::make_move_iterator(std::end(holes)));
+        return outers;
+    }
+
+    // Assign each hole to the smallest enclosing ring, then seam holes in order of decreasing rightmost extent.
+    const auto contains = [](const output_ring &r, const std::array<double,2> &p) -> bool {
+        bool in = false;
+        for(size_t i = 0, j = r.size() - 1; i < r.size(); j = i++){
+            if( ((p[1] < r[i][1]) != (p[1] < r[j][1]))
+            &&  (p[0] < (r[j][0] - r[i][0]) * (p[1] - r[i][1]) / (r[j][1] - r[i][1]) + r[i][0]) ){
+                in = !in;
+            }
+        }
+        return in;
+    };
+    std::vector<std::vector<size_t>> outer_holes(outers.size());
+    for(size_t i = 0; i < holes.size(); ++i){
+        const auto &h = holes[i];
+        const std::array<double,2> p = {{ 0.5 * (h[0][0] + h[1][0]), 0.5 * (h[0][1] + h[1][1]) }};
+        size_t best = outers.size();
+        for(size_t j = 0; j < outers.size(); ++j){
+            if( ((best == outers.size()) || (outer_areas[j] < outer_areas[best])) && contains(outers[j], p) ) best = j;
+        }
+        if(best != outers.size()) outer_holes[best].emplace_back(i);
+    }
+    const auto max_x = [](const output_ring &r) -> double {
+        double m = -std::numeric_limits<double>::infinity();
+        for(const auto &p : r) m = std::max(m, p[0]);
+        return m;
+    };
+    for(size_t j = 0; j < outers.size(); ++j){
+        auto &hs = outer_holes[j];
+        std::sort(std::begin(hs), std::end(hs), [&](size_t a, size_t b){ return max_x(holes[b]) < max_x(holes[a]); });
+        for(const auto &i : hs){
+            if(!seam_hole(outers[j], holes[i])){
+                throw std::runtime_error("Unable to seam hole to enclosing contour.");
+            }
+        }
+    }
+    return outers;
+}
+
+} // namespace
+
+
+// Performs the same operation as ContourBoolean() using the snapped integer-coordinate backend. The contours in each
+// set are always joined.
+std::optional<contour_collection<double>>
+ContourBoolean_Snapped(plane<double> p,
+                       std::list<std::reference_wrapper<contour_of_points<double>>> A,
+                       std::list<std::reference_wrapper<contour_of_points<double>>> B,
+                       ContourBooleanMethod op,
+                       double resolution){
+
+    if(!(0.0 < resolution) || !std::isfinite(resolution)){
+        throw std::invalid_argument("Snapping resolution must be positive.");
+    }
+    const planar_basis basis(p);
+
+    std::list<std::reference_wrapper<contour_of_points<double>>> all;
+    all.insert(all.end(), A.begin(), A.end());
+    all.insert(all.end(), B.begin(), B.end());
+    auto common_metadata = contour_collection<double>().get_common_metadata( { }, { std::ref(all) } );
+
+    // Snap to the integer lattice. Contours that cannot be represented are deferred to the exact backend.
+    bool representable = true;
+    const auto snap = [&](const std::list<std::reference_wrapper<contour_of_points<double>>> &cops){
+        std::vector<snapped_ring> rings;
+        for(const auto &c_ref : cops){
+            rings.emplace_back();
+            for(const auto &v : c_ref.get().points){
+                const auto proj = basis.to_plane(v);
+                const auto x = std::round(proj.x / resolution);
+                const auto y = std::round(proj.y / resolution);
+                if( !(std::abs(x) < static_cast<double>(snapped_coordinate_limit))
+                ||  !(std::abs(y) < static_cast<double>(snapped_coordinate_limit)) ){
+                    representable = false;
+                    return rings;
+                }
+                rings.back().push_back( { static_cast<int64_t>(x), static_cast<int64_t>(y) } );
+            }
+        }
+        return rings;
+    };
+    const auto A_rings = snap(A);
+    const auto B_rings = snap(B);
+    if(!representable) return {};
+
+    contour_collection<double> out;
+    for(const auto &r : snapped_boolean(A_rings, B_rings, op)){
+        out.contours.emplace_back();
+        for(const auto &v : r){
+            const vec3<double> proj(v[0] * resolution, v[1] * resolution, 0.0);
+            out.contours.back().points.emplace_back( basis.from_plane(proj) );
+        }
+        out.contours.back().closed = true;
+        out.contours.back().metadata = common_metadata;
+    }
+    return out;
+}
+
+
+// Builds the pieces that are joined with (or removed from) a region to offset it. Rings are in lattice units and must
+// have the interior on their left. The side is +1 to build pieces outside the region and -1 to build them inside.
+static std::vector<std::vector<std::array<double,2>>>
+offset_pieces(const std::vector<std::vector<std::array<double,2>>> &rings,
+              double D,
+              double side,
+              ContourOffsetJoin join,
+              double miter_limit,
+              double arc_tolerance){
+    using pt = std::array<double,2>;
+    const auto add = [](const pt &a, const pt &b, double f) -> pt {
+        return {{ a[0] + b[0] * f, a[1] + b[1] * f }};
+    };
+    // The unit normal pointing away from the interior, scaled to the requested side.
+    const auto normal = [side](const pt &a, const pt &b) -> std::optional<pt> {
+        const auto dx = b[0] - a[0];
+        const auto dy = b[1] - a[1];
+        const auto L = std::hypot(dx, dy);
+        if(!(0.0 < L)) return {};
+        return pt{{ side * dy / L, -side * dx / L }};
+    };
+
+    // The largest angle an arc chord can subtend while remaining within the tolerance.
+    const auto max_step = (arc_tolerance < D) ? 2.0 * std::acos(1.0 - arc_tolerance / D) : M_PI;
+    const auto step = std::min(max_step, 0.25 * M_PI);
+
+    std::vector<std::vector<pt>> pieces;
+    for(const auto &r : rings){
+        const auto N = r.size();
+        if(N < 3) continue;
+        for(size_t i = 0; i < N; ++i){
+            const auto &prev = r[(i + N - 1) % N];
+            const auto &v = r[i];
+            const auto &next = r[(i + 1) % N];
+
+            const auto n2 = normal(v, next);
+            if(!n2) continue;
+            pieces.push_back( { v, next, add(next, n2.value(), D), add(v, n2.value(), D) } );
+
+            // Only corners that are convex when viewed from the offset side leave a gap between adjacent rectangles.
+            const auto n1 = normal(prev, v);
+            if(!n1) continue;
+            const auto e1x = v[0] - prev[0];
+            const auto e1y = v[1] - prev[1];
+            const auto e2x = next[0] - v[0];
+            const auto e2y = next[1] - v[1];
+            if(!(0.0 < side * (e1x * e2y - e1y * e2x))) continue;
+
+            const auto &a = n1.value();
+            const auto &b = n2.value();
+            const auto cos_t = std::clamp(a[0] * b[0] + a[1] * b[1], -1.0, 1.0);
+            const auto sin_t = a[0] * b[1] - a[1] * b[0];
+            std::vector<pt> wedge = { v, add(v, a, D) };
+            if(join == ContourOffsetJoin::miter_join){
+                const auto f = 1.0 / (1.0 + cos_t);
+                if( std::isfinite(f) && (std::sqrt(2.0 * f) <= miter_limit) ){
+                    wedge.push_back( add(v, pt{{ a[0] + b[0], a[1] + b[1] }}, D * f) );
+                }
+            }else{
+                const auto theta = std::atan2(sin_t, cos_t);
+                const auto N_steps = static_cast<long int>(std::ceil(std::abs(theta) / step));
+                for(long int j = 1; j < N_steps; ++j){
+                    const auto t = theta * static_cast<double>(j) / static_cast<double>(N_steps);
+                    const pt u = {{ a[0] * std::cos(t) - a[1] * std::sin(t),
+                                    a[0] * std::sin(t) + a[1] * std::cos(t) }};
+                    wedge.push_back( add(v, u, D) );
+                }
+            }
+            wedge.push_back( add(v, b, D) );
+            pieces.emplace_back(std::move(wedge));
+        }
+    }
+    return pieces;
+}
+
+// Offsets the region enclosed by the contours using the snapped integer-coordinate backend.
+std::optional<contour_collection<double>>
+ContourOffset_Snapped(plane<double> p,
+                      std::list<std::reference_wrapper<contour_of_points<double>>> A,
+                      double distance,
+                      ContourOffsetJoin join,
+                      double miter_limit,
+                      double arc_tolerance,
+                      double resolution){
+
+    if(!(0.0 < resolution) || !std::isfinite(resolution)){
+        throw std::invalid_argument("Snapping resolution must be positive.");
+    }
+    if(!std::isfinite(distance)){
+        throw std::invalid_argument("Offset distance must be finite.");
+    }
+    if(!(1.0 <= miter_limit)){
+        throw std::invalid_argument("Miter limit must be at least one.");
+    }
+    if(!(0.0 < arc_tolerance)){
+        throw std::invalid_argument("Arc tolerance must be positive.");
+    }
+    const planar_basis basis(p);
+    auto common_metadata = contour_collection<double>().get_common_metadata( { }, { std::ref(A) } );
+
+    // Snap to the integer lattice.
+    bool representable = true;
+    const auto snap = [&](double x, double y) -> snapped_point {
+        x = std::round(x);
+        y = std::round(y);
+        if( !(std::abs(x) < static_cast<double>(snapped_coordinate_limit))
+        ||  !(std::abs(y) < static_cast<double>(snapped_coordinate_limit)) ){
+            representable = false;
+            return {};
+        }
+        return { static_cast<int64_t>(x), static_cast<int64_t>(y) };
+    };
+    std::vector<snapped_ring> A_rings;
+    for(const auto &c_ref : A){
+        A_rings.emplace_back();
+        for(const auto &v : c_ref.get().points){
+            const auto proj = basis.to_plane(v);
+            A_rings.back().push_back( snap(proj.x / resolution, proj.y / resolution) );
+        }
+    }
+    if(!representable) return {};
+
+    // Extract the boundary of the region, which resolves self-intersections, overlapping contours, and seams.
+    const auto D = std::abs(distance) / resolution;
+    std::vector<snapped_ring> pieces;
+    if(0.0 < D){
+        const auto boundary = snapped_boolean(A_rings, {}, ContourBooleanMethod::join, false, true);
+        for(const auto &r : offset_pieces(boundary, D, (0.0 < distance) ? 1.0 : -1.0,
+                                          join, miter_limit, arc_tolerance / resolution)){
+            pieces.emplace_back();
+            for(const auto &v : r) pieces.back().push_back( snap(v[0], v[1]) );
+        }
+        if(!representable) return {};
+    }
+
+    const auto op = (distance < 0.0) ? ContourBooleanMethod::difference : ContourBooleanMethod::join;
+    contour_collection<double> out;
+    for(const auto &r : snapped_boolean(A_rings, pieces, op, true, true)){
+        out.contours.emplace_back();
+        for(const auto &v : r){
+            const vec3<double> proj(v[0] * resolution, v[1] * resolution, 0.0);
+            out.contours.back().points.emplace_back( basis.from_plane(proj) );
+        }
+        out.contours.back().closed = true;
+        out.contours.back().metadata = common_metadata;
+    }
+    return out;
+}
@@ -0,0 +1,435 @@
+//Contour_Index.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "Contour_Index.h"
+#include "YgorMath.h"
+
+
+namespace contour_index {
+
+bool box::empty(void) const {
+    return !( (this->min.x <= this->max.x)
+           && (this->min.y <= this->max.y)
+           && (this->min.z <= this->max.z) );
+}
+
+void box::expand(const vec3<double> &p){
+    this->min.x = std::min(this->min.x, p.x);
+    this->min.y = std::min(this->min.y, p.y);
+    this->min.z = std::min(this->min.z, p.z);
+    this->max.x = std::max(this->max.x, p.x);
+    this->max.y = std::max(this->max.y, p.y);
+    this->max.z = std::max(this->max.z, p.z);
+    return;
+}
+
+void box::expand(const box &b){
+    if(b.empty()) return;
+    this->expand(b.min);
+    this->expand(b.max);
+    return;
+}
+
+box box::inflated(double margin) const {
+    box out(*this);
+    if(out.empty()) return out;
+    const vec3<double> m(margin, margin, margin);
+    out.min = out.min - m;
+    out.max = out.max + m;
+    return out;
+}
+
+bool box::intersects(const box &b) const {
+    if(this->empty() || b.empty()) return false;
+    return (this->min.x <= b.max.x) && (b.min.x <= this->max.x)
+        && (this->min.y <= b.max.y) && (b.min.y <= this->max.y)
+        && (this->min.z <= b.max.z) && (b.min.z <= this->max.z);
+}
+
+double box::sq_dist(const vec3<double> &p) const {
+    if(this->empty()) return std::numeric_limits<double>::infinity();
+    const auto dx = std::max({ this->min.x - p.x, 0.0, p.x - this->max.x });
+    const auto dy = std::max({ this->min.y - p.y, 0.0, p.y - this->max.y });
+    const auto dz = std::max({ this->min.z - p.z, 0.0, p.z - this->max.z });
+    return dx * dx + dy * dy + dz * dz;
+}
+
+std::array<double,2> box::signed_distance_range(const plane<double> &P) const {
+    if(this->empty()){
+        return {{ std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() }};
+    }
+    const auto centre = (this->min + this->max) * 0.5;
+    const auto half = (this->max - this->min) * 0.5;
+    const auto d = P.Get_Signed_Distance_To_Point(centre);
+    const auto r = std::abs(P.N_0.x) * half.x
+                 + std::abs(P.N_0.y) * half.y
+                 + std::abs(P.N_0.z) * half.z;
+    return {{ d - r, d + r }};
+}
+
+
+bool contour_entry::encloses(const vec3<double> &p, double tolerance) const {
+    if(!this->planar) return false;
+    if(tolerance < std::abs(this->P.Get_Signed_Distance_To_Point(p))) return false;
+
+    const auto dP = p - this->P.R_0;
+    const auto pu = dP.Dot(this->u);
+    const auto pv = dP.Dot(this->v);
+    const auto N_bands = static_cast<long int>(this->band_offsets.size()) - 1;
+    const auto b = static_cast<long int>(std::floor((pv - this->band_min) / this->band_width));
+    if( (b < 0) || (N_bands <= b) ) return false;
+
+    const auto N_verts = this->verts.size();
+    bool inside = false;
+    for(auto k = this->band_offsets[b]; k < this->band_offsets[b + 1]; ++k){
+        const auto i = this->band_edges[k];
+        const auto &A = this->verts[i];
+        const auto &B = this->verts[(i + 1) % N_verts];
+        if( (pv < A[1]) != (pv < B[1]) ){
+            const auto x = A[0] + (pv - A[1]) * (B[0] - A[0]) / (B[1] - A[1]);
+            if(pu < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Hashes the vertex coordinates (FNV-1a) so altered contours can be detected without retaining a copy.
+static uint64_t fingerprint(const contour_of_points<double> &c){
+    uint64_t h = 14695981039346656037ULL;
+    const auto mix = [&h](double x){
+        uint64_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(bits));
+        for(size_t i = 0; i < sizeof(bits); ++i){
+            h ^= (bits >> (8 * i)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+    };
+    mix(static_cast<double>(c.points.size()));
+    for(const auto &p : c.points){
+        mix(p.x);
+        mix(p.y);
+        mix(p.z);
+    }
+    return h;
+}
+
+static void build_entry(contour_entry &e){
+    const auto &points = e.contour->points;
+    e.bbox = box();
+    for(const auto &p : points) e.bbox.expand(p);
+
+    e.planar = false;
+    e.verts.clear();
+    e.band_offsets.clear();
+    e.band_edges.clear();
+    const auto N_verts = points.size();
+    if(N_verts < 3) return;
+
+    vec3<double> centroid(0.0, 0.0, 0.0);
+    for(const auto &p : points) centroid += p;
+    centroid = centroid / static_cast<double>(N_verts);
+
+    // Newell's method, which is robust to collinear and slightly non-planar vertices.
+    vec3<double> N(0.0, 0.0, 0.0);
+    for(auto it = std::begin(points); it != std::end(points); ++it){
+        auto next = std::next(it);
+        if(next == std::end(points)) next = std::begin(points);
+        N += (*it - centroid).Cross(*next - centroid);
+    }
+    const auto diag = (e.bbox.max - e.bbox.min).length();
+    const auto N_len = N.length();
+    if(!std::isfinite(N_len) || !(1.0E-12 * diag * diag < N_len)) return;
+    N = N / N_len;
+    e.P = plane<double>(N, centroid);
+
+    // Use the coordinate axis least aligned with the normal to seed the in-plane basis.
+    const auto ax = std::abs(N.x);
+    const auto ay = std::abs(N.y);
+    const auto az = std::abs(N.z);
+    const auto seed = ((ax <= ay) && (ax <= az)) ? vec3<double>(1.0, 0.0, 0.0)
+                    : ((ay <= az)                ? vec3<double>(0.0, 1.0, 0.0)
+                                                 : vec3<double>(0.0, 0.0, 1.0));
+    e.u = seed.Cross(N).unit();
+    e.v = N.Cross(e.u).unit();
+
+    e.thickness = 0.0;
+    double v_min = std::numeric_limits<double>::infinity();
+    double v_max = -std::numeric_limits<double>::infinity();
+    e.verts.reserve(N_verts);
+    for(const auto &p : points){
+        const auto dP = p - centroid;
+        e.thickness = std::max(e.thickness, std::abs(dP.Dot(N)));
+        const auto pv = dP.Dot(e.v);
+        e.verts.push_back({{ dP.Dot(e.u), pv }});
+        v_min = std::min(v_min, pv);
+        v_max = std::max(v_max, pv);
+    }
+    if(!(v_min < v_max)) return;
+
+    // Bucket the edges into bands so that roughly sqrt(N) edges need to be considered per query.
+    const auto N_bands = std::clamp<size_t>(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(N_verts)))),
+                                            1, N_verts);
+    e.band_min = v_min;
+    e.band_width = (v_max - v_min) / static_cast<double>(N_bands);
+    const auto band_of = [&](double pv) -> size_t {
+        const auto b = static_cast<long int>(std::floor((pv - e.band_min) / e.band_width));
+        return static_cast<size_t>(std::clamp<long int>(b, 0, static_cast<long int>(N_bands) - 1));
+    };
+
+    std::vector<std::array<size_t,2>> spans(N_verts);
+    e.band_offsets.assign(N_bands + 1, 0);
+    for(size_t i = 0; i < N_verts; ++i){
+        const auto a = e.verts[i][1];
+        const auto b = e.verts[(i + 1) % N_verts][1];
+        spans[i] = {{ band_of(std::min(a, b)), band_of(std::max(a, b)) }};
+        for(auto k = spans[i][0]; k <= spans[i][1]; ++k) ++e.band_offsets[k + 1];
+    }
+    for(size_t k = 0; k < N_bands; ++k) e.band_offsets[k + 1] += e.band_offsets[k];
+    e.band_edges.resize(e.band_offsets.back());
+    auto fill = e.band_offsets;
+    for(size_t i = 0; i < N_verts; ++i){
+        for(auto k = spans[i][0]; k <= spans[i][1]; ++k) e.band_edges[fill[k]++] = static_cast<uint32_t>(i);
+    }
+
+    e.planar = true;
+    return;
+}
+
+
+size_t index::refresh(const std::list<std::reference_wrapper<contour_collection<double>>> &ccs){
+    std::vector<const contour_collection<double> *> ptrs;
+    for(const auto &cc_refw : ccs) ptrs.push_back( &(cc_refw.get()) );
+    return this->refresh(ptrs);
+}
+
+size_t index::refresh(const std::vector<const contour_collection<double> *> &ccs){
+    std::vector<contour_entry> next;
+    for(const auto &cc_ptr : ccs){
+        for(const auto &c : cc_ptr->contours){
+            next.emplace_back();
+            next.back().cc = cc_ptr;
+            next.back().contour = &c;
+        }
+    }
+    const auto N = next.size();
+
+    std::unordered_map<const contour_of_points<double> *, size_t> previous;
+    for(size_t i = 0; i < this->entries.size(); ++i) previous[ this->entries[i].contour ] = i;
+
+    // Fingerprint every contour. Contours that were already indexed and are unaltered are reused.
+    std::vector<long int> reuse(N, -1);
+    for(size_t i = 0; i < N; ++i){
+        auto &e = next[i];
+        e.fingerprint = fingerprint(*(e.contour));
+        e.N_points = e.contour->points.size();
+        const auto it = previous.find(e.contour);
+        if( (it != std::end(previous))
+        &&  (this->entries[it->second].cc == e.cc)
+        &&  (this->entries[it->second].fingerprint == e.fingerprint) ){
+            reuse[i] = static_cast<long int>(it->second);
+        }
+    }
+
+    bool unchanged = (N == this->entries.size());
+    for(size_t i = 0; unchanged && (i < N); ++i){
+        unchanged = (reuse[i] == static_cast<long int>(i));
+    }
+    if(unchanged) return 0;
+
+    size_t N_indexed = 0;
+    for(size_t i = 0; i < N; ++i){
+        if(0 <= reuse[i]){
+            next[i] = std::move(this->entries[reuse[i]]);
+        }else{
+            build_entry(next[i]);
+            ++N_indexed;
+        }
+    }
+
+    this->entries = std::move(next);
+    this->build_tree();
+    return N_indexed;
+}
+
+bool index::matches(const std::vector<const contour_collection<double> *> &ccs) const {
+    auto e_it = std::begin(this->entries);
+    for(const auto &cc_ptr : ccs){
+        for(const auto &c : cc_ptr->contours){
+            if( (e_it == std::end(this->entries))
+            ||  (e_it->cc != cc_ptr)
+            ||  (e_it->contour != &c)
+            ||  (e_it->N_points != c.points.size()) ) return false;
+            ++e_it;
+        }
+    }
+    return (e_it == std::end(this->entries));
+}
+
+bool index::is_current(const std::vector<const contour_collection<double> *> &ccs) const {
+    if(!this->matches(ccs)) return false;
+    for(const auto &e : this->entries){
+        if(e.fingerprint != fingerprint(*(e.contour))) return false;
+    }
+    return true;
+}
+
+size_t index::size(void) const {
+    return this->entries.size();
+}
+
+const std::vector<contour_entry> & index::get_entries(void) const {
+    return this->entries;
+}
+
+// Orders the items using sort-tile-recursive packing so that each consecutive run of 'fanout' items is compact.
+template <class F>
+static void str_order(std::vector<uint32_t> &ids, size_t fanout, F centre_of){
+    const auto N = ids.size();
+    const auto N_groups = (N + fanout - 1) / fanout;
+    const auto S = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(N_groups))));
+
+    const auto sort_range = [&](size_t first, size_t last, auto coord){
+        std::sort(std::next(std::begin(ids), first), std::next(std::begin(ids), last),
+                  [&](uint32_t a, uint32_t b){ return coord(centre_of(a)) < coord(centre_of(b)); });
+    };
+    const auto x_of = [](const vec3<double> &c){ return c.x; };
+    const auto y_of = [](const vec3<double> &c){ return c.y; };
+    const auto z_of = [](const vec3<double> &c){ return c.z; };
+
+    sort_range(0, N, x_of);
+    const auto x_slab = std::max<size_t>(S * S * fanout, 1);
+    for(size_t i = 0; i < N; i += x_slab){
+        const auto i_end = std::min(N, i + x_slab);
+        sort_range(i, i_end, y_of);
+        const auto y_slab = std::max<size_t>(S * fanout, 1);
+        for(size_t j = i; j < i_end; j += y_slab){
+            sort_range(j, std::min(i_end, j + y_slab), z_of);
+        }
+    }
+    return;
+}
+
+void index::build_tree(void){
+    const size_t fanout = 8;
+    this->nodes.clear();
+    this->order.clear();
+    const auto N = this->entries.size();
+    if(N == 0) return;
+
+    const auto centre = [](const box &b) -> vec3<double> {
+        return b.empty() ? vec3<double>(0.0, 0.0, 0.0) : (b.min + b.max) * 0.5;
+    };
+
+    // Leaves.
+    this->order.resize(N);
+    for(size_t i = 0; i < N; ++i) this->order[i] = static_cast<uint32_t>(i);
+    str_order(this->order, fanout, [&](uint32_t i){ return centre(this->entries[i].bbox); });
+
+    std::vector<node> level;
+    for(size_t i = 0; i < N; i += fanout){
+        node n;
+        n.first = static_cast<uint32_t>(i);
+        n.count = static_cast<uint32_t>(std::min(fanout, N - i));
+        n.leaf = true;
+        for(size_t j = i; j < (i + n.count); ++j) n.bbox.expand(this->entries[ this->order[j] ].bbox);
+        level.push_back(n);
+    }
+
+    // Internal nodes. Each level is stored contiguously so children can be addressed by offset.
+    while(1 < level.size()){
+        std::vector<uint32_t> ids(level.size());
+        for(size_t i = 0; i < ids.size(); ++i) ids[i] = static_cast<uint32_t>(i);
+        str_order(ids, fanout, [&](uint32_t i){ return centre(level[i].bbox); });
+
+        const auto base = this->nodes.size();
+        for(const auto &i : ids) this->nodes.push_back(level[i]);
+
+        std::vector<node> parents;
+        for(size_t i = 0; i < ids.size(); i += fanout){
+            node n;
+            n.first = static_cast<uint32_t>(base + i);
+            n.count = static_cast<uint32_t>(std::min(fanout, ids.size() - i));
+            n.leaf = false;
+            for(size_t j = base + i; j < (base + i + n.count); ++j) n.bbox.expand(this->nodes[j].bbox);
+            parents.push_back(n);
+        }
+        level.swap(parents);
+    }
+    this->nodes.push_back(level.front());
+    return;
+}
+
+template <class BoxPred, class EntryPred>
+std::vector<const contour_entry *> index::query(BoxPred box_pred, EntryPred entry_pred) const {
+    std::vector<const contour_entry *> out;
+    if(this->nodes.empty()) return out;
+
+    std::vector<uint32_t> stack = { static_cast<uint32_t>(this->nodes.size() - 1) };
+    while(!stack.empty()){
+        const auto &n = this->nodes[stack.back()];
+        stack.pop_back();
+        if(!box_pred(n.bbox)) continue;
+
+        for(auto i = n.first; i < (n.first + n.count); ++i){
+            if(n.leaf){
+                const auto &e = this->entries[ this->order[i] ];
+                if(box_pred(e.bbox) && entry_pred(e)) out.push_back(&e);
+            }else{
+                stack.push_back(i);
+            }
+        }
+    }
+
+    // Report contours in the order they were indexed.
+    std::sort(std::begin(out), std::end(out));
+    return out;
+}
+
+std::vector<const contour_entry *> index::intersecting_box(const box &b) const {
+    return this->query([&](const box &n){ return n.intersects(b); },
+                       [](const contour_entry &){ return true; });
+}
+
+std::vector<const contour_entry *> index::near_point(const vec3<double> &p, double distance) const {
+    const auto sq_distance = distance * distance;
+    return this->query([&](const box &n){ return n.sq_dist(p) <= sq_distance; },
+                       [](const contour_entry &){ return true; });
+}
+
+std::vector<const contour_entry *> index::enclosing_point(const vec3<double> &p, double tolerance) const {
+    const auto sq_tolerance = tolerance * tolerance;
+    return this->query([&](const box &n){ return n.sq_dist(p) <= sq_tolerance; },
+                       [&](const contour_entry &e){ return e.encloses(p, tolerance); });
+}
+
+std::vector<const contour_entry *> index::intersecting_plane(const plane<double> &P, double tolerance) const {
+    return this->query([&](const box &n){
+                           const auto r = n.signed_distance_range(P);
+                           return (r[0] <= tolerance) && (-tolerance <= r[1]);
+                       },
+                       [&](const contour_entry &e){
+                           double d_min = std::numeric_limits<double>::infinity();
+                           double d_max = -std::numeric_limits<double>::infinity();
+                           for(const auto &p : e.contour->points){
+                               const auto d = P.Get_Signed_Distance_To_Point(p);
+                               d_min = std::min(d_min, d);
+                               d_max = std::max(d_max, d);
+                           }
+                           return (d_min <= tolerance) && (-tolerance <= d_max);
+                       });
+}
+
+} // namespace contour_index
+
@@ -0,0 +1,124 @@
+//Contour_Index.h.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include "YgorMath.h"
+
+// A spatial index over contours for point, plane, and box queries.
+//
+// Each contour is summarized by its plane, an axis-aligned bounding box, and its vertices projected into the plane.
+// Projected edges are bucketed into uniform bands across the contour so point-in-polygon tests only visit the edges
+// that span the query point's band. Bounding boxes are organized in a packed R-tree (sort-tile-recursive), so queries
+// only visit the contours whose extents could possibly match.
+//
+// The index holds pointers into the indexed contours and does not own them. It is refreshed incrementally: contours
+// are fingerprinted, and only those that were added or altered since the previous refresh are re-indexed.
+//
+// Because the index refers to the contours, it must not be queried after the indexed contours are altered, added,
+// removed, or destroyed; refresh it (or fetch a new snapshot via Contour_Data::Get_Index()) first. Use matches() or
+// is_current() to check whether the index still corresponds to a set of contours.
+namespace contour_index {
+
+struct box {
+    vec3<double> min = vec3<double>( std::numeric_limits<double>::infinity(),
+                                     std::numeric_limits<double>::infinity(),
+                                     std::numeric_limits<double>::infinity() );
+    vec3<double> max = vec3<double>( -std::numeric_limits<double>::infinity(),
+                                     -std::numeric_limits<double>::infinity(),
+                                     -std::numeric_limits<double>::infinity() );
+
+    bool empty(void) const;
+    void expand(const vec3<double> &p);
+    void expand(const box &b);
+    box inflated(double margin) const;
+
+    bool intersects(const box &b) const;
+    double sq_dist(const vec3<double> &p) const;
+
+    // The range of signed distances from the plane to points within the box.
+    std::array<double,2> signed_distance_range(const plane<double> &P) const;
+};
+
+struct contour_entry {
+    const contour_collection<double> *cc = nullptr;
+    const contour_of_points<double> *contour = nullptr;
+    uint64_t fingerprint = 0;
+    size_t N_points = 0;
+
+    plane<double> P;         // Passes through the vertex centroid, oriented by the contour winding.
+    vec3<double> u;          // In-plane basis.
+    vec3<double> v;
+    bool planar = false;     // False for degenerate contours, which never enclose points.
+    double thickness = 0.0;  // The largest distance from any vertex to the plane.
+    box bbox;
+
+    // Vertices projected onto the plane, and the edges spanning each band along v. Edge i joins vertex i to i+1.
+    std::vector<std::array<double,2>> verts;
+    double band_min = 0.0;
+    double band_width = 1.0;
+    std::vector<uint32_t> band_offsets; // Edges in band b are band_edges[band_offsets[b]] to band_edges[band_offsets[b+1]].
+    std::vector<uint32_t> band_edges;
+
+    // True if the point lies within the given distance of the plane and within the polygon, projected onto the plane.
+    // Holes and self-intersections are resolved with the even-odd rule.
+    bool encloses(const vec3<double> &p, double tolerance) const;
+};
+
+class index {
+    public:
+        // Brings the index up-to-date with the given contours. Entries, and any pointers to them, are invalidated
+        // unless nothing changed. Returns the number of contours that were (re-)indexed.
+        size_t refresh(const std::vector<const contour_collection<double> *> &ccs);
+        size_t refresh(const std::list<std::reference_wrapper<contour_collection<double>>> &ccs);
+
+        // Cheaply checks that the index refers to exactly the given contours, in order, and that each still has the
+        // indexed number of vertices. Vertices moved in-place are not detected.
+        bool matches(const std::vector<const contour_collection<double> *> &ccs) const;
+
+        // Like matches(), but also compares the vertex fingerprints, so all alterations are detected. This is as costly
+        // as a refresh that re-indexes nothing.
+        bool is_current(const std::vector<const contour_collection<double> *> &ccs) const;
+
+        size_t size(void) const;
+        const std::vector<contour_entry> & get_entries(void) const;
+
+        // Contours with a bounding box that intersects the box.
+        std::vector<const contour_entry *> intersecting_box(const box &b) const;
+
+        // Contours with a bounding box within the given distance of the point.
+        std::vector<const contour_entry *> near_point(const vec3<double> &p, double distance) const;
+
+        // Contours that enclose the point (see contour_entry::encloses()).
+        std::vector<const contour_entry *> enclosing_point(const vec3<double> &p, double tolerance) const;
+
+        // Contours with vertices within the given distance of the plane, or on both sides of it.
+        std::vector<const contour_entry *> intersecting_plane(const plane<double> &P, double tolerance) const;
+
+    private:
+        struct node {
+            box bbox;
+            uint32_t first = 0;  // Index of the first child node, or first entry for leaves.
+            uint32_t count = 0;
+            bool leaf = true;
+        };
+
+        std::vector<contour_entry> entries;
+        std::vector<uint32_t> order;  // Entries ordered as referenced by the leaves.
+        std::vector<node> nodes;      // The root is the last node.
+
+        void build_tree(void);
+
+        template <class BoxPred, class EntryPred>
+        std::vector<const contour_entry *> query(BoxPred box_pred, EntryPred entry_pred) const;
+};
+
+} // namespace contour_index
+
@@ -12,9 +12,14 @@
 // computing the min/max dose).
 //
 
+#include <algorithm>
+#include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 //#include <cstdint>   //For int64_t.
 //#include <utility>   //For std::pair.
 //#include <algorithm> //std::min_element/max_element.
@@ -24,6 +29,9 @@
 #include "Regex_Selectors.h"
 
 #include "Dose_Meld.h"
+#include "Thread_Pool.h"
+#include "YgorImages_Functors/Grid_Resampling.h"
+#include "YgorImages_Functors/Pixel_Kernels.h"
 
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -110,6 +118,18 @@ std::list<std::shared_ptr<Image_Array>>  Meld_Image_Data(const std::list<std::sh
     if(out.size() == 0) return out;
     if(out.size() == 1) return out;
 
+    //Prefer melding all arrays at once, which avoids repeated (lossy) resampling of intermediate results. If this is
+    // not possible, fall back to pairwise melding.
+    {
+        auto melded = Meld_N_Way_Image_Data(out);
+        if(melded != nullptr){
+            FUNCINFO("Melded " << out.size() << " image arrays using the N-way meld routine");
+            out.clear();
+            out.emplace_back( std::move(melded) );
+            return out;
+        }
+    }
+
     auto d2_it = out.begin(); //Note: d*_it are ~ std::list<std::shared_ptr<Image_Array>>::iterator
     auto d1_it = --(out.end());
     while((d1_it != out.end()) && (d2_it != out.end()) && (d1_it != d2_it)){
@@ -139,6 +159,104 @@ std::list<std::shared_ptr<Image_Array>>  Meld_Image_Data(const std::list<std::sh
     return out;
 }
 
+std::unique_ptr<Image_Array> Meld_N_Way_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist,
+                                                   bool accumulate_in_double){
+    //Gather the arrays, verifying each forms a rectilinear grid.
+    std::list<std::shared_ptr<Image_Array>> arrays;
+    std::vector<grid_resampling::rectilinear_grid> grids;
+    std::shared_ptr<Image_Array> target;
+    for(const auto &dap : dalist){
+        if( (dap == nullptr) || dap->imagecoll.images.empty() ) continue;
+
+        std::list<std::reference_wrapper<planar_image<float,double>>> imgs;
+        for(auto &img : dap->imagecoll.images) imgs.push_back( std::ref(img) );
+        auto grid = grid_resampling::Make_Rectilinear_Grid(imgs);
+        if(!grid){
+            FUNCINFO("Image array is not rectilinear; unable to perform N-way meld");
+            return nullptr;
+        }
+
+        arrays.push_back(dap);
+        grids.emplace_back( std::move(grid.value()) );
+        if( (target == nullptr) || (target->imagecoll.volume() < dap->imagecoll.volume()) ){
+            target = dap;
+        }
+    }
+    if(target == nullptr) return nullptr;
+    for(const auto &g : grids){
+        if(g.channels != grids.front().channels) return nullptr;
+    }
+
+    std::unique_ptr<Image_Array> out(new Image_Array());
+    *out = *target; //Performs a deep copy.
+
+    grid_resampling::resample_opts rs_opts;
+    rs_opts.method  = grid_resampling::kernel::Nearest;
+    rs_opts.inplane = grid_resampling::extrapolation::Fill;
+    rs_opts.slices  = grid_resampling::extrapolation::Fill;
+    rs_opts.fill    = 0.0f;
+    rs_opts.channel = -1;
+
+    //Each target image is produced by a separate task. Every input is resampled directly onto the target image, so
+    // each input is resampled at most once and intermediate sums are never resampled. Inputs sharing the target's
+    // geometry are summed without resampling.
+    bool failed = false;
+    {
+        asio_thread_pool tp;
+        std::mutex failure_lock;
+        for(auto &out_img : out->imagecoll.images){
+            tp.submit_task([&](void) -> void {
+                const auto N = out_img.data.size();
+                std::vector<double> acc_d;
+                if(accumulate_in_double) acc_d.assign(N, 0.0);
+                auto contrib = out_img;
+                std::fill(std::begin(out_img.data), std::end(out_img.data), 0.0f);
+
+                auto g_it = std::begin(grids);
+                for(auto a_it = std::begin(arrays); a_it != std::end(arrays); ++a_it, ++g_it){
+                    const float *src = nullptr;
+
+                    // Look for an image with identical geometry.
+                    for(const auto *img : g_it->imgs){
+                        if( (img->data.size() == N) && img->Spatially_eq(out_img) ){
+                            src = img->data.data();
+                            break;
+                        }
+                    }
+
+                    if(src == nullptr){
+                        const auto identity = [](const vec3<double> &v) -> vec3<double> { return v; };
+                        if( !grid_resampling::Resample_Aligned_Image(*g_it, contrib, rs_opts)
+                        &&  !grid_resampling::Resample_Mapped_Image(*g_it, contrib, identity, rs_opts) ){
+                            std::lock_guard<std::mutex> lock(failure_lock);
+                            failed = true;
+                            return;
+                        }
+                        src = contrib.data.data();
+                    }
+
+                    if(accumulate_in_double){
+                        for(size_t i = 0; i < N; ++i) acc_d[i] += static_cast<double>(src[i]);
+                    }else{
+                        pixel_kernels::Add( pixel_kernels::Pixel_Buffer(out_img), src );
+                    }
+                }
+
+                if(accumulate_in_double){
+                    for(size_t i = 0; i < N; ++i) out_img.data[i] = static_cast<float>(acc_d[i]);
+                }
+                out_img.metadata["Description"] = "N-way dose melded.";
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    if(failed){
+        FUNCINFO("Unable to resample image arrays onto a common grid; unable to perform N-way meld");
+        return nullptr;
+    }
+    return out;
+}
+
 std::unique_ptr<Image_Array> Meld_Equal_Geom_Image_Data(std::shared_ptr<Image_Array> A, std::shared_ptr<Image_Array> B){
     std::unique_ptr<Image_Array> out(new Image_Array());
     *out = *A; //Performs a deep copy.
@@ -242,6 +360,16 @@ std::unique_ptr<Image_Array> Meld_Unequal_Geom_Image_Data(std::shared_ptr<Image_
     *out = *larger; //Make a deep copy of the data.
 
     //Now cycle through the voxel data, collecting the dose contributions from either A or B. 
+    //
+    // When the images are aligned, the nearest voxel lookups are performed using per-axis index tables that are
+    // computed once per image rather than per voxel. Voxels outside an image receive no contribution from it.
+    grid_resampling::resample_opts rs_opts;
+    rs_opts.method  = grid_resampling::kernel::Nearest;
+    rs_opts.inplane = grid_resampling::extrapolation::Fill;
+    rs_opts.slices  = grid_resampling::extrapolation::Fill;
+    rs_opts.fill    = 0.0f;
+    rs_opts.channel = -1;
+
     auto i0_it = out->imagecoll.images.begin();
     auto i1_it = A->imagecoll.images.begin();
     auto i2_it = B->imagecoll.images.begin();
@@ -249,6 +377,20 @@ std::unique_ptr<Image_Array> Meld_Unequal_Geom_Image_Data(std::shared_ptr<Image_
              && (i1_it !=   A->imagecoll.images.end())
              && (i2_it !=   B->imagecoll.images.end()); ++i0_it, ++i1_it, ++i2_it){
 
+        {
+            const auto grid1 = grid_resampling::Make_Rectilinear_Grid({ std::ref(*i1_it) });
+            const auto grid2 = grid_resampling::Make_Rectilinear_Grid({ std::ref(*i2_it) });
+            auto contrib = *i0_it;
+            if( grid1
+            &&  grid2
+            &&  grid_resampling::Resample_Aligned_Image(grid1.value(), *i0_it, rs_opts)
+            &&  grid_resampling::Resample_Aligned_Image(grid2.value(), contrib, rs_opts) ){
+                pixel_kernels::Add( pixel_kernels::Pixel_Buffer(*i0_it), contrib.data.data() );
+                continue;
+            }
+        }
+
+        // Otherwise, fall back to per-voxel lookups.
         const auto rows     = i0_it->rows;
         const auto columns  = i0_it->columns;
         const auto channels = i0_it->channels;
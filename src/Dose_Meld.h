@@ -23,6 +23,13 @@ Meld_Only_Dose_Data(Drover);
 std::list<std::shared_ptr<Image_Array>> 
 Meld_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist);
 
+//Melds any number of image arrays in a single pass. The largest array is used as the target grid and every other array
+// is resampled onto it exactly once. Contributions are summed in parallel (one task per target image), optionally in
+// double precision. Returns a nullptr if any array is not rectilinear or has a differing number of channels.
+std::unique_ptr<Image_Array>
+Meld_N_Way_Image_Data(const std::list<std::shared_ptr<Image_Array>> &dalist,
+                      bool accumulate_in_double = true);
+
 //Resamples dose data to ensure no overflow occurs. Is a lossy operation.
 std::unique_ptr<Image_Array>
 Meld_Equal_Geom_Image_Data(std::shared_ptr<Image_Array> A, std::shared_ptr<Image_Array> B);
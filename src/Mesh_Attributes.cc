@@ -0,0 +1,322 @@
+//Mesh_Attributes.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Mesh_Attributes.h"
+#include "YgorMath.h"
+
+
+namespace mesh_attributes {
+
+bool Is_Valid_Name(const std::string &name){
+    if(name.empty()) return false;
+    for(const auto &c : name){
+        // Printable ASCII excluding space.
+        if( (c < '!') || ('~' < c) ) return false;
+    }
+    return true;
+}
+
+attribute_store attribute_store::clone(void) const {
+    attribute_store out;
+    out.N = this->N;
+    out.columns = this->columns;
+    return out;
+}
+
+void attribute_store::resize(size_t n){
+    this->N = n;
+    for(auto &p : this->columns){
+        std::visit([n](auto &v){ v.resize(n); }, p.second);
+    }
+}
+
+void attribute_store::clear(void){
+    this->N = 0;
+    this->columns.clear();
+}
+
+std::vector<std::string> attribute_store::names(void) const {
+    std::vector<std::string> out;
+    out.reserve(this->columns.size());
+    for(const auto &p : this->columns) out.emplace_back(p.first);
+    return out;
+}
+
+attribute_store attribute_store::gather(const std::vector<size_t> &indices) const {
+    attribute_store out;
+    out.N = indices.size();
+    for(const auto &p : this->columns){
+        out.columns[p.first] = std::visit([&](const auto &v) -> column {
+            std::remove_cv_t<std::remove_reference_t<decltype(v)>> g;
+            g.reserve(indices.size());
+            for(const auto &i : indices){
+                if(this->N <= i) throw std::out_of_range("Attribute index is out of range");
+                g.emplace_back(v[i]);
+            }
+            return g;
+        }, p.second);
+    }
+    return out;
+}
+
+
+const std::string vertex_normal_x = "normal_x";
+const std::string vertex_normal_y = "normal_y";
+const std::string vertex_normal_z = "normal_z";
+const std::string vertex_mean_curvature = "mean_curvature";
+
+bool Is_Geometry_Cache(const std::string &name){
+    return (name == vertex_normal_x)
+        || (name == vertex_normal_y)
+        || (name == vertex_normal_z)
+        || (name == vertex_mean_curvature);
+}
+
+// Visits each triangle of the fan-triangulated faces.
+template <class F>
+static void for_each_triangle(const fv_surface_mesh<double, uint64_t> &mesh, F f){
+    const auto N_verts = mesh.vertices.size();
+    for(const auto &face : mesh.faces){
+        for(size_t i = 2; i < face.size(); ++i){
+            const auto a = static_cast<size_t>(face[0]);
+            const auto b = static_cast<size_t>(face[i - 1]);
+            const auto c = static_cast<size_t>(face[i]);
+            if( (N_verts <= a) || (N_verts <= b) || (N_verts <= c) ){
+                throw std::out_of_range("Mesh face references a nonexistent vertex");
+            }
+            f(a, b, c);
+        }
+    }
+}
+
+static std::vector<vec3<double>> vertex_normals(const fv_surface_mesh<double, uint64_t> &mesh){
+    std::vector<vec3<double>> normals(mesh.vertices.size(), vec3<double>(0.0, 0.0, 0.0));
+    for_each_triangle(mesh, [&](size_t a, size_t b, size_t c){
+        // The cross product's magnitude is twice the triangle's area, which provides the weighting.
+        const auto n = (mesh.vertices[b] - mesh.vertices[a]).Cross(mesh.vertices[c] - mesh.vertices[a]);
+        normals[a] += n;
+        normals[b] += n;
+        normals[c] += n;
+    });
+    for(auto &n : normals){
+        const auto u = n.unit();
+        n = (u.isfinite()) ? u : vec3<double>(0.0, 0.0, 0.0);
+    }
+    return normals;
+}
+
+void Cache_Vertex_Normals(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes){
+    const auto N = mesh.vertices.size();
+    if(vertex_attributes.empty()) vertex_attributes.resize(N);
+    if(vertex_attributes.size() != N){
+        throw std::invalid_argument("Vertex attributes do not match the number of vertices");
+    }
+
+    const auto normals = vertex_normals(mesh);
+    auto nx = vertex_attributes.add<double>(vertex_normal_x);
+    auto ny = vertex_attributes.add<double>(vertex_normal_y);
+    auto nz = vertex_attributes.add<double>(vertex_normal_z);
+    for(size_t i = 0; i < N; ++i){
+        nx[i] = normals[i].x;
+        ny[i] = normals[i].y;
+        nz[i] = normals[i].z;
+    }
+}
+
+void Cache_Vertex_Curvature(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes){
+    const auto N = mesh.vertices.size();
+    if(vertex_attributes.empty()) vertex_attributes.resize(N);
+    if(vertex_attributes.size() != N){
+        throw std::invalid_argument("Vertex attributes do not match the number of vertices");
+    }
+
+    // Accumulate the cotangent Laplacian of the vertex positions along with a barycentric area for each vertex.
+    std::vector<vec3<double>> laplacian(N, vec3<double>(0.0, 0.0, 0.0));
+    std::vector<double> area(N, 0.0);
+    for_each_triangle(mesh, [&](size_t a, size_t b, size_t c){
+        const std::array<size_t, 3> v = {{ a, b, c }};
+        const auto A = 0.5 * (mesh.vertices[b] - mesh.vertices[a]).Cross(mesh.vertices[c] - mesh.vertices[a]).length();
+        if(!(0.0 < A)) return;
+        for(size_t k = 0; k < 3; ++k){
+            // The angle at v[k] is opposite the edge joining the other two vertices.
+            const auto i = v[(k + 1) % 3];
+            const auto j = v[(k + 2) % 3];
+            const auto e1 = mesh.vertices[i] - mesh.vertices[v[k]];
+            const auto e2 = mesh.vertices[j] - mesh.vertices[v[k]];
+            const auto cot = e1.Dot(e2) / e1.Cross(e2).length();
+            laplacian[i] += (mesh.vertices[j] - mesh.vertices[i]) * (0.5 * cot);
+            laplacian[j] += (mesh.vertices[i] - mesh.vertices[j]) * (0.5 * cot);
+            area[v[k]] += A / 3.0;
+        }
+    });
+
+    const auto normals = vertex_normals(mesh);
+    auto H = vertex_attributes.add<double>(vertex_mean_curvature);
+    for(size_t i = 0; i < N; ++i){
+        // The Laplacian approximates -2 H n, where n is the unit normal.
+        H[i] = (0.0 < area[i]) ? -0.5 * laplacian[i].Dot(normals[i]) / area[i] : 0.0;
+    }
+}
+
+void Refresh_Geometry_Caches(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes){
+    if( vertex_attributes.contains(vertex_normal_x)
+    ||  vertex_attributes.contains(vertex_normal_y)
+    ||  vertex_attributes.contains(vertex_normal_z) ){
+        Cache_Vertex_Normals(mesh, vertex_attributes);
+    }
+    if(vertex_attributes.contains(vertex_mean_curvature)){
+        Cache_Vertex_Curvature(mesh, vertex_attributes);
+    }
+}
+
+
+connectivity_change::connectivity_change(fv_surface_mesh<double, uint64_t> &mesh,
+                                         attribute_store &vertex_attributes,
+                                         attribute_store &face_attributes,
+                                         transfer_routine transfer)
+    : mesh(mesh), vertex_attributes(vertex_attributes), face_attributes(face_attributes), transfer(transfer),
+      active(!vertex_attributes.empty() || !face_attributes.empty()) {
+    if(this->active) this->orig_mesh = this->mesh;
+}
+
+connectivity_change::~connectivity_change(){
+    if(this->active) this->mesh = std::move(this->orig_mesh);
+}
+
+void connectivity_change::commit(void){
+    if(!this->active) return;
+
+    attribute_store new_vertex_attributes;
+    attribute_store new_face_attributes;
+    this->transfer( this->orig_mesh,
+                    this->vertex_attributes,
+                    this->face_attributes,
+                    this->mesh,
+                    new_vertex_attributes,
+                    new_face_attributes );
+    this->vertex_attributes = std::move(new_vertex_attributes);
+    this->face_attributes = std::move(new_face_attributes);
+
+    this->active = false;
+    this->orig_mesh = fv_surface_mesh<double, uint64_t>();
+}
+
+
+// PLY property names must be distinct from the mandatory properties and from each other.
+static bool has_valid_ply_names(const attribute_store &attrs, const std::vector<std::string> &reserved){
+    for(const auto &p : attrs.get_columns()){
+        if(!Is_Valid_Name(p.first)) return false;
+        if(std::find(std::begin(reserved), std::end(reserved), p.first) != std::end(reserved)) return false;
+    }
+    return true;
+}
+
+// PLY has no 64-bit integer type, so integer columns are written as 32-bit 'int' properties. Returns false if any value
+// would not survive the narrowing.
+static bool fits_ply_int(const attribute_store &attrs){
+    for(const auto &p : attrs.get_columns()){
+        const auto *v = std::get_if<std::vector<int64_t>>(&p.second);
+        if(v == nullptr) continue;
+        for(const auto &x : *v){
+            if( (x < std::numeric_limits<int32_t>::min()) || (std::numeric_limits<int32_t>::max() < x) ) return false;
+        }
+    }
+    return true;
+}
+
+// Emits property declarations for each column.
+static void write_ply_properties(const attribute_store &attrs, std::ostream &os){
+    for(const auto &p : attrs.get_columns()){
+        const char *type = std::visit([](const auto &v) -> const char * {
+            using T = typename std::remove_cv_t<std::remove_reference_t<decltype(v)>>::value_type;
+            if constexpr (std::is_same_v<T, float>) return "float";
+            if constexpr (std::is_same_v<T, double>) return "double";
+            return "int";
+        }, p.second);
+        os << "property " << type << " " << p.first << "\n";
+    }
+}
+
+// Emits the values of each column for a single element.
+static void write_ply_values(const attribute_store &attrs, size_t i, std::ostream &os){
+    for(const auto &p : attrs.get_columns()){
+        std::visit([&](const auto &v){ os << " " << v[i]; }, p.second);
+    }
+}
+
+bool Write_PLY(const fv_surface_mesh<double, uint64_t> &mesh,
+               const attribute_store &vertex_attributes,
+               const attribute_store &face_attributes,
+               std::ostream &os){
+    const auto N_verts = mesh.vertices.size();
+    const auto N_faces = mesh.faces.size();
+    const bool has_vert_attrs = !vertex_attributes.empty();
+    const bool has_face_attrs = !face_attributes.empty();
+    if( (has_vert_attrs && (vertex_attributes.size() != N_verts))
+    ||  (has_face_attrs && (face_attributes.size() != N_faces)) ){
+        return false;
+    }
+    for(const auto &f : mesh.faces){
+        if(255 < f.size()) return false; // Face vertex counts are written as 'uchar'.
+    }
+    if( (static_cast<uint64_t>(std::numeric_limits<int32_t>::max()) < N_verts) // Vertex indices are written as 'int'.
+    ||  !fits_ply_int(vertex_attributes)
+    ||  !fits_ply_int(face_attributes) ){
+        return false;
+    }
+    if( !has_valid_ply_names(vertex_attributes, { "x", "y", "z" })
+    ||  !has_valid_ply_names(face_attributes, { "vertex_indices" }) ){
+        return false;
+    }
+
+    const auto orig_precision = os.precision();
+    os.precision(17);
+
+    os << "ply\n"
+       << "format ascii 1.0\n"
+       << "comment Written by DICOMautomaton\n"
+       << "element vertex " << N_verts << "\n"
+       << "property double x\n"
+       << "property double y\n"
+       << "property double z\n";
+    write_ply_properties(vertex_attributes, os);
+    os << "element face " << N_faces << "\n"
+       << "property list uchar int vertex_indices\n";
+    write_ply_properties(face_attributes, os);
+    os << "end_header\n";
+
+    for(size_t i = 0; i < N_verts; ++i){
+        const auto &v = mesh.vertices[i];
+        os << v.x << " " << v.y << " " << v.z;
+        if(has_vert_attrs) write_ply_values(vertex_attributes, i, os);
+        os << "\n";
+    }
+    for(size_t i = 0; i < N_faces; ++i){
+        const auto &f = mesh.faces[i];
+        os << f.size();
+        for(const auto &j : f) os << " " << j;
+        if(has_face_attrs) write_ply_values(face_attributes, i, os);
+        os << "\n";
+    }
+
+    os.precision(orig_precision);
+    os.flush();
+    return (!os.fail());
+}
+
+} // namespace mesh_attributes
+
@@ -0,0 +1,203 @@
+//Mesh_Attributes.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "YgorMath.h"
+
+// Typed, columnar storage for per-vertex or per-face surface mesh attributes.
+//
+// Each attribute is a named column holding one value per element in a single contiguous array. Supported element types
+// are float, double, and int64_t. All columns in a store share the same length, so elements are addressed by the same
+// index as the mesh vertex or face they describe.
+//
+// Stores are move-only so that attributes are transferred rather than copied by accident. Deep copies must be requested
+// explicitly via clone().
+namespace mesh_attributes {
+
+using column = std::variant< std::vector<float>,
+                             std::vector<double>,
+                             std::vector<int64_t> >;
+
+// Attribute names must be non-empty and consist only of printable, non-whitespace ASCII characters so that they can be
+// written as PLY property names.
+bool Is_Valid_Name(const std::string &name);
+
+template <class T>
+constexpr bool is_supported_type = std::is_same_v<T, float>
+                                || std::is_same_v<T, double>
+                                || std::is_same_v<T, int64_t>;
+
+// A non-owning view of a column. Views are invalidated when the column is resized, replaced, or erased.
+template <class T>
+class column_view {
+    T *ptr = nullptr;
+    size_t N = 0;
+
+  public:
+    column_view(T *p, size_t n) : ptr(p), N(n) {}
+
+    size_t size(void) const { return this->N; }
+    bool empty(void) const { return (this->N == 0); }
+    T *data(void) const { return this->ptr; }
+    T *begin(void) const { return this->ptr; }
+    T *end(void) const { return this->ptr + this->N; }
+    T &operator[](size_t i) const { return this->ptr[i]; }
+};
+
+class attribute_store {
+    size_t N = 0;
+    std::map<std::string, column> columns;
+
+  public:
+    attribute_store() = default;
+    attribute_store(const attribute_store &) = delete;
+    attribute_store &operator=(const attribute_store &) = delete;
+    attribute_store(attribute_store &&) = default;
+    attribute_store &operator=(attribute_store &&) = default;
+
+    // Returns a deep copy.
+    attribute_store clone(void) const;
+
+    // The number of elements in every column.
+    size_t size(void) const { return this->N; }
+
+    // Changes the number of elements in every column. New elements are zero.
+    void resize(size_t n);
+
+    // Removes all columns and resets the number of elements.
+    void clear(void);
+
+    bool empty(void) const { return this->columns.empty(); }
+    bool contains(const std::string &name) const { return (this->columns.count(name) != 0); }
+    void erase(const std::string &name){ this->columns.erase(name); }
+    std::vector<std::string> names(void) const;
+
+    // Creates a column filled with the given value, replacing any existing column with the same name.
+    template <class T>
+    column_view<T> add(const std::string &name, T fill = T()){
+        static_assert(is_supported_type<T>, "Unsupported attribute type");
+        if(!Is_Valid_Name(name)) throw std::invalid_argument("Invalid attribute name '" + name + "'");
+        auto &c = this->columns[name];
+        c = std::vector<T>(this->N, fill);
+        auto &v = std::get<std::vector<T>>(c);
+        return column_view<T>(v.data(), v.size());
+    }
+
+    // Adopts an existing array as a column, replacing any existing column with the same name. The array must have
+    // exactly size() elements, unless the store has no columns, in which case the array defines size().
+    template <class T>
+    void adopt(const std::string &name, std::vector<T> &&values){
+        static_assert(is_supported_type<T>, "Unsupported attribute type");
+        if(!Is_Valid_Name(name)) throw std::invalid_argument("Invalid attribute name '" + name + "'");
+        if(this->columns.empty()) this->N = values.size();
+        if(values.size() != this->N){
+            throw std::invalid_argument("Attribute column length does not match the number of elements");
+        }
+        this->columns[name] = std::move(values);
+    }
+
+    // Returns a view of the named column, or nothing if the column does not exist or holds another type.
+    template <class T>
+    std::optional<column_view<T>> get(const std::string &name){
+        static_assert(is_supported_type<T>, "Unsupported attribute type");
+        auto it = this->columns.find(name);
+        if( (it == std::end(this->columns)) || !std::holds_alternative<std::vector<T>>(it->second) ) return {};
+        auto &v = std::get<std::vector<T>>(it->second);
+        return column_view<T>(v.data(), v.size());
+    }
+    template <class T>
+    std::optional<column_view<const T>> get(const std::string &name) const {
+        static_assert(is_supported_type<T>, "Unsupported attribute type");
+        auto it = this->columns.find(name);
+        if( (it == std::end(this->columns)) || !std::holds_alternative<std::vector<T>>(it->second) ) return {};
+        const auto &v = std::get<std::vector<T>>(it->second);
+        return column_view<const T>(v.data(), v.size());
+    }
+
+    // Provides direct access to the columns, e.g., for visiting every column regardless of type.
+    const std::map<std::string, column> &get_columns(void) const { return this->columns; }
+
+    // Returns a store with one element for each index, copied from the corresponding element of this store.
+    attribute_store gather(const std::vector<size_t> &indices) const;
+};
+
+
+// Optional geometry caches. These are ordinary attribute columns with reserved names, so they are carried wherever the
+// rest of the attributes are. They must be refreshed whenever the mesh geometry changes.
+extern const std::string vertex_normal_x;
+extern const std::string vertex_normal_y;
+extern const std::string vertex_normal_z;
+extern const std::string vertex_mean_curvature;
+
+bool Is_Geometry_Cache(const std::string &name);
+
+// Computes area-weighted vertex normals and stores them as double columns. Polygonal faces are fan-triangulated.
+void Cache_Vertex_Normals(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes);
+
+// Estimates the mean curvature at each vertex using the cotangent Laplacian and stores it as a double column. Convex
+// regions are positive when faces are oriented outward, e.g., everywhere on a sphere.
+void Cache_Vertex_Curvature(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes);
+
+// Recomputes whichever geometry caches are present.
+void Refresh_Geometry_Caches(const fv_surface_mesh<double, uint64_t> &mesh, attribute_store &vertex_attributes);
+
+
+// Carries attributes across an operation that replaces the mesh connectivity, e.g., remeshing or subdivision.
+//
+// The original mesh is retained on construction whenever attributes are present. commit() resamples the attributes
+// onto the (now altered) mesh using the provided transfer routine and swaps them into the stores. If the operation
+// is abandoned, e.g., because an exception was thrown, the original mesh is restored on destruction so that the mesh
+// and its attributes remain consistent.
+class connectivity_change {
+  public:
+    using transfer_routine = void (*)(const fv_surface_mesh<double, uint64_t> &src_mesh,
+                                      const attribute_store &src_vertex_attributes,
+                                      const attribute_store &src_face_attributes,
+                                      const fv_surface_mesh<double, uint64_t> &dst_mesh,
+                                      attribute_store &dst_vertex_attributes,
+                                      attribute_store &dst_face_attributes);
+
+  private:
+    fv_surface_mesh<double, uint64_t> &mesh;
+    attribute_store &vertex_attributes;
+    attribute_store &face_attributes;
+    transfer_routine transfer;
+
+    bool active;
+    fv_surface_mesh<double, uint64_t> orig_mesh;
+
+  public:
+    connectivity_change(fv_surface_mesh<double, uint64_t> &mesh,
+                        attribute_store &vertex_attributes,
+                        attribute_store &face_attributes,
+                        transfer_routine transfer);
+    connectivity_change(const connectivity_change &) = delete;
+    connectivity_change &operator=(const connectivity_change &) = delete;
+    ~connectivity_change();
+
+    // Resamples the attributes onto the current mesh. Must be called at most once, after the mesh has been altered.
+    void commit(void);
+};
+
+
+// Writes the mesh in ASCII PLY format, including all vertex and face attributes as element properties.
+// PLY has no 64-bit integer type, so int64_t columns are written as 'int'. Returns false, without writing anything, if
+// any integer attribute value lies outside the 32-bit range or if any attribute name is not a valid PLY property name.
+bool Write_PLY(const fv_surface_mesh<double, uint64_t> &mesh,
+               const attribute_store &vertex_attributes,
+               const attribute_store &face_attributes,
+               std::ostream &os);
+
+} // namespace mesh_attributes
+
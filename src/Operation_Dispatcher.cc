@@ -26,12 +26,14 @@
 #include "Operations/AnalyzePicketFence.h"
 #include "Operations/AnalyzeTPlan.h"
 #include "Operations/ApplyCalibrationCurve.h"
+#include "Operations/ApplyROIMargins.h"
 #include "Operations/AutoCropImages.h"
 #include "Operations/Average.h"
 #include "Operations/BoostSerializeDrover.h"
 #include "Operations/BuildLexiconInteractively.h"
 #include "Operations/ClusterDBSCAN.h"
 #include "Operations/ComparePixels.h"
+#include "Operations/ConnectedComponentFilter.h"
 #include "Operations/ContourBasedRayCastDoseAccumulate.h"
 #include "Operations/ContourSimilarity.h"
 #include "Operations/ContourViaGeometry.h"
@@ -127,6 +129,7 @@
 #include "Operations/PruneEmptyImageDoseArrays.h"
 #include "Operations/PurgeContours.h"
 #include "Operations/RankPixels.h"
+#include "Operations/RasterizeMLCFluence.h"
 #include "Operations/ReduceNeighbourhood.h"
 #include "Operations/ScalePixels.h"
 #include "Operations/SelectSlicesIntersectingROI.h"
@@ -142,6 +145,7 @@
 #include "Operations/ThresholdImages.h"
 #include "Operations/ThresholdOtsu.h"
 #include "Operations/TransformContours.h"
+#include "Operations/TransformImages.h"
 #include "Operations/TransformMeshes.h"
 #include "Operations/TrimROIDose.h"
 #include "Operations/UBC3TMRI_DCE.h"
@@ -201,12 +205,14 @@ std::map<std::string, op_packet_t> Known_Operations(void){
     out["AnalyzePicketFence"] = std::make_pair(OpArgDocAnalyzePicketFence, AnalyzePicketFence);
     out["AnalyzeTPlan"] = std::make_pair(OpArgDocAnalyzeTPlan, AnalyzeTPlan);
     out["ApplyCalibrationCurve"] = std::make_pair(OpArgDocApplyCalibrationCurve, ApplyCalibrationCurve);
+    out["ApplyROIMargins"] = std::make_pair(OpArgDocApplyROIMargins, ApplyROIMargins);
     out["AutoCropImages"] = std::make_pair(OpArgDocAutoCropImages, AutoCropImages);
     out["Average"] = std::make_pair(OpArgDocAverage, Average);
     out["BoostSerializeDrover"] = std::make_pair(OpArgDocBoost_Serialize_Drover, Boost_Serialize_Drover);
     out["BuildLexiconInteractively"] = std::make_pair(OpArgDocBuildLexiconInteractively, BuildLexiconInteractively);
     out["ClusterDBSCAN"] = std::make_pair(OpArgDocClusterDBSCAN, ClusterDBSCAN);
     out["ComparePixels"] = std::make_pair(OpArgDocComparePixels, ComparePixels);
+    out["ConnectedComponentFilter"] = std::make_pair(OpArgDocConnectedComponentFilter, ConnectedComponentFilter);
     out["ContourBasedRayCastDoseAccumulate"] = std::make_pair(OpArgDocContourBasedRayCastDoseAccumulate, ContourBasedRayCastDoseAccumulate);
     out["ContourSimilarity"] = std::make_pair(OpArgDocContourSimilarity, ContourSimilarity);
     out["ContourViaGeometry"] = std::make_pair(OpArgDocContourViaGeometry, ContourViaGeometry);
@@ -302,6 +308,7 @@ std::map<std::string, op_packet_t> Known_Operations(void){
     out["PruneEmptyImageDoseArrays"] = std::make_pair(OpArgDocPruneEmptyImageDoseArrays, PruneEmptyImageDoseArrays);
     out["PurgeContours"] = std::make_pair(OpArgDocPurgeContours, PurgeContours);
     out["RankPixels"] = std::make_pair(OpArgDocRankPixels, RankPixels);
+    out["RasterizeMLCFluence"] = std::make_pair(OpArgDocRasterizeMLCFluence, RasterizeMLCFluence);
     out["ReduceNeighbourhood"] = std::make_pair(OpArgDocReduceNeighbourhood, ReduceNeighbourhood);
     out["ScalePixels"] = std::make_pair(OpArgDocScalePixels, ScalePixels);
     out["SelectSlicesIntersectingROI"] = std::make_pair(OpArgDocSelectSlicesIntersectingROI, SelectSlicesIntersectingROI);
@@ -317,6 +324,7 @@ std::map<std::string, op_packet_t> Known_Operations(void){
     out["ThresholdImages"] = std::make_pair(OpArgDocThresholdImages, ThresholdImages);
     out["ThresholdOtsu"] = std::make_pair(OpArgDocThresholdOtsu, ThresholdOtsu);
     out["TransformContours"] = std::make_pair(OpArgDocTransformContours, TransformContours);
+    out["TransformImages"] = std::make_pair(OpArgDocTransformImages, TransformImages);
     out["TransformMeshes"] = std::make_pair(OpArgDocTransformMeshes, TransformMeshes);
     out["TrimROIDose"] = std::make_pair(OpArgDocTrimROIDose, TrimROIDose);
     out["UBC3TMRI_DCE"] = std::make_pair(OpArgDocUBC3TMRI_DCE, UBC3TMRI_DCE);
@@ -390,6 +398,9 @@ bool Operation_Dispatcher( Drover &DICOM_data,
 
                     FUNCINFO("Performing operation '" << op_func.first << "' now..");
                     DICOM_data = op_func.second.second(DICOM_data, optargs, InvocationMetadata, FilenameLex);
+
+                    //Operations can alter contours directly, so cached contour indices must be refreshed.
+                    if(DICOM_data.contour_data != nullptr) DICOM_data.contour_data->Mark_Modified();
                 }
             }
             if(!WasFound) throw std::invalid_argument("No operation matched '" + optargs.getName() + "'");
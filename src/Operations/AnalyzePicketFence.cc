@@ -5,6 +5,7 @@
 #include <array>
 #include <cmath>
 #include <cstdlib>            //Needed for exit() calls.
+#include <exception>
 #include <optional>
 #include <fstream>
 #include <functional>
@@ -14,6 +15,7 @@
 #include <map>
 #include <memory>
 #include <regex>
+#include <sstream>
 #include <stdexcept>
 #include <string>    
 #include <vector>
@@ -22,6 +24,7 @@
 #include "../Insert_Contours.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "../Write_File.h"
 #include "AnalyzePicketFence.h"
 #include "YgorImages.h"
@@ -31,6 +34,42 @@
 #include "YgorStats.h"        //Needed for Stats:: namespace.
 
 
+namespace {
+
+using PF_Shuttles = std::vector< YgorMathPlottingGnuplot::Shuttle<samples_1D<double>> >;
+
+// Geometry that is detected from a picket fence image, but that can be re-used for other images acquired on the same
+// machine, with the same beam energy, and with the same imaging geometry.
+struct PF_Geometry {
+    double CollimatorCompensation = std::numeric_limits<double>::quiet_NaN();
+
+    std::map<long int, line<double>> junction_lines;
+    std::map<long int, double> junction_cax_separations;
+    std::map<long int, double> junction_separations;
+    double min_junction_sep = std::numeric_limits<double>::quiet_NaN();
+    double max_junction_sep = std::numeric_limits<double>::quiet_NaN();
+};
+
+// The outcome of analyzing a single image. Nothing is shared between images, so images can be analyzed concurrently
+// and the results emitted afterward.
+struct PF_Result {
+    std::string leaf_gaps;  // CSV rows.
+    std::string summary;    // CSV rows.
+
+    std::list<contours_with_meta> peak_contours;
+    std::list<contours_with_meta> leaf_pair_contours;
+    std::list<contours_with_meta> junction_contours;
+
+    PF_Shuttles leaf_plot_shtl;
+    PF_Shuttles junction_plot_shtl;
+
+    std::optional<PF_Geometry> geometry;
+    std::exception_ptr error;
+};
+
+} // namespace
+
+
 OperationDoc OpArgDocAnalyzePicketFence(void){
     OperationDoc out;
     out.name = "AnalyzePicketFence";
@@ -156,6 +195,19 @@ OperationDoc OpArgDocAnalyzePicketFence(void){
     out.args.back().examples = { "", "Using XYZ", "Patient treatment plan C" };
 
 
+    out.args.emplace_back();
+    out.args.back().name = "BatchMode";
+    out.args.back().desc = "Whether to analyze all selected images concurrently."
+                      " Images are grouped by machine, beam energy, and imaging geometry (e.g., collimator angle,"
+                      " SID, and image extent). The junctions and any uncompensated collimator rotation are"
+                      " detected using the first image in each group and re-used for the remaining images in the"
+                      " group, so only leaf profiles and peaks are extracted for each image."
+                      " Note that junction positions are therefore not re-detected for every image.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
+
+
     out.args.emplace_back();
     out.args.back().name = "InteractivePlots";
     out.args.back().desc = "Whether to interactively show plots showing detected edges.";
@@ -173,7 +225,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
 
-    auto MLCModel = OptArgs.getValueStr("MLCModel").value();
+    const auto MLCModelStr = OptArgs.getValueStr("MLCModel").value();
 
     const auto MLCROILabel = OptArgs.getValueStr("MLCROILabel").value();
     const auto JunctionROILabel = OptArgs.getValueStr("JunctionROILabel").value();
@@ -188,6 +240,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
+    const auto BatchModeStr = OptArgs.getValueStr("BatchMode").value();
     const auto InteractivePlotsStr = OptArgs.getValueStr("InteractivePlots").value();
 
     //-----------------------------------------------------------------------------------------------------------------
@@ -201,6 +254,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
     const auto NormalizedJunctionROILabel = X(JunctionROILabel);
     const auto NormalizedPeakROILabel = X(PeakROILabel);
 
+    const auto BatchMode = std::regex_match(BatchModeStr, regex_true);
     const auto InteractivePlots = std::regex_match(InteractivePlotsStr, regex_true);
 
     auto IAs_all = All_IAs( DICOM_data );
@@ -209,10 +263,19 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         throw std::invalid_argument("No image arrays selected. Cannot continue.");
     }
 
+    std::vector<std::shared_ptr<Image_Array>> ias;
     for(auto & iap_it : IAs){
         if((*iap_it)->imagecoll.images.empty()) throw std::invalid_argument("Unable to find an image to analyze.");
+        ias.emplace_back(*iap_it);
+    }
 
-        planar_image<float, double> *animg = &( (*iap_it)->imagecoll.images.front() );
+    // Analyzes a single image. Only the given image is accessed and all outputs are written to the result, so this
+    // routine can safely be invoked concurrently for distinct images. If seed geometry is provided, junction and
+    // collimator rotation detection are skipped.
+    const auto analyze_image = [&](const std::shared_ptr<Image_Array> &ia_ptr,
+                                   const PF_Geometry *seed,
+                                   PF_Result &result) -> void {
+        planar_image<float, double> *animg = &( ia_ptr->imagecoll.images.front() );
         const auto row_unit = animg->row_unit;
         const auto col_unit = animg->col_unit;
         //const auto ort_unit = row_unit.Cross(col_unit);
@@ -279,6 +342,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         //---------------------------------------------------------------------------
         //Auto-detect the MLC model, if possible.
         const auto StationName = animg->GetMetadataValueAs<std::string>("StationName").value_or("Unknown");
+        auto MLCModel = MLCModelStr;
         {
             const auto regex_FVAREA2TB = Compile_Regex(".*FVAREA2TB.*");
             const auto regex_FVAREA4TB = Compile_Regex(".*FVAREA4TB.*");
@@ -345,7 +409,8 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         };
 
         PF_Context PFC;
-        PFC.CollimatorCompensation = std::numeric_limits<double>::quiet_NaN();
+        PFC.CollimatorCompensation = (seed == nullptr) ? std::numeric_limits<double>::quiet_NaN()
+                                                       : seed->CollimatorCompensation;
 
 
         // This is the core routine for extracting the position of MLC leaves along junctions.
@@ -533,7 +598,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
             //---------------------------------------------------------------------------
             // Detect junctions.
             PFC.junction_lines.clear();
-            {
+            if(seed == nullptr){
                 samples_1D<double> avgd_profile;
                 size_t N_visible_leaves = 0;
                 for(auto & profile_p : PFC.leaf_profiles){
@@ -689,7 +754,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
             PFC.junction_separations.clear();
             PFC.min_junction_sep = std::numeric_limits<double>::quiet_NaN();
             PFC.max_junction_sep = std::numeric_limits<double>::quiet_NaN();
-            {
+            if(seed == nullptr){
                 using j_lines_t = decltype(PF_Context::junction_lines);
 
                 const auto p_lt = [](std::pair<PF_Context::j_num, double> A,
@@ -772,6 +837,12 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
                 std::cout << "Minimum junction separation: " << (PFC.min_junction_sep * SIDToSAD) << std::endl;
                 std::cout << "Maximum junction separation: " << (PFC.max_junction_sep * SIDToSAD) << std::endl;
 
+            }else{
+                PFC.junction_lines = seed->junction_lines;
+                PFC.junction_cax_separations = seed->junction_cax_separations;
+                PFC.junction_separations = seed->junction_separations;
+                PFC.min_junction_sep = seed->min_junction_sep;
+                PFC.max_junction_sep = seed->max_junction_sep;
             }
 
 
@@ -941,6 +1012,15 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
             Extract_Leaf_Positions();
         }
 
+        // Record the detected geometry so it can be re-used for similar images.
+        result.geometry.emplace();
+        result.geometry->CollimatorCompensation = PFC.CollimatorCompensation;
+        result.geometry->junction_lines = PFC.junction_lines;
+        result.geometry->junction_cax_separations = PFC.junction_cax_separations;
+        result.geometry->junction_separations = PFC.junction_separations;
+        result.geometry->min_junction_sep = PFC.min_junction_sep;
+        result.geometry->max_junction_sep = PFC.max_junction_sep;
+
         //---------------------------------------------------------------------------
         // Compare peak locations.
         PFC.leaf_line_colour.clear();
@@ -1001,31 +1081,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
                 }
 
                 //Report findings about this leaf-pair.
-                FUNCINFO("Attempting to claim a mutex");
-                try{
-                    auto gen_filename = [&](void) -> std::string {
-                        if(LeafGapsFileName.empty()){
-                            LeafGapsFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_evaluatepf_", 6, ".csv");
-                        }
-                        return LeafGapsFileName;
-                    };
-
-                    std::stringstream header;
-                    header << "PatientID,"
-                           << "StationName,"
-                           << "LeafNumber,"
-
-                           << "\"max |actual-nominal| position\","
-                           << "\"mean (actual-nominal) position\","
-                           << "\"Pass abs. sep. threshold?\","
-
-                           << "\"max |adjacent difference|\","
-                           << "\"mean (adjacent difference)\","
-                           << "\"Pass adj. diff. threshold?\","
-
-                           << "UserComment" // Keep this column even if empty so we can append/concat files.
-                           << std::endl;
-
+                {
                     std::stringstream body;
                     body << PatientID << ","
                          << StationName << ","
@@ -1041,17 +1097,9 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
 
                          << UserComment.value_or("")
                          << std::endl;
-
-                    Append_File( gen_filename,
-                                 "dicomautomaton_operation_analyzepicketfence_mutex",
-                                 header.str(),
-                                 body.str() );
-
-                }catch(const std::exception &e){
-                    FUNCERR("Unable to write to output file: '" << e.what() << "'");
+                    result.leaf_gaps += body.str();
                 }
 
-
                 //Record whether this leaf passed or failed visually.
                 if( within_abs_sep && within_adj_diff ){
                     PFC.leaf_line_colour[leaf_num] = "blue";
@@ -1069,20 +1117,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
 
 
         //Report a summary.
-        FUNCINFO("Attempting to claim a mutex");
-        try{
-            auto gen_filename = [&](void) -> std::string {
-                if(ResultsSummaryFileName.empty()){
-                    ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_pfsummary_", 6, ".csv");
-                }
-                return ResultsSummaryFileName;
-            };
-
-            std::stringstream header;
-            header << "Quantity,"
-                   << "Result"
-                   << std::endl;
-
+        {
             std::stringstream body;
             body << "Patient ID,"
                  << PatientID
@@ -1108,14 +1143,7 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
             body << "Detected uncompensated rotation (degrees),"
                  << PFC.CollimatorCompensation
                  << std::endl;
-
-            Append_File( gen_filename,
-                         "dicomautomaton_operation_analyzepicketfence_mutex",
-                         header.str(),
-                         body.str() );
-
-        }catch(const std::exception &e){
-            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+            result.summary += body.str();
         }
 
         //---------------------------------------------------------------------------
@@ -1198,29 +1226,174 @@ Drover AnalyzePicketFence(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         }
 
 
-        //---------------------------------------------------------------------------
-        //Display some interactive plots.
-        if(InteractivePlots){
+        // Hand over the outputs. Plots and contours are emitted once all images have been analyzed.
+        result.leaf_plot_shtl = PFC.leaf_plot_shtl;
+        result.junction_plot_shtl = PFC.junction_plot_shtl;
+        result.peak_contours.splice( result.peak_contours.end(), PFC.peak_contours );
+        result.leaf_pair_contours.splice( result.leaf_pair_contours.end(), PFC.leaf_pair_contours );
+        result.junction_contours.splice( result.junction_contours.end(), PFC.junction_contours );
+        return;
+    };
+
+    std::vector<PF_Result> results(ias.size());
+    if(!BatchMode){
+        for(size_t i = 0; i < ias.size(); ++i){
+            analyze_image(ias[i], nullptr, results[i]);
+        }
+
+    }else{
+        // Group images that can share junction and collimator rotation geometry.
+        const auto group_key = [](const planar_image<float, double> &img) -> std::string {
+            std::stringstream ss;
+            ss.precision(std::numeric_limits<double>::max_digits10);
+            for(const auto &key : { "StationName", "RadiationMachineName", "KVP", "RTImageSID", "RadiationMachineSAD",
+                                    "IsocenterPosition", "BeamLimitingDeviceAngle" }){
+                ss << img.GetMetadataValueAs<std::string>(key).value_or("") << ";";
+            }
+            ss << img.rows << ";" << img.columns << ";" << img.pxl_dx << ";" << img.pxl_dy << ";"
+               << img.offset << ";" << img.row_unit << ";" << img.col_unit;
+            return ss.str();
+        };
+        std::map<std::string, std::vector<size_t>> groups;
+        for(size_t i = 0; i < ias.size(); ++i){
+            groups[ group_key(ias[i]->imagecoll.images.front()) ].push_back(i);
+        }
+        FUNCINFO("Analyzing " << ias.size() << " images in " << groups.size() << " group(s)");
+
+        // Each task is isolated; exceptions are captured and re-thrown in order once all tasks have completed.
+        const auto analyze_concurrently = [&](const std::vector<std::pair<size_t, const PF_Geometry *>> &jobs) -> void {
+            {
+                asio_thread_pool tp;
+                for(const auto &job : jobs){
+                    tp.submit_task([&,job](void) -> void {
+                        try{
+                            analyze_image(ias[job.first], job.second, results[job.first]);
+                        }catch(const std::exception &){
+                            results[job.first].error = std::current_exception();
+                        }
+                    }); // thread pool task closure.
+                }
+            } // Wait for all tasks to complete.
+
+            for(const auto &job : jobs){
+                if(results[job.first].error) std::rethrow_exception(results[job.first].error);
+            }
+            return;
+        };
+
+        // Fully analyze the first image in each group, and then analyze the remainder using the detected geometry.
+        std::vector<std::pair<size_t, const PF_Geometry *>> jobs;
+        for(const auto &g : groups){
+            jobs.emplace_back( g.second.front(), nullptr );
+        }
+        analyze_concurrently(jobs);
+
+        jobs.clear();
+        for(const auto &g : groups){
+            const auto &ref = results[g.second.front()];
+            const PF_Geometry *seed = (ref.geometry) ? &(ref.geometry.value()) : nullptr;
+            for(auto it = std::next(std::begin(g.second)); it != std::end(g.second); ++it){
+                jobs.emplace_back( *it, seed );
+            }
+        }
+        analyze_concurrently(jobs);
+    }
 
+    //---------------------------------------------------------------------------
+    // Write the results. All rows are appended at once so the file is only locked once.
+    std::string leaf_gaps;
+    std::string summary;
+    for(const auto &result : results){
+        leaf_gaps += result.leaf_gaps;
+        summary += result.summary;
+    }
+
+    if(!leaf_gaps.empty()){
+        FUNCINFO("Attempting to claim a mutex");
+        try{
+            auto gen_filename = [&](void) -> std::string {
+                if(LeafGapsFileName.empty()){
+                    LeafGapsFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_evaluatepf_", 6, ".csv");
+                }
+                return LeafGapsFileName;
+            };
+
+            std::stringstream header;
+            header << "PatientID,"
+                   << "StationName,"
+                   << "LeafNumber,"
+
+                   << "\"max |actual-nominal| position\","
+                   << "\"mean (actual-nominal) position\","
+                   << "\"Pass abs. sep. threshold?\","
+
+                   << "\"max |adjacent difference|\","
+                   << "\"mean (adjacent difference)\","
+                   << "\"Pass adj. diff. threshold?\","
+
+                   << "UserComment" // Keep this column even if empty so we can append/concat files.
+                   << std::endl;
+
+            Append_File( gen_filename,
+                         "dicomautomaton_operation_analyzepicketfence_mutex",
+                         header.str(),
+                         leaf_gaps );
+
+        }catch(const std::exception &e){
+            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+        }
+    }
+
+    if(!summary.empty()){
+        FUNCINFO("Attempting to claim a mutex");
+        try{
+            auto gen_filename = [&](void) -> std::string {
+                if(ResultsSummaryFileName.empty()){
+                    ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_pfsummary_", 6, ".csv");
+                }
+                return ResultsSummaryFileName;
+            };
+
+            std::stringstream header;
+            header << "Quantity,"
+                   << "Result"
+                   << std::endl;
+
+            Append_File( gen_filename,
+                         "dicomautomaton_operation_analyzepicketfence_mutex",
+                         header.str(),
+                         summary );
+
+        }catch(const std::exception &e){
+            FUNCERR("Unable to write to output file: '" << e.what() << "'");
+        }
+    }
+
+    //---------------------------------------------------------------------------
+    //Display some interactive plots.
+    if(InteractivePlots){
+        for(auto &result : results){
             // Plot leaf-pair profiles that were over tolerance.
             if(true){
-                YgorMathPlottingGnuplot::Plot<double>(PFC.leaf_plot_shtl, "Failed leaf-pair profiles", "DICOM position", "Pixel Intensity");
+                YgorMathPlottingGnuplot::Plot<double>(result.leaf_plot_shtl, "Failed leaf-pair profiles", "DICOM position", "Pixel Intensity");
             }
 
             // Plot junction profiles.
             if(false){
-                YgorMathPlottingGnuplot::Plot<double>(PFC.junction_plot_shtl, "Junction profiles", "DICOM position", "Pixel Intensity");
+                YgorMathPlottingGnuplot::Plot<double>(result.junction_plot_shtl, "Junction profiles", "DICOM position", "Pixel Intensity");
             }
         }
+    }
 
-        // Insert contours.
-        if(DICOM_data.contour_data == nullptr){
-            std::unique_ptr<Contour_Data> output (new Contour_Data());
-            DICOM_data.contour_data = std::move(output);
-        }
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.peak_contours );
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.leaf_pair_contours );
-        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), PFC.junction_contours );
+    // Insert contours.
+    if(DICOM_data.contour_data == nullptr){
+        std::unique_ptr<Contour_Data> output (new Contour_Data());
+        DICOM_data.contour_data = std::move(output);
+    }
+    for(auto &result : results){
+        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), result.peak_contours );
+        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), result.leaf_pair_contours );
+        DICOM_data.contour_data->ccs.splice( DICOM_data.contour_data->ccs.end(), result.junction_contours );
     }
 
     return DICOM_data;
@@ -0,0 +1,541 @@
+//ApplyROIMargins.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Contour_Collection_Estimates.h"
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
+#include "../YgorImages_Functors/Connected_Components.h"
+#include "../YgorImages_Functors/Distance_Transform.h"
+#include "ApplyROIMargins.h"
+#include "Explicator.h"       //Needed for Explicator class.
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+
+
+namespace {
+
+struct pt2 {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// Contours that share a transverse plane, projected onto it.
+struct contour_plane {
+    double z = 0.0;
+    std::vector<std::vector<pt2>> polygons;
+};
+
+// Marks voxels whose centres fall within any of the polygons. Polygons are filled individually using the even-odd rule,
+// so holes joined to their enclosing contour via a seam are respected, and are then combined via union. Polygon
+// coordinates are in units of voxels.
+void rasterize_plane(const contour_plane &cp, long int nx, long int ny, uint8_t *m){
+    std::vector<double> xs;
+    for(long int j = 0; j < ny; ++j){
+        const auto y = static_cast<double>(j);
+        for(const auto &poly : cp.polygons){
+            xs.clear();
+            const auto N = poly.size();
+            for(size_t i = 0; i < N; ++i){
+                const auto &a = poly[i];
+                const auto &b = poly[(i + 1) % N];
+                if((a.y <= y) != (b.y <= y)){
+                    xs.push_back( a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y) );
+                }
+            }
+            std::sort(std::begin(xs), std::end(xs));
+            for(size_t k = 0; (k + 1) < xs.size(); k += 2){
+                const auto i_lo = std::max<long int>(0L, static_cast<long int>(std::ceil(xs[k])));
+                const auto i_hi = std::min<long int>(nx, static_cast<long int>(std::ceil(xs[k + 1])));
+                for(long int i = i_lo; i < i_hi; ++i) m[j * nx + i] = 1;
+            }
+        }
+    }
+}
+
+// Dilates or erodes the mask in place by the structuring element and returns a field that is non-positive within the
+// result. The field approximates the signed, normalized distance to the boundary of the result, so it can be
+// interpolated to place the boundary more precisely than the voxel grid permits.
+std::vector<float> apply_margin(connected_components::mask_volume &mv,
+                                const std::array<double,3> &spacing,
+                                std::array<distance_transform::axis_extent,3> extents,
+                                bool erode){
+    // Erosion is performed by dilating the complement with the reflected structuring element.
+    if(erode){
+        for(auto &m : mv.mask) m = (m == 0) ? 1 : 0;
+        for(auto &e : extents) std::swap(e.negative, e.positive);
+    }
+    auto field = distance_transform::Anisotropic_Distance_Transform(mv, spacing, extents);
+
+    const auto N = field.size();
+    for(size_t i = 0; i < N; ++i){
+        const auto d = std::sqrt(field[i]);
+        field[i] = (erode) ? (1.0f - d) : (d - 1.0f);
+        mv.mask[i] = (field[i] <= 0.0f) ? 1 : 0;
+    }
+    return field;
+}
+
+// Extracts the zero level set of a field sampled on a regular grid using marching squares. Polygons are oriented
+// counter-clockwise around regions where the field is non-positive. Coordinates are in units of voxels. The field should
+// be positive along the border of the grid so that all polygons close.
+std::vector<std::vector<pt2>> contour_field(const float *phi, long int nx, long int ny){
+    const auto N = static_cast<size_t>(nx) * static_cast<size_t>(ny);
+    const auto val = [&](long int i, long int j) -> double {
+        return std::clamp<double>(phi[j * nx + i], -1.0E6, 1.0E6);
+    };
+
+    // Edges are keyed by the grid point at their lower-left. Horizontal edges join (i,j) and (i+1,j) whereas vertical
+    // edges join (i,j) and (i,j+1).
+    const auto h_edge = [&](long int i, long int j) -> int64_t { return 2 * (j * nx + i); };
+    const auto v_edge = [&](long int i, long int j) -> int64_t { return 2 * (j * nx + i) + 1; };
+
+    std::vector<int64_t> next(2 * N, -1);
+    std::vector<pt2> crossing(2 * N);
+    const auto interpolate = [&](long int ia, long int ja, long int ib, long int jb) -> pt2 {
+        const auto a = val(ia, ja);
+        const auto b = val(ib, jb);
+        const auto t = a / (a - b); // The values straddle zero, so they differ.
+        return { static_cast<double>(ia) + t * static_cast<double>(ib - ia),
+                 static_cast<double>(ja) + t * static_cast<double>(jb - ja) };
+    };
+
+    for(long int j = 0; (j + 1) < ny; ++j){
+        for(long int i = 0; (i + 1) < nx; ++i){
+            // Corners and edges are visited counter-clockwise, starting at the lower-left corner.
+            const std::array<std::array<long int,2>,4> c = {{ {{ i, j }}, {{ i + 1, j }}, {{ i + 1, j + 1 }}, {{ i, j + 1 }} }};
+            const std::array<int64_t,4> e = {{ h_edge(i, j), v_edge(i + 1, j), h_edge(i, j + 1), v_edge(i, j) }};
+            std::array<bool,4> in;
+            for(size_t k = 0; k < 4; ++k) in[k] = (val(c[k][0], c[k][1]) <= 0.0);
+            if( (in[0] == in[1]) && (in[1] == in[2]) && (in[2] == in[3]) ) continue;
+
+            // Crossings alternate between leaving and entering the interior as the cell is traversed.
+            std::array<size_t,4> edge;
+            std::array<bool,4> leaving;
+            size_t n = 0;
+            for(size_t k = 0; k < 4; ++k){
+                const auto l = (k + 1) % 4;
+                if(in[k] == in[l]) continue;
+                crossing[e[k]] = (k < 2) ? interpolate(c[k][0], c[k][1], c[l][0], c[l][1])
+                                         : interpolate(c[l][0], c[l][1], c[k][0], c[k][1]);
+                edge[n] = k;
+                leaving[n] = in[k];
+                ++n;
+            }
+
+            // Each segment runs from where the boundary leaves the interior to where it re-enters, which keeps the
+            // interior on the left. Saddles are resolved using the average of the corners.
+            if(n == 2){
+                const size_t o = (leaving[0]) ? 0 : 1;
+                next[e[edge[o]]] = e[edge[1 - o]];
+            }else{
+                const auto centre = 0.25 * ( val(c[0][0], c[0][1]) + val(c[1][0], c[1][1])
+                                           + val(c[2][0], c[2][1]) + val(c[3][0], c[3][1]) );
+                const bool centre_in = (centre <= 0.0);
+                for(size_t m = 0; m < 4; ++m){
+                    if(!leaving[m]) continue;
+                    const auto t = (centre_in) ? (m + 1) % 4 : (m + 3) % 4;
+                    next[e[edge[m]]] = e[edge[t]];
+                }
+            }
+        }
+    }
+
+    std::vector<std::vector<pt2>> out;
+    std::vector<uint8_t> visited(2 * N, 0);
+    for(size_t s = 0; s < 2 * N; ++s){
+        if( (next[s] < 0) || (visited[s] != 0) ) continue;
+
+        std::vector<pt2> poly;
+        auto cur = static_cast<int64_t>(s);
+        while( (0 <= cur) && (visited[cur] == 0) ){
+            visited[cur] = 1;
+            const auto &p = crossing[cur];
+            if( poly.empty() || (poly.back().x != p.x) || (poly.back().y != p.y) ) poly.push_back(p);
+            cur = next[cur];
+        }
+        if(cur != static_cast<int64_t>(s)) continue; // Open chains can only arise if the border is not exterior.
+        if( (1 < poly.size()) && (poly.front().x == poly.back().x) && (poly.front().y == poly.back().y) ){
+            poly.pop_back();
+        }
+        if(3 <= poly.size()) out.emplace_back(std::move(poly));
+    }
+    return out;
+}
+
+} // namespace
+
+
+OperationDoc OpArgDocApplyROIMargins(void){
+    OperationDoc out;
+    out.name = "ApplyROIMargins";
+
+    out.desc =
+        "This operation grows or shrinks ROIs in 3D by adding margins, which may differ in each direction."
+        " It is suitable for generating planning target volumes (PTVs) and planning organ-at-risk volumes (PRVs).";
+
+    out.notes.emplace_back(
+        "ROIs are rasterized onto a fine, axis-aligned voxel grid. An exact Euclidean distance transform is then"
+        " computed using a structuring element with separate extents in each direction, i.e., an ellipsoid with a"
+        " separate semi-axis in each octant. The result is re-contoured on the selected image planes using marching"
+        " squares. Every step requires a number of operations linear in the number of voxels and runs in parallel."
+    );
+    out.notes.emplace_back(
+        "Directions are interpreted in the DICOM patient coordinate system, where +x is patient left, +y is"
+        " posterior, and +z is superior. Only transverse (axial) contours and image planes are supported."
+    );
+    out.notes.emplace_back(
+        "Margins with mixed signs are applied in two stages: first all positive margins are used to grow the ROI, and"
+        " then all negative margins are used to shrink it."
+    );
+    out.notes.emplace_back(
+        "Each contour is taken to extend halfway to the neighbouring contour planes."
+        " Overlapping contours are combined as a union, but holes joined to their enclosing contour via a seam are"
+        " respected."
+    );
+    out.notes.emplace_back(
+        "The accuracy of the resulting contours is limited by the grid resolution. Contours have a vertex on every"
+        " voxel edge they cross, so simplifying them afterward may be worthwhile."
+    );
+
+    out.args.emplace_back();
+    out.args.back().name = "NormalizedROILabelRegex";
+    out.args.back().desc = "A regex matching ROI labels/names to consider. The default will match"
+                      " all available ROIs. Be aware that input spaces are trimmed to a single space."
+                      " If your ROI name has more than two sequential spaces, use regex to avoid them."
+                      " All ROIs have to match the single regex, so use the 'or' token if needed."
+                      " Regex is case insensitive and uses extended POSIX syntax.";
+    out.args.back().default_val = ".*";
+    out.args.back().expected = true;
+    out.args.back().examples = { ".*", ".*Body.*", "Body", "Gross_Liver",
+                            R"***(.*Left.*Parotid.*|.*Right.*Parotid.*|.*Eye.*)***",
+                            R"***(Left Parotid|Right Parotid)***" };
+
+    out.args.emplace_back();
+    out.args.back().name = "ROILabelRegex";
+    out.args.back().desc = "A regex matching ROI labels/names to consider. The default will match"
+                           " all available ROIs. Be aware that input spaces are trimmed to a single space."
+                           " If your ROI name has more than two sequential spaces, use regex to avoid them."
+                           " All ROIs have to match the single regex, so use the 'or' token if needed."
+                           " Regex is case insensitive and uses grep syntax.";
+    out.args.back().default_val = ".*";
+    out.args.back().expected = true;
+    out.args.back().examples = { ".*", ".*body.*", "body", "Gross_Liver",
+                                 R"***(.*parotid.*|.*sub.*mand.*)***",
+                                 R"***(left_parotid|right_parotid|eyes)***" };
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().desc += " Note that the selected images are used to sample the new contours on."
+                            " Image planes need not match the original contour planes.";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "ROILabel";
+    out.args.back().desc = "A label to attach to the new ROI.";
+    out.args.back().default_val = "margin";
+    out.args.back().expected = true;
+    out.args.back().examples = { "PTV", "PRV", "ROI_plus_5mm", "margin" };
+
+    const std::array<std::string,6> directions = {{ "Superior", "Inferior", "Anterior", "Posterior", "Left", "Right" }};
+    for(const auto &d : directions){
+        out.args.emplace_back();
+        out.args.back().name = "Margin" + d;
+        out.args.back().desc = "The margin to add in the " + d + " direction, in DICOM units (usually mm)."
+                               " Positive margins grow the ROI and negative margins shrink it.";
+        out.args.back().default_val = "5.0";
+        out.args.back().expected = true;
+        out.args.back().examples = { "-3.0", "0.0", "5.0", "10.0" };
+    }
+
+    out.args.emplace_back();
+    out.args.back().name = "Resolution";
+    out.args.back().desc = "The spacing of the voxel grid the ROIs are rasterized onto, in DICOM units (usually mm)."
+                           " Finer grids are more accurate, but require more memory and time. Within transverse"
+                           " planes this spacing is used exactly. Between planes, the spacing is adjusted so that grid"
+                           " planes coincide with the selected image planes.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.5", "1.0", "2.0" };
+
+    return out;
+}
+
+Drover ApplyROIMargins(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std::string,std::string> /*InvocationMetadata*/, std::string FilenameLex){
+
+    Explicator X(FilenameLex);
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
+    const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto ROILabel = OptArgs.getValueStr("ROILabel").value();
+
+    const auto MarginSuperior = std::stod( OptArgs.getValueStr("MarginSuperior").value() );
+    const auto MarginInferior = std::stod( OptArgs.getValueStr("MarginInferior").value() );
+    const auto MarginAnterior = std::stod( OptArgs.getValueStr("MarginAnterior").value() );
+    const auto MarginPosterior = std::stod( OptArgs.getValueStr("MarginPosterior").value() );
+    const auto MarginLeft = std::stod( OptArgs.getValueStr("MarginLeft").value() );
+    const auto MarginRight = std::stod( OptArgs.getValueStr("MarginRight").value() );
+
+    const auto Resolution = std::stod( OptArgs.getValueStr("Resolution").value() );
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto NormalizedROILabel = X(ROILabel);
+
+    if(!std::isfinite(Resolution) || (Resolution <= 0.0)){
+        throw std::invalid_argument("Resolution must be positive. Cannot continue.");
+    }
+
+    // Margins along the patient axes (+x is left, +y is posterior, and +z is superior).
+    const std::array<std::array<double,2>,3> margins = {{ {{ MarginRight, MarginLeft }},
+                                                          {{ MarginAnterior, MarginPosterior }},
+                                                          {{ MarginInferior, MarginSuperior }} }};
+    std::array<distance_transform::axis_extent,3> grow;
+    std::array<distance_transform::axis_extent,3> shrink;
+    bool needs_grow = false;
+    bool needs_shrink = false;
+    for(size_t a = 0; a < 3; ++a){
+        for(const auto &m : margins[a]){
+            if(!std::isfinite(m)) throw std::invalid_argument("Margins must be finite. Cannot continue.");
+            needs_grow = needs_grow || (0.0 < m);
+            needs_shrink = needs_shrink || (m < 0.0);
+        }
+        grow[a] = { std::max(0.0, margins[a][0]), std::max(0.0, margins[a][1]) };
+        shrink[a] = { std::max(0.0, -margins[a][0]), std::max(0.0, -margins[a][1]) };
+    }
+    // Without any margins, the ROI is merely resampled.
+    if(!needs_grow && !needs_shrink) needs_grow = true;
+
+    auto cc_all = All_CCs( DICOM_data );
+    auto cc_ROIs = Whitelist( cc_all, { { "ROIName", ROILabelRegex },
+                                        { "NormalizedROIName", NormalizedROILabelRegex } } );
+    if(cc_ROIs.empty()){
+        throw std::invalid_argument("No contours selected. Cannot continue.");
+    }
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    std::vector<std::reference_wrapper<const planar_image<float,double>>> imgs;
+    for(auto & iap_it : IAs){
+        for(const auto &animg : (*iap_it)->imagecoll.images){
+            if(std::abs(animg.image_plane().N_0.z) < 0.999){
+                throw std::invalid_argument("Only transverse image planes are supported. Cannot continue.");
+            }
+            imgs.emplace_back( std::cref(animg) );
+        }
+    }
+    if(imgs.empty()){
+        throw std::invalid_argument("No images selected. Cannot continue.");
+    }
+
+    // Gather the contours, grouping them by plane.
+    auto contour_sep = Estimate_Contour_Separation_Multi(cc_ROIs);
+    if(!std::isfinite(contour_sep) || (contour_sep <= 0.0)) contour_sep = Resolution;
+
+    std::vector<std::pair<double, std::vector<pt2>>> contours;
+    double x_min = std::numeric_limits<double>::infinity();
+    double x_max = -x_min;
+    double y_min = x_min;
+    double y_max = -x_min;
+    for(auto &cc_refw : cc_ROIs){
+        for(const auto &c : cc_refw.get().contours){
+            if(c.points.size() < 3) continue;
+            if(std::abs(c.Estimate_Planar_Normal().z) < 0.999){
+                throw std::invalid_argument("Only transverse contours are supported. Cannot continue.");
+            }
+            std::vector<pt2> poly;
+            poly.reserve(c.points.size());
+            double z = 0.0;
+            for(const auto &p : c.points){
+                poly.push_back( { p.x, p.y } );
+                z += p.z;
+                x_min = std::min(x_min, p.x);
+                x_max = std::max(x_max, p.x);
+                y_min = std::min(y_min, p.y);
+                y_max = std::max(y_max, p.y);
+            }
+            contours.emplace_back( z / static_cast<double>(c.points.size()), std::move(poly) );
+        }
+    }
+    if(contours.empty()){
+        throw std::invalid_argument("Selected ROIs contain no contours. Cannot continue.");
+    }
+    std::sort(std::begin(contours), std::end(contours),
+              [](const auto &l, const auto &r){ return (l.first < r.first); });
+    std::vector<contour_plane> planes;
+    for(auto &c : contours){
+        if( planes.empty() || ((0.05 * contour_sep) < std::abs(c.first - planes.back().z)) ){
+            planes.emplace_back();
+            planes.back().z = c.first;
+        }
+        planes.back().polygons.emplace_back(std::move(c.second));
+    }
+    const auto z_min = planes.front().z;
+    const auto z_max = planes.back().z;
+
+    // Determine the extent of the voxel grid. The grid is padded so that its border is always exterior.
+    //
+    // Between planes the spacing is chosen to evenly subdivide the image slice separation so that grid planes coincide
+    // with the image planes.
+    const auto z_on_image = [](const planar_image<float,double> &animg, double x, double y) -> double {
+        const auto P = animg.image_plane();
+        return P.R_0.z - (P.N_0.x * (x - P.R_0.x) + P.N_0.y * (y - P.R_0.y)) / P.N_0.z;
+    };
+    const auto x_mid = 0.5 * (x_min + x_max);
+    const auto y_mid = 0.5 * (y_min + y_max);
+    std::vector<double> img_z;
+    for(const auto &animg_refw : imgs) img_z.emplace_back( z_on_image(animg_refw.get(), x_mid, y_mid) );
+    std::sort(std::begin(img_z), std::end(img_z));
+
+    std::vector<double> img_gaps;
+    for(size_t i = 1; i < img_z.size(); ++i){
+        const auto gap = img_z[i] - img_z[i - 1];
+        if(1.0E-3 < gap) img_gaps.emplace_back(gap);
+    }
+    double img_sep = Resolution;
+    if(!img_gaps.empty()){
+        std::nth_element(std::begin(img_gaps), std::begin(img_gaps) + img_gaps.size() / 2, std::end(img_gaps));
+        img_sep = img_gaps[img_gaps.size() / 2];
+    }
+    const auto subdivisions = std::max(1.0, std::ceil(img_sep / Resolution - 1.0E-6));
+    const std::array<double,3> spacing = {{ Resolution, Resolution, img_sep / subdivisions }};
+
+    const long int pad = 2;
+    const auto x0 = x_min - grow[0].negative - static_cast<double>(pad) * spacing[0];
+    const auto y0 = y_min - grow[1].negative - static_cast<double>(pad) * spacing[1];
+    const auto z_lo = z_min - 0.5 * contour_sep - grow[2].negative - static_cast<double>(pad) * spacing[2];
+    const auto z0 = img_z.front() + spacing[2] * std::floor((z_lo - img_z.front()) / spacing[2]);
+    const auto x_hi = x_max + grow[0].positive + static_cast<double>(pad) * spacing[0];
+    const auto y_hi = y_max + grow[1].positive + static_cast<double>(pad) * spacing[1];
+    const auto z_hi = z_max + 0.5 * contour_sep + grow[2].positive + static_cast<double>(pad) * spacing[2];
+
+    connected_components::mask_volume mv;
+    mv.columns = static_cast<long int>(std::ceil((x_hi - x0) / spacing[0])) + 1;
+    mv.rows    = static_cast<long int>(std::ceil((y_hi - y0) / spacing[1])) + 1;
+    mv.slices  = static_cast<long int>(std::ceil((z_hi - z0) / spacing[2])) + 1;
+    const auto N_voxels = static_cast<double>(mv.columns) * static_cast<double>(mv.rows) * static_cast<double>(mv.slices);
+    if(2.0E9 < N_voxels){
+        throw std::invalid_argument("Voxel grid would be too large. Increase the resolution parameter.");
+    }
+    mv.mask.resize(static_cast<size_t>(N_voxels), 0);
+    const auto N_per_slice = static_cast<size_t>(mv.columns) * static_cast<size_t>(mv.rows);
+    FUNCINFO("Using a voxel grid with " << mv.columns << " columns, " << mv.rows << " rows, and "
+             << mv.slices << " slices");
+
+    // Express the contours in units of voxels.
+    for(auto &cp : planes){
+        for(auto &poly : cp.polygons){
+            for(auto &p : poly){
+                p.x = (p.x - x0) / spacing[0];
+                p.y = (p.y - y0) / spacing[1];
+            }
+        }
+    }
+
+    // Rasterize each grid plane using the nearest contour plane, provided it is within half a contour separation.
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < mv.slices; ++k){
+            tp.submit_task([&,k](void) -> void {
+                const auto z = z0 + spacing[2] * static_cast<double>(k);
+                auto it = std::lower_bound(std::begin(planes), std::end(planes), z,
+                                           [](const contour_plane &cp, double v){ return (cp.z < v); });
+                const contour_plane *nearest = nullptr;
+                if(it != std::end(planes)) nearest = &(*it);
+                if( (it != std::begin(planes))
+                &&  ( (nearest == nullptr) || ((z - std::prev(it)->z) < (nearest->z - z)) ) ){
+                    nearest = &(*std::prev(it));
+                }
+                if( (nearest == nullptr)
+                ||  ((0.5 * contour_sep * (1.0 + 1.0E-6)) < std::abs(nearest->z - z)) ){
+                    return;
+                }
+                rasterize_plane(*nearest, mv.columns, mv.rows, mv.mask.data() + N_per_slice * static_cast<size_t>(k));
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    // Voxel centres lie on average half a voxel inside the boundary, so each stage is widened by half a voxel. This
+    // also lets the boundary be placed between voxels along directions without any margin.
+    for(size_t a = 0; a < 3; ++a){
+        for(auto *e : { &grow[a], &shrink[a] }){
+            e->negative += 0.5 * spacing[a];
+            e->positive += 0.5 * spacing[a];
+        }
+    }
+    std::vector<float> field;
+    if(needs_grow) field = apply_margin(mv, spacing, grow, false);
+    if(needs_shrink) field = apply_margin(mv, spacing, shrink, true);
+
+    // Re-contour on the image planes.
+    std::vector<std::list<contour_of_points<double>>> img_contours(imgs.size());
+    {
+        asio_thread_pool tp;
+        for(size_t n = 0; n < imgs.size(); ++n){
+            tp.submit_task([&,n](void) -> void {
+                const auto &animg = imgs[n].get();
+                const auto k = static_cast<long int>(std::round((z_on_image(animg, x_mid, y_mid) - z0) / spacing[2]));
+                if( (k < 0) || (mv.slices <= k) ) return;
+
+                const auto polys = contour_field(field.data() + N_per_slice * static_cast<size_t>(k), mv.columns, mv.rows);
+                for(const auto &poly : polys){
+                    img_contours[n].emplace_back();
+                    auto &c = img_contours[n].back();
+                    c.closed = true;
+                    for(const auto &p : poly){
+                        const auto x = x0 + p.x * spacing[0];
+                        const auto y = y0 + p.y * spacing[1];
+                        c.points.emplace_back( x, y, z_on_image(animg, x, y) );
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    //Construct a destination for the ROI contours.
+    if(DICOM_data.contour_data == nullptr){
+        std::unique_ptr<Contour_Data> output (new Contour_Data());
+        DICOM_data.contour_data = std::move(output);
+    }
+    DICOM_data.contour_data->ccs.emplace_back();
+
+    const double MinimumSeparation = img_sep;
+    DICOM_data.contour_data->ccs.back().Raw_ROI_name = ROILabel;
+    DICOM_data.contour_data->ccs.back().ROI_number = 10000; // TODO: find highest existing and ++ it.
+    DICOM_data.contour_data->ccs.back().Minimum_Separation = MinimumSeparation;
+
+    for(size_t n = 0; n < imgs.size(); ++n){
+        const auto &animg = imgs[n].get();
+        for(auto &c : img_contours[n]){
+            c.metadata["ROIName"] = ROILabel;
+            c.metadata["NormalizedROIName"] = NormalizedROILabel;
+            c.metadata["Description"] = "ROI with margins";
+            c.metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
+            for(const auto &key : { "StudyInstanceUID", "FrameofReferenceUID" }){
+                if(animg.metadata.count(key) != 0) c.metadata[key] = animg.metadata.at(key);
+            }
+        }
+        DICOM_data.contour_data->ccs.back().contours.splice(DICOM_data.contour_data->ccs.back().contours.end(),
+                                                            img_contours[n]);
+    }
+
+    return DICOM_data;
+}
@@ -0,0 +1,17 @@
+// ApplyROIMargins.h.
+
+#pragma once
+
+#include <string>
+#include <map>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocApplyROIMargins(void);
+
+Drover
+ApplyROIMargins(Drover DICOM_data,
+                OperationArgPkg /*OptArgs*/,
+                std::map<std::string, std::string> /*InvocationMetadata*/,
+                std::string /*FilenameLex*/);
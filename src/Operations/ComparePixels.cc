@@ -307,6 +307,35 @@ OperationDoc OpArgDocComparePixels(void){
     out.args.back().examples = { "true",
                                  "false" };
 
+    out.args.emplace_back();
+    out.args.back().name = "GammaEngine";
+    out.args.back().desc = "Parameter for gamma-index comparisons."
+                           " Controls how the gamma-index search is performed."
+                           " 'Exhaustive' grows a rectangular wavefront of reference voxels around each test voxel"
+                           " and interpolates only along voxel edges and in-plane diagonals (see DTAInterpolationMethod)."
+                           " 'Accelerated' visits reference voxels in order of increasing distance and stops as soon"
+                           " as the distance term alone exceeds the best gamma found so far. The best candidate is then"
+                           " refined with a coarse-to-fine search between voxel centres, sampling the reference images"
+                           " with on-the-fly trilinear interpolation. The accelerated engine is typically much faster"
+                           " for fully 3D comparisons. It does not short-circuit on the point discrepancy, so every"
+                           " voxel within the thresholds is counted towards the passing rate.";
+    out.args.back().default_val = "exhaustive";
+    out.args.back().expected = true;
+    out.args.back().examples = { "exhaustive",
+                                 "accelerated" };
+
+    out.args.emplace_back();
+    out.args.back().name = "GammaRefinementLevels";
+    out.args.back().desc = "Parameter for accelerated gamma-index comparisons."
+                           " The number of coarse-to-fine refinement levels used to locate the gamma minimum between"
+                           " reference voxel centres. Each level halves the step, so the final step is (1/2)^levels"
+                           " of the reference voxel dimensions. Zero disables sub-voxel refinement.";
+    out.args.back().default_val = "3";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0",
+                                 "3",
+                                 "5" };
+
     return out;
 }
 
@@ -342,6 +371,8 @@ Drover ComparePixels(Drover DICOM_data,
     const auto GammaDTAThreshold = std::stod( OptArgs.getValueStr("GammaDTAThreshold").value() );
     const auto GammaDiscThreshold = std::stod( OptArgs.getValueStr("GammaDiscThreshold").value() );
     const auto GammaTerminateAboveOneStr = OptArgs.getValueStr("GammaTerminateAboveOne").value();
+    const auto GammaEngineStr = OptArgs.getValueStr("GammaEngine").value();
+    const auto GammaRefinementLevels = std::stol( OptArgs.getValueStr("GammaRefinementLevels").value() );
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_true = Compile_Regex("^tr?u?e?$");
@@ -358,6 +389,9 @@ Drover ComparePixels(Drover DICOM_data,
     const auto disctype_dif = Compile_Regex("^di?f?f?e?r?e?n?c?e?$");
     const auto disctype_pin = Compile_Regex("^pi?n?n?e?d?-?t?o?-?m?a?x?$");
 
+    const auto engine_exh = Compile_Regex("^ex?h?a?u?s?t?i?v?e?$");
+    const auto engine_acc = Compile_Regex("^ac?c?e?l?e?r?a?t?e?d?$");
+
     const auto GammaTerminateAboveOne = std::regex_match(GammaTerminateAboveOneStr, regex_true);
     //-----------------------------------------------------------------------------------------------------------------
 
@@ -440,6 +474,21 @@ Drover ComparePixels(Drover DICOM_data,
         ud.gamma_DTA_threshold = GammaDTAThreshold;
 
         ud.gamma_terminate_when_max_exceeded = GammaTerminateAboveOne;
+
+        if(false){
+        }else if(std::regex_match(GammaEngineStr, engine_exh)){
+            ud.gamma_engine = ComputeCompareImagesUserData::GammaEngine::Exhaustive;
+
+        }else if(std::regex_match(GammaEngineStr, engine_acc)){
+            ud.gamma_engine = ComputeCompareImagesUserData::GammaEngine::Accelerated;
+
+        }else{
+            throw std::invalid_argument("Gamma engine not understood. Cannot continue.");
+        }
+        if(GammaRefinementLevels < 0){
+            throw std::invalid_argument("Gamma refinement levels must be non-negative. Cannot continue.");
+        }
+        ud.gamma_refinement_levels = GammaRefinementLevels;
         //ud.gamma_terminated_early = std::nextafter(1.0, std::numeric_limits<double>::infinity());
 
         if(!(*iap_it)->imagecoll.Compute_Images( ComputeCompareImages, 
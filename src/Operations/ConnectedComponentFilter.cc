@@ -0,0 +1,244 @@
+//ConnectedComponentFilter.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
+#include "../YgorImages_Functors/ConvenienceRoutines.h"
+#include "../YgorImages_Functors/Connected_Components.h"
+#include "../YgorImages_Functors/Grid_Resampling.h"
+#include "ConnectedComponentFilter.h"
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+
+
+OperationDoc OpArgDocConnectedComponentFilter(void){
+    OperationDoc out;
+    out.name = "ConnectedComponentFilter";
+
+    out.desc =
+        "This operation identifies 3D connected components (i.e., contiguous regions) in a thresholded image"
+        " volume and removes components based on their volume."
+        " It can be used to remove small islands from a mask or to retain only the largest component(s).";
+
+    out.notes.emplace_back(
+        "The selected images must form a rectilinear grid. Slices need not be evenly spaced."
+    );
+    out.notes.emplace_back(
+        "Voxels are considered part of a component if their value is within the inclusive range [Lower, Upper]."
+        " Voxels belonging to removed components will be assigned the replacement value."
+        " Voxels outside of the range are not altered."
+    );
+    out.notes.emplace_back(
+        "Components are identified in a single linear pass, so this operation is suitable for large volumes."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "Channel";
+    out.args.back().desc = "The image channel to use (zero-based).";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0",
+                                 "1",
+                                 "2" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Lower";
+    out.args.back().desc = "The lower voxel value (inclusive) of voxels that form components.";
+    out.args.back().default_val = "0.5";
+    out.args.back().expected = true;
+    out.args.back().examples = { "-inf",
+                                 "0.5",
+                                 "-200",
+                                 "1.23" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Upper";
+    out.args.back().desc = "The upper voxel value (inclusive) of voxels that form components.";
+    out.args.back().default_val = "inf";
+    out.args.back().expected = true;
+    out.args.back().examples = { "inf",
+                                 "1.5",
+                                 "500",
+                                 "1.23" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Connectivity";
+    out.args.back().desc = "The voxel neighbourhood used to determine whether voxels are connected."
+                           " '6' connects voxels that share a face,"
+                           " '18' connects voxels that share a face or an edge, and"
+                           " '26' connects voxels that share a face, an edge, or a corner.";
+    out.args.back().default_val = "6";
+    out.args.back().expected = true;
+    out.args.back().examples = { "6",
+                                 "18",
+                                 "26" };
+
+    out.args.emplace_back();
+    out.args.back().name = "MinVolume";
+    out.args.back().desc = "Components with volumes (in DICOM units: mm^3) smaller than this value are removed.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0",
+                                 "10.0",
+                                 "1000.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "MaxVolume";
+    out.args.back().desc = "Components with volumes (in DICOM units: mm^3) larger than this value are removed.";
+    out.args.back().default_val = "inf";
+    out.args.back().expected = true;
+    out.args.back().examples = { "inf",
+                                 "1000.0",
+                                 "1E6" };
+
+    out.args.emplace_back();
+    out.args.back().name = "KeepLargest";
+    out.args.back().desc = "If positive, only this many of the largest components that satisfy the volume criteria"
+                           " are retained. Zero disables this criterion.";
+    out.args.back().default_val = "0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0",
+                                 "1",
+                                 "3" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Replacement";
+    out.args.back().desc = "The value assigned to voxels that belong to removed components.";
+    out.args.back().default_val = "0.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.0",
+                                 "-1024.0",
+                                 "nan" };
+
+    return out;
+}
+
+
+
+Drover ConnectedComponentFilter(Drover DICOM_data,
+                                OperationArgPkg OptArgs,
+                                std::map<std::string,std::string> /*InvocationMetadata*/,
+                                std::string /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    const auto Lower = std::stod( OptArgs.getValueStr("Lower").value() );
+    const auto Upper = std::stod( OptArgs.getValueStr("Upper").value() );
+    const auto ConnectivityStr = OptArgs.getValueStr("Connectivity").value();
+    const auto MinVolume = std::stod( OptArgs.getValueStr("MinVolume").value() );
+    const auto MaxVolume = std::stod( OptArgs.getValueStr("MaxVolume").value() );
+    const auto KeepLargest = std::stol( OptArgs.getValueStr("KeepLargest").value() );
+    const auto Replacement = std::stof( OptArgs.getValueStr("Replacement").value() );
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_6  = Compile_Regex("^6$");
+    const auto regex_18 = Compile_Regex("^18$");
+    const auto regex_26 = Compile_Regex("^26$");
+
+    auto conn = connected_components::connectivity::Six;
+    if(false){
+    }else if(std::regex_match(ConnectivityStr, regex_6)){
+        conn = connected_components::connectivity::Six;
+    }else if(std::regex_match(ConnectivityStr, regex_18)){
+        conn = connected_components::connectivity::Eighteen;
+    }else if(std::regex_match(ConnectivityStr, regex_26)){
+        conn = connected_components::connectivity::TwentySix;
+    }else{
+        throw std::invalid_argument("Connectivity argument '"_s + ConnectivityStr + "' is not valid");
+    }
+    if(KeepLargest < 0){
+        throw std::invalid_argument("KeepLargest must be non-negative. Cannot continue.");
+    }
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        if((*iap_it)->imagecoll.images.empty()) continue;
+
+        std::list<std::reference_wrapper<planar_image<float,double>>> imgs;
+        for(auto &img : (*iap_it)->imagecoll.images){
+            imgs.push_back( std::ref(img) );
+        }
+        const auto grid = grid_resampling::Make_Rectilinear_Grid(imgs);
+        if(!grid){
+            throw std::invalid_argument("Selected images do not form a rectilinear grid. Cannot continue.");
+        }
+
+        const auto lv = connected_components::Label_Components(grid.value(), Channel, Lower, Upper, conn);
+
+        // Determine which components to retain.
+        std::vector<const connected_components::component *> retained;
+        for(const auto &comp : lv.components){
+            if( (MinVolume <= comp.volume) && (comp.volume <= MaxVolume) ){
+                retained.push_back( &comp );
+            }
+        }
+        std::stable_sort(std::begin(retained), std::end(retained),
+                         [](const auto *A, const auto *B){ return (B->volume < A->volume); });
+        if( (0 < KeepLargest) && (static_cast<size_t>(KeepLargest) < retained.size()) ){
+            retained.resize(KeepLargest);
+        }
+
+        std::vector<uint8_t> keep(lv.components.size() + 1, 0);
+        for(const auto *comp : retained) keep[comp->label] = 1;
+
+        FUNCINFO("Found " << lv.components.size() << " components; retaining " << retained.size());
+        for(size_t i = 0; (i < retained.size()) && (i < 10); ++i){
+            const auto *comp = retained[i];
+            FUNCINFO("Retained component with volume " << comp->volume
+                  << " mm^3 (" << comp->voxels << " voxels) and centroid " << comp->centroid);
+        }
+
+        // Replace the voxels of removed components. Slices in the grid are ordered spatially, so each image is matched
+        // to the slice of the label volume that it corresponds to.
+        std::map<const planar_image<float,double> *, long int> slice_index;
+        for(long int k = 0; k < lv.slices; ++k){
+            slice_index[ grid->imgs[k] ] = k;
+        }
+
+        const auto N_per_slice = static_cast<size_t>(lv.rows) * static_cast<size_t>(lv.columns);
+        {
+            asio_thread_pool tp;
+            for(auto &animg : (*iap_it)->imagecoll.images){
+                tp.submit_task([&,img = std::addressof(animg)](void) -> void {
+                    const auto k = slice_index.at(img);
+                    const auto N_chns = static_cast<size_t>(img->channels);
+                    const uint32_t *l = lv.labels.data() + N_per_slice * static_cast<size_t>(k);
+                    for(size_t i = 0; i < N_per_slice; ++i){
+                        if( (l[i] != 0U) && (keep[ l[i] ] == 0) ){
+                            img->data[i * N_chns + static_cast<size_t>(Channel)] = Replacement;
+                        }
+                    }
+
+                    std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(*img) );
+                    UpdateImageDescription( img_refw, "Connected component filtered" );
+                    UpdateImageWindowCentreWidth( img_refw );
+                }); // thread pool task closure.
+            }
+        } // Wait for all tasks to complete.
+    }
+
+    return DICOM_data;
+}
@@ -0,0 +1,17 @@
+// ConnectedComponentFilter.h.
+
+#pragma once
+
+#include <string>
+#include <map>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocConnectedComponentFilter(void);
+
+Drover
+ConnectedComponentFilter(Drover DICOM_data, 
+                         OperationArgPkg /*OptArgs*/,
+                         std::map<std::string, std::string> /*InvocationMetadata*/,
+                         std::string /*FilenameLex*/);
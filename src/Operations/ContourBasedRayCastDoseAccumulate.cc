@@ -248,8 +248,9 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
 
     //Pre-compute the line segments and spheres we will use to define the surface boundary. 
     //
-    // NOTE: We should be using a spatial indexing data structure, like R*-tree. (Does it support cylinders? Can it be
-    // made to support cylinders?) TODO.
+    // NOTE: The 'surface' here is a union of capsules (spheres and cylinders of a common radius) rather than a triangle
+    // mesh, so the triangle BVH used by SurfaceBasedRayCastDoseAccumulate does not apply. Instead, each ray culls the
+    // primitives its (unbounded) line cannot reach before marching, so only nearby primitives are tested per step.
     std::vector<line_segment<double>> cylinders; // Radii are all the same: CylinderRadius.
     std::vector<vec3<double>> spheres; // Centres of the spheres. The radii are the same as the cylinder radii.
 
@@ -398,6 +399,31 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
     const auto sq_radius = std::pow(CylinderRadius, 2.0);
+
+    //Squared distance from an unbounded line (through P with unit direction U) to a point or line segment.
+    const auto sq_dist_line_to_point = [](const vec3<double> &P, const vec3<double> &U, const vec3<double> &X) -> double {
+        const auto R = X - P;
+        const auto D = R - U * R.Dot(U);
+        return D.Dot(D);
+    };
+    const auto sq_dist_line_to_segment = [](const vec3<double> &P, const vec3<double> &U, const line_segment<double> &L) -> double {
+        // Project the segment onto the plane orthogonal to the line, then find the nearest point to the origin.
+        const auto RA = L.Get_R0() - P;
+        const auto RB = L.Get_R1() - P;
+        const auto A = RA - U * RA.Dot(U);
+        const auto B = RB - U * RB.Dot(U);
+        const auto AB = B - A;
+        const auto sq_len = AB.Dot(AB);
+        const auto t = (0.0 < sq_len) ? std::clamp( -A.Dot(AB) / sq_len, 0.0, 1.0 ) : 0.0;
+        const auto D = A + AB * t;
+        return D.Dot(D);
+    };
+
+    std::vector<const vec3<double>*> ray_spheres;
+    std::vector<const line_segment<double>*> ray_cylinders;
+    ray_spheres.reserve(spheres.size());
+    ray_cylinders.reserve(cylinders.size());
+
     for(long int row = 0; row < Rows; ++row){
         FUNCINFO("Working on row " << (row+1) << " of " << Rows 
                   << " --> " << static_cast<int>(1000.0*(row+1)/Rows)/10.0 << "% done");
@@ -409,6 +435,16 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
             const vec3<double> terminus = DetectImg.position(row, col);
             const vec3<double> ray_dir = (terminus - ray_pos).unit();
 
+            //Cull primitives that cannot intersect the ray.
+            ray_spheres.clear();
+            ray_cylinders.clear();
+            for(const auto &asphere : spheres){
+                if(sq_dist_line_to_point(ray_pos, ray_dir, asphere) < sq_radius) ray_spheres.emplace_back( &asphere );
+            }
+            for(const auto &acylinder : cylinders){
+                if(sq_dist_line_to_segment(ray_pos, ray_dir, acylinder) <= sq_radius) ray_cylinders.emplace_back( &acylinder );
+            }
+
             //Go until we get within certain distance or overshoot and the ray wants to backtrack.
             while(    (ray_dir.Dot( (terminus - ray_pos).unit() ) > 0.8 ) // Ray orientation is still downward-facing.
                    && (ray_pos.distance(terminus) > std::max(RaydL, grid_margin)) ){ // Still far away from detector.
@@ -418,8 +454,8 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
 
                 //Search to see if ray is in an object.
                 bool skip = false; //Was already found to be in a surface and was counted.
-                for(const auto &asphere : spheres){
-                    if(ray_pos.sq_dist(asphere) < sq_radius){
+                for(const auto &asphere : ray_spheres){
+                    if(ray_pos.sq_dist(*asphere) < sq_radius){
                         accumulated_length += RaydL;
 
                         //Find the dose at the half-way point.
@@ -434,8 +470,8 @@ Drover ContourBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
                 }
 
                 if(!skip){
-                    for(const auto &acylinder : cylinders){
-                        if(acylinder.Within_Cylindrical_Volume(ray_pos, CylinderRadius)){
+                    for(const auto &acylinder : ray_cylinders){
+                        if(acylinder->Within_Cylindrical_Volume(ray_pos, CylinderRadius)){
                             accumulated_length += RaydL;
 
                             //Find the dose at the half-way point.
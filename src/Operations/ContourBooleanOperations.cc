@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>            //Needed for exit() calls.
+#include <exception>
 #include <optional>
 #include <fstream>
 #include <functional>
@@ -12,10 +13,12 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <vector>
 
 #include "../Contour_Boolean_Operations.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "ContourBooleanOperations.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -53,6 +56,10 @@ OperationDoc OpArgDocContourBooleanOperations(void){
     out.notes.emplace_back(
         "Only the common metadata between contours is propagated to the product contours."
     );
+
+    out.notes.emplace_back(
+        "Each plane is processed independently and concurrently."
+    );
         
 
     out.args.emplace_back();
@@ -118,6 +125,20 @@ OperationDoc OpArgDocContourBooleanOperations(void){
     out.args.back().expected = true;
     out.args.back().examples = { "A+B", "A-B", "AuB", "AnB", "AxB", "A^B", "union", "xor", "combined", "body_without_spinal_cord" };
 
+    out.args.emplace_back();
+    out.args.back().name = "Backend";
+    out.args.back().desc = "The implementation used to perform the Boolean operations."
+                           " 'Snapped' snaps contour vertices to a 1 micron lattice and processes all contours on a"
+                           " plane in a single sweep using exact integer arithmetic. It is significantly faster,"
+                           " especially for ROIs with many contours or vertices."
+                           " Planes that the snapped backend cannot handle (e.g., because contours lie too far from"
+                           " the plane's origin) are automatically processed with the exact CGAL backend instead."
+                           " 'CGAL' uses exact polygon sets from the CGAL library for every plane, folding contours"
+                           " in one at a time.";
+    out.args.back().default_val = "snapped";
+    out.args.back().expected = true;
+    out.args.back().examples = { "snapped", "cgal" };
+
     return out;
 }
 
@@ -133,6 +154,7 @@ Drover ContourBooleanOperations(Drover DICOM_data, OperationArgPkg OptArgs, std:
 
     const auto Operation_str = OptArgs.getValueStr("Operation").value();
     const auto OutputROILabel = OptArgs.getValueStr("OutputROILabel").value();
+    const auto BackendStr = OptArgs.getValueStr("Backend").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto roiregexA = Compile_Regex(ROILabelRegexA);
@@ -146,6 +168,19 @@ Drover ContourBooleanOperations(Drover DICOM_data, OperationArgPkg OptArgs, std:
     const auto regex_difference = Compile_Regex("^diffe?r?e?n?c?e?$");
     const auto regex_symmdiff = Compile_Regex("^symme?t?r?i?c?_?d?i?f?f?e?r?e?n?c?e?$");
 
+    const auto regex_snapped = Compile_Regex("^sn?a?p?p?e?d?$");
+    const auto regex_cgal = Compile_Regex("^cg?a?l?$");
+
+    bool use_snapped = true;
+    if(false){
+    }else if(std::regex_match(BackendStr, regex_snapped)){
+        use_snapped = true;
+    }else if(std::regex_match(BackendStr, regex_cgal)){
+        use_snapped = false;
+    }else{
+        throw std::invalid_argument("Backend not understood. Cannot continue.");
+    }
+
     //Figure out which operation is desired.
     ContourBooleanMethod op = ContourBooleanMethod::join;
     if(false){
@@ -223,43 +258,73 @@ Drover ContourBooleanOperations(Drover DICOM_data, OperationArgPkg OptArgs, std:
         return ( vA.sq_dist(vB) < std::pow(0.01,2.0) );
     };
 
-    // For each plane, pack the shuttles with (only) the relevant contours.
-    contour_collection<double> cc_new;
-    for(const auto &aplane : ucp){
-        std::list<std::reference_wrapper<contour_of_points<double>>> A;
-        std::list<std::reference_wrapper<contour_of_points<double>>> B;
-
-        for(auto &cc : cc_A){
-            for(auto &cop : cc.get().contours){
-                //Ignore contours that are not 'on' the specified plane.
-                // We give planes a thickness to help determine coincidence.
-                cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
-                cop.Remove_Needles(verts_equal_F);
-                if(cop.points.empty()) continue;
-                const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
-                if(dist_to_plane > est_cont_thickness) continue;
-
-                //Pack the contour into the shuttle.
-                A.emplace_back(std::ref(cop));
-            }
-        }
-        for(auto &cc : cc_B){
-            for(auto &cop : cc.get().contours){
-                cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
-                cop.Remove_Needles(verts_equal_F);
-                if(cop.points.empty()) continue;
-                const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
-                if(dist_to_plane > est_cont_thickness) continue;
-
-                B.emplace_back(std::ref(cop));
-            }
+    // Clean the contours once, up front, since they are shared by all planes.
+    for(auto &cc : cc_A_B){
+        for(auto &cop : cc.get().contours){
+            cop.Remove_Sequential_Duplicate_Points(verts_equal_F);
+            cop.Remove_Needles(verts_equal_F);
         }
+    }
 
-        //Perform the operation.
-        //FUNCINFO("About to perform boolean operation. A and B have " << A.size() << " and " << B.size() << " elements, respectively");
-        auto cc = ContourBoolean(aplane, A, B, op);
+    // For each plane, pack the shuttles with (only) the relevant contours and perform the operation.
+    std::vector<plane<double>> planes(ucp.begin(), ucp.end());
+    std::vector<contour_collection<double>> plane_results(planes.size());
+    std::vector<std::exception_ptr> plane_errors(planes.size());
+    {
+        asio_thread_pool tp;
+        for(size_t i = 0; i < planes.size(); ++i){
+            tp.submit_task([&,i](void) -> void {
+                try{
+                    const auto &aplane = planes[i];
+                    std::list<std::reference_wrapper<contour_of_points<double>>> A;
+                    std::list<std::reference_wrapper<contour_of_points<double>>> B;
+
+                    for(auto &cc : cc_A){
+                        for(auto &cop : cc.get().contours){
+                            //Ignore contours that are not 'on' the specified plane.
+                            // We give planes a thickness to help determine coincidence.
+                            if(cop.points.empty()) continue;
+                            const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
+                            if(dist_to_plane > est_cont_thickness) continue;
+
+                            //Pack the contour into the shuttle.
+                            A.emplace_back(std::ref(cop));
+                        }
+                    }
+                    for(auto &cc : cc_B){
+                        for(auto &cop : cc.get().contours){
+                            if(cop.points.empty()) continue;
+                            const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
+                            if(dist_to_plane > est_cont_thickness) continue;
+
+                            B.emplace_back(std::ref(cop));
+                        }
+                    }
+
+                    //Perform the operation, falling back on the exact backend if necessary.
+                    std::optional<contour_collection<double>> cc;
+                    if(use_snapped){
+                        try{
+                            cc = ContourBoolean_Snapped(aplane, A, B, op);
+                        }catch(const std::exception &e){
+                            FUNCWARN("Snapped Boolean backend failed ('" << e.what() << "'). Falling back on CGAL");
+                        }
+                    }
+                    if(!cc) cc = ContourBoolean(aplane, A, B, op);
+                    plane_results[i] = std::move(cc.value());
+                }catch(const std::exception &){
+                    plane_errors[i] = std::current_exception();
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    for(const auto &e : plane_errors){
+        if(e) std::rethrow_exception(e);
+    }
 
-        //Insert any contours created into a holding contour_collection.
+    //Insert any contours created into a holding contour_collection.
+    contour_collection<double> cc_new;
+    for(auto &cc : plane_results){
         cc_new.contours.splice(cc_new.contours.end(), std::move(cc.contours));
     }
 
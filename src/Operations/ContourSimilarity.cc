@@ -7,6 +7,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>    
 #include <vector>
@@ -17,7 +18,8 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
-#include "../YgorImages_Functors/Compute/Contour_Similarity.h"
+#include "../YgorImages_Functors/Grid_Resampling.h"
+#include "../YgorImages_Functors/ROI_Similarity.h"
 #include "ContourSimilarity.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -30,11 +32,22 @@ OperationDoc OpArgDocContourSimilarity(void){
     out.name = "ContourSimilarity";
     out.desc = 
         "This operation estimates the similarity or overlap between two sets of contours."
-        " The comparison is based on point samples. It is useful for comparing contouring styles.";
+        " The comparison is based on voxel samples. It is useful for comparing contouring styles.";
 
     out.notes.emplace_back(
         "This routine requires an image grid, which is used to control where the contours are sampled."
-        " Images are not modified."
+        " The images must form a rectilinear grid. Images are not modified."
+    );
+
+    out.notes.emplace_back(
+        "Each ROI selected by the 'A' criteria is compared with each ROI selected by the 'B' criteria, and one row is"
+        " reported per pair. Each ROI is only rasterized once, so large inter-observer comparisons are efficient."
+    );
+
+    out.notes.emplace_back(
+        "Dice and Jaccard coefficients are computed from voxel overlap. Surface distances (mean, 95th percentile"
+        " Hausdorff, and Hausdorff) are computed from the voxels on the surface of each ROI and are reported in DICOM"
+        " units (i.e., mm)."
     );
 
     out.args.emplace_back();
@@ -97,7 +110,9 @@ OperationDoc OpArgDocContourSimilarity(void){
     out.args.emplace_back();
     out.args.back().name = "FileName";
     out.args.back().desc = "A filename (or full path) in which to append similarity data generated by this routine."
-                           " The format is CSV. Leave empty to dump to generate a unique temporary file.";
+                           " The format is CSV. Leave empty to dump to generate a unique temporary file."
+                           " If an existing file is present, rows will be appended only if its header matches;"
+                           " files written with different columns (e.g., by earlier versions) are not modified.";
     out.args.back().default_val = "";
     out.args.back().expected = true;
     out.args.back().examples = { "", "/tmp/somefile", "localfile.csv", "derivative_data.csv" };
@@ -136,18 +151,12 @@ Drover ContourSimilarity(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
     if(cc_A.empty()){
         throw std::invalid_argument("No contours selected (A). Cannot continue.");
     }
-    if(cc_A.size() != 1){
-        throw std::invalid_argument("Multiple contour collections selected (A). Refusing to continue.");
-    }
 
     auto cc_B = Whitelist( cc_all, { { "ROIName", ROILabelRegexB },
                                      { "NormalizedROIName", NormalizedROILabelRegexB } } );
     if(cc_B.empty()){
         throw std::invalid_argument("No contours selected (B). Cannot continue.");
     }
-    if(cc_B.size() != 1){
-        throw std::invalid_argument("Multiple contour collections selected (B). Refusing to continue.");
-    }
 
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
@@ -158,41 +167,77 @@ Drover ContourSimilarity(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
         throw std::invalid_argument("Multiple image arrays selected. Cannot continue.");
     }
     auto iap_it = IAs.front();
-    ComputeContourSimilarityUserData ud;
-    ud.Clear();
-    if(!(*iap_it)->imagecoll.Compute_Images( ComputeContourSimilarity, { },
-                                           { cc_A.front(), cc_B.front() }, &ud )){
-        throw std::runtime_error("Unable to compute Dice similarity. Cannot continue.");
+
+    std::list<std::reference_wrapper<planar_image<float,double>>> imgs;
+    for(auto &img : (*iap_it)->imagecoll.images){
+        imgs.push_back( std::ref(img) );
     }
-    FUNCINFO("Dice coefficient(A,B) = " << ud.Dice_Coefficient());
-    FUNCINFO("Jaccard coefficient(A,B) = " << ud.Jaccard_Coefficient());
-
-    // Attempt to identify the patient for reporting purposes.
-    std::string patient_ID;
-    if( auto o = cc_A.front().get().contours.front().GetMetadataValueAs<std::string>("PatientID") ){
-        patient_ID = o.value();
-    }else if( auto o = cc_B.front().get().contours.front().GetMetadataValueAs<std::string>("PatientID") ){
-        patient_ID = o.value();
-    }else if( auto o = cc_A.front().get().contours.front().GetMetadataValueAs<std::string>("StudyInstanceUID") ){
-        patient_ID = o.value();
-    }else if( auto o = cc_B.front().get().contours.front().GetMetadataValueAs<std::string>("StudyInstanceUID") ){
-        patient_ID = o.value();
-    }else{
-        patient_ID = "unknown_patient";
+    const auto grid = grid_resampling::Make_Rectilinear_Grid(imgs);
+    if(!grid){
+        throw std::invalid_argument("Selected images do not form a rectilinear grid. Cannot continue.");
+    }
+    if(!grid->uniform_slices){
+        FUNCWARN("Images are not evenly spaced. Surface distances will be approximated using the mean spacing");
     }
 
-    std::string ROINameA;
-    if( auto o = cc_A.front().get().contours.front().GetMetadataValueAs<std::string>("ROIName") ){
-        ROINameA = o.value();
-    }else{
-        ROINameA = "unknown_roi";
+    // Rasterize each ROI only once, even if it was selected in both sets.
+    struct rasterized_roi {
+        roi_similarity::packed_mask mask;
+        roi_similarity::packed_mask surface;
+    };
+    std::map<contour_collection<double> *, rasterized_roi> rasterized;
+    for(const auto &cc_refw : cc_A) rasterized[ std::addressof(cc_refw.get()) ];
+    for(const auto &cc_refw : cc_B) rasterized[ std::addressof(cc_refw.get()) ];
+    for(auto &p : rasterized){
+        p.second.mask = roi_similarity::Rasterize_ROI(grid.value(), { std::ref(*(p.first)) });
+        p.second.surface = roi_similarity::Surface_Voxels(p.second.mask);
     }
 
-    std::string ROINameB;
-    if( auto o = cc_B.front().get().contours.front().GetMetadataValueAs<std::string>("ROIName") ){
-        ROINameB = o.value();
-    }else{
-        ROINameB = "unknown_roi";
+    const auto get_metadata = [](const contour_collection<double> &cc,
+                                 const std::string &key) -> std::optional<std::string> {
+        for(const auto &c : cc.contours){
+            if(auto o = c.GetMetadataValueAs<std::string>(key)) return o;
+        }
+        return {};
+    };
+
+    struct comparison {
+        std::string patient_ID;
+        std::string ROINameA;
+        std::string ROINameB;
+        roi_similarity::overlap_stats overlap;
+        roi_similarity::surface_distance_stats distances;
+    };
+    std::list<comparison> comparisons;
+    for(const auto &cc_A_refw : cc_A){
+        for(const auto &cc_B_refw : cc_B){
+            auto &A = cc_A_refw.get();
+            auto &B = cc_B_refw.get();
+            if(std::addressof(A) == std::addressof(B)) continue;
+
+            const auto &rA = rasterized.at(std::addressof(A));
+            const auto &rB = rasterized.at(std::addressof(B));
+
+            comparison c;
+            c.overlap = roi_similarity::Compute_Overlap(rA.mask, rB.mask);
+            c.distances = roi_similarity::Compute_Surface_Distances(grid.value(), rA.surface, rB.surface);
+
+            // Attempt to identify the patient for reporting purposes.
+            c.patient_ID = get_metadata(A, "PatientID").value_or(
+                           get_metadata(B, "PatientID").value_or(
+                           get_metadata(A, "StudyInstanceUID").value_or(
+                           get_metadata(B, "StudyInstanceUID").value_or("unknown_patient"))));
+            c.ROINameA = get_metadata(A, "ROIName").value_or("unknown_roi");
+            c.ROINameB = get_metadata(B, "ROIName").value_or("unknown_roi");
+
+            FUNCINFO("Dice coefficient(" << c.ROINameA << "," << c.ROINameB << ") = " << c.overlap.Dice_Coefficient());
+            FUNCINFO("Jaccard coefficient(" << c.ROINameA << "," << c.ROINameB << ") = " << c.overlap.Jaccard_Coefficient());
+            FUNCINFO("Hausdorff distance(" << c.ROINameA << "," << c.ROINameB << ") = " << c.distances.hausdorff);
+            comparisons.emplace_back(c);
+        }
+    }
+    if(comparisons.empty()){
+        throw std::invalid_argument("No distinct pairs of ROIs were selected. Cannot continue.");
     }
 
     //Report the findings. 
@@ -209,31 +254,52 @@ Drover ContourSimilarity(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
         if(FileName.empty()){
             FileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_contoursimilarity_", 6, ".csv");
         }
-        const auto FirstWrite = !Does_File_Exist_And_Can_Be_Read(FileName);
+        const std::string Header = "UserComment,"
+                                   "PatientID,"
+                                   "ROInameA,"
+                                   "NormalizedROInameA,"
+                                   "ROInameB,"
+                                   "NormalizedROInameB,"
+                                   "DiceSimilarity,"
+                                   "JaccardSimilarity,"
+                                   "MeanSurfaceDistance,"
+                                   "HausdorffDistance95,"
+                                   "HausdorffDistance";
+
+        // Rows are only appended beneath a matching header, since columns would otherwise be misattributed.
+        bool FirstWrite = true;
+        if(Does_File_Exist_And_Can_Be_Read(FileName)){
+            std::ifstream FI(FileName);
+            std::string ExistingHeader;
+            if(std::getline(FI, ExistingHeader) && !ExistingHeader.empty()){
+                if(ExistingHeader != Header){
+                    throw std::runtime_error("Existing file '"_s + FileName + "' has a different header."
+                                             " Refusing to append. Cannot continue.");
+                }
+                FirstWrite = false;
+            }
+        }
         std::fstream FO(FileName, std::fstream::out | std::fstream::app);
         if(!FO){
             throw std::runtime_error("Unable to open file for reporting similarity. Cannot continue.");
         }
         if(FirstWrite){ // Write a CSV header.
-            FO << "UserComment,"
-               << "PatientID,"
-               << "ROInameA,"
-               << "NormalizedROInameA,"
-               << "ROInameB,"
-               << "NormalizedROInameB,"
-               << "CosineSimilarity,"
-               << "JaccardSimilarity"
+            FO << Header << std::endl;
+        }
+        for(const auto &c : comparisons){
+            FO << UserComment.value_or("") << ","
+               << c.patient_ID        << ","
+               << c.ROINameA          << ","
+               << X(c.ROINameA)       << ","
+               << c.ROINameB          << ","
+               << X(c.ROINameB)       << ","
+               << c.overlap.Dice_Coefficient() << ","
+               << c.overlap.Jaccard_Coefficient() << ","
+               << c.distances.mean << ","
+               << c.distances.hausdorff_95 << ","
+               << c.distances.hausdorff
                << std::endl;
         }
-        FO << UserComment.value_or("") << ","
-           << patient_ID        << ","
-           << ROINameA          << ","
-           << X(ROINameA)       << ","
-           << ROINameB          << ","
-           << X(ROINameB)       << ","
-           << ud.Dice_Coefficient() << ","
-           << ud.Jaccard_Coefficient()
-           << std::endl;
         FO.flush();
         FO.close();
 
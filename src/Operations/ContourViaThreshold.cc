@@ -2,6 +2,7 @@
 
 #include <asio.hpp>
 #include <algorithm>
+#include <cstdint>
 #include <optional>
 #include <fstream>
 #include <iterator>
@@ -147,6 +148,160 @@ OperationDoc OpArgDocContourViaThreshold(void){
 
 
 
+// Traces the boundaries of the pixels selected by an oracle, producing closed contours that follow pixel edges.
+//
+// Pixel inclusivity is run-length encoded per row, and boundary half-edges are recorded in a flat per-vertex bitmask
+// with one bit per outgoing direction. Vertices lie on pixel corners. When merging adjacent pixels only the edges that
+// separate included and excluded pixels are created; otherwise all four edges of every included pixel are created.
+//
+// Loops are walked by always taking the outgoing half-edge with the smallest destination vertex index, so pinches and
+// holes are resolved exactly as they were by the original map-of-sets implementation. Colinear vertices are omitted
+// while walking.
+template <class Oracle>
+static
+std::list<contour_of_points<double>>
+Trace_Pixel_Boundaries(const planar_image<float,double> &img,
+                       long int chnl,
+                       const Oracle &pixel_oracle,
+                       bool merge_adjacent){
+    const auto R = img.rows;
+    const auto C = img.columns;
+    const auto N_chns = img.channels;
+
+    // Run-length encode the included pixels of each row. Runs are half-open column intervals [first, second), and the
+    // runs of row r are runs[row_runs[r]] through runs[row_runs[r+1] - 1].
+    std::vector<std::pair<long int, long int>> runs;
+    std::vector<size_t> row_runs(R + 1, 0);
+    for(long int r = 0; r < R; ++r){
+        const float *row = img.data.data() + static_cast<size_t>(r * C * N_chns + chnl);
+        long int c = 0;
+        while(c < C){
+            while( (c < C) && !pixel_oracle(row[c * N_chns]) ) ++c;
+            if(C <= c) break;
+            const auto first = c;
+            while( (c < C) && pixel_oracle(row[c * N_chns]) ) ++c;
+            runs.emplace_back(first, c);
+        }
+        row_runs[r + 1] = runs.size();
+    }
+
+    // Outgoing half-edges. Bits are ordered by the destination vertex index, so the lowest set bit is always the
+    // half-edge leading to the smallest vertex index.
+    enum : uint8_t { dir_up = 1, dir_left = 2, dir_right = 4, dir_down = 8 };
+    const auto vert_stride = C + 1;
+    std::vector<uint8_t> out_edges( static_cast<size_t>((R + 1) * vert_stride), 0 );
+    const auto vert_index = [vert_stride](long int vert_row, long int vert_col) -> size_t {
+        return static_cast<size_t>(vert_stride * vert_row + vert_col);
+    };
+
+    if(merge_adjacent){
+        // Vertical edges. Only the ends of a run border excluded pixels in the same row.
+        for(long int r = 0; r < R; ++r){
+            for(auto i = row_runs[r]; i < row_runs[r + 1]; ++i){
+                out_edges[ vert_index(r, runs[i].first) ] |= dir_down;
+                out_edges[ vert_index(r + 1, runs[i].second) ] |= dir_up;
+            }
+        }
+
+        // Horizontal edges. Vertex row vr separates pixel row (vr - 1) above from pixel row vr below, and edges are
+        // needed wherever exactly one of the two is included. These spans are found by merging the runs of both rows.
+        std::vector<std::pair<long int, uint8_t>> toggles; // (column, 1 = above or 2 = below).
+        for(long int vr = 0; vr <= R; ++vr){
+            toggles.clear();
+            if(0 < vr){
+                for(auto i = row_runs[vr - 1]; i < row_runs[vr]; ++i){
+                    toggles.emplace_back(runs[i].first, 1);
+                    toggles.emplace_back(runs[i].second, 1);
+                }
+            }
+            const auto N_above = toggles.size();
+            if(vr < R){
+                for(auto i = row_runs[vr]; i < row_runs[vr + 1]; ++i){
+                    toggles.emplace_back(runs[i].first, 2);
+                    toggles.emplace_back(runs[i].second, 2);
+                }
+            }
+            std::inplace_merge(std::begin(toggles), std::next(std::begin(toggles), N_above), std::end(toggles),
+                               [](const auto &A, const auto &B){ return A.first < B.first; });
+
+            uint8_t state = 0;
+            long int prev = 0;
+            for(const auto &t : toggles){
+                if(state == 1){
+                    // Only the pixel above is included, so these are the bottom edges of its pixels.
+                    for(auto c = prev; c < t.first; ++c) out_edges[ vert_index(vr, c) ] |= dir_right;
+                }else if(state == 2){
+                    // Only the pixel below is included, so these are the top edges of its pixels.
+                    for(auto c = prev; c < t.first; ++c) out_edges[ vert_index(vr, c + 1) ] |= dir_left;
+                }
+                state ^= t.second;
+                prev = t.first;
+            }
+        }
+
+    }else{
+        for(long int r = 0; r < R; ++r){
+            for(auto i = row_runs[r]; i < row_runs[r + 1]; ++i){
+                for(auto c = runs[i].first; c < runs[i].second; ++c){
+                    out_edges[ vert_index(r + 1, c    ) ] |= dir_right; // Bottom-left to bottom-right.
+                    out_edges[ vert_index(r + 1, c + 1) ] |= dir_up;    // Bottom-right to top-right.
+                    out_edges[ vert_index(r,     c + 1) ] |= dir_left;  // Top-right to top-left.
+                    out_edges[ vert_index(r,     c    ) ] |= dir_down;  // Top-left to bottom-left.
+                }
+            }
+        }
+    }
+
+    // Walk all available half-edges forming contour perimeters.
+    const auto corner = img.position(0,0) - img.row_unit*img.pxl_dx*0.5 - img.col_unit*img.pxl_dy*0.5;
+    const auto vert_pos = [&](size_t v) -> vec3<double> {
+        const auto vert_row = static_cast<long int>(v) / vert_stride;
+        const auto vert_col = static_cast<long int>(v) % vert_stride;
+        return corner + img.row_unit*img.pxl_dx*vert_row
+                      + img.col_unit*img.pxl_dy*vert_col;
+    };
+    const auto retire_edge = [&](size_t v) -> uint8_t {
+        const auto e = out_edges[v];
+        const auto d = static_cast<uint8_t>(e & (~e + 1U)); // Lowest set bit.
+        out_edges[v] = static_cast<uint8_t>(e ^ d);
+        return d;
+    };
+    const auto traverse = [vert_stride](size_t v, uint8_t d) -> size_t {
+        return (d == dir_up)    ? v - static_cast<size_t>(vert_stride)
+             : (d == dir_left)  ? v - 1
+             : (d == dir_right) ? v + 1
+                                : v + static_cast<size_t>(vert_stride);
+    };
+
+    std::list<contour_of_points<double>> copl;
+    const auto N_verts = out_edges.size();
+    for(size_t A = 0; A < N_verts; ++A){
+        while(out_edges[A] != 0){
+            copl.emplace_back();
+            copl.back().closed = true;
+            auto &points = copl.back().points;
+
+            // Vertices are only emitted where the direction changes. The starting vertex is handled last, once the
+            // direction of the half-edge that closes the loop is known.
+            const auto d_first = retire_edge(A);
+            auto d_in = d_first;
+            auto B = traverse(A, d_first);
+            while(B != A){
+                const auto d_out = retire_edge(B);
+                if(d_out == 0){
+                    throw std::logic_error("Encountered an unterminated contour perimeter. Cannot continue.");
+                }
+                if(d_out != d_in) points.emplace_back(vert_pos(B));
+                d_in = d_out;
+                B = traverse(B, d_out);
+            }
+            if(d_in != d_first) points.emplace_back(vert_pos(A));
+        }
+    }
+    return copl;
+}
+
+
 Drover ContourViaThreshold(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std::string,std::string> /*InvocationMetadata*/, std::string FilenameLex){
 
     Explicator X(FilenameLex);
@@ -200,7 +355,6 @@ Drover ContourViaThreshold(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
     for(auto & iap_it : IAs){
         const long int img_count = (*iap_it)->imagecoll.images.size();
 
-        asio_thread_pool tp;
         std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
         long int completed = 0;
 
@@ -245,6 +399,9 @@ Drover ContourViaThreshold(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
             return (cl <= p) && (p <= cu);
         };
 
+        // Note: the thread pool is declared last so that it is destroyed (i.e., waits for all tasks) before any of the
+        // state the tasks refer to.
+        asio_thread_pool tp;
         for(const auto &animg : (*iap_it)->imagecoll.images){
             if( (animg.rows < 1) || (animg.columns < 1) || (Channel >= animg.channels) ){
                 throw std::runtime_error("Image or channel is empty -- cannot contour via thresholds.");
@@ -256,138 +413,17 @@ Drover ContourViaThreshold(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
                 if(false){
                 }else if(std::regex_match(MethodStr, binary_regex)){
 
-                    const auto R = animg.rows;
-                    const auto C = animg.columns;
-
-                    //Construct the vertex grid. Vertices are in the corners of pixels, but we also need a mapping from
-                    // pixel coordinate space to the vertex grid storage indices.
-                    const auto vert_count = (R+1)*(C+1);
-                    std::vector<vec3<double>> verts( vert_count );
-                    enum row_modif { r_neg = 0, r_pos = 1 }; // Modifiers which translate (in the img plane) +-1/2 of pxl_dx.
-                    enum col_modif { c_neg = 0, c_pos = 1 }; // Modifiers which translate (in the img plane) +-1/2 of pxl_dy.
-
-                    const auto vert_index = [R,C](long int vert_row, long int vert_col) -> long int {
-                        return (C+1)*vert_row + vert_col;
-                    };
-                    const auto vert_mapping = [vert_index,R,C](long int r, long int c, row_modif rm, col_modif cm ) -> long int {
-                        const auto vert_row = r + rm;
-                        const auto vert_col = c + cm;
-                        return vert_index(vert_row,vert_col);
-                    };
-
-                    //Pin each vertex grid element to the appropriate pixel corner.
-                    const auto corner = animg.position(0,0) - animg.row_unit*animg.pxl_dx*0.5 - animg.col_unit*animg.pxl_dy*0.5;
-                    for(auto r = 0; r < (R+1); ++r){
-                        for(auto c = 0; c < (C+1); ++c){
-                            verts.at(vert_index(r,c)) = corner + animg.row_unit*animg.pxl_dx*r
-                                                               + animg.col_unit*animg.pxl_dy*c;
-                        }
-                    }
-
-                    //Construct a container for storing half-edges.
-                    std::map<long int, std::set<long int>> half_edges;
-
-                    //Iterate over each pixel. If the oracle tells us the pixel is within the ROI, add four half-edges
-                    // around the pixel's perimeter.
-                    for(auto r = 0; r < R; ++r){
-                        for(auto c = 0; c < C; ++c){
-                            if(pixel_oracle(animg.value(r, c, Channel))){
-                                const auto bot_l = vert_mapping(r,c,r_pos,c_neg);
-                                const auto bot_r = vert_mapping(r,c,r_pos,c_pos);
-                                const auto top_r = vert_mapping(r,c,r_neg,c_pos);
-                                const auto top_l = vert_mapping(r,c,r_neg,c_neg);
-
-                                half_edges[bot_l].insert(bot_r);
-                                half_edges[bot_r].insert(top_r);
-                                half_edges[top_r].insert(top_l);
-                                half_edges[top_l].insert(bot_l);
-                            }
-                        }
-                    }
-
-                    //Find and remove all cancelling half-edges, which are equivalent to circular two-vertex loops.
-                    if(SimplifyMergeAdjacent){
-                        //'Retire' half-edges by merely removing their endpoint, invalidating them.
-                        for(auto &he_group : half_edges){
-                            const auto A = he_group.first;
-                            auto B_it = he_group.second.begin();
-                            while(B_it != he_group.second.end()){
-                                const auto he_group2_it = half_edges.find(*B_it);
-                                if( (he_group2_it != half_edges.end()) 
-                                &&  (he_group2_it->second.count(A) != 0) ){
-                                    //Cycle detected -- remove both half-edges.
-                                    he_group2_it->second.erase(A);
-                                    B_it = he_group.second.erase(B_it);
-                                }else{
-                                    ++B_it;
-                                }
-                            }
-                        }
-                    }
-
-                    // Additional simplification could be performed here...
-                    // 
-                    // Ideas:
-                    //   - Simplify straight lines by removing redundant vertices along line segments.
-                    //     (Can this be done on the contour later?)
-                    //
-                    //   - Remove vertices that do not affect the total area appreciably. (Note: do this for the contour.)
-                    //  
-
-                    
-                    //Walk all available half-edges forming contour perimeters.
-                    std::list<contour_of_points<double>> copl;
-                    if(!half_edges.empty()){
-                        auto he_it = half_edges.begin();
-                        while(he_it != half_edges.end()){
-                            if(he_it->second.empty()){
-                                ++he_it;
-                                continue;
-                            }
-
-                            copl.emplace_back();
-                            copl.back().closed = true;
-                            copl.back().metadata["ROIName"] = ROILabel;
-                            copl.back().metadata["NormalizedROIName"] = NormalizedROILabel;
-                            copl.back().metadata["Description"] = "Contoured via threshold ("_s + std::to_string(Lower)
-                                                                 + " <= pixel_val <= " + std::to_string(Upper) + ")";
-                            copl.back().metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
-                            for(const auto &key : { "StudyInstanceUID", "FrameofReferenceUID" }){
-                                if(animg.metadata.count(key) != 0) copl.back().metadata[key] = animg.metadata.at(key);
-                            }
-
-                            const auto A = he_it->first; //The starting node.
-                            auto B = A;
-                            do{
-                                const auto B_he_it = half_edges.find(B);
-                                auto B_it = B_he_it->second.begin(); // TODO: pick left-most (relative to current direction) node.
-                                                                     //       This is how you can will get consistent orientation handling!
-
-                                B = *B_it;
-                                copl.back().points.emplace_back(verts[B]); //Add the vertex to the current contour.
-                                B_he_it->second.erase(B_it); //Retire the node.
-                            }while(B != A);
-                        }
-                    }
-
-                    // Try to simplify the contours as much as possible.
-                    //
-                    // The following will straddle each vertex, interpolate the adjacent vertices, and compare the
-                    // interpolated vertex to the actual (straddled) vertex. If they differ by a small amount, the straddled
-                    // vertex is pruned. 1% should be more than enough to account for numerical fluctuations.
-                    /*
-                    if(SimplifyMergeAdjacent){
-                        const auto tolerance_sq_dist = 0.01*(animg.pxl_dx*animg.pxl_dx + animg.pxl_dy*animg.pxl_dy + animg.pxl_dz*animg.pxl_dz);
-                        const auto verts_are_equal = [=](const vec3<double> &A, const vec3<double> &B) -> bool {
-                            return A.sq_dist(B) < tolerance_sq_dist;
-                        };
-                        for(auto &cop : copl){
-                            cop.Remove_Sequential_Duplicate_Points(verts_are_equal);
-                            cop.Remove_Extraneous_Points(verts_are_equal);
+                    auto copl = Trace_Pixel_Boundaries(animg, Channel, pixel_oracle, SimplifyMergeAdjacent);
+                    for(auto &cop : copl){
+                        cop.metadata["ROIName"] = ROILabel;
+                        cop.metadata["NormalizedROIName"] = NormalizedROILabel;
+                        cop.metadata["Description"] = "Contoured via threshold ("_s + std::to_string(Lower)
+                                                     + " <= pixel_val <= " + std::to_string(Upper) + ")";
+                        cop.metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
+                        for(const auto &key : { "StudyInstanceUID", "FrameofReferenceUID" }){
+                            if(animg.metadata.count(key) != 0) cop.metadata[key] = animg.metadata.at(key);
                         }
                     }
-                    */
-
 
                     //Save the contours and print some information to screen.
                     {
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <optional>
 #include <fstream>
+#include <functional>
 #include <iterator>
 #include <list>
 #include <map>
@@ -128,29 +129,40 @@ Drover ConvertMeshesToContours(Drover DICOM_data, OperationArgPkg OptArgs, std::
         //       Proceeding with a manifold mesh can cause lots of issues later.
         //dcma_surface_meshes::Polyhedron surface_mesh = dcma_surface_meshes::FVSMeshToPolyhedron((*smp_it)->meshes);
 
+        // Gather all image planes so the mesh can be sliced in a single pass.
         auto IAs_all = All_IAs( DICOM_data );
         auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+        std::list<std::reference_wrapper<const planar_image<float,double>>> imgs;
+        std::list<plane<double>> img_planes;
         for(auto & iap_it : IAs){
             for(const auto &animg : (*iap_it)->imagecoll.images){
-                // Slice the mesh along the image plane.
-                auto lcc = polyhedron_processing::Slice_Polyhedron( surface_mesh, 
-                                                                    {{ animg.image_plane() }} );
-
-                // Tag the contours with metadata.
-                for(auto &cop : lcc.contours){
-                    cop.closed = true;
-                    cop.metadata["ROIName"] = ROILabel;
-                    cop.metadata["NormalizedROIName"] = NormalizedROILabel;
-                    cop.metadata["Description"] = "Sliced surface mesh";
-                    cop.metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
-                    for(const auto &key : { "StudyInstanceUID", "FrameofReferenceUID" }){
-                        if(animg.metadata.count(key) != 0) cop.metadata[key] = animg.metadata.at(key);
-                    }
-                }
+                imgs.emplace_back( std::cref(animg) );
+                img_planes.emplace_back( animg.image_plane() );
+            }
+        }
 
-                DICOM_data.contour_data->ccs.back().contours.splice(DICOM_data.contour_data->ccs.back().contours.end(),
-                                                                    lcc.contours);
+        // Slice the mesh along the image planes.
+        auto lccs = polyhedron_processing::Slice_Polyhedron_Per_Plane( surface_mesh, img_planes );
+
+        auto lcc_it = std::begin(lccs);
+        for(const auto &animg_refw : imgs){
+            const auto &animg = animg_refw.get();
+            auto &lcc = *(lcc_it++);
+
+            // Tag the contours with metadata.
+            for(auto &cop : lcc.contours){
+                cop.closed = true;
+                cop.metadata["ROIName"] = ROILabel;
+                cop.metadata["NormalizedROIName"] = NormalizedROILabel;
+                cop.metadata["Description"] = "Sliced surface mesh";
+                cop.metadata["MinimumSeparation"] = std::to_string(MinimumSeparation);
+                for(const auto &key : { "StudyInstanceUID", "FrameofReferenceUID" }){
+                    if(animg.metadata.count(key) != 0) cop.metadata[key] = animg.metadata.at(key);
+                }
             }
+
+            DICOM_data.contour_data->ccs.back().contours.splice(DICOM_data.contour_data->ccs.back().contours.end(),
+                                                                lcc.contours);
         }
 
         ++completed;
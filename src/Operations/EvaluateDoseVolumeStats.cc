@@ -224,29 +224,34 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data, OperationArgPkg OptArgs, std::
         patient_ID = "unknown_person";
     }
 
-    //Accumulate the voxel intensity distributions.
+    //Accumulate summary statistics of the voxel intensity distributions. Only the statistics are needed, so individual
+    // voxels are not retained. Voxels exceeding 95% of the prescription dose are counted via an indicator term.
+    const auto Dpres95 = 0.95 * PTVPrescriptionDose;
+    voxel_statistics prototype;
+    prototype.terms.emplace_back( [Dpres95](double D) -> double { return (D > Dpres95) ? 1.0 : 0.0; } );
+
     AccumulatePixelDistributionsUserData ud_PTV;
+    ud_PTV.retain_voxels = false;
+    ud_PTV.prototype = prototype;
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_PTV_ROIs, &ud_PTV )){
         throw std::runtime_error("Unable to accumulate PTV pixel distributions.");
     }
     AccumulatePixelDistributionsUserData ud_Body;
+    ud_Body.retain_voxels = false;
+    ud_Body.prototype = prototype;
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_Body_ROIs, &ud_Body )){
         throw std::runtime_error("Unable to accumulate Body pixel distributions.");
     }
 
 
-    const auto Dpres95 = 0.95 * PTVPrescriptionDose;
     long int N_Body_over_Dpres95 = 0; //We assume all body ROIs are part of a single object.
 
     //Evalute the models.
     {
-        for(auto &av : ud_Body.accumulated_voxels){
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_Body_over_Dpres95;
-            }
-            av.second.clear(); // Reduce memory pressure.
+        for(const auto &av : ud_Body.aggregated_voxels){
+            N_Body_over_Dpres95 += std::lround(av.second.term_sums.at(0));
         }
     }
 
@@ -255,24 +260,20 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data, OperationArgPkg OptArgs, std::
 
     std::map<std::string, long int> N_PTV_over_Dpres95; //We assume all PTV ROIs are distinct.
     {
-        for(const auto &av : ud_PTV.accumulated_voxels){
+        for(const auto &av : ud_PTV.aggregated_voxels){
             const auto lROIname = av.first;
 
-            const auto D_02 = Stats::Percentile(av.second, 0.98); // D_02 == 98% dose percentile.
-            const auto D_50 = Stats::Percentile(av.second, 0.50);
-            const auto D_98 = Stats::Percentile(av.second, 0.02); // D_98 == 2% dose percentile.
+            const auto D_02 = av.second.get_quantile(0.98); // D_02 == 98% dose percentile.
+            const auto D_50 = av.second.get_quantile(0.50);
+            const auto D_98 = av.second.get_quantile(0.02); // D_98 == 2% dose percentile.
 
             HI[lROIname] = (D_02 - D_98)/D_50;
 
-            long int N_over_Dpres95 = 0;
-            for(const auto &D_voxel : av.second){
-                if(D_voxel > Dpres95) ++N_over_Dpres95;
-            }
-            N_PTV_over_Dpres95[lROIname] += N_over_Dpres95;
+            N_PTV_over_Dpres95[lROIname] += std::lround(av.second.term_sums.at(0));
         }
-        for(const auto &av : ud_PTV.accumulated_voxels){
+        for(const auto &av : ud_PTV.aggregated_voxels){
             const auto lROIname = av.first;
-            const auto N = av.second.size();
+            const auto N = av.second.count;
             //const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
 
             const auto N_T = static_cast<double>(N);
@@ -317,13 +318,13 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data, OperationArgPkg OptArgs, std::
                    << "VoxelCount"
                    << std::endl;
         }
-        for(const auto &av : ud_PTV.accumulated_voxels){
+        for(const auto &av : ud_PTV.aggregated_voxels){
             const auto lROIname = av.first;
-            const auto DoseMin = Stats::Min( av.second );
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseMax = Stats::Max( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+            const auto DoseMin = av.second.min;
+            const auto DoseMean = av.second.get_mean();
+            const auto DoseMedian = av.second.get_median();
+            const auto DoseMax = av.second.max;
+            const auto DoseStdDev = av.second.get_stddev();
             const auto HeterogeneityIndex = HI[lROIname];
             const auto ConformityNumber = CN[lROIname];
 
@@ -338,7 +339,7 @@ Drover EvaluateDoseVolumeStats(Drover DICOM_data, OperationArgPkg OptArgs, std::
                     << DoseMedian         << ","
                     << DoseMax            << ","
                     << DoseStdDev         << ","
-                    << av.second.size()
+                    << av.second.count
                     << std::endl;
         }
         FO_tcp.flush();
@@ -267,8 +267,15 @@ Drover EvaluateNTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         patient_ID = "unknown_patient";
     }
 
-    //Accumulate the voxel intensity distributions.
+    //Accumulate summary statistics of the voxel intensity distributions. Only the statistics are needed, so individual
+    // voxels are not retained.
+    //
+    // LKB model: the per-voxel gEUD term is tracked as a running sum.
+    //
+    // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
     AccumulatePixelDistributionsUserData ud;
+    ud.retain_voxels = false;
+    ud.prototype.terms.emplace_back( voxel_statistics_power_term(LKB_Alpha) ); //Non-finite (e.g., 0^-x) terms are ignored.
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_ROIs, &ud )){
         throw std::runtime_error("Unable to accumulate pixel distributions.");
@@ -279,47 +286,22 @@ Drover EvaluateNTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
     std::map<std::string, double> FenwickModel;
 //    std::map<std::string, double> mEUDModel;
     {
-        for(const auto &av : ud.accumulated_voxels){
+        for(const auto &av : ud.aggregated_voxels){
             const auto lROIname = av.first;
 
-            const auto N = av.second.size();
+            const auto N = av.second.count;
             const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
 
-            std::vector<double> LKB_gEUD_elements;
-//            std::vector<double> mEUD_elements;
-            LKB_gEUD_elements.reserve(N);
-//            mEUD_elements.reserve(N);
-            for(const auto &D_voxel : av.second){
-                // LKB model.
-                //
-                // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
-                {
-                    const auto scaled = std::pow(D_voxel, LKB_Alpha); //Problematic for (non-physical) 0.0.
-                    if(std::isfinite(scaled)){
-                        LKB_gEUD_elements.push_back(V_frac * std::pow(D_voxel, LKB_Alpha));
-                    }else{
-                        LKB_gEUD_elements.push_back(0.0); //No real need to include this except acknowledging what we are doing.
-                    }
-                }
-                
-                // mEUD model.
-                //
-                // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
-                {
+            // mEUD model.
+            //
+            // Note: Assumes voxel doses are EQD2. Pre-convert if the RT plan is not already in 2Gy/fraction!
 //NOTE: this model only uses the 100c with the highest dose. So sort and filter the voxels before computing mEUD!
 // Also, the model presented by Huang et al. is underspecified in their paper. Check the original for more comprehensive
 // explanation.
-//                    gEUD_elements.push_back(V_frac * std::pow(D_voxel, gEUD_Alpha));
-                }
-
-                // ... other models ...
-                // ...
-
-            }
 
             //Post-processing.
             {
-                const auto OAR_mean_dose = Stats::Mean(av.second);
+                const auto OAR_mean_dose = av.second.get_mean();
                 const auto numer = OAR_mean_dose - 29.2;
                 const auto denom = 13.1 * std::sqrt(2);
                 const auto t = numer/denom;
@@ -327,7 +309,7 @@ Drover EvaluateNTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
                 FenwickModel[lROIname] = NTCP_Fenwick;
             }
             {
-                const long double LKB_gEUD = std::pow( Stats::Sum(LKB_gEUD_elements), static_cast<long double>(1) / LKB_Alpha );
+                const long double LKB_gEUD = std::pow( V_frac * av.second.term_sums.at(0), static_cast<long double>(1) / LKB_Alpha );
 
                 const long double numer = LKB_gEUD - LKB_TD50;
                 const long double denom = LKB_M * LKB_TD50 * std::sqrt(2.0);
@@ -384,13 +366,13 @@ Drover EvaluateNTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
                    << "VoxelCount"
                    << std::endl;
         }
-        for(const auto &av : ud.accumulated_voxels){
+        for(const auto &av : ud.aggregated_voxels){
             const auto lROIname = av.first;
-            const auto DoseMin = Stats::Min( av.second );
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseMax = Stats::Max( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+            const auto DoseMin = av.second.min;
+            const auto DoseMean = av.second.get_mean();
+            const auto DoseMedian = av.second.get_median();
+            const auto DoseMax = av.second.max;
+            const auto DoseStdDev = av.second.get_stddev();
             const auto NTCPLKB = LKBModel[lROIname];
 //            const auto NTCPmEUD = mEUDModel[lROIname];
             const auto NTCPFenwick = FenwickModel[lROIname];
@@ -407,7 +389,7 @@ Drover EvaluateNTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
                     << DoseMedian        << ","
                     << DoseMax           << ","
                     << DoseStdDev        << ","
-                    << av.second.size()
+                    << av.second.count
                     << std::endl;
         }
         FO_tcp.flush();
@@ -309,8 +309,40 @@ Drover EvaluateTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
         patient_ID = "unknown_patient";
     }
 
-    //Accumulate the voxel intensity distributions.
+    //Accumulate summary statistics of the voxel intensity distributions. Only the statistics are needed, so individual
+    // voxels are not retained. Each model's per-voxel contribution is tracked as a running sum.
+    //
+    // The Martel and Fenwick models take the product of per-voxel TCPs raised to the voxel's fractional volume, which
+    // is accumulated as a sum of logarithms.
     AccumulatePixelDistributionsUserData ud;
+    ud.retain_voxels = false;
+
+    // Martel model.
+    ud.prototype.terms.emplace_back( [=](double D_voxel) -> double {
+        const long double numer = std::pow(D_voxel, Gamma50*4);
+        const long double denom = std::pow(Dose50, Gamma50*4) + numer;
+        const long double TCP_voxel = numer/denom; // This is a sigmoid curve.
+        return std::log(TCP_voxel);
+    });
+
+    // gEUD model.
+    ud.prototype.terms.emplace_back( [=](double D_voxel) -> double {
+        return std::pow(D_voxel, EUD_Alpha);
+    });
+
+    // Fenwick model.
+    ud.prototype.terms.emplace_back( [=](double D_voxel) -> double {
+        const long double numer = (D_voxel - Fenwick_D50 - Fenwick_C * std::log(ROI_V/Fenwick_Vref));
+        const long double denom = Fenwick_M * D_voxel * std::sqrt(2.0);
+        //Note: the 'normal distribution function Phi(z)' referred to in Fenwick's paper is
+        // (1/sqrt(2pi))*integral(exp(-x*x/2)dx, -inf, z) == 0.5*(1+erf(z/sqrt(2))).
+        const long double TCP_voxel = 0.5*(1.0 + std::erf(numer/denom)); // This is a sigmoid curve.
+        return std::log(TCP_voxel);
+    });
+
+    // ... other models ...
+    // ...
+
     if(!img_arr_ptr->imagecoll.Compute_Images( AccumulatePixelDistributions, { },
                                                cc_ROIs, &ud )){
         throw std::runtime_error("Unable to accumulate pixel distributions.");
@@ -321,52 +353,18 @@ Drover EvaluateTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
     std::map<std::string, double> gEUDModel;
     std::map<std::string, double> FenwickModel;
     {
-        for(const auto &av : ud.accumulated_voxels){
+        for(const auto &av : ud.aggregated_voxels){
             const auto lROIname = av.first;
 
-            const auto N = av.second.size();
+            const auto N = av.second.count;
             const long double V_frac = static_cast<long double>(1) / N; // Fractional volume of a single voxel compared to whole ROI.
 
-            double TCP_Martel = static_cast<long double>(1);
-            double TCP_Fenwick = static_cast<long double>(1);
-
-            std::vector<double> gEUD_elements;
-            gEUD_elements.reserve(N);
-            for(const auto &D_voxel : av.second){
-                // Martel model.
-                {
-                    const long double numer = std::pow(D_voxel, Gamma50*4);
-                    const long double denom = std::pow(Dose50, Gamma50*4) + numer;
-                    const long double TCP_voxel = numer/denom; // This is a sigmoid curve.
-                    TCP_Martel *= std::pow(TCP_voxel, V_frac);
-                }
-                
-                // gEUD model.
-                {
-                    gEUD_elements.push_back(V_frac * std::pow(D_voxel, EUD_Alpha));
-                }
-
-                // Fenwick model.
-                {
-                    const long double numer = (D_voxel - Fenwick_D50 - Fenwick_C * std::log(ROI_V/Fenwick_Vref));
-                    const long double denom = Fenwick_M * D_voxel * std::sqrt(2.0);
-                    //Note: the 'normal distribution function Phi(z)' referred to in Fenwick's paper is
-                    // (1/sqrt(2pi))*integral(exp(-x*x/2)dx, -inf, z) == 0.5*(1+erf(z/sqrt(2))).
-                    const long double TCP_voxel = 0.5*(1.0 + std::erf(numer/denom)); // This is a sigmoid curve.
-                    TCP_Fenwick *= std::pow(TCP_voxel, V_frac);
-                }
-
-                // ... other models ...
-                // ...
-
-            }
-
             //Post-processing.
-            MartelModel[lROIname] = TCP_Martel;
-            FenwickModel[lROIname] = TCP_Fenwick;
+            MartelModel[lROIname] = std::exp(V_frac * av.second.term_sums.at(0));
+            FenwickModel[lROIname] = std::exp(V_frac * av.second.term_sums.at(2));
 
             {
-                const long double gEUD = std::pow( Stats::Sum(gEUD_elements), static_cast<long double>(1) / EUD_Alpha );
+                const long double gEUD = std::pow( V_frac * av.second.term_sums.at(1), static_cast<long double>(1) / EUD_Alpha );
 
                 const long double numer = std::pow(gEUD, EUD_Gamma50*4);
                 const long double denom = numer + std::pow(EUD_TCD50, EUD_Gamma50*4);
@@ -410,11 +408,11 @@ Drover EvaluateTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
                    << "VoxelCount"
                    << std::endl;
         }
-        for(const auto &av : ud.accumulated_voxels){
+        for(const auto &av : ud.aggregated_voxels){
             const auto lROIname = av.first;
-            const auto DoseMean = Stats::Mean( av.second );
-            const auto DoseMedian = Stats::Median( av.second );
-            const auto DoseStdDev = std::sqrt(Stats::Unbiased_Var_Est( av.second ));
+            const auto DoseMean = av.second.get_mean();
+            const auto DoseMedian = av.second.get_median();
+            const auto DoseStdDev = av.second.get_stddev();
             const auto TCPMartel = MartelModel[lROIname];
             const auto TCPgEUD = gEUDModel[lROIname];
             const auto TCPFenwick = FenwickModel[lROIname];
@@ -429,7 +427,7 @@ Drover EvaluateTCPModels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<st
                     << DoseMean          << ","
                     << DoseMedian        << ","
                     << DoseStdDev        << ","
-                    << av.second.size()  << std::endl;
+                    << av.second.count   << std::endl;
         }
         FO_tcp.flush();
         FO_tcp.close();
@@ -45,7 +45,7 @@ OperationDoc OpArgDocExportSurfaceMeshes(void){
     out.args.emplace_back();
     out.args.back().name = "Filename";
     out.args.back().desc = "The filename (or full path name) to which the surface mesh data should be written."
-                           " The file format is an ASCII OFF model."
+                           " The file format is controlled by the 'Format' parameter."
                            " If no name is given, unique names will be chosen automatically.";
     out.args.back().default_val = "";
     out.args.back().expected = true;
@@ -54,6 +54,15 @@ OperationDoc OpArgDocExportSurfaceMeshes(void){
                                  "/path/to/some/surface_mesh.off" };
     out.args.back().mimetype = "application/object-file-format"; // TODO: find correct MIME type.
 
+    out.args.emplace_back();
+    out.args.back().name = "Format";
+    out.args.back().desc = "The file format to write. 'OFF' writes only the mesh geometry."
+                           " 'PLY' writes an ASCII PLY file that also includes all vertex and face attributes as"
+                           " element properties.";
+    out.args.back().default_val = "OFF";
+    out.args.back().expected = true;
+    out.args.back().examples = { "OFF", "PLY" };
+
     return out;
 }
 
@@ -64,19 +73,35 @@ Drover ExportSurfaceMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
     //---------------------------------------------- User Parameters --------------------------------------------------
     const auto MeshSelectionStr = OptArgs.getValueStr("MeshSelection").value();
     auto FilenameStr = OptArgs.getValueStr("Filename").value();
+    const auto FormatStr = OptArgs.getValueStr("Format").value();
 
     //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_off = Compile_Regex("^of?f?$");
+    const auto regex_ply = Compile_Regex("^pl?y?$");
+
+    const bool write_off = std::regex_match(FormatStr, regex_off);
+    const bool write_ply = std::regex_match(FormatStr, regex_ply);
+    if(!write_off && !write_ply){
+        throw std::invalid_argument("Format not understood. Cannot continue.");
+    }
 
     auto SMs_all = All_SMs( DICOM_data );
     auto SMs = Whitelist( SMs_all, MeshSelectionStr );
     for(auto & smp_it : SMs){
         auto FN = FilenameStr;
         if(FilenameStr.empty()){
-            FN = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_exportsurfacemeshes_", 6, ".off");
+            FN = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_exportsurfacemeshes_", 6,
+                                                (write_ply) ? ".ply" : ".off");
         }
         std::fstream FO(FN, std::fstream::out);
 
-        if(!WriteFVSMeshToOFF( (*smp_it)->meshes, FO )){
+        if(write_ply){
+            if(!mesh_attributes::Write_PLY( (*smp_it)->meshes,
+                                            (*smp_it)->vertex_attributes,
+                                            (*smp_it)->face_attributes, FO )){
+                throw std::runtime_error("Unable to write mesh in PLY format. Cannot continue.");
+            }
+        }else if(!WriteFVSMeshToOFF( (*smp_it)->meshes, FO )){
             throw std::runtime_error("Unable to write mesh in OFF format. Cannot continue.");
         }
         FUNCINFO("Surface mesh written to '" << FN << "'");
@@ -62,6 +62,11 @@ OperationDoc OpArgDocExtractDoseVolumeHistograms(void){
         " If necessary, resample image arrays to be rectilinear."
     );
         
+    out.notes.emplace_back(
+        "Voxels are accumulated into fixed-width dose bins as they are visited, so memory use does not depend on the"
+        " number of voxels. Bin edges are multiples of the bin width, and the histogram always includes zero dose."
+    );
+        
     out.notes.emplace_back(
         "This routine will combine spatially-overlapping images by summing voxel intensities. It will not"
         " combine separate image_arrays. If needed, you'll have to perform a meld on them beforehand."
@@ -146,6 +151,18 @@ OperationDoc OpArgDocExtractDoseVolumeHistograms(void){
     out.args.back().examples = { "0.1", "0.5", "2.0", "5.0", "10", "50" };
 
 
+    out.args.emplace_back();
+    out.args.back().name = "Supersample";
+    out.args.back().desc = "The number of sub-samples along each in-plane voxel axis used to estimate the fraction of each"
+                           " voxel that is within the ROI(s). Voxel volumes are weighted by this fraction, which reduces"
+                           " partial-volume errors for small ROIs and coarse dose grids."
+                           " A value of 1 disables supersampling; each voxel is then either fully in or fully out of the"
+                           " ROI according to the 'Inclusivity' parameter, which is otherwise ignored.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "4", "8" };
+
+
     out.args.emplace_back();
     out.args.back().name = "UserComment";
     out.args.back().desc = "A string that will be inserted into the output file which will simplify merging output"
@@ -174,6 +191,7 @@ Drover ExtractDoseVolumeHistograms(Drover DICOM_data, OperationArgPkg OptArgs, s
     const auto ContourOverlapStr = OptArgs.getValueStr("ContourOverlap").value();
 
     const auto dDose = std::stod(OptArgs.getValueStr("dDose").value());
+    const auto Supersample = std::stol(OptArgs.getValueStr("Supersample").value());
 
     const auto UserComment = OptArgs.getValueStr("UserComment");
 
@@ -220,6 +238,7 @@ Drover ExtractDoseVolumeHistograms(Drover DICOM_data, OperationArgPkg OptArgs, s
         ComputeExtractDoseVolumeHistogramsUserData ud;
 
         ud.dDose = dDose;
+        ud.supersample = Supersample;
         ud.channel = Channel;
 
         ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
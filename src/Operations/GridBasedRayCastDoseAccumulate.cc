@@ -15,14 +15,17 @@
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <utility>
 
 #include "../Dose_Meld.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "../YgorImages_Functors/Compute/GenerateSurfaceMask.h"
+#include "../YgorImages_Functors/Grid_Resampling.h"
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "../YgorImages_Functors/Processing/In_Image_Plane_Bicubic_Supersample.h"
+#include "../YgorImages_Functors/Voxel_Traversal.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "GridBasedRayCastDoseAccumulate.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
@@ -39,6 +42,11 @@ OperationDoc OpArgDocGridBasedRayCastDoseAccumulate(void){
     out.desc = 
         "This operation performs a ray casting to estimate the surface dose of an ROI.";
 
+    out.notes.emplace_back(
+        "When the surface mask and dose images both form rectilinear grids, rays are traversed exactly voxel-by-voxel"
+        " and the RaydL and SmallestFeature parameters are not used. Otherwise rays are marched in fixed steps."
+    );
+
 
     out.args.emplace_back();
     out.args.back().name = "DoseMapFileName";
@@ -461,12 +469,105 @@ Drover GridBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptArgs
 
     //Now ready to ray cast. Loop over integer pixel coordinates. Start and finish are image pixels.
     // The top image can be the length image.
+    const double cleaved_gap_dist = std::abs(ROICleaving.Get_Signed_Distance_To_Point(ROI_centroid));
+
+    // Resolve the surface mask and dose into indexed volumes, if possible, so rays can be traversed exactly.
+    std::optional<voxel_traversal::indexed_volume> mask_vol;
+    std::optional<voxel_traversal::indexed_volume> dose_vol;
     {
+        std::list<std::reference_wrapper<planar_image<float,double>>> mask_imgs;
+        for(auto &img : grid_arr_ptr->imagecoll.images) mask_imgs.push_back( std::ref(img) );
+        std::list<std::reference_wrapper<planar_image<float,double>>> dose_imgs;
+        for(auto &img : img_arr_ptr->imagecoll.images) dose_imgs.push_back( std::ref(img) );
+
+        const auto mask_grid = grid_resampling::Make_Rectilinear_Grid(mask_imgs);
+        const auto dose_grid = grid_resampling::Make_Rectilinear_Grid(dose_imgs);
+        if(mask_grid && dose_grid){
+            mask_vol = voxel_traversal::Make_Indexed_Volume(mask_grid.value(), 0);
+            dose_vol = voxel_traversal::Make_Indexed_Volume(dose_grid.value(), 0);
+        }else{
+            FUNCWARN("Surface mask or dose images are not rectilinear. Falling back to ray marching");
+        }
+    }
+
+    if(mask_vol && dose_vol){
+        // Rays are traversed through the surface mask. Contiguous runs of surface voxels are then traversed through the
+        // dose volume to integrate the dose along the ray within the surface.
+        //
+        // The detector is divided into square tiles, each of which is processed by a single task. Neighbouring rays
+        // traverse nearby voxels, so this improves cache locality compared with processing whole rows.
+        const long int tile_size = 16;
+        const long int tile_rows = (SourceDetectorRows + tile_size - 1) / tile_size;
+        const long int tile_cols = (SourceDetectorColumns + tile_size - 1) / tile_size;
+
         asio_thread_pool tp;
         std::mutex printer; // Who gets to print to the console and iterate the counter.
         long int completed = 0;
+        for(long int tr = 0; tr < tile_rows; ++tr){
+            for(long int tc = 0; tc < tile_cols; ++tc){
+                tp.submit_task([&,tr,tc](void) -> void {
+                    const auto row_end = std::min((tr + 1) * tile_size, SourceDetectorRows);
+                    const auto col_end = std::min((tc + 1) * tile_size, SourceDetectorColumns);
+                    for(long int row = tr * tile_size; row < row_end; ++row){
+                        for(long int col = tc * tile_size; col < col_end; ++col){
+                            const vec3<double> terminus = DetectImg->position(row, col);
+                            const vec3<double> source = SourceImg->position(row, col);
+                            const vec3<double> ray_dir = (terminus - source).unit();
+                            const vec3<double> ray_start = source + ray_dir * cleaved_gap_dist; // Skip the gap which has been cleaved out.
+                            const auto ray_vec = terminus - ray_start;
+                            const auto ray_length = terminus.distance(ray_start);
+
+                            double accumulated_length = 0.0;      //Length of ray travel within the 'surface'.
+                            double accumulated_doselength = 0.0;
+
+                            // Integrates dose along the portion of the ray within [t0, t1].
+                            const auto integrate_dose = [&](double t0, double t1) -> void {
+                                accumulated_length += (t1 - t0) * ray_length;
+                                voxel_traversal::Traverse(dose_vol.value(), ray_start + ray_vec * t0, ray_start + ray_vec * t1,
+                                    [&](std::size_t i, double s0, double s1) -> void {
+                                        accumulated_doselength += static_cast<double>(dose_vol->values[i]) * (s1 - s0) * (t1 - t0) * ray_length;
+                                    });
+                            };
+
+                            double run_t0 = -1.0;
+                            double run_t1 = -1.0;
+                            voxel_traversal::Traverse(mask_vol.value(), ray_start, terminus,
+                                [&](std::size_t i, double t0, double t1) -> void {
+                                    if(mask_vol->values[i] != surface_mask_val) return;
+                                    if(t0 != run_t1){
+                                        if(run_t0 < run_t1) integrate_dose(run_t0, run_t1);
+                                        run_t0 = t0;
+                                    }
+                                    run_t1 = t1;
+                                });
+                            if(run_t0 < run_t1) integrate_dose(run_t0, run_t1);
+
+                            //Deposit the dose in the images.
+                            SourceImg->reference(row, col, 0) = static_cast<float>(accumulated_length);
+                            DetectImg->reference(row, col, 0) = static_cast<float>(accumulated_doselength);
+                            DoseImg->reference(row, col, 0) = 0.0f;
+                            if(accumulated_length != 0.0){
+                                DoseImg->reference(row, col, 0) = static_cast<float>(accumulated_doselength)
+                                                                  / static_cast<float>(accumulated_length);
+                            }
+                        }
+                    }
 
-        const double cleaved_gap_dist = std::abs(ROICleaving.Get_Signed_Distance_To_Point(ROI_centroid));
+                    {
+                        std::lock_guard<std::mutex> lock(printer);
+                        ++completed;
+                        if( (completed % 100 == 0) || (completed == (tile_rows * tile_cols)) ){
+                            FUNCINFO("Completed " << completed << " of " << (tile_rows * tile_cols) << " detector tiles"
+                                  << " --> " << static_cast<int>(1000.0*(completed)/(tile_rows * tile_cols))/10.0 << "% done");
+                        }
+                    }
+                });
+            }
+        }
+    }else{
+        asio_thread_pool tp;
+        std::mutex printer; // Who gets to print to the console and iterate the counter.
+        long int completed = 0;
 
         for(long int row = 0; row < SourceDetectorRows; ++row){
             tp.submit_task([&,row](void) -> void {
@@ -1,16 +1,24 @@
 //GrowContours.cc - A part of DICOMautomaton 2017. Written by hal clark.
 
+#include <cmath>
+#include <exception>
+#include <limits>
 #include <optional>
 #include <list>
 #include <map>
 #include <memory>
 #include <regex>
+#include <stdexcept>
 #include <string>    
+#include <vector>
 
+#include "../Contour_Boolean_Operations.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "GrowContours.h"
 #include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
 
 
 
@@ -19,10 +27,23 @@ OperationDoc OpArgDocGrowContours(void){
     out.name = "GrowContours";
 
     out.desc = 
-        "This routine will grow (or shrink) 2D contours in their plane by the specified amount. "
-        " Growth is accomplish by translating vertices away from the interior by the specified amount."
-        " The direction is chosen to be the direction opposite of the in-plane normal produced by averaging the line"
-        " segments connecting the contours.";
+        "This routine will grow (or shrink) 2D contours in their plane by the specified amount.";
+
+    out.notes.emplace_back(
+        "The 'offset' method computes the exact in-plane Minkowski sum (or difference) of each ROI's region and a"
+        " disc. All contours of an ROI on a plane are processed together. The region is formed with the even-odd"
+        " rule, so contours nested within another contour are treated as holes, as are the holes of contours with"
+        " seams; contour orientation is ignored. Concave features and narrow gaps are handled correctly, and"
+        " features narrower than twice the margin collapse cleanly. Holes and separate components will merge if the"
+        " margin closes the gap between them. The resulting contours never self-intersect, so no repair is needed"
+        " afterward. Planes are processed in parallel."
+    );
+
+    out.notes.emplace_back(
+        "The 'translate' method translates each vertex away from the contour centroid by the specified amount."
+        " It preserves the number of vertices and their correspondence, but contours with concavities or large"
+        " margins will generally self-intersect."
+    );
 
 
     out.args.emplace_back();
@@ -54,10 +75,30 @@ OperationDoc OpArgDocGrowContours(void){
 
     out.args.emplace_back();
     out.args.back().name = "Distance";
-    out.args.back().desc = "The distance to translate contour vertices. (The direction is outward.)";
+    out.args.back().desc = "The distance to grow contours, in DICOM units (usually mm)."
+                           " Negative distances shrink contours.";
     out.args.back().default_val = "0.00354165798657632";
     out.args.back().expected = true;
-    out.args.back().examples = { "1E-5", "0.321", "1.1", "15.3" };
+    out.args.back().examples = { "1E-5", "0.321", "1.1", "15.3", "-2.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "The method used to grow or shrink contours."
+                           " 'Offset' computes a robust polygon offset of the region enclosed by each ROI's contours."
+                           " 'Translate' moves each vertex away from the contour's centroid.";
+    out.args.back().default_val = "offset";
+    out.args.back().expected = true;
+    out.args.back().examples = { "offset", "translate" };
+
+    out.args.emplace_back();
+    out.args.back().name = "JoinStyle";
+    out.args.back().desc = "Controls how corners are treated by the 'offset' method."
+                           " 'Round' joins follow a circular arc, which is the exact result of growing by a fixed"
+                           " distance. 'Miter' joins extend corners to a point, but corners sharper than 60 degrees"
+                           " are bevelled to avoid long spikes.";
+    out.args.back().default_val = "round";
+    out.args.back().expected = true;
+    out.args.back().examples = { "round", "miter" };
 
     return out;
 }
@@ -72,22 +113,135 @@ Drover GrowContours(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std::st
     const auto NormalizedROILabelRegex = OptArgs.getValueStr("NormalizedROILabelRegex").value();
 
     const auto dR = std::stod( OptArgs.getValueStr("Distance").value() );
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
+    const auto JoinStyleStr = OptArgs.getValueStr("JoinStyle").value();
 
     //-----------------------------------------------------------------------------------------------------------------
 
     const auto theregex = Compile_Regex(ROILabelRegex);
     const auto thenormalizedregex = Compile_Regex(NormalizedROILabelRegex);
 
+    const auto regex_offset = Compile_Regex("^of?f?s?e?t?$");
+    const auto regex_translate = Compile_Regex("^tr?a?n?s?l?a?t?e?$");
+    const auto regex_round = Compile_Regex("^ro?u?n?d?$");
+    const auto regex_miter = Compile_Regex("^mi?t?e?r?$");
+
+    bool use_offset = true;
+    if(false){
+    }else if(std::regex_match(MethodStr, regex_offset)){
+        use_offset = true;
+    }else if(std::regex_match(MethodStr, regex_translate)){
+        use_offset = false;
+    }else{
+        throw std::invalid_argument("Method not understood. Cannot continue.");
+    }
+    if( !std::regex_match(JoinStyleStr, regex_round)
+    &&  !std::regex_match(JoinStyleStr, regex_miter) ){
+        throw std::invalid_argument("JoinStyle not understood. Cannot continue.");
+    }
+    if(!std::isfinite(dR)){
+        throw std::invalid_argument("Distance must be finite. Cannot continue.");
+    }
+
+    const auto is_selected = [&](const contour_of_points<double> &cop) -> bool {
+        const auto ROINameOpt = cop.GetMetadataValueAs<std::string>("ROIName");
+        const auto ROIName = ROINameOpt.value_or("");
+//        const auto NROINameOpt = cop.GetMetadataValueAs<std::string>("NormalizedROIName");
+//        const auto NROIName = NROINameOpt.value_or("");
+//        if(!( std::regex_match(ROIName,theregex) || std::regex_match(NROIName,thenormalizedregex))) return false;
+        return std::regex_match(ROIName,theregex);
+    };
+
+    if(use_offset){
+        const auto join = std::regex_match(JoinStyleStr, regex_miter) ? ContourOffsetJoin::miter_join
+                                                                      : ContourOffsetJoin::round_join;
+
+        // Group the selected contours of each ROI by plane. Each group is offset as a single region.
+        struct plane_group {
+            contour_collection<double> *cc = nullptr;
+            plane<double> aplane;
+            std::list<std::reference_wrapper<contour_of_points<double>>> cops;
+            contour_collection<double> result;
+        };
+        std::vector<plane_group> groups;
+        const auto is_offset = [&](const contour_of_points<double> &cop) -> bool {
+            return (3 <= cop.points.size()) && is_selected(cop);
+        };
+        for(auto &cc : DICOM_data.contour_data->ccs){
+            contour_collection<double> sel;
+            for(const auto &cop : cc.contours){
+                if(is_offset(cop)) sel.contours.emplace_back(cop);
+            }
+            if(sel.contours.empty()) continue;
+
+            const auto est_cont_normal = sel.contours.front().Estimate_Planar_Normal();
+            const auto ucp = Unique_Contour_Planes<double>({ std::ref(sel) }, est_cont_normal, /*distance_eps=*/ 0.005);
+
+            // Assign each contour to the single nearest plane so that no contour is offset more than once.
+            std::vector<plane_group> cc_groups(ucp.size());
+            for(auto &cop : cc.contours){
+                if(!is_offset(cop)) continue;
+                size_t nearest = 0;
+                double nearest_dist = std::numeric_limits<double>::infinity();
+                size_t n = 0;
+                for(const auto &aplane : ucp){
+                    const auto dist_to_plane = std::abs(aplane.Get_Signed_Distance_To_Point(cop.points.front()));
+                    if(dist_to_plane < nearest_dist){
+                        nearest = n;
+                        nearest_dist = dist_to_plane;
+                    }
+                    ++n;
+                }
+                cc_groups[nearest].cops.emplace_back(std::ref(cop));
+            }
+
+            size_t n = 0;
+            for(const auto &aplane : ucp){
+                auto &g = cc_groups[n++];
+                if(g.cops.empty()) continue;
+                g.cc = std::addressof(cc);
+                g.aplane = aplane;
+                groups.emplace_back(std::move(g));
+            }
+        }
+
+        std::vector<std::exception_ptr> errors(groups.size());
+        {
+            asio_thread_pool tp;
+            for(size_t i = 0; i < groups.size(); ++i){
+                tp.submit_task([&,i](void) -> void {
+                    try{
+                        auto &g = groups[i];
+                        auto cc = ContourOffset_Snapped(g.aplane, g.cops, dR, join);
+                        if(!cc){
+                            throw std::runtime_error("Contours are too distant from the plane's origin to be offset.");
+                        }
+                        g.result = std::move(cc.value());
+                    }catch(const std::exception &){
+                        errors[i] = std::current_exception();
+                    }
+                }); // thread pool task closure.
+            }
+        } // Wait for all tasks to complete.
+        for(const auto &e : errors){
+            if(e) std::rethrow_exception(e);
+        }
+
+        // Replace the selected contours with the offset contours.
+        for(auto &cc : DICOM_data.contour_data->ccs){
+            cc.contours.remove_if(is_offset);
+        }
+        for(auto &g : groups){
+            g.cc->contours.splice(g.cc->contours.end(), std::move(g.result.contours));
+        }
+        return DICOM_data;
+    }
+
     for(auto &cc : DICOM_data.contour_data->ccs){
         for(auto &cop : cc.contours){
             if(cop.points.size() < 3) continue;
 
-            const auto ROINameOpt = cop.GetMetadataValueAs<std::string>("ROIName");
-            const auto ROIName = ROINameOpt.value_or("");
-            const auto NROINameOpt = cop.GetMetadataValueAs<std::string>("NormalizedROIName");
-            const auto NROIName = NROINameOpt.value_or("");
-//            if(!( std::regex_match(ROIName,theregex) || std::regex_match(NROIName,thenormalizedregex))) continue;
-            if(!std::regex_match(ROIName,theregex)) continue;
+            if(!is_selected(cop)) continue;
 
             const auto N = cop.Estimate_Planar_Normal();
             const auto aplane = cop.Least_Squares_Best_Fit_Plane(N);
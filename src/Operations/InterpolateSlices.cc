@@ -34,8 +34,9 @@ OperationDoc OpArgDocInterpolateSlices(void){
         " geometry from the reference images."
     );
     out.notes.emplace_back(
-        "If all images (selected and reference, altogether) are detected to be rectilinear, this operation will"
-        " avoid in-plane interpolation and will thus be much faster."
+        "If the selected images are detected to be rectilinear and the reference images share their orientation,"
+        " interpolation is separable and will be performed using interpolation weights precomputed for each axis."
+        " This is much faster, and the reference images may use a different voxel size and extent."
         " There is no **need** for rectilinearity, however without it sections of the image that cannot"
         " reasonably be interpolated (via plane-orthogonal projection onto the reference images) will be"
         " invalid and marked with NaNs. Non-rectilearity which amounts to a differing number of rows"
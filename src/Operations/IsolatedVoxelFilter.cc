@@ -38,6 +38,10 @@ OperationDoc OpArgDocIsolatedVoxelFilter(void){
         "If the neighbourhood involves voxels that do not exist, they are treated as NaNs in the same"
         " way that voxels with the NaN value are treated."
     );
+    out.notes.emplace_back(
+        "Only the immediate neighbourhood of each voxel is considered. To remove larger isolated regions based on"
+        " their volume, see the ConnectedComponentFilter operation."
+    );
     
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
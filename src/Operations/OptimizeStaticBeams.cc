@@ -4,7 +4,10 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
+#include <condition_variable>
 #include <cstdlib>            //Needed for exit() calls.
+#include <exception>
 #include <optional>
 #include <fstream>
 #include <functional>
@@ -13,9 +16,12 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <regex>
 #include <stdexcept>
 #include <string>    
+#include <thread>
 #include <vector>
 #include <utility>
 
@@ -55,6 +61,7 @@ struct dose_dist_stats {
 
 // Global objects so lambdas can be non-capturing and thus passed as function pointers.
 std::function< dose_dist_stats (std::vector<double> &, std::vector<double> &)> global_evaluate_weights;
+std::function< double (const std::vector<double> &, std::vector<double> *)> global_evaluate_cost_and_gradient;
 std::vector<double> global_working;
 bool generate_dose_dist_stats = false;
 
@@ -83,6 +90,178 @@ double DVH_Normalize(std::vector<double> in,
 }
 
 
+// Sparse (voxel, beam) dose-influence matrix restricted to ROI voxels. Entries are stored in compressed sparse row
+// format: the entries for voxel i are [voxel_start[i], voxel_start[i+1]). Zero entries are omitted.
+struct beam_influence_matrix {
+    size_t N_beams = 0;
+    std::vector<size_t> voxel_start = { 0 };
+    std::vector<uint32_t> beam;
+    std::vector<double> dose;
+
+    size_t N_voxels(void) const { return (this->voxel_start.size() - 1); }
+};
+
+// Converts per-beam voxel doses (with consistent voxel ordering) into an influence matrix.
+static beam_influence_matrix Build_Influence_Matrix(const std::vector<std::vector<double>> &voxels){
+    beam_influence_matrix A;
+    A.N_beams = voxels.size();
+    const auto N_voxels = voxels.empty() ? 0 : voxels.front().size();
+    A.voxel_start.reserve(N_voxels + 1);
+    for(size_t i = 0; i < N_voxels; ++i){
+        for(size_t b = 0; b < A.N_beams; ++b){
+            const auto D = voxels[b][i];
+            if(D != 0.0){
+                A.beam.push_back(static_cast<uint32_t>(b));
+                A.dose.push_back(D);
+            }
+        }
+        A.voxel_start.push_back(A.beam.size());
+    }
+    return A;
+}
+
+// The number of contiguous voxel ranges to process in parallel. Small problems are not worth parallelizing.
+static size_t Voxel_Chunk_Count(size_t N_voxels){
+    const size_t min_chunk = 8192;
+    const size_t N_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    return std::clamp<size_t>(N_voxels / min_chunk, 1, N_threads);
+}
+
+// Invokes f(begin, end, chunk) over contiguous voxel ranges, in parallel when there is more than one range and a thread
+// pool is provided. The pool is expected to outlive the optimization, so it is reused across objective evaluations
+// rather than being created and destroyed for each one. This routine blocks until all ranges are complete.
+static void For_Each_Voxel_Chunk(asio_thread_pool *tp, size_t N_voxels, size_t N_chunks,
+                                 const std::function<void(size_t, size_t, size_t)> &f){
+    if((tp == nullptr) || (N_chunks <= 1)){
+        f(0, N_voxels, 0);
+        return;
+    }
+
+    std::mutex m;
+    std::condition_variable cv;
+    size_t remaining = N_chunks;
+    std::exception_ptr error;
+    for(size_t c = 0; c < N_chunks; ++c){
+        tp->submit_task([&,c](void) -> void {
+            std::exception_ptr e;
+            try{
+                f( (N_voxels * c) / N_chunks, (N_voxels * (c + 1)) / N_chunks, c );
+            }catch(const std::exception &){
+                e = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(m);
+            if(e && !error) error = e;
+            if(--remaining == 0) cv.notify_one();
+        }); // thread pool task closure.
+    }
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&](void){ return (remaining == 0); });
+    }
+    if(error) std::rethrow_exception(error);
+    return;
+}
+
+// Computes the total dose to each voxel for the given beam weights.
+static void Accumulate_Dose(asio_thread_pool *tp,
+                            const beam_influence_matrix &A,
+                            const std::vector<double> &weights,
+                            std::vector<double> &working){
+    const auto N_voxels = A.N_voxels();
+    working.resize(N_voxels);
+    For_Each_Voxel_Chunk(tp, N_voxels, Voxel_Chunk_Count(N_voxels), [&](size_t begin, size_t end, size_t){
+        for(size_t i = begin; i < end; ++i){
+            double D = 0.0;
+            for(auto j = A.voxel_start[i]; j < A.voxel_start[i+1]; ++j) D += weights[A.beam[j]] * A.dose[j];
+            working[i] = D;
+        }
+    });
+    return;
+}
+
+// Evaluates the cost used for optimization along with its analytic gradient with respect to the beam weights.
+//
+// The weighted dose is first scaled to satisfy the DVH criteria $V_{D} \geq V_{min}$ (see DVH_Normalize()) and then the
+// sum of squared deviations from the prescription dose is computed. The scaling depends on the voxel at the relevant
+// dose percentile, so the cost is piecewise smooth; the gradient is exact wherever the percentile voxels do not change.
+//
+// Note: the cost is invariant to uniformly scaling the weights.
+static double Evaluate_Normalized_Cost(asio_thread_pool *tp,
+                                       const beam_influence_matrix &A,
+                                       const std::vector<double> &weights,
+                                       double D_norm,
+                                       double Vmin,
+                                       double D_Rx,
+                                       std::vector<double> &working,
+                                       std::vector<size_t> &order,
+                                       std::vector<double> *grad){
+    const auto N_voxels = A.N_voxels();
+    const auto N_beams = A.N_beams;
+    if(grad != nullptr) grad->assign(N_beams, 0.0);
+    if(N_voxels == 0) return 0.0;
+
+    Accumulate_Dose(tp, A, weights, working);
+
+    // Locate the voxels bracketing the percentile, interpolating linearly between order statistics.
+    const auto rank = std::clamp(1.0 - Vmin, 0.0, 1.0) * static_cast<double>(N_voxels - 1);
+    const auto k_lo = static_cast<size_t>(std::floor(rank));
+    const auto k_hi = std::min(k_lo + 1, N_voxels - 1);
+    const auto frac = rank - static_cast<double>(k_lo);
+
+    order.resize(N_voxels);
+    std::iota(order.begin(), order.end(), static_cast<size_t>(0));
+    const auto by_dose = [&](size_t l, size_t r){ return (working[l] < working[r]); };
+    std::nth_element(order.begin(), std::next(order.begin(), k_lo), order.end(), by_dose);
+    const auto i_lo = order[k_lo];
+    const auto i_hi = (k_hi == k_lo) ? i_lo
+                                     : *std::min_element(std::next(order.begin(), k_lo + 1), order.end(), by_dose);
+    const auto D_p = working[i_lo] + (working[i_hi] - working[i_lo]) * frac;
+
+    const auto scale = D_norm / D_p;
+    if(!std::isfinite(scale) || !(0.0 < D_p)){
+        return std::numeric_limits<double>::max();
+    }
+
+    // Cost and the per-beam sums needed for the gradient, accumulated per chunk.
+    const auto N_chunks = Voxel_Chunk_Count(N_voxels);
+    std::vector<double> chunk_cost(N_chunks, 0.0);
+    std::vector<double> chunk_H(N_chunks, 0.0);
+    std::vector<std::vector<double>> chunk_G(N_chunks);
+    For_Each_Voxel_Chunk(tp, N_voxels, N_chunks, [&](size_t begin, size_t end, size_t c){
+        double cost = 0.0;
+        double H = 0.0;
+        std::vector<double> G( (grad == nullptr) ? 0 : N_beams, 0.0 );
+        for(size_t i = begin; i < end; ++i){
+            const auto r = scale * working[i] - D_Rx;
+            cost += r * r;
+            if(grad == nullptr) continue;
+            H += 2.0 * r * working[i];
+            for(auto j = A.voxel_start[i]; j < A.voxel_start[i+1]; ++j) G[A.beam[j]] += 2.0 * r * A.dose[j];
+        }
+        chunk_cost[c] = cost;
+        chunk_H[c] = H;
+        chunk_G[c] = std::move(G);
+    });
+    const auto cost = std::accumulate(chunk_cost.begin(), chunk_cost.end(), 0.0);
+
+    if(grad != nullptr){
+        const auto H = std::accumulate(chunk_H.begin(), chunk_H.end(), 0.0);
+
+        // d(scale)/d(w_b) = -(scale / D_p) * d(D_p)/d(w_b).
+        std::vector<double> dD_p(N_beams, 0.0);
+        for(auto j = A.voxel_start[i_lo]; j < A.voxel_start[i_lo+1]; ++j) dD_p[A.beam[j]] += (1.0 - frac) * A.dose[j];
+        for(auto j = A.voxel_start[i_hi]; j < A.voxel_start[i_hi+1]; ++j) dD_p[A.beam[j]] += frac * A.dose[j];
+
+        for(size_t b = 0; b < N_beams; ++b){
+            double G = 0.0;
+            for(const auto &cG : chunk_G) G += cG[b];
+            (*grad)[b] = scale * G - H * (scale / D_p) * dD_p[b];
+        }
+    }
+    return cost;
+}
+
+
 OperationDoc OpArgDocOptimizeStaticBeams(void){
     OperationDoc out;
     out.name = "OptimizeStaticBeams";
@@ -114,6 +293,11 @@ OperationDoc OpArgDocOptimizeStaticBeams(void){
         " Patches are welcome."
     );
 
+    out.notes.emplace_back(
+        "Beam doses are stored as a sparse voxel-beam influence matrix restricted to the sampled ROI voxels,"
+        " so only voxels that receive dose from a beam contribute to the cost of evaluating that beam."
+    );
+
     out.args.emplace_back();
     out.args.back() = IAWhitelistOpArgDoc();
     out.args.back().name = "ImageSelection";
@@ -205,6 +389,18 @@ OperationDoc OpArgDocOptimizeStaticBeams(void){
     out.args.back().examples = { "0.90", "0.95", "0.98", "0.99", "1.0" };
 
 
+    out.args.emplace_back();
+    out.args.back().name = "Optimizer";
+    out.args.back().desc = "The optimization strategy to use."
+                           " 'Direct' uses a derivative-free global search, which is robust but only practical for"
+                           " a handful of beams."
+                           " 'Gradient' uses a quasi-Newton (L-BFGS) local search with analytic gradients,"
+                           " which scales to tens or hundreds of beams (or beamlets).";
+    out.args.back().default_val = "direct";
+    out.args.back().expected = true;
+    out.args.back().examples = { "direct", "gradient" };
+
+
     out.args.emplace_back();
     out.args.back().name = "RxDose";
     out.args.back().desc = "The dose prescribed to the ROI that will be optimized."
@@ -236,7 +432,16 @@ Drover OptimizeStaticBeams(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
     const auto dvh_Vmin_frac = std::stod(  OptArgs.getValueStr("NormalizationV").value() );
     const auto D_Rx = std::stod(  OptArgs.getValueStr("RxDose").value() );
 
+    const auto OptimizerStr = OptArgs.getValueStr("Optimizer").value();
+
     //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_direct   = Compile_Regex("^di?r?e?c?t?$");
+    const auto regex_gradient = Compile_Regex("^gr?a?d?i?e?n?t?$");
+
+    const bool use_gradient = std::regex_match(OptimizerStr, regex_gradient);
+    if( !use_gradient && !std::regex_match(OptimizerStr, regex_direct) ){
+        throw std::invalid_argument("Optimizer argument '"_s + OptimizerStr + "' is not valid");
+    }
 
     if(ResultsSummaryFileName.empty()){
         ResultsSummaryFileName = Get_Unique_Sequential_Filename("/tmp/dicomautomaton_optimizestaticbeamssummary_", 6, ".csv");
@@ -356,10 +561,22 @@ Drover OptimizeStaticBeams(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
     const auto N_beams = static_cast<long int>(voxels.size());
     const auto N_voxels = voxels.front().size();
 
+    // Convert to a sparse influence matrix and release the dense per-beam copies.
+    const auto influence = Build_Influence_Matrix(voxels);
+    voxels.clear();
+    voxels.shrink_to_fit();
+    FUNCINFO("Influence matrix has " << influence.dose.size() << " non-zero elements ("
+             << (100.0 * static_cast<double>(influence.dose.size()) / static_cast<double>(N_voxels * N_beams))
+             << "% of dense)");
+
+    // A single thread pool is shared by every objective evaluation. Small problems are evaluated serially.
+    std::unique_ptr<asio_thread_pool> tp;
+    if(1 < Voxel_Chunk_Count(N_voxels)) tp = std::make_unique<asio_thread_pool>(Voxel_Chunk_Count(N_voxels));
+
     std::stringstream ss;
 
     // This routine evaluates weighting schemes to produce cost and quality metrics.
-    auto evaluate_weights = [&,N_beams](std::vector<double> &weights, 
+    auto evaluate_weights = [&](std::vector<double> &weights, 
                                         std::vector<double> &working) -> dose_dist_stats {
 
         dose_dist_stats out;
@@ -367,14 +584,7 @@ Drover OptimizeStaticBeams(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
         // Compute the total dose using the current weighting scheme.
         //
         // Note: This requires consistent voxel ordering!
-        std::fill(working.begin(), working.end(), 0.0);
-        for(long int beam = 0; beam < N_beams; ++beam){
-            const auto weight = weights[beam];
-            std::transform( working.begin(), working.end(),
-                            voxels[beam].begin(), 
-                            working.begin(),
-                            [=](const double &L, const double &R){ return L + weight * R; });
-        }
+        Accumulate_Dose(tp.get(), influence, weights, working);
 
         // Sanity check.
         const auto D_max = Stats::Max(working);
@@ -431,27 +641,48 @@ Drover OptimizeStaticBeams(Drover DICOM_data, OperationArgPkg OptArgs, std::map<
         return res.cost;
     };
 
+    // Gradient-based optimization. The cost is invariant to uniformly scaling the weights, so the weights need not be
+    // normalized here.
+    std::vector<size_t> gradient_order;
+    global_evaluate_cost_and_gradient = [&](const std::vector<double> &open_weights,
+                                            std::vector<double> *grad) -> double {
+        return Evaluate_Normalized_Cost(tp.get(), influence, open_weights, dvh_D_frac * D_Rx, dvh_Vmin_frac, D_Rx,
+                                        global_working, gradient_order, grad);
+    };
+    auto f_to_optimize_with_gradient = [](const std::vector<double> &open_weights, 
+                                          std::vector<double> &grad, 
+                                          void * ) -> double {
+        return global_evaluate_cost_and_gradient(open_weights, (grad.empty() ? nullptr : &grad));
+    };
+
     std::vector<double> open_weights(N_beams, 0.5);
     std::vector<double> working(N_voxels, 0.0);
     global_working = working;
 
 #ifdef DCMA_USE_NLOPT
     //nlopt::opt optimizer(nlopt::LN_NELDERMEAD, N_beams);
-    nlopt::opt optimizer(nlopt::GN_DIRECT_L, N_beams);
     //nlopt::opt optimizer(nlopt::GN_ISRES, N_beams);
     //nlopt::opt optimizer(nlopt::GN_ESCH, N_beams);
+    nlopt::opt optimizer( (use_gradient ? nlopt::LD_LBFGS : nlopt::GN_DIRECT_L), N_beams);
 
     std::vector<double> lower_bounds(N_beams, 0.0);
     std::vector<double> upper_bounds(N_beams, 1.0);
 
     optimizer.set_lower_bounds(lower_bounds);
     optimizer.set_upper_bounds(upper_bounds);
-    optimizer.set_min_objective(f_to_optimize, NULL);
-    optimizer.set_ftol_abs(-HUGE_VAL);
-    optimizer.set_ftol_rel(1.0E-8);
-    optimizer.set_xtol_abs(-HUGE_VAL);
-    optimizer.set_xtol_rel(-HUGE_VAL);
-    optimizer.set_maxeval(500'000);
+    if(use_gradient){
+        optimizer.set_min_objective(f_to_optimize_with_gradient, NULL);
+        optimizer.set_ftol_rel(1.0E-10);
+        optimizer.set_xtol_rel(1.0E-8);
+        optimizer.set_maxeval(50'000);
+    }else{
+        optimizer.set_min_objective(f_to_optimize, NULL);
+        optimizer.set_ftol_abs(-HUGE_VAL);
+        optimizer.set_ftol_rel(1.0E-8);
+        optimizer.set_xtol_abs(-HUGE_VAL);
+        optimizer.set_xtol_rel(-HUGE_VAL);
+        optimizer.set_maxeval(500'000);
+    }
     double minf;
 
     generate_dose_dist_stats = false;
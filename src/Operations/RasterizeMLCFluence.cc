@@ -0,0 +1,400 @@
+//RasterizeMLCFluence.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
+#include "RasterizeMLCFluence.h"
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+
+namespace {
+
+// A single aperture, i.e., the MLC and jaw positions at some point within a beam, and the fraction of the beam
+// meterset delivered through it.
+struct aperture_sample {
+    double weight = 0.0;
+    std::vector<double> mlc; // Bank A followed by bank B.
+    std::array<double,2> jaw_x = {{ -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() }};
+    std::array<double,2> jaw_y = {{ -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity() }};
+};
+
+// A square-pixel fluence grid in the beam limiting device coordinate system. Columns increase along +x (the direction
+// of leaf travel) and rows increase along -y, so the image appears as it would from the source.
+struct fluence_grid {
+    long int rows = 0;
+    long int columns = 0;
+    double x_min = 0.0;
+    double y_max = 0.0;
+    double spacing = 1.0;
+};
+
+// Adds the exact area coverage of the rectangle [x0,x1] x [y0,y1], multiplied by w, to every pixel it overlaps. Pixels
+// are only partially covered along the rectangle edges, so the coverage separates into row and column fractions.
+void add_rectangle(const fluence_grid &g,
+                   double x0, double x1,
+                   double y0, double y1,
+                   double w,
+                   double *buf){
+    const auto C = static_cast<double>(g.columns);
+    const auto R = static_cast<double>(g.rows);
+
+    // Convert to continuous pixel coordinates, where pixel (r,c) spans [r,r+1) x [c,c+1).
+    const auto u0 = std::clamp((x0 - g.x_min) / g.spacing, 0.0, C);
+    const auto u1 = std::clamp((x1 - g.x_min) / g.spacing, 0.0, C);
+    const auto v0 = std::clamp((g.y_max - y1) / g.spacing, 0.0, R);
+    const auto v1 = std::clamp((g.y_max - y0) / g.spacing, 0.0, R);
+    if( !(u0 < u1) || !(v0 < v1) || (w == 0.0) ) return;
+
+    const auto c_lo = static_cast<long int>(std::floor(u0));
+    const auto c_hi = std::min(g.columns - 1, static_cast<long int>(std::ceil(u1)) - 1);
+    const auto r_lo = static_cast<long int>(std::floor(v0));
+    const auto r_hi = std::min(g.rows - 1, static_cast<long int>(std::ceil(v1)) - 1);
+
+    const auto f_c_lo = std::min(u1, static_cast<double>(c_lo + 1)) - u0;
+    const auto f_c_hi = u1 - std::max(u0, static_cast<double>(c_hi));
+
+    for(long int r = r_lo; r <= r_hi; ++r){
+        const auto f_r = std::min(v1, static_cast<double>(r + 1)) - std::max(v0, static_cast<double>(r));
+        const auto w_r = w * f_r;
+        double *row = buf + static_cast<size_t>(r) * static_cast<size_t>(g.columns);
+
+        if(c_lo == c_hi){
+            row[c_lo] += w_r * f_c_lo;
+            continue;
+        }
+        row[c_lo] += w_r * f_c_lo;
+        for(long int c = c_lo + 1; c < c_hi; ++c) row[c] += w_r;
+        row[c_hi] += w_r * f_c_hi;
+    }
+    return;
+}
+
+// Adds the fluence transmitted through a single aperture. Leaf pair k spans [boundaries[k], boundaries[k+1]) along y.
+void add_aperture(const fluence_grid &g,
+                  const std::vector<double> &boundaries,
+                  const aperture_sample &s,
+                  double *buf){
+    const auto &X = s.jaw_x;
+    const auto &Y = s.jaw_y;
+
+    if(s.mlc.empty()){
+        add_rectangle(g, X[0], X[1], Y[0], Y[1], s.weight, buf);
+        return;
+    }
+
+    const auto N_pairs = s.mlc.size() / 2;
+    for(size_t k = 0; k < N_pairs; ++k){
+        const auto y0 = std::max(boundaries[k], Y[0]);
+        const auto y1 = std::min(boundaries[k + 1], Y[1]);
+        const auto x0 = std::max(s.mlc[k], X[0]);
+        const auto x1 = std::min(s.mlc[k + N_pairs], X[1]);
+        add_rectangle(g, x0, x1, y0, y1, s.weight, buf);
+    }
+    return;
+}
+
+// Locates the leaf boundaries for the MLCX device, if available.
+std::vector<double> get_leaf_boundaries(const Dynamic_Machine_State &ds){
+    const std::string boundaries_key = "LeafPositionBoundaries";
+    const std::string type_key = "RTBeamLimitingDeviceType";
+    for(const auto &kv : ds.metadata){
+        const auto &key = kv.first;
+        if( (key.size() < boundaries_key.size())
+        ||  (key.compare(key.size() - boundaries_key.size(), boundaries_key.size(), boundaries_key) != 0) ){
+            continue;
+        }
+
+        const auto prefix = key.substr(0, key.size() - boundaries_key.size());
+        const auto type_it = ds.metadata.find(prefix + type_key);
+        if( (type_it == std::end(ds.metadata))
+        ||  (Canonicalize_String2(type_it->second, CANONICALIZE::TRIM_ENDS | CANONICALIZE::TO_UPPER) != "MLCX") ){
+            continue;
+        }
+
+        std::vector<double> out;
+        for(const auto &s : SplitStringToVector(kv.second, '\\', 'd')){
+            out.emplace_back( std::stod(s) );
+        }
+        return out;
+    }
+    return {};
+}
+
+// Linearly blends jaw or leaf positions. Positions that are not available in both states are taken from the first.
+std::vector<double> blend(const std::vector<double> &A, const std::vector<double> &B, double f){
+    if(A.size() != B.size()) return A;
+    std::vector<double> out(A.size());
+    for(size_t i = 0; i < A.size(); ++i) out[i] = (1.0 - f) * A[i] + f * B[i];
+    return out;
+}
+
+} // namespace
+
+
+OperationDoc OpArgDocRasterizeMLCFluence(void){
+    OperationDoc out;
+    out.name = "RasterizeMLCFluence";
+
+    out.desc =
+        "This operation converts the MLC and jaw apertures of the selected treatment plans into a two-dimensional"
+        " fluence map for each beam. Apertures are linearly interpolated between adjacent control points,"
+        " rasterized, and weighted by the fraction of the beam meterset delivered through them."
+        " The fluence maps are suitable for assessing plan complexity or for comparing plans.";
+
+    out.notes.emplace_back(
+        "Fluence maps are generated in the beam limiting device coordinate system at the isocentre plane,"
+        " i.e., the collimator rotation is ignored. Image columns increase in the direction of leaf travel (x)"
+        " and rows increase in the -y direction, as seen from the source."
+        " The image is placed in the z=0 plane with the isocentre at the origin."
+    );
+    out.notes.emplace_back(
+        "Pixel values are the fraction of the beam meterset delivered through the pixel, so an unmodulated field"
+        " will have pixel values of one. The area of each pixel covered by each leaf opening and jaw is computed"
+        " exactly, so pixels straddling a leaf edge receive partial fluence."
+        " Transmission through the leaves and jaws, the rounded leaf ends, and the tongue-and-groove effect"
+        " are not modeled."
+    );
+    out.notes.emplace_back(
+        "Sub-sampling the interval between control points improves the accuracy of dynamic deliveries"
+        " (e.g., VMAT or sliding window), where leaves move while the beam is on. Step-and-shoot deliveries do not"
+        " benefit from sub-sampling. Apertures are rasterized in parallel and the partial fluence maps are"
+        " combined using a reduction tree."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = TPWhitelistOpArgDoc();
+    out.args.back().name = "TPlanSelection";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "PixelSpacing";
+    out.args.back().desc = "The width and height of each fluence map pixel (in DICOM units; mm) at the isocentre plane.";
+    out.args.back().default_val = "1.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "0.25", "0.5", "1.0", "2.5" };
+
+    out.args.emplace_back();
+    out.args.back().name = "FieldSize";
+    out.args.back().desc = "The width and height (in DICOM units; mm) of the square region, centred on the isocentre,"
+                           " that the fluence map will cover. It should encompass the largest possible aperture.";
+    out.args.back().default_val = "400.0";
+    out.args.back().expected = true;
+    out.args.back().examples = { "100.0", "250.0", "400.0" };
+
+    out.args.emplace_back();
+    out.args.back().name = "SubSamples";
+    out.args.back().desc = "The number of apertures sampled between each pair of adjacent control points."
+                           " Samples are evenly distributed, and share the meterset delivered between the control"
+                           " points equally.";
+    out.args.back().default_val = "1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "1", "2", "5", "10" };
+
+    out.args.emplace_back();
+    out.args.back().name = "LeafBoundaries";
+    out.args.back().desc = "The leaf pair boundaries (in DICOM units; mm) along the y axis, listed in increasing"
+                           " order and separated by commas. If left empty, the boundaries specified in the plan will"
+                           " be used. Beams for which boundaries are not available will be skipped.";
+    out.args.back().default_val = "";
+    out.args.back().expected = false;
+    out.args.back().examples = { "", "-200,-190,-180,-170,-160,-150,-140,-130,-120,-110,-100,-95,-90,-85,-80,-75,-70,"
+                                 "-65,-60,-55,-50,-45,-40,-35,-30,-25,-20,-15,-10,-5,0,5,10,15,20,25,30,35,40,45,50,"
+                                 "55,60,65,70,75,80,85,90,95,100,110,120,130,140,150,160,170,180,190,200" };
+
+    return out;
+}
+
+
+
+Drover RasterizeMLCFluence(Drover DICOM_data,
+                           OperationArgPkg OptArgs,
+                           std::map<std::string, std::string> /*InvocationMetadata*/,
+                           std::string /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto TPlanSelectionStr = OptArgs.getValueStr("TPlanSelection").value();
+
+    const auto PixelSpacing = std::stod( OptArgs.getValueStr("PixelSpacing").value() );
+    const auto FieldSize = std::stod( OptArgs.getValueStr("FieldSize").value() );
+    const auto SubSamples = std::stol( OptArgs.getValueStr("SubSamples").value() );
+    const auto LeafBoundariesStr = OptArgs.getValueStr("LeafBoundaries").value_or("");
+
+    //-----------------------------------------------------------------------------------------------------------------
+    if( !std::isfinite(PixelSpacing) || (PixelSpacing <= 0.0) ){
+        throw std::invalid_argument("Pixel spacing must be positive.");
+    }
+    if( !std::isfinite(FieldSize) || (FieldSize < PixelSpacing) ){
+        throw std::invalid_argument("Field size must be at least one pixel wide.");
+    }
+    if(SubSamples < 1){
+        throw std::invalid_argument("At least one sample is required between control points.");
+    }
+
+    std::vector<double> user_boundaries;
+    for(const auto &s : SplitStringToVector(LeafBoundariesStr, ',', 'd')){
+        user_boundaries.emplace_back( std::stod(s) );
+    }
+
+    fluence_grid g;
+    g.rows = static_cast<long int>(std::ceil(FieldSize / PixelSpacing));
+    g.columns = g.rows;
+    g.spacing = PixelSpacing;
+    g.x_min = -0.5 * PixelSpacing * static_cast<double>(g.columns);
+    g.y_max =  0.5 * PixelSpacing * static_cast<double>(g.rows);
+    const auto N_pixels = static_cast<size_t>(g.rows) * static_cast<size_t>(g.columns);
+
+    auto TPs_all = All_TPs( DICOM_data );
+    auto TPs = Whitelist( TPs_all, TPlanSelectionStr );
+
+    for(auto & tp_it : TPs){
+        auto out = std::make_shared<Image_Array>();
+
+        for(const auto &ds_orig : (*tp_it)->dynamic_states){
+            const auto BeamNumber = ds_orig.GetMetadataValueAs<std::string>("BeamNumber").value_or("unknown");
+            const auto BeamName = ds_orig.GetMetadataValueAs<std::string>("BeamName").value_or("unknown");
+
+            auto ds = ds_orig;
+            ds.sort_states();
+            ds.normalize_states();
+            if(!ds.verify_states_are_ordered()){
+                FUNCWARN("Control points for beam " << BeamNumber << " ('" << BeamName << "') are missing or invalid. Skipping beam");
+                continue;
+            }
+
+            // Determine the leaf boundaries, if needed.
+            const auto N_leaves = ds.static_states.front().MLCPositionsX.size();
+            std::vector<double> boundaries;
+            if(N_leaves != 0){
+                boundaries = user_boundaries.empty() ? get_leaf_boundaries(ds) : user_boundaries;
+                const auto N_pairs = N_leaves / 2;
+                if( ((N_leaves % 2) != 0)
+                ||  (boundaries.size() != (N_pairs + 1))
+                ||  !std::is_sorted(std::begin(boundaries), std::end(boundaries)) ){
+                    FUNCWARN("Leaf boundaries for beam " << BeamNumber << " ('" << BeamName << "') are missing or invalid. Skipping beam");
+                    continue;
+                }
+            }
+
+            // Sample apertures between each pair of adjacent control points.
+            const auto final_weight = std::isfinite(ds.FinalCumulativeMetersetWeight)
+                                    ? ds.FinalCumulativeMetersetWeight
+                                    : ds.static_states.back().CumulativeMetersetWeight;
+            if( !std::isfinite(final_weight) || (final_weight <= 0.0) ){
+                FUNCWARN("Beam " << BeamNumber << " ('" << BeamName << "') has no meterset. Skipping beam");
+                continue;
+            }
+
+            std::vector<aperture_sample> samples;
+            bool valid = true;
+            for(size_t i = 0; (i + 1) < ds.static_states.size(); ++i){
+                const auto &A = ds.static_states[i];
+                const auto &B = ds.static_states[i + 1];
+                const auto dw = (B.CumulativeMetersetWeight - A.CumulativeMetersetWeight) / final_weight;
+                if(!std::isfinite(dw)){
+                    valid = false;
+                    break;
+                }
+                if(dw <= 0.0) continue;
+
+                if(A.MLCPositionsX.size() != N_leaves){
+                    valid = false;
+                    break;
+                }
+
+                for(long int s = 0; s < SubSamples; ++s){
+                    const auto f = (static_cast<double>(s) + 0.5) / static_cast<double>(SubSamples);
+                    samples.emplace_back();
+                    auto &a = samples.back();
+                    a.weight = dw / static_cast<double>(SubSamples);
+                    a.mlc = blend(A.MLCPositionsX, B.MLCPositionsX, f);
+
+                    const auto jx = blend(A.JawPositionsX, B.JawPositionsX, f);
+                    const auto jy = blend(A.JawPositionsY, B.JawPositionsY, f);
+                    if(jx.size() == 2) a.jaw_x = {{ jx[0], jx[1] }};
+                    if(jy.size() == 2) a.jaw_y = {{ jy[0], jy[1] }};
+                }
+            }
+            if(!valid){
+                FUNCWARN("Beam " << BeamNumber << " ('" << BeamName << "') has invalid control points. Skipping beam");
+                continue;
+            }
+
+            // Rasterize apertures in parallel. Each task accumulates a contiguous run of samples into a private buffer,
+            // so no synchronization is needed.
+            const auto N_samples = samples.size();
+            size_t N_tasks = std::thread::hardware_concurrency();
+            N_tasks = std::clamp<size_t>(N_tasks, 1, std::max<size_t>(N_samples, 1));
+            std::vector<std::vector<double>> partials(N_tasks);
+            {
+                asio_thread_pool tp;
+                for(size_t t = 0; t < N_tasks; ++t){
+                    tp.submit_task([&,t](void) -> void {
+                        partials[t].assign(N_pixels, 0.0);
+                        const auto beg = (N_samples * t) / N_tasks;
+                        const auto end = (N_samples * (t + 1)) / N_tasks;
+                        for(size_t i = beg; i < end; ++i){
+                            add_aperture(g, boundaries, samples[i], partials[t].data());
+                        }
+                    }); // thread pool task closure.
+                }
+            } // Wait for all tasks to complete.
+
+            // Combine the partial fluence maps pairwise, halving the number of buffers at each level.
+            for(size_t stride = 1; stride < N_tasks; stride *= 2){
+                asio_thread_pool tp;
+                for(size_t t = 0; (t + stride) < N_tasks; t += 2 * stride){
+                    tp.submit_task([&,t,stride](void) -> void {
+                        auto &dst = partials[t];
+                        auto &src = partials[t + stride];
+                        for(size_t i = 0; i < N_pixels; ++i) dst[i] += src[i];
+                        src = std::vector<double>();
+                    }); // thread pool task closure.
+                }
+            } // Wait for all tasks to complete.
+
+            // Emit the fluence map.
+            out->imagecoll.images.emplace_back();
+            auto &img = out->imagecoll.images.back();
+            img.init_orientation( vec3<double>(0.0, -1.0, 0.0), vec3<double>(1.0, 0.0, 0.0) );
+            img.init_buffer( g.rows, g.columns, 1 );
+            const auto pxl_centre = vec3<double>( g.x_min + 0.5 * g.spacing, g.y_max - 0.5 * g.spacing, 0.0 );
+            img.init_spatial( g.spacing, g.spacing, 1.0, vec3<double>(0.0, 0.0, 0.0), pxl_centre );
+
+            const auto &fluence = partials.front();
+            for(size_t i = 0; i < N_pixels; ++i) img.data[i] = static_cast<float>(fluence[i]);
+
+            for(const auto &key : { "PatientID", "StudyInstanceUID", "FrameOfReferenceUID", "RTPlanLabel", "RTPlanName" }){
+                const auto val = (*tp_it)->GetMetadataValueAs<std::string>(key);
+                if(val) img.metadata[key] = val.value();
+            }
+            img.metadata["BeamNumber"] = BeamNumber;
+            img.metadata["BeamName"] = BeamName;
+            img.metadata["Description"] = "MLC aperture fluence";
+
+            FUNCINFO("Rasterized " << N_samples << " apertures for beam " << BeamNumber << " ('" << BeamName << "')");
+        }
+
+        if(!out->imagecoll.images.empty()){
+            DICOM_data.image_data.emplace_back(out);
+        }
+    }
+
+    return DICOM_data;
+}
@@ -0,0 +1,17 @@
+// RasterizeMLCFluence.h.
+
+#pragma once
+
+#include <string>
+#include <map>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocRasterizeMLCFluence(void);
+
+Drover
+RasterizeMLCFluence(Drover DICOM_data,
+                    OperationArgPkg /*OptArgs*/,
+                    std::map<std::string, std::string> /*InvocationMetadata*/,
+                    std::string /*FilenameLex*/);
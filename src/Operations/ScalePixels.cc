@@ -17,7 +17,9 @@
 
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
+#include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
+#include "../YgorImages_Functors/Pixel_Kernels.h"
 #include "ScalePixels.h"
 #include "YgorImages.h"
 #include "YgorMath.h"         //Needed for vec3 class.
@@ -149,46 +151,48 @@ Drover ScalePixels(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std::str
     for(auto & iap_it : IAs){
         if((*iap_it)->imagecoll.images.empty()) continue;
 
-        PartitionedImageVoxelVisitorMutatorUserData ud;
-        ud.mutation_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
-        ud.mutation_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
-        ud.mutation_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
-        ud.mutation_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
-        //ud.description = "";
+        Mutate_Voxels_Opts mv_opts;
+        mv_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+        mv_opts.aggregate = Mutate_Voxels_Opts::Aggregate::First;
+        mv_opts.adjacency = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
+        mv_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
 
         if(false){
         }else if( std::regex_match(ContourOverlapStr, regex_ignore) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
+            mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::Ignore;
         }else if( std::regex_match(ContourOverlapStr, regex_honopps) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
+            mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
         }else if( std::regex_match(ContourOverlapStr, regex_cancel) ){
-            ud.mutation_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
+            mv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::ImplicitOrientations;
         }else{
             throw std::invalid_argument("ContourOverlap argument '"_s + ContourOverlapStr + "' is not valid");
         }
         if(false){
         }else if( std::regex_match(InclusivityStr, regex_centre) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
+            mv_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Centre;
         }else if( std::regex_match(InclusivityStr, regex_pci) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
+            mv_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Inclusive;
         }else if( std::regex_match(InclusivityStr, regex_pce) ){
-            ud.mutation_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
+            mv_opts.inclusivity = Mutate_Voxels_Opts::Inclusivity::Exclusive;
         }else{
             throw std::invalid_argument("Inclusivity argument '"_s + InclusivityStr + "' is not valid");
         }
 
-        ud.f_bounded = [&](long int, long int, long int chan, std::reference_wrapper<planar_image<float,double>>, float &val) {
-            if( (Channel < 0) || (Channel == chan) ){
-                val *= ScaleFactor;
-            }
-            return;
-        };
+        // Rasterize the ROIs once per image and then scale the masked pixels in bulk.
+        {
+            asio_thread_pool tp;
+            for(auto &animg : (*iap_it)->imagecoll.images){
+                std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(animg) );
 
-        if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                          PartitionedImageVoxelVisitorMutator,
-                                                          {}, cc_ROIs, &ud )){
-            throw std::runtime_error("Unable to scale voxel values.");
-        }
+                tp.submit_task([&,img_refw](void) -> void {
+                    const auto mask = pixel_kernels::ROI_Mask(img_refw.get(), cc_ROIs, mv_opts);
+                    const auto buf = pixel_kernels::Pixel_Buffer(img_refw.get(), Channel, &mask);
+                    pixel_kernels::Scale_Offset(buf, static_cast<float>(ScaleFactor), 0.0f);
+
+                    UpdateImageWindowCentreWidth( img_refw );
+                }); // thread pool task closure.
+            }
+        } // Wait for all tasks to complete.
     }
 
     return DICOM_data;
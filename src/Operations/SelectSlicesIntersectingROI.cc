@@ -6,8 +6,10 @@
 #include <map>
 #include <memory>
 #include <regex>
+#include <set>
 #include <string>    
 
+#include "../Contour_Index.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "SelectSlicesIntersectingROI.h"
@@ -72,13 +74,22 @@ Drover SelectSlicesIntersectingROI(Drover DICOM_data, OperationArgPkg OptArgs, s
                                         { "NormalizedROIName", NormalizedROILabelRegex } } );
 
 
+    std::set<const contour_collection<double> *> selected_ccs;
+    for(const auto &cc_ref : cc_ROIs) selected_ccs.insert( &(cc_ref.get()) );
+
+    const auto cindex_ptr = (DICOM_data.contour_data == nullptr) ? std::make_shared<const contour_index::index>()
+                                                                 : DICOM_data.contour_data->Get_Index();
+    const auto &cindex = *cindex_ptr;
+
     //Generate a closure that discards images not encompassing any ROI contours.
-    const auto retain_encompassing_imgs = [&cc_ROIs](const planar_image<float, double> &animg) -> bool {
+    //
+    // The spatial index limits the detailed check to contours with vertices within (or straddling) the image slab.
+    const auto retain_encompassing_imgs = [&](const planar_image<float, double> &animg) -> bool {
                 //Retain the image IFF it intersects one of the contours.
-                for(const auto &cc_ref : cc_ROIs){
-                    for(const auto &acontour : cc_ref.get().contours){
-                        if(animg.encompasses_contour_of_points(acontour)) return true;
-                    }
+                const auto tolerance = 0.5 * animg.pxl_dz + 1.0E-6;
+                for(const auto *e : cindex.intersecting_plane(animg.image_plane(), tolerance)){
+                    if(selected_ccs.count(e->cc) == 0) continue;
+                    if(animg.encompasses_contour_of_points(*(e->contour))) return true;
                 }
                 return false;
     };
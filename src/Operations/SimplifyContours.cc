@@ -19,10 +19,12 @@
 #include <vector>
 #include <utility>
 
+#include "../Contour_Collection_Estimates.h"
 #include "../Insert_Contours.h"
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../YgorImages_Functors/Contour_Simplification.h"
 
 #include "SimplifyContours.h"
 #include "YgorImages.h"
@@ -41,7 +43,8 @@ OperationDoc OpArgDocSimplifyContours(void){
       " This operation is mostly used to reduce the computational complexity of other operations.";
 
     out.notes.emplace_back(
-        "Contours are currently processed individually, not as a volume."
+        "Contours are simplified individually and concurrently. Only the 'Visvalingam' method can account for"
+        " the volumetric context of a contour, and only when inter-slice consistency is enabled."
     );
     out.notes.emplace_back(
         "Simplification is generally performed most eagerly on regions with relatively low curvature."
@@ -107,10 +110,28 @@ OperationDoc OpArgDocSimplifyContours(void){
                            " simplify contours more for a given tolerance (or, equivalently, can retain"
                            " contour fidelity better than vertex removal for the same number of vertices)."
                            " However, vertex collapse performs an averaging that may"
-                           " result in numerical imprecision.";
+                           " result in numerical imprecision."
+                           " 'Visvalingam' also removes vertices without replacement, ranking each by the area of"
+                           " the triangle it forms with its neighbours."
+                           " Ranks are maintained in a priority queue and only the neighbours of a removed vertex are"
+                           " re-ranked, so it scales well to contours with many vertices."
+                           " Removals that would cause a contour to self-intersect are rejected.";
     out.args.back().default_val = "vert-collapse";
     out.args.back().expected = true;
-    out.args.back().examples = { "vertex-collapse", "vertex-removal" };
+    out.args.back().examples = { "vertex-collapse", "vertex-removal", "visvalingam" };
+
+
+    out.args.emplace_back();
+    out.args.back().name = "InterSliceConsistency";
+    out.args.back().desc = "Whether to limit how far simplification can displace a contour's boundary based on the"
+                           " separation of adjacent contour slices."
+                           " When enabled, no removed vertex may lie further than half the ROI's contour separation"
+                           " from the simplified contour, so in-plane changes remain commensurate with the"
+                           " through-plane resolution and adjacent slices stay consistent when treated as a volume."
+                           " This option is only honoured by the 'Visvalingam' method.";
+    out.args.back().default_val = "false";
+    out.args.back().expected = true;
+    out.args.back().examples = { "true", "false" };
 
 
     return out;
@@ -125,13 +146,19 @@ Drover SimplifyContours(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std
     const auto ROILabelRegex = OptArgs.getValueStr("ROILabelRegex").value();
     const auto FractionalAreaTolerance = std::stod( OptArgs.getValueStr("FractionalAreaTolerance").value() );
     const auto SimplificationMethod = OptArgs.getValueStr("SimplificationMethod").value();
+    const auto InterSliceConsistencyStr = OptArgs.getValueStr("InterSliceConsistency").value();
 
     //-----------------------------------------------------------------------------------------------------------------
     const auto regex_vert_col = Compile_Regex("ve?r?t?e?x?-?co?l?l?a?p?s?e?");
     const auto regex_vert_rem = Compile_Regex("ve?r?t?e?x?-?re?m?o?v?a?l?");
+    const auto regex_visval = Compile_Regex("vi?s?v?a?l?i?n?g?a?m?");
+
+    const auto regex_true = Compile_Regex("^tr?u?e?$");
+    const bool InterSliceConsistency = std::regex_match(InterSliceConsistencyStr, regex_true);
 
     if( !std::regex_match(SimplificationMethod, regex_vert_col)
-    &&  !std::regex_match(SimplificationMethod, regex_vert_rem) ){
+    &&  !std::regex_match(SimplificationMethod, regex_vert_rem)
+    &&  !std::regex_match(SimplificationMethod, regex_visval) ){
         throw std::invalid_argument("SimplificationMethod selection is not valid. Cannot continue.");
     }
 
@@ -143,26 +170,44 @@ Drover SimplifyContours(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std
                                         { "NormalizedROIName", NormalizedROILabelRegex } } );
 
     const bool AssumePlanar = true;
-    for(auto &cc_refw : cc_ROIs){
-        for(auto &c : cc_refw.get().contours){
-            const auto A_orig = std::abs( c.Get_Signed_Area(AssumePlanar) );
-            const auto A_tol = FractionalAreaTolerance * A_orig;
-
-            if(false){
-            }else if( std::regex_match(SimplificationMethod, regex_vert_col) ){
-                // Vertex collapse. Adjacent vertices are merged together.
-                c = c.Collapse_Vertices(A_tol);
-
-            }else if( std::regex_match(SimplificationMethod, regex_vert_rem) ){
-                // Vertex removal. No vertices are added.
-                c = c.Remove_Vertices(A_tol);
-
-            }else{
-                throw std::logic_error("SimplificationMethod options have been updated incompletely. Cannot continue.");
+    {
+        asio_thread_pool tp;
+        for(auto &cc_refw : cc_ROIs){
+            // Adjacent slices are only considered through the ROI's contour separation.
+            double max_deviation = std::numeric_limits<double>::infinity();
+            if(InterSliceConsistency){
+                const auto sep = Estimate_Contour_Separation_Multi({ cc_refw });
+                if(std::isfinite(sep) && (0.0 < sep)) max_deviation = 0.5 * sep;
             }
 
+            for(auto &c : cc_refw.get().contours){
+                tp.submit_task([&,max_deviation](void) -> void {
+                    const auto A_orig = std::abs( c.Get_Signed_Area(AssumePlanar) );
+                    const auto A_tol = FractionalAreaTolerance * A_orig;
+
+                    if(false){
+                    }else if( std::regex_match(SimplificationMethod, regex_vert_col) ){
+                        // Vertex collapse. Adjacent vertices are merged together.
+                        c = c.Collapse_Vertices(A_tol);
+
+                    }else if( std::regex_match(SimplificationMethod, regex_vert_rem) ){
+                        // Vertex removal. No vertices are added.
+                        c = c.Remove_Vertices(A_tol);
+
+                    }else if( std::regex_match(SimplificationMethod, regex_visval) ){
+                        // Vertex removal, ranked by effective area. No vertices are added.
+                        contour_simplification::parameters params;
+                        params.area_tolerance = A_tol;
+                        params.max_deviation = max_deviation;
+                        c = contour_simplification::Simplify_Visvalingam(c, params);
+
+                    }else{
+                        throw std::logic_error("SimplificationMethod options have been updated incompletely. Cannot continue.");
+                    }
+                }); // thread pool task closure.
+            }
         }
-    }
+    } // Wait for all tasks to complete.
 
     return DICOM_data;
 }
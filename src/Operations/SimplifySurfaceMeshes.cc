@@ -34,6 +34,7 @@
 #include "YgorMathIOOFF.h"
 
 #include "../Surface_Meshes.h"
+#include "../YgorImages_Functors/Mesh_Attribute_Transfer.h"
 
 
 OperationDoc OpArgDocSimplifySurfaceMeshes(void){
@@ -84,6 +85,12 @@ Drover SimplifySurfaceMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::ma
 
         const auto orig_metadata = (*smp_it)->meshes.metadata;
 
+        // Retain the original mesh so attributes can be resampled onto the new mesh.
+        mesh_attributes::connectivity_change attr_change( (*smp_it)->meshes,
+                                                          (*smp_it)->vertex_attributes,
+                                                          (*smp_it)->face_attributes,
+                                                          mesh_attribute_transfer::Transfer_Attributes );
+
         // Convert to a CGAL mesh.
         std::stringstream ss_i;
         if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
@@ -110,6 +117,8 @@ Drover SimplifySurfaceMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::ma
 
         (*smp_it)->meshes.metadata = orig_metadata;
 
+        attr_change.commit();
+
         ++completed;
         FUNCINFO("Completed " << completed << " of " << sm_count
               << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
@@ -48,6 +48,8 @@
 #include "../Dose_Meld.h"
 
 #include "../YgorImages_Functors/Grouping/Misc_Functors.h"
+#include "../YgorImages_Functors/Grid_Resampling.h"
+#include "../YgorImages_Functors/Voxel_Traversal.h"
 
 #include "SimulateRadiograph.h"
 
@@ -58,9 +60,9 @@ OperationDoc OpArgDocSimulateRadiograph(void){
     out.name = "SimulateRadiograph";
 
     out.desc = 
-        "This routine uses ray marching an volumteric sampling to simulate radiographs from a CT image array."
+        "This routine uses ray casting to simulate radiographs from a CT image array."
         " Voxels are assumed to have intensities in HU. A simplisitic conversion"
-        " from CT number (in HU) to relative electron density (see note below) is performed for marched"
+        " from CT number (in HU) to relative electron density (see note below) is performed for cast"
         " rays.";
 
     out.notes.emplace_back(
@@ -68,6 +70,11 @@ OperationDoc OpArgDocSimulateRadiograph(void){
         // Note: while this operation could be implemented without requiring rectilinearity, it is much faster to
         // require it. If this functionality is required then modify this operation.
     );
+    out.notes.emplace_back(
+        "By default, the exact path length of each ray through every voxel is computed using an incremental"
+        " voxel traversal, treating each voxel as having a uniform density. Ray marching with trilinear"
+        " interpolation is also available, but is slower and its accuracy depends on the marching distance."
+    );
     out.notes.emplace_back(
         "This operation currently takes a simplistic approach and should only be used for purposes"
         " where the simulated radiograph contrast can be tuned and validated (e.g., in a relative way)."
@@ -95,9 +102,22 @@ OperationDoc OpArgDocSimulateRadiograph(void){
     out.args.back().mimetype = "image/fits";
 
 
+    out.args.emplace_back();
+    out.args.back().name = "Method";
+    out.args.back().desc = "The method used to integrate density along each ray."
+                           " 'Exact' computes the path length through each voxel that a ray intersects,"
+                           " so every voxel contributes and the result does not depend on a step size."
+                           " 'March' advances rays in fixed steps (see MarchingDistance) and samples the"
+                           " volume using trilinear interpolation.";
+    out.args.back().default_val = "exact";
+    out.args.back().expected = true;
+    out.args.back().examples = { "exact", "march" };
+
+
     out.args.emplace_back();
     out.args.back().name = "MarchingDistance";
     out.args.back().desc = "The distance (in DICOM units; mm) that rays will incrementally be marched at each iteration."
+                           " This parameter is only used when marching rays."
                            " This value should be on the order of the smallest image voxel size to give the best image"
                            " quality. Conversely, if a course radiograph is needed then larger values can be used."
                            " Trilinear interpolation is used to sample the CT number at arbitrary points in 3D."
@@ -171,6 +191,8 @@ Drover SimulateRadiograph(Drover DICOM_data,
 
     auto FilenameStr = OptArgs.getValueStr("Filename").value();
 
+    const auto MethodStr = OptArgs.getValueStr("Method").value();
+
     const auto MarchingDistance = std::stod( OptArgs.getValueStr("MarchingDistance").value() );
 
     const auto SourcePositionStr = OptArgs.getValueStr("SourcePosition").value();
@@ -189,6 +211,14 @@ Drover SimulateRadiograph(Drover DICOM_data,
     const bool spos_is_relative = std::regex_match(SourcePositionStr, regex_rel);
     const bool spos_is_absolute = std::regex_match(SourcePositionStr, regex_abs);
 
+    const auto regex_exact = Compile_Regex("^ex?a?c?t?$");
+    const auto regex_march = Compile_Regex("^ma?r?c?h?$");
+
+    const bool use_exact = std::regex_match(MethodStr, regex_exact);
+    if( !use_exact && !std::regex_match(MethodStr, regex_march) ){
+        throw std::invalid_argument("Method argument '"_s + MethodStr + "' is not valid");
+    }
+
     const vec3<double> vec3_nan( std::numeric_limits<double>::quiet_NaN(),
                                  std::numeric_limits<double>::quiet_NaN(),
                                  std::numeric_limits<double>::quiet_NaN() );
@@ -234,27 +264,19 @@ Drover SimulateRadiograph(Drover DICOM_data,
 
 
     // Ensure the image array is rectilinear. (This will allow us to use a faster postion-to-image lookup.)
-    {
-        std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-        for(auto &img : img_arr_ptr->imagecoll.images){
-            selected_imgs.push_back( std::ref(img) );
-        }
-
-        if(!Images_Form_Rectilinear_Grid(selected_imgs)){
-            throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
-        }
-        //const bool is_regular_grid = Images_Form_Regular_Grid(selected_imgs);
+    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
+    for(auto &img : img_arr_ptr->imagecoll.images){
+        selected_imgs.push_back( std::ref(img) );
+    }
+    if(!Images_Form_Rectilinear_Grid(selected_imgs)){
+        throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
     }
+    //const bool is_regular_grid = Images_Form_Regular_Grid(selected_imgs);
 
     const auto row_unit = img_arr_ptr->imagecoll.images.front().row_unit.unit();
     const auto col_unit = img_arr_ptr->imagecoll.images.front().col_unit.unit();
     const auto ortho_unit = col_unit.Cross(row_unit).unit();
 
-    planar_image_adjacency<float,double> img_adj( {}, { { std::ref(img_arr_ptr->imagecoll) } }, ortho_unit );
-    if(img_adj.int_to_img.empty()){
-        throw std::logic_error("Image array contained no images. Cannot continue.");
-    }
-
     // Determine an appropriate radiograph orientation.
     const auto img_centre = img_arr_ptr->imagecoll.center(); // TODO: For TBI, should be at the t0 point (i.e., at the level of the lung).
     auto ray_source = vec3_nan;
@@ -329,8 +351,90 @@ Drover SimulateRadiograph(Drover DICOM_data,
     const auto orthosrc_plane = OrthoSrcImg->image_plane();
 
     //------------------------
-    // March rays through the image data.
-    {
+    // Cast rays through the image data.
+    //
+    // Each ray is cast from the near bounding plane to the detector. The mass density encountered along the ray is
+    // integrated and normalized by the ray length. The remaining fractional ray intensity could be immediately reduced
+    // by multiplying by a factor of exp(-density*dL) as the ray interacts with the medium. However, it is easier to sum
+    // all the density*dL contributions and apply the reduction factor once at the end.
+    const auto ray_segment = [&](long int row, long int col) -> std::pair<vec3<double>, vec3<double>> {
+        //Construct a line segment between the source and detector. 
+        const auto ray_terminus = DetectImg->position(row, col);
+        const auto ray_line = line<double>(ray_terminus, ray_source);
+
+        // Find the intersection of the ray with the near and far bounding planes.
+        vec3<double> near_bp_intersection;
+        if(!orthosrc_plane.Intersects_With_Line_Once(ray_line, near_bp_intersection)){
+            throw std::logic_error("Ray line does not intersect near image array bounding plane. Cannot continue.");
+        }
+        vec3<double> far_bp_intersection;
+        if(!detector_plane.Intersects_With_Line_Once(ray_line, far_bp_intersection)){
+            throw std::logic_error("Ray line does not intersect far image array bounding plane. Cannot continue.");
+        }
+        return { near_bp_intersection, far_bp_intersection };
+    };
+
+    // Ficticious mass density encountered by the ray.
+    const auto mass_density = [](float intensity) -> float {
+        intensity = (intensity < -1000.0f) ? -1000.0f : intensity; // Enforce physicality.
+        return 1.0f + (intensity / 1000.0f); 
+    };
+
+    if(use_exact){
+        // Resolve the CT numbers into a flat volume of mass densities so each voxel is converted only once.
+        const auto grid = grid_resampling::Make_Rectilinear_Grid(selected_imgs);
+        if(!grid){
+            throw std::invalid_argument("Images do not form a rectilinear grid. Cannot continue");
+        }
+        const auto vol = voxel_traversal::Make_Indexed_Volume(grid.value(), Channel, mass_density);
+
+        // The detector is divided into square tiles, each of which is processed by a single task. Neighbouring rays
+        // traverse nearby voxels, so this improves cache locality compared with processing whole rows.
+        const long int tile_size = 16;
+        const long int tile_rows = (RadiographRows + tile_size - 1) / tile_size;
+        const long int tile_cols = (RadiographColumns + tile_size - 1) / tile_size;
+
+        asio_thread_pool tp;
+        std::mutex printer; // Who gets to print to the console and iterate the counter.
+        long int completed = 0;
+        for(long int tr = 0; tr < tile_rows; ++tr){
+            for(long int tc = 0; tc < tile_cols; ++tc){
+                tp.submit_task([&,tr,tc](void) -> void {
+                    const auto row_end = std::min((tr + 1) * tile_size, RadiographRows);
+                    const auto col_end = std::min((tc + 1) * tile_size, RadiographColumns);
+                    for(long int row = tr * tile_size; row < row_end; ++row){
+                        for(long int col = tc * tile_size; col < col_end; ++col){
+                            const auto [ray_start, ray_end] = ray_segment(row, col);
+
+                            // Path lengths are in units of the whole ray length.
+                            double accumulated_mass_density_length = 0.0;
+                            voxel_traversal::Traverse(vol, ray_start, ray_end,
+                                [&](std::size_t i, double t_enter, double t_exit) -> void {
+                                    accumulated_mass_density_length += static_cast<double>(vol.values[i]) * (t_exit - t_enter);
+                                });
+
+                            //Record the result in the image.
+                            DetectImg->reference(row, col, 0) = static_cast<float>(accumulated_mass_density_length);
+                        }
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(printer);
+                        ++completed;
+                        if( (completed % 100 == 0) || (completed == (tile_rows * tile_cols)) ){
+                            FUNCINFO("Completed " << completed << " of " << (tile_rows * tile_cols) << " detector tiles"
+                                  << " --> " << static_cast<int>(1000.0*(completed)/(tile_rows * tile_cols))/10.0 << "% done");
+                        }
+                    }
+                });
+            }
+        }
+    }else{
+        planar_image_adjacency<float,double> img_adj( {}, { { std::ref(img_arr_ptr->imagecoll) } }, ortho_unit );
+        if(img_adj.int_to_img.empty()){
+            throw std::logic_error("Image array contained no images. Cannot continue.");
+        }
+
         asio_thread_pool tp;
         std::mutex printer; // Who gets to print to the console and iterate the counter.
         long int completed = 0;
@@ -338,43 +442,19 @@ Drover SimulateRadiograph(Drover DICOM_data,
         for(long int row = 0; row < RadiographRows; ++row){
             tp.submit_task([&,row](void) -> void {
                 for(long int col = 0; col < RadiographColumns; ++col){
-
-                    //Construct a line segment between the source and detector. 
-                    const auto ray_terminus = DetectImg->position(row, col);
-                    const auto ray_line = line<double>(ray_terminus, ray_source);
-
-                    // Find the intersection of the ray with the near and far bounding planes.
-                    vec3<double> near_bp_intersection;
-                    if(!orthosrc_plane.Intersects_With_Line_Once(ray_line, near_bp_intersection)){
-                        throw std::logic_error("Ray line does not intersect near image array bounding plane. Cannot continue.");
-                    }
-                    vec3<double> far_bp_intersection;
-                    if(!detector_plane.Intersects_With_Line_Once(ray_line, far_bp_intersection)){
-                        throw std::logic_error("Ray line does not intersect far image array bounding plane. Cannot continue.");
-                    }
-                    const vec3<double> ray_start = near_bp_intersection;
-                    const vec3<double> ray_end = far_bp_intersection;
+                    const auto [ray_start, ray_end] = ray_segment(row, col);
 
                     const auto travel_dist = ray_end.distance(ray_start);
                     const auto N_advances = static_cast<long int>(travel_dist/MarchingDistance) + 1L;
                     const auto actual_ray_march_dist = static_cast<double>(1)/static_cast<double>(N_advances);
 
-                    // Each time the ray samples the CT number, the ray is simulated to have interacted with the medium
-                    // for the length of the ray advancement. The remaining fractional ray intensity could be
-                    // immediately reduced by multiplying by a factor of exp(-density*dL). However, it is easier to sum
-                    // all the density*dL contributions and apply the reduction factor once at the end.
                     double accumulated_mass_density_length = 0.0;
                     for(long int i = 0; i <= N_advances; ++i){
                         const auto x = static_cast<double>(i)/static_cast<double>(N_advances);
                         const auto P = (ray_end - ray_start) * x + ray_start;
 
                         const auto interp_val = img_adj.trilinearly_interpolate(P,Channel,-1000.0f);
-
-                        // Ficticious mass density encountered by the ray.
-                        const auto intensity = (interp_val < -1000.0f) ? -1000.0f : interp_val; // Enforce physicality.
-                        const auto mass_density = 1.0f + (intensity / 1000.0f); 
-
-                        accumulated_mass_density_length += mass_density * actual_ray_march_dist;
+                        accumulated_mass_density_length += mass_density(interp_val) * actual_ray_march_dist;
                     }
 
                     //Record the result in the image.
@@ -389,17 +469,16 @@ Drover SimulateRadiograph(Drover DICOM_data,
                 }
             });
         }
+    } // Complete tasks and terminate thread pool.
 
-        // Transform the image to the fraction of light that would have made it through.
-        for(long int row = 0; row < RadiographRows; ++row){
-            for(long int col = 0; col < RadiographColumns; ++col){
-                const auto ad = DetectImg->reference(row, col, 0);
-                const auto f = 1.0 - std::exp(-ad * AttenuationScale);
-                DetectImg->reference(row, col, 0) = f;
-            }
+    // Transform the image to the fraction of light that would have made it through.
+    for(long int row = 0; row < RadiographRows; ++row){
+        for(long int col = 0; col < RadiographColumns; ++col){
+            const auto ad = DetectImg->reference(row, col, 0);
+            const auto f = 1.0 - std::exp(-ad * AttenuationScale);
+            DetectImg->reference(row, col, 0) = f;
         }
-
-    } // Complete tasks and terminate thread pool.
+    }
 
     //------------------------
     // Save image maps to file.
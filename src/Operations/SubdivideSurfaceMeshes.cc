@@ -24,6 +24,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
+#include "../YgorImages_Functors/Mesh_Attribute_Transfer.h"
 #include "SubdivideSurfaceMeshes.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "YgorImages.h"
@@ -84,6 +85,12 @@ Drover SubdivideSurfaceMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::m
 
         const auto orig_metadata = (*smp_it)->meshes.metadata;
 
+        // Retain the original mesh so attributes can be resampled onto the new mesh.
+        mesh_attributes::connectivity_change attr_change( (*smp_it)->meshes,
+                                                          (*smp_it)->vertex_attributes,
+                                                          (*smp_it)->face_attributes,
+                                                          mesh_attribute_transfer::Transfer_Attributes );
+
         // Convert to a CGAL mesh.
         std::stringstream ss_i;
         if(!WriteFVSMeshToOFF( (*smp_it)->meshes, ss_i )){
@@ -115,6 +122,8 @@ Drover SubdivideSurfaceMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::m
 
         (*smp_it)->meshes.metadata = orig_metadata;
 
+        attr_change.commit();
+
         ++completed;
         FUNCINFO("Completed " << completed << " of " << sm_count
               << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
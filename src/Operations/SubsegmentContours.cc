@@ -24,6 +24,7 @@
 #include "../Structs.h"
 #include "../Regex_Selectors.h"
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
+#include "../YgorImages_Functors/Subsegmentation.h"
 #include "Explicator.h"       //Needed for Explicator class.
 #include "SubsegmentContours.h"
 #include "YgorFilesDirs.h"    //Needed for Does_File_Exist_And_Can_Be_Read(...), etc..
@@ -323,137 +324,64 @@ Drover SubsegmentContours(Drover DICOM_data, OperationArgPkg OptArgs, std::map<s
         throw std::invalid_argument("Planar orientations not understood. Cannot continue.");
     }
 
-    // This routine returns a pair of planes that approximately encompass the desired interior volume. The ROIs are not
-    // altered. The lower plane is the first element of the pair. This routine can be applied to any contour_collection
-    // and the planes can also be applied to any contour_collection.
-    const auto bisect_ROIs = [FractionalTolerance,MaxBisects](
-                                 const contour_collection<double> &ROIs,
-                                 const vec3<double> &planar_normal,
-                                 double SelectionLower,
-                                 double SelectionUpper) -> 
-                                     std::pair<plane<double>, plane<double>> {
-
-        if(ROIs.contours.empty()) throw std::logic_error("Unable to split empty contour collection.");
-        size_t iters_taken = 0;
-        double final_area_frac = 0.0;
-
-        //Find the lower plane.
-        plane<double> lower_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionLower,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &lower_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above LOWER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionLower << "."
-                 << " Iters: " << iters_taken);
-
-        //Find the upper plane.
-        plane<double> upper_plane;
-        ROIs.Total_Area_Bisection_Along_Plane(planar_normal,
-                                                      SelectionUpper,
-                                                      FractionalTolerance,
-                                                      MaxBisects,
-                                                      &upper_plane,
-                                                      &iters_taken,
-                                                      &final_area_frac);
-        FUNCINFO("Bisection: planar area fraction"
-                 << " above UPPER plane with normal: " << planar_normal
-                 << " was " << final_area_frac << "."
-                 << " Requested: " << SelectionUpper << "."
-                 << " Iters: " << iters_taken);
-
-        return std::make_pair(lower_plane, upper_plane);
-    };
-
-    const auto subsegment_interior = [](const contour_collection<double> &ROIs,
-                                        const std::pair<plane<double>, plane<double>> &planes) ->
-                                            contour_collection<double> {
-        const plane<double> lower_plane(planes.first);
-        const plane<double> upper_plane(planes.second);
-
-        //Implements the sub-segmentation, selecting only the interior portion.
-        auto split1 = ROIs.Split_Along_Plane(lower_plane);
-        if(split1.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
-        auto split2 = split1.back().Split_Along_Plane(upper_plane);
-        if(split2.size() != 2){
-            throw std::logic_error("Expected exactly two groups, above and below plane.");
-        }
+    const subsegmentation::cleave x_cleave{ x_normal, XSelectionLower, XSelectionUpper };
+    const subsegmentation::cleave y_cleave{ y_normal, YSelectionLower, YSelectionUpper };
+    const subsegmentation::cleave z_cleave{ z_normal, ZSelectionLower, ZSelectionUpper };
 
-        if(false) for(auto & it : split2){ it.Plot(); }
+    subsegmentation::bisection_opts bisection;
+    bisection.tolerance = FractionalTolerance;
+    bisection.max_iters = MaxBisects;
 
-        const contour_collection<double> cc_selection( split2.front() );
-        if( cc_selection.contours.empty() ){
-            FUNCWARN("Selection contains no contours. Try adjusting your criteria.");
+    std::vector<subsegmentation::cleave> cleaves;
+    subsegmentation::method method;
+
+    // ---------------------------------- Compound sub-segmentation --------------------------------------
+    //Generate all planes using the original contour_collection before sub-segmenting.
+    //
+    // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
+    //       Do not use this method unless you know what you're doing.
+    if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
+        method = subsegmentation::method::Compound;
+        cleaves = { x_cleave, y_cleave, z_cleave };
+
+    // ----------------------------------- Nested sub-segmentation ---------------------------------------
+    // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
+    // at each pair of cleaves.
+    //
+    // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
+    //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
+    //       sub-segmentation in almost all cases. It should be faster too.
+    }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
+        method = subsegmentation::method::Nested;
+        for(const auto &cleave : NestedCleaveOrder){
+            if(false){
+            }else if( (cleave == static_cast<unsigned char>('X'))
+                  ||  (cleave == static_cast<unsigned char>('x')) ){
+                cleaves.push_back(x_cleave);
+
+            }else if( (cleave == static_cast<unsigned char>('Y'))
+                  ||  (cleave == static_cast<unsigned char>('y')) ){
+                cleaves.push_back(y_cleave);
+
+            }else if( (cleave == static_cast<unsigned char>('Z'))
+                  ||  (cleave == static_cast<unsigned char>('z')) ){
+                cleaves.push_back(z_cleave);
+
+            }else{
+                throw std::invalid_argument("Cleave axis '"_s + cleave + "' not understood. Cannot continue.");
+            }
         }
-        return cc_selection;
-    };
 
-    // Perform the sub-segmentation.
+    }else{
+        throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
+    }
+
+    // Perform the sub-segmentation. Bisections and contour clipping are performed concurrently within each ROI.
     std::list<contour_collection<double>> cc_selection;
     for(const auto &cc_ref : cc_ROIs){
         if(cc_ref.get().contours.empty()) continue;
-
-        // ---------------------------------- Compound sub-segmentation --------------------------------------
-        //Generate all planes using the original contour_collection before sub-segmenting.
-        //
-        // NOTE: This method results in sub-segments of different volumes depending on the location within the ROI.
-        //       Do not use this method unless you know what you're doing.
-        if( std::regex_match(SubsegMethodReq,SubsegMethodCompound) ){
-            const auto x_planes_pair = bisect_ROIs(cc_ref.get(), x_normal, XSelectionLower, XSelectionUpper);
-            const auto y_planes_pair = bisect_ROIs(cc_ref.get(), y_normal, YSelectionLower, YSelectionUpper);
-            const auto z_planes_pair = bisect_ROIs(cc_ref.get(), z_normal, ZSelectionLower, ZSelectionUpper);
-
-            //Perform the sub-segmentation.
-            contour_collection<double> running(cc_ref.get());
-            running = subsegment_interior(running, x_planes_pair);
-            running = subsegment_interior(running, y_planes_pair);
-            running = subsegment_interior(running, z_planes_pair);
-            cc_selection.emplace_back(running);
-
-        // ----------------------------------- Nested sub-segmentation ---------------------------------------
-        // Instead of relying on whole-organ sub-segmentation, attempt to fairly partition the *remaining* volume 
-        // at each pair of cleaves.
-        //
-        // NOTE: This method will generate sub-segments with equal volumes (as best possible given the number of slices
-        //       if the plane orientations are aligned with the contour planes) and should be preferred over compound
-        //       sub-segmentation in almost all cases. It should be faster too.
-        }else if( std::regex_match(SubsegMethodReq,SubsegMethodNested) ){
-            contour_collection<double> running(cc_ref.get());
-
-            for(const auto &cleave : NestedCleaveOrder){
-                if(false){
-                }else if( (cleave == static_cast<unsigned char>('X'))
-                      ||  (cleave == static_cast<unsigned char>('x')) ){
-                    const auto x_planes_pair = bisect_ROIs(running, x_normal, XSelectionLower, XSelectionUpper);
-                    running = subsegment_interior(running, x_planes_pair);
-
-                }else if( (cleave == static_cast<unsigned char>('Y'))
-                      ||  (cleave == static_cast<unsigned char>('y')) ){
-                    const auto y_planes_pair = bisect_ROIs(running, y_normal, YSelectionLower, YSelectionUpper);
-                    running = subsegment_interior(running, y_planes_pair);
-
-                }else if( (cleave == static_cast<unsigned char>('Z'))
-                      ||  (cleave == static_cast<unsigned char>('z')) ){
-                    const auto z_planes_pair = bisect_ROIs(running, z_normal, ZSelectionLower, ZSelectionUpper);
-                    running = subsegment_interior(running, z_planes_pair);
-
-                }else{
-                    throw std::invalid_argument("Cleave axis '"_s + cleave + "' not understood. Cannot continue.");
-                }
-            }
-
-            cc_selection.emplace_back(running);
-
-        }else{
-            throw std::invalid_argument("Subsegmentation method not understood. Cannot continue.");
-        }
+        auto subseg = subsegmentation::Subsegment_ROI(cc_ref.get(), cleaves, method, bisection);
+        cc_selection.emplace_back( std::move(subseg.contours) );
     }
 
     //Generate references.
@@ -1,6 +1,8 @@
 //SupersampleImageGrid.cc - A part of DICOMautomaton 2016. Written by hal clark.
 
 #include <any>
+#include <cmath>
+#include <limits>
 #include <optional>
 #include <functional>
 #include <iterator>
@@ -64,7 +66,8 @@ OperationDoc OpArgDocSupersampleImageGrid(void){
     out.args.back().desc = "A positive integer specifying how many image slices will be in the new images."
                            " The number is relative to the incoming image slice count. Specifying '1' will"
                            " result in nothing happening. Specifying '8' will result in 8x as many slices."
-                           " Note that slice supersampling always happens *after* in-plane supersampling."
+                           " Note that 3D-aware methods perform in-plane and slice supersampling together in a"
+                           " single pass."
                            " Also note that merely setting this factor will not enable 3D supersampling;"
                            " you also need to specify a 3D-aware SamplingMethod.";
     out.args.back().default_val = "2";
@@ -108,39 +111,10 @@ Drover SupersampleImageGrid(Drover DICOM_data, OperationArgPkg OptArgs, std::map
     auto IAs_all = All_IAs( DICOM_data );
     auto IAs = Whitelist( IAs_all, ImageSelectionStr );
     
-    if(false){
-    }else if( std::regex_match(SamplingMethodStr, inplane_bilin)
-          ||  std::regex_match(SamplingMethodStr, trilin) ){
-        for(auto & iap_it : IAs){
-            InImagePlaneBilinearSupersampleUserData bilin_ud;
-            bilin_ud.RowScaleFactor = RowScaleFactor; 
-            bilin_ud.ColumnScaleFactor = ColumnScaleFactor; 
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              InImagePlaneBilinearSupersample,
-                                                              {}, {}, &bilin_ud )){
-                throw std::runtime_error("Unable to bilinearly supersample images. Cannot continue.");
-            }
-        }
-
-    }else if(std::regex_match(SamplingMethodStr, inplane_bicub)){
-        for(auto & iap_it : IAs){
-            InImagePlaneBicubicSupersampleUserData bicub_ud;
-            bicub_ud.RowScaleFactor = RowScaleFactor; 
-            bicub_ud.ColumnScaleFactor = ColumnScaleFactor; 
-            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
-                                                              InImagePlaneBicubicSupersample,
-                                                              {}, {}, &bicub_ud )){
-                throw std::runtime_error("Unable to bicubically supersample images. Cannot continue.");
-            }
-        }
-
-    }else{
-        throw std::invalid_argument("Invalid sampling method specified. Cannot continue");
-    }
-
     if(false){
     }else if( std::regex_match(SamplingMethodStr, trilin) ){
-
+        // Trilinear supersampling is performed in a single pass: placeholder images with the supersampled geometry are
+        // created and then interpolated directly from the original images.
         for(auto & iap_it : IAs){
             if((*iap_it)->imagecoll.images.empty()){
                 FUNCWARN("Skipping empty image array");
@@ -150,17 +124,30 @@ Drover SupersampleImageGrid(Drover DICOM_data, OperationArgPkg OptArgs, std::map
             // Create placeholder image slices with the correct geometry. The values of these images will be overwritten.
             planar_image_collection<float, double> edit_imagecoll;
 
-            const auto proto_plane = (*iap_it)->imagecoll.images.front().image_plane();
-            //const auto R_0 = proto_plane.R_0;
-            const auto R_0 = (*iap_it)->imagecoll.images.front().position(0,0);
+            const auto &proto_img = (*iap_it)->imagecoll.images.front();
+            const auto proto_plane = proto_img.image_plane();
             const auto N_0 = proto_plane.N_0;
 
+            const auto RowScaleFactorR = static_cast<double>(RowScaleFactor);
+            const auto ColumnScaleFactorR = static_cast<double>(ColumnScaleFactor);
+            const auto new_rows = proto_img.rows * RowScaleFactor;
+            const auto new_columns = proto_img.columns * ColumnScaleFactor;
+            const auto new_pxl_dx = proto_img.pxl_dx / RowScaleFactorR;
+            const auto new_pxl_dy = proto_img.pxl_dy / ColumnScaleFactorR;
+
+            // The centre of the first supersampled voxel, which preserves the in-plane extent of the image.
+            //const auto R_0 = proto_plane.R_0;
+            const auto R_0 = proto_img.position(0,0)
+                           - proto_img.row_unit * proto_img.pxl_dx * 0.5
+                           - proto_img.col_unit * proto_img.pxl_dy * 0.5
+                           + proto_img.row_unit * new_pxl_dx * 0.5
+                           + proto_img.col_unit * new_pxl_dy * 0.5;
+
             auto upper_extent = std::numeric_limits<double>::quiet_NaN();
             auto lower_extent = std::numeric_limits<double>::quiet_NaN();
             for(const auto &img : (*iap_it)->imagecoll.images){
-                const auto img_plane = img.image_plane();
                 //const auto dR = (R_0 - img_plane.R_0).Dot(N_0);
-                const auto dR = (img.position(0,0) - R_0).Dot(N_0);
+                const auto dR = (img.position(0,0) - proto_img.position(0,0)).Dot(N_0);
                 const auto up = dR + 0.5 * img.pxl_dz;
                 const auto lo = dR - 0.5 * img.pxl_dz;
                 if(!std::isfinite(upper_extent) || (upper_extent < up)) upper_extent = up;
@@ -174,17 +161,22 @@ Drover SupersampleImageGrid(Drover DICOM_data, OperationArgPkg OptArgs, std::map
             const auto common_metadata = (*iap_it)->imagecoll.get_common_metadata({});
 
             for(long int i = 0; i < N_new; ++i){
-                edit_imagecoll.images.push_back( (*iap_it)->imagecoll.images.front() );
+                edit_imagecoll.images.emplace_back();
                 const auto offset = R_0
                                   - N_0 * std::abs(lower_extent)
                                   + N_0 * pxl_dz * 0.5
                                   + N_0 * pxl_dz * static_cast<double>(i); 
-                edit_imagecoll.images.back().init_spatial(edit_imagecoll.images.back().pxl_dx,
-                                                          edit_imagecoll.images.back().pxl_dy,
+                edit_imagecoll.images.back().init_buffer(new_rows, new_columns, proto_img.channels);
+                edit_imagecoll.images.back().init_spatial(new_pxl_dx,
+                                                          new_pxl_dy,
                                                           pxl_dz,
-                                                          edit_imagecoll.images.back().anchor,
+                                                          proto_img.anchor,
                                                           offset);
+                edit_imagecoll.images.back().init_orientation(proto_img.row_unit,
+                                                              proto_img.col_unit);
                 edit_imagecoll.images.back().metadata = common_metadata;
+                edit_imagecoll.images.back().metadata["Rows"] = std::to_string(new_rows);
+                edit_imagecoll.images.back().metadata["Columns"] = std::to_string(new_columns);
                 edit_imagecoll.images.back().metadata["SliceThickness"] = std::to_string(pxl_dz);
             }
             edit_imagecoll.images.reverse();
@@ -205,21 +197,38 @@ Drover SupersampleImageGrid(Drover DICOM_data, OperationArgPkg OptArgs, std::map
                 throw std::runtime_error("Unable to interpolate image slices.");
             }
 
-            // Trim metadata.
-
-            // ... 
-
-            // Inject the data.
-            //DICOM_data.image_data.emplace_back( std::make_shared<Image_Array>() );
-            //DICOM_data.image_data.back()->imagecoll.images.splice(
-            //    DICOM_data.image_data.back()->imagecoll.images.end(),
-            //    edit_imagecoll.images );
-
             (*iap_it)->imagecoll.images.clear();
             (*iap_it)->imagecoll.images.splice(
                 (*iap_it)->imagecoll.images.end(),
                 edit_imagecoll.images );
         }
+
+    }else if( std::regex_match(SamplingMethodStr, inplane_bilin) ){
+        for(auto & iap_it : IAs){
+            InImagePlaneBilinearSupersampleUserData bilin_ud;
+            bilin_ud.RowScaleFactor = RowScaleFactor; 
+            bilin_ud.ColumnScaleFactor = ColumnScaleFactor; 
+            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
+                                                              InImagePlaneBilinearSupersample,
+                                                              {}, {}, &bilin_ud )){
+                throw std::runtime_error("Unable to bilinearly supersample images. Cannot continue.");
+            }
+        }
+
+    }else if(std::regex_match(SamplingMethodStr, inplane_bicub)){
+        for(auto & iap_it : IAs){
+            InImagePlaneBicubicSupersampleUserData bicub_ud;
+            bicub_ud.RowScaleFactor = RowScaleFactor; 
+            bicub_ud.ColumnScaleFactor = ColumnScaleFactor; 
+            if(!(*iap_it)->imagecoll.Process_Images_Parallel( GroupIndividualImages,
+                                                              InImagePlaneBicubicSupersample,
+                                                              {}, {}, &bicub_ud )){
+                throw std::runtime_error("Unable to bicubically supersample images. Cannot continue.");
+            }
+        }
+
+    }else{
+        throw std::invalid_argument("Invalid sampling method specified. Cannot continue");
     }
 
     return DICOM_data;
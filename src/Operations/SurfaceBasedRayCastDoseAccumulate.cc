@@ -50,11 +50,6 @@
 
 #include <CGAL/subdivision_method_3.h>
 
-#include <CGAL/AABB_tree.h>
-#include <CGAL/AABB_traits.h>
-#include <CGAL/boost/graph/graph_traits_Polyhedron_3.h>
-#include <CGAL/AABB_face_graph_triangle_primitive.h>
-#include <boost/optional.hpp>
 
 
 #include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
@@ -119,6 +114,8 @@
 #include "../YgorImages_Functors/Compute/AccumulatePixelDistributions.h"
 #include "../YgorImages_Functors/Compute/GenerateSurfaceMask.h"
 
+#include "../YgorImages_Functors/Mesh_BVH.h"
+
 #include "SurfaceBasedRayCastDoseAccumulate.h"
 
 
@@ -135,7 +132,8 @@ OperationDoc OpArgDocSurfaceBasedRayCastDoseAccumulate(void){
         " Though it is not required by the implementation, only the ray-surface intersection nearest to the detector is"
         " considered. All other intersections (i.e., on the far side of the surface mesh) are ignored."
         " This routine is fairly fast compared to the slow grid-based counterpart previously implemented. The speedup comes"
-        " from use of an AABB-tree to accelerate intersection queries and avoid having to 'walk' rays step-by-step through"
+        " from use of a bounding volume hierarchy to accelerate intersection queries and avoid having to 'walk' rays"
+        " step-by-step through"
         " over/through the geometry.";
 
 
@@ -618,21 +616,14 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
     if(OnlyGenerateSurface) return DICOM_data;
 
 
-    // ================================ Construct AABB Trees for Spatial Lookups ===================================
-    //typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
-    using Kernel                = dcma_surface_meshes::Kernel;
-    using Point                 = Kernel::Point_3;
-    using Segment               = Kernel::Segment_3;
-    using Line                  = Kernel::Line_3;
-    using Triangle_Primitive    = CGAL::AABB_face_graph_triangle_primitive<dcma_surface_meshes::Polyhedron>;
-    using Traits                = CGAL::AABB_traits<Kernel, Triangle_Primitive>;
-    using AABB_Tree             = CGAL::AABB_tree<Traits>;
-    using Segment_intersection  = boost::optional<AABB_Tree::Intersection_and_primitive_id<Segment>::Type>;
-    //using Line_intersection     = boost::optional<AABB_Tree::Intersection_and_primitive_id<Line>::Type>;
-
-    //Construct the tree.
-    AABB_Tree tree(faces(polyhedron).first, faces(polyhedron).second, polyhedron);
-    AABB_Tree ref_tree(faces(ref_polyhedron).first, faces(ref_polyhedron).second, ref_polyhedron);
+    // ================================= Construct BVHs for Spatial Lookups ====================================
+    //Convert the polyhedra to face-vertex meshes and build a bounding volume hierarchy over each. Vertices are copied
+    // directly from the polyhedra so no precision is lost.
+    const auto build_bvh = [](const dcma_surface_meshes::Polyhedron &p) -> mesh_bvh::triangle_bvh {
+        return mesh_bvh::Build_BVH( dcma_surface_meshes::PolyhedronToFVSMesh(p) );
+    };
+    const auto tree = build_bvh(polyhedron);
+    const auto ref_tree = build_bvh(ref_polyhedron);
 
     //Figure out what z-margin is needed so the extra two images do not interfere with the grid lining up with the
     // contours. (Want exactly one contour plane per image.) So the margin should be large enough so the empty
@@ -779,75 +770,53 @@ Drover SurfaceBasedRayCastDoseAccumulate(Drover DICOM_data, OperationArgPkg OptA
                     const vec3<double> ray_start = SourceImg->position(row, col); // The naive starting position, without boosting.
                     const vec3<double> ray_end = DetectImg->position(row, col);
 
-                    Segment line_segment( Point(ray_start.x, ray_start.y, ray_start.z),
-                                          Point(ray_end.x,   ray_end.y,   ray_end.z)   );
-
-                    //Fast check for intersections.
-                    if(tree.do_intersect(line_segment)){
-
-                        //Enumerate all intersections. Note that some may be line segment "glances."
-                        std::list<Segment_intersection> intersections;
-                        tree.all_intersections(line_segment, std::back_inserter(intersections));
+                    //Enumerate all intersections along the segment. Note that some may be duplicates where the
+                    // segment passes through shared edges or vertices.
+                    mesh_bvh::ray r;
+                    r.origin = ray_start;
+                    r.dir = ray_end - ray_start;
+                    r.t_min = 0.0;
+                    r.t_max = 1.0;
+                    auto intersections = mesh_bvh::All_Intersections(tree, r);
+                    if(!intersections.empty()){
+
+                        //Determine whether the reference ROI is orthogonally adjacent to these intersections. The
+                        // ray is extended into an infinite line for this test.
+                        mesh_bvh::ray ref_r = r;
+                        ref_r.t_min = -std::numeric_limits<double>::infinity();
+                        ref_r.t_max = std::numeric_limits<double>::infinity();
+                        const bool ref_adjacent = mesh_bvh::Any_Intersection(ref_tree, ref_r);
 
                         //Sort by distance from the detector so the first intersection is closest to the detector.
-                        intersections.sort([&](const Segment_intersection &A, const Segment_intersection &B) -> bool {
-                            const Point *pA = boost::get<Point>(&(A->first));
-                            const Point *pB = boost::get<Point>(&(B->first));
-                            if( (pA) && (pB) ){ // Both valid points.
-                                const vec3<double> PA(static_cast<double>( CGAL::to_double( pA->x() )),
-                                                      static_cast<double>( CGAL::to_double( pA->y() )),
-                                                      static_cast<double>( CGAL::to_double( pA->z() )));
-                                const vec3<double> PB(static_cast<double>( CGAL::to_double( pB->x() )),
-                                                      static_cast<double>( CGAL::to_double( pB->y() )),
-                                                      static_cast<double>( CGAL::to_double( pB->z() )));
-                                return std::abs( detector_plane.Get_Signed_Distance_To_Point(PA) ) 
-                                          < std::abs( detector_plane.Get_Signed_Distance_To_Point(PB) );
-                            }else if((pA) && !(pB)){
-                                return true;
-                            }else if(!(pA) && (pB)){
-                                return false;
-                            }
-                            return false; //Both non-points.
-
+                        std::stable_sort(std::begin(intersections), std::end(intersections),
+                                         [&](const mesh_bvh::ray_hit &A, const mesh_bvh::ray_hit &B) -> bool {
+                            return std::abs( detector_plane.Get_Signed_Distance_To_Point(A.point) ) 
+                                      < std::abs( detector_plane.Get_Signed_Distance_To_Point(B.point) );
                         });
 
                         //Cycle through the intersections stopping after the point nearest the detector is located.
                         for(const auto & intersection : intersections){
-                            if(intersection){
-                                const Point* p = boost::get<Point>(&(intersection->first));
-                                if(p){
-                                    //Convert from CGAL vector to Ygor vector.
-                                    const vec3<double> P(static_cast<double>( CGAL::to_double( p->x() )),
-                                                         static_cast<double>( CGAL::to_double( p->y() )),
-                                                         static_cast<double>( CGAL::to_double( p->z() )));
-
-                                    //Compute the distance to the detector.
-                                    const auto P_src_dist = std::abs( detector_plane.Get_Signed_Distance_To_Point(P) );
-                                    DepthImg->reference(row, col, accumulated_counts) = static_cast<float>( P_src_dist );
-
-                                    //Compute the distance to the COM-COM line (between target ROI and reference ROI).
-                                    const auto P_rad_dist = COM_COM_line.Distance_To_Point(P);
-                                    RadialDistImg->reference(row, col, accumulated_counts) = static_cast<float>( P_rad_dist );
-
-                                    //Find the dose at the intersection point.
-                                    const auto interp_val = img_arr_ptr->imagecoll.trilinearly_interpolate(P,0);
-
-                                    accumulated_totaldose += interp_val;
-                                    ++accumulated_counts;
-
-                                    //Determine whether the reference ROI is orthogonally adjacent to this intersection.
-                                    Line cgal_line( Point(ray_start.x, ray_start.y, ray_start.z),
-                                                    Point(ray_end.x,   ray_end.y,   ray_end.z)   );
-                                    
-                                    //Fast check for intersections with the reference ROI.
-                                    if(ref_tree.do_intersect(cgal_line)){
-                                        ++ref_accumulated_counts;
-                                    }
-
-                                    //Terminate the loop after desired number of intersections.
-                                    if(accumulated_counts >= MaxRaySurfaceIntersections) break;
-                                }
+                            const vec3<double> &P = intersection.point;
+
+                            //Compute the distance to the detector.
+                            const auto P_src_dist = std::abs( detector_plane.Get_Signed_Distance_To_Point(P) );
+                            DepthImg->reference(row, col, accumulated_counts) = static_cast<float>( P_src_dist );
+
+                            //Compute the distance to the COM-COM line (between target ROI and reference ROI).
+                            const auto P_rad_dist = COM_COM_line.Distance_To_Point(P);
+                            RadialDistImg->reference(row, col, accumulated_counts) = static_cast<float>( P_rad_dist );
+
+                            //Find the dose at the intersection point.
+                            const auto interp_val = img_arr_ptr->imagecoll.trilinearly_interpolate(P,0);
+
+                            accumulated_totaldose += interp_val;
+                            ++accumulated_counts;
+                            if(ref_adjacent){
+                                ++ref_accumulated_counts;
                             }
+
+                            //Terminate the loop after desired number of intersections.
+                            if(accumulated_counts >= MaxRaySurfaceIntersections) break;
                         }
                     }
 
@@ -20,6 +20,7 @@
 #include "../Regex_Selectors.h"
 #include "../Thread_Pool.h"
 #include "../YgorImages_Functors/ConvenienceRoutines.h"
+#include "../YgorImages_Functors/Pixel_Kernels.h"
 
 #include "ThresholdImages.h"
 #include "Explicator.h"       //Needed for Explicator class.
@@ -158,8 +159,6 @@ Drover ThresholdImages(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std:
             std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(animg) );
 
             tp.submit_task([&,img_refw](void) -> void {
-                const auto R = img_refw.get().rows;
-                const auto C = img_refw.get().columns;
 
                 //Determine the bounds in terms of pixel-value thresholds.
                 auto cl = Lower; // Will be replaced if percentages/percentiles requested.
@@ -190,29 +189,16 @@ Drover ThresholdImages(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std:
                     }
                 }
 
-                //Construct pixel 'oracle' closures using the user-specified threshold criteria. 
-                // These functions identify whether pixels are within the threshold values.
-                auto lower_pixel_oracle = [cu,cl](float p) -> bool {
-                    return (cl < p);
-                };
-                auto upper_pixel_oracle = [cu,cl](float p) -> bool {
-                    return (p < cu);
-                };
+                //Replace pixels outside of the thresholds in bulk.
+                const auto buf = pixel_kernels::Pixel_Buffer(img_refw.get(), Channel);
+                pixel_kernels::Threshold_Replace(buf, static_cast<float>(cl), static_cast<float>(Low),
+                                                      static_cast<float>(cu), static_cast<float>(High));
 
-                //Iterate over each pixel, asking the oracle to identify each.
                 Stats::Running_MinMax<float> minmax_pixel;
-                for(auto r = 0; r < R; ++r){
-                    for(auto c = 0; c < C; ++c){
-                        const auto v = img_refw.get().value(r, c, Channel);
-
-                        if(!lower_pixel_oracle(v)){
-                            img_refw.get().reference(r, c, Channel) = Low;
-                        }
-                        if(!upper_pixel_oracle(v)){
-                            img_refw.get().reference(r, c, Channel) = High;
-                        }
-                        minmax_pixel.Digest( img_refw.get().value(r, c, Channel) );
-                    }
+                const auto mm = pixel_kernels::Min_Max(buf);
+                if(mm.valid()){
+                    minmax_pixel.Digest(mm.min);
+                    minmax_pixel.Digest(mm.max);
                 }
 
                 UpdateImageDescription( img_refw, "Thresholded" );
@@ -0,0 +1,265 @@
+//TransformImages.cc - A part of DICOMautomaton 2020. Written by hal clark.
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../Structs.h"
+#include "../Regex_Selectors.h"
+#include "../YgorImages_Functors/ConvenienceRoutines.h"
+#include "../YgorImages_Functors/Grid_Resampling.h"
+#include "TransformImages.h"
+#include "YgorImages.h"
+#include "YgorMath.h"         //Needed for vec3 class.
+#include "YgorMisc.h"         //Needed for FUNCINFO, FUNCWARN, FUNCERR macros.
+#include "YgorString.h"       //Needed for GetFirstRegex(...)
+
+
+
+OperationDoc OpArgDocTransformImages(void){
+    OperationDoc out;
+    out.name = "TransformImages";
+
+    out.desc =
+        "This operation transforms the contents of images by translating, scaling, and rotating them."
+        " The image geometry is not altered; voxel values are resampled from the transformed image.";
+
+    out.notes.emplace_back(
+        "A single transformation can be specified at a time. Perform this operation sequentially to enforce order."
+    );
+    out.notes.emplace_back(
+        "The selected images must form a rectilinear grid. Slices need not be evenly spaced."
+    );
+    out.notes.emplace_back(
+        "Voxels that sample beyond the extent of the original images will be assigned the fill value."
+    );
+
+    out.args.emplace_back();
+    out.args.back() = IAWhitelistOpArgDoc();
+    out.args.back().name = "ImageSelection";
+    out.args.back().default_val = "last";
+
+    out.args.emplace_back();
+    out.args.back().name = "Transform";
+    out.args.back().desc = "This parameter is used to specify the transformation that should be performed."
+                           " A single transformation can be specified for each invocation of this operation."
+                           " Currently translation, scaling, and rotation are available."
+                           " Translations have three configurable scalar parameters denoting the translation along"
+                           " x, y, and z in the DICOM coordinate system."
+                           " Translating $x=1.0$, $y=-2.0$, and $z=0.3$ can be specified as"
+                           " 'translate(1.0, -2.0, 0.3)'."
+                           " The scale transformation has four configurable scalar parameters denoting the scale"
+                           " centre 3-vector and the magnification factor. Note that the magnification factor can"
+                           " be negative, which will cause the image to be inverted along x, y, and z axes and"
+                           " magnified."
+                           " Magnifying by 2.7x about $(1.23, -2.34, 3.45)$ can be specified as"
+                           " 'scale(1.23, -2.34, 3.45, 2.7)'."
+                           " Rotations around an arbitrary axis line can be accomplished."
+                           " The rotation transformation has seven configurable scalar parameters denoting"
+                           " the rotation centre 3-vector, the rotation axis 3-vector, and the rotation angle"
+                           " in radians. A rotation of pi radians around the axis line parallel to vector"
+                           " $(1.0, 0.0, 0.0)$ that intersects the point $(4.0, 5.0, 6.0)$ can be specified"
+                           " as 'rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)'.";
+    out.args.back().default_val = "translate(0.0, 0.0, 0.0)";
+    out.args.back().expected = true;
+    out.args.back().examples = { "translate(1.0, -2.0, 0.3)",
+                                 "scale(1.23, -2.34, 3.45, 2.7)",
+                                 "rotate(4.0, 5.0, 6.0,  1.0, 0.0, 0.0,  3.141592653)" };
+
+    out.args.emplace_back();
+    out.args.back().name = "SamplingMethod";
+    out.args.back().desc = "The interpolation kernel to use when resampling voxel values."
+                           " 'Nearest' selects the nearest voxel and is appropriate for masks and labels."
+                           " 'Linear' performs trilinear interpolation."
+                           " 'Cubic' performs tricubic (Catmull-Rom) interpolation, which is smoother but can"
+                           " overshoot near sharp edges.";
+    out.args.back().default_val = "linear";
+    out.args.back().expected = true;
+    out.args.back().examples = { "nearest",
+                                 "linear",
+                                 "cubic" };
+
+    out.args.emplace_back();
+    out.args.back().name = "Channel";
+    out.args.back().desc = "The image channel to transform (zero-based)."
+                           " A negative value will result in all channels being transformed, otherwise"
+                           " unspecified channels are left unaltered.";
+    out.args.back().default_val = "-1";
+    out.args.back().expected = true;
+    out.args.back().examples = { "-1",
+                                 "0",
+                                 "1",
+                                 "2" };
+
+    out.args.emplace_back();
+    out.args.back().name = "FillValue";
+    out.args.back().desc = "The value assigned to voxels that sample beyond the extent of the original images.";
+    out.args.back().default_val = "nan";
+    out.args.back().expected = true;
+    out.args.back().examples = { "nan",
+                                 "0.0",
+                                 "-1024.0" };
+
+    return out;
+}
+
+
+
+Drover TransformImages(Drover DICOM_data,
+                       OperationArgPkg OptArgs,
+                       std::map<std::string,std::string> /*InvocationMetadata*/,
+                       std::string /*FilenameLex*/){
+
+    //---------------------------------------------- User Parameters --------------------------------------------------
+    const auto ImageSelectionStr = OptArgs.getValueStr("ImageSelection").value();
+    const auto TransformStr = OptArgs.getValueStr("Transform").value();
+    const auto SamplingMethodStr = OptArgs.getValueStr("SamplingMethod").value();
+    const auto Channel = std::stol( OptArgs.getValueStr("Channel").value() );
+    const auto FillValue = std::stof( OptArgs.getValueStr("FillValue").value() );
+
+    //-----------------------------------------------------------------------------------------------------------------
+    const auto regex_trn = Compile_Regex("^tr?a?n?s?l?a?t?e?.*$");
+    const auto regex_scl = Compile_Regex("^sc?a?l?e?.*$");
+    const auto regex_rot = Compile_Regex("^ro?t?a?t?.*$");
+
+    const auto regex_nearest = Compile_Regex("^ne?a?r?e?s?t?$");
+    const auto regex_linear = Compile_Regex("^li?n?e?a?r?$");
+    const auto regex_cubic = Compile_Regex("^cu?b?i?c?$");
+
+    const auto extract_function_parameters = [](const std::string &in) -> std::vector<double> {
+            // This rountine extracts numerical function parameters.
+            // Input should look like 'func(1.0, 2.0,3.0, -1.23, ...)'.
+            auto split = SplitStringToVector(in, '(', 'd');
+            split = SplitVector(split, ')', 'd');
+            split = SplitVector(split, ',', 'd');
+
+            std::vector<double> numbers;
+            for(const auto &w : split){
+               try{
+                   const auto x = std::stod(w);
+                   numbers.emplace_back(x);
+               }catch(const std::exception &){ }
+            }
+            return numbers;
+    };
+
+    grid_resampling::resample_opts rs_opts;
+    rs_opts.inplane = grid_resampling::extrapolation::Fill;
+    rs_opts.slices  = grid_resampling::extrapolation::Fill;
+    rs_opts.fill    = FillValue;
+    rs_opts.channel = Channel;
+
+    if(false){
+    }else if(std::regex_match(SamplingMethodStr, regex_nearest)){
+        rs_opts.method = grid_resampling::kernel::Nearest;
+    }else if(std::regex_match(SamplingMethodStr, regex_linear)){
+        rs_opts.method = grid_resampling::kernel::Linear;
+    }else if(std::regex_match(SamplingMethodStr, regex_cubic)){
+        rs_opts.method = grid_resampling::kernel::Cubic;
+    }else{
+        throw std::invalid_argument("Sampling method not understood. Cannot continue.");
+    }
+
+    // Voxel values are resampled, so the inverse transformation is needed to map from the outgoing image geometry
+    // back to the original images.
+    std::function<vec3<double>(const vec3<double> &)> inverse_map;
+
+    // Translations.
+    if(false){
+    }else if(std::regex_match(TransformStr, regex_trn)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 3){
+            throw std::invalid_argument("Unable to parse translation parameters. Cannot continue.");
+        }
+        const auto Tr = vec3<double>( numbers.at(0),
+                                      numbers.at(1),
+                                      numbers.at(2) );
+        if(!Tr.isfinite()) throw std::invalid_argument("Translation vector invalid. Cannot continue.");
+
+        inverse_map = [=](const vec3<double> &v) -> vec3<double> {
+            return (v - Tr);
+        };
+
+    // Scaling.
+    }else if(std::regex_match(TransformStr, regex_scl)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 4){
+            throw std::invalid_argument("Unable to parse scale parameters. Cannot continue.");
+        }
+        const auto centre = vec3<double>( numbers.at(0),
+                                          numbers.at(1),
+                                          numbers.at(2) );
+        const auto factor = numbers.at(3);
+        if(!centre.isfinite()) throw std::invalid_argument("Scale centre invalid. Cannot continue.");
+        if( !std::isfinite(factor)
+        ||  (factor == 0.0) ) throw std::invalid_argument("Scale factor invalid. Cannot continue.");
+
+        inverse_map = [=](const vec3<double> &v) -> vec3<double> {
+            return centre + ((v - centre) * (1.0 / factor));
+        };
+
+    // Rotations.
+    }else if(std::regex_match(TransformStr, regex_rot)){
+        auto numbers = extract_function_parameters(TransformStr);
+        if(numbers.size() != 7){
+            throw std::invalid_argument("Unable to parse rotation parameters. Cannot continue.");
+        }
+        const auto centre = vec3<double>( numbers.at(0),
+                                          numbers.at(1),
+                                          numbers.at(2) );
+        const auto axis = vec3<double>( numbers.at(3),
+                                        numbers.at(4),
+                                        numbers.at(5) ).unit();
+        const auto angle = numbers.at(6);
+
+        if(!centre.isfinite()) throw std::invalid_argument("Rotation centre invalid. Cannot continue.");
+        if(!axis.isfinite()) throw std::invalid_argument("Rotation axis invalid. Cannot continue.");
+        if(!std::isfinite(angle)) throw std::invalid_argument("Rotation angle invalid. Cannot continue.");
+
+        inverse_map = [=](const vec3<double> &v) -> vec3<double> {
+            return (v - centre).rotate_around_unit(axis, -angle) + centre;
+        };
+
+    }else{
+        throw std::invalid_argument("Transformation not understood. Cannot continue.");
+    }
+
+    auto IAs_all = All_IAs( DICOM_data );
+    auto IAs = Whitelist( IAs_all, ImageSelectionStr );
+    for(auto & iap_it : IAs){
+        if((*iap_it)->imagecoll.images.empty()) continue;
+
+        // The original images are retained as the source since the images are resampled in-place.
+        auto orig_imagecoll = (*iap_it)->imagecoll;
+        std::list<std::reference_wrapper<planar_image<float,double>>> orig_imgs;
+        for(auto &img : orig_imagecoll.images){
+            orig_imgs.push_back( std::ref(img) );
+        }
+        const auto grid = grid_resampling::Make_Rectilinear_Grid(orig_imgs);
+        if(!grid){
+            throw std::invalid_argument("Selected images do not form a rectilinear grid. Cannot continue.");
+        }
+
+        std::list<std::reference_wrapper<planar_image<float,double>>> edit_imgs;
+        for(auto &img : (*iap_it)->imagecoll.images){
+            edit_imgs.push_back( std::ref(img) );
+        }
+        if(!grid_resampling::Resample_Mapped(grid.value(), edit_imgs, inverse_map, rs_opts)){
+            throw std::invalid_argument("Selected channel is not present in all images. Cannot continue.");
+        }
+
+        for(auto &img_refw : edit_imgs){
+            UpdateImageDescription( img_refw, "Transformed" );
+            UpdateImageWindowCentreWidth( img_refw );
+        }
+    }
+
+    return DICOM_data;
+}
@@ -0,0 +1,17 @@
+// TransformImages.h.
+
+#pragma once
+
+#include <string>
+#include <map>
+
+#include "../Structs.h"
+
+
+OperationDoc OpArgDocTransformImages(void);
+
+Drover
+TransformImages(Drover DICOM_data, 
+                OperationArgPkg /*OptArgs*/,
+                std::map<std::string, std::string> /*InvocationMetadata*/,
+                std::string /*FilenameLex*/);
@@ -183,6 +183,9 @@ Drover TransformMeshes(Drover DICOM_data, OperationArgPkg OptArgs, std::map<std:
             throw std::invalid_argument("Transformation not understood. Cannot continue.");
         }
 
+        // Attributes remain attached to their vertices, but cached geometric quantities must be recomputed.
+        mesh_attributes::Refresh_Geometry_Caches((*smp_it)->meshes, (*smp_it)->vertex_attributes);
+
         ++completed;
         FUNCINFO("Completed " << completed << " of " << sm_count
               << " --> " << static_cast<int>(1000.0*(completed)/sm_count)/10.0 << "% done");
@@ -7,12 +7,14 @@
 #include <boost/algorithm/string/trim_all.hpp>
 #include <algorithm> //std::min_element/max_element, std::stable_sort.
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <cstdint>   //For int64_t.
 #include <optional>
 #include <functional>
 #include <initializer_list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
 #include <string>
@@ -154,7 +156,44 @@ Contour_Data::Contour_Data(const Contour_Data &in) : ccs(in.ccs) { }
 
 //Member functions.
 void Contour_Data::operator=(const Contour_Data &rhs){
-    if(this != &rhs) this->ccs = rhs.ccs;
+    if(this != &rhs){
+        this->ccs = rhs.ccs;
+        this->Mark_Modified();
+    }
+    return;
+}
+
+std::shared_ptr<const contour_index::index> Contour_Data::Get_Index(void) const {
+    std::vector<const contour_collection<double> *> cc_ptrs;
+    for(const auto &cc : this->ccs) cc_ptrs.push_back( &cc );
+
+    std::lock_guard<std::mutex> lock(this->spatial_index_mutex);
+
+    //Contours can be added or removed without marking them as modified, so also confirm the cached index still refers
+    // to the current contours. This is cheap compared with fingerprinting every vertex.
+    if( (this->spatial_index != nullptr)
+    &&  (this->spatial_index_generation == this->generation)
+    &&  this->spatial_index->matches(cc_ptrs) ){
+        //Vertices altered in-place are only detected via Mark_Modified(), so verify it was called in debug builds.
+        assert(this->spatial_index->is_current(cc_ptrs));
+        return this->spatial_index;
+    }
+
+    //Outstanding snapshots must not change, so refresh a copy if the current index has been handed out.
+    if(this->spatial_index == nullptr){
+        this->spatial_index = std::make_shared<contour_index::index>();
+    }else if(1 < this->spatial_index.use_count()){
+        this->spatial_index = std::make_shared<contour_index::index>( *(this->spatial_index) );
+    }
+
+    this->spatial_index->refresh(cc_ptrs);
+    this->spatial_index_generation = this->generation;
+    return this->spatial_index;
+}
+
+void Contour_Data::Mark_Modified(void){
+    std::lock_guard<std::mutex> lock(this->spatial_index_mutex);
+    ++(this->generation);
     return;
 }
 
@@ -1135,11 +1174,11 @@ Dynamic_Machine_State::normalize_states(void){
         if( !A->JawPositionsX.empty()
         &&   B->JawPositionsX.empty()) B->JawPositionsX = A->JawPositionsX;
 
-        if( A->JawPositionsY.empty() 
-        && !B->JawPositionsY.empty()) B->JawPositionsY = A->JawPositionsY;
+        if( !A->JawPositionsY.empty() 
+        &&   B->JawPositionsY.empty()) B->JawPositionsY = A->JawPositionsY;
 
-        if( A->MLCPositionsX.empty() 
-        && !B->MLCPositionsX.empty()) B->MLCPositionsX = A->MLCPositionsX;
+        if( !A->MLCPositionsX.empty() 
+        &&   B->MLCPositionsX.empty()) B->MLCPositionsX = A->MLCPositionsX;
     }
 
     return;
@@ -1328,12 +1367,26 @@ Surface_Mesh::Surface_Mesh(const Surface_Mesh &rhs){
     *this = rhs; //Performs a deep copy (unless copying self).
 }
 
+Surface_Mesh::Surface_Mesh(Surface_Mesh &&rhs) noexcept
+    : meshes(std::move(rhs.meshes)),
+      vertex_attributes(std::move(rhs.vertex_attributes)),
+      face_attributes(std::move(rhs.face_attributes)) { }
+
 Surface_Mesh & Surface_Mesh::operator=(const Surface_Mesh &rhs){
     //Performs a deep copy (unless copying self).
     if(this != &rhs){
         this->meshes            = rhs.meshes;
-        this->vertex_attributes = rhs.vertex_attributes;
-        this->face_attributes   = rhs.face_attributes;
+        this->vertex_attributes = rhs.vertex_attributes.clone();
+        this->face_attributes   = rhs.face_attributes.clone();
+    }
+    return *this;
+}
+
+Surface_Mesh & Surface_Mesh::operator=(Surface_Mesh &&rhs) noexcept {
+    if(this != &rhs){
+        this->meshes            = std::move(rhs.meshes);
+        this->vertex_attributes = std::move(rhs.vertex_attributes);
+        this->face_attributes   = std::move(rhs.face_attributes);
     }
     return *this;
 }
@@ -1396,6 +1449,10 @@ drover_bnded_dose_stat_moments_map_t drover_bnded_dose_stat_moments_map_factory(
     drover_bnded_dose_stat_moments_map_t out(/*25, */bnded_dose_map_cmp_lambda);
     return out;
 }
+drover_bnded_dose_stats_map_t drover_bnded_dose_stats_map_factory(void){
+    drover_bnded_dose_stats_map_t out(/*25, */bnded_dose_map_cmp_lambda);
+    return out;
+}
 
 
 
@@ -1422,6 +1479,85 @@ void Drover::operator=(const Drover &rhs){
     return;
 }
 
+//Invokes the callback for every voxel in the image that is bounded by the contour.
+//
+// The callback receives the row, column, and position of each bounded voxel. Contours with fewer than three vertices,
+// and contours that do not lie within the image's top and bottom planes, bound no voxels.
+template <class F>
+static void For_Each_Bounded_Voxel(const planar_image<float,double> &img,
+                                   const contour_of_points<double> &c,
+                                   F f){
+    if(c.points.size() < 3) return;
+
+    const auto filtering_avg_point = c.First_N_Point_Avg(3); //Average_Point(); //Just need a point at the correct height, somewhere inside contour.
+    if(!img.sandwiches_point_within_top_bottom_planes(filtering_avg_point)) return;
+
+    //Now we have a contour of points and pixel data (note: we can ignore the z components for both) 
+    // which may or may not lie within the contour. This is called the 'Point-in-polygon' problem and is
+    // a well-known problem. Unfortunately, it can be a costly problem to solve. We will bound the contour with
+    // a cartesian bounding box (in the XY plane) and poll each point. We can immediately ignore points outside the box.
+    // This will save a considerable amount of time for small contours within a large volume, and probably won't greatly
+    // slow the large contour/large volume case too much.
+    //
+    // We then examine line crossings. For a regular polygon, whether or not the number of line crossings (from the point
+    // to infinity (in this case - the edge of the box)) is even or odd will determine whether or not the point is within
+    // the contour. I *believe* there would be an issue if the contour would wrap around and touch exactly on some segment
+    // (like a "C" where the two sharp edges touch to form an "O".) ***BEWARE*** that this is most likely the case!
+    //
+    // See http://www.visibone.com/inpoly/ (Accessed Jan 2012,) 
+    //     http://paulbourke.net/geometry/insidepoly/ (January 2012,)
+    //     http://stackoverflow.com/questions/217578/point-in-polygon-aka-hit-test (January 2012).
+    //     NOTE: Some web servers/web applications used to have to implement this routine to deal with image maps. 
+    //           Check their sources for leads if looking/scrounging for code. I would like a fully 3D version!
+    //
+    //     |---------------------|
+    //     | /-----\  /--------\ |
+    //     | |     |__|        / |
+    //     |/                 /  |
+    //     ||   X            /   |
+    //     | \______________/    |
+    //     |---------------------|
+    //
+    const contour_of_points<double> BB(c.Bounding_Box_Along(vec3<double>(1.0,0.0,0.0)));
+    const float alrgnum(1E30);
+    float min_x = alrgnum, max_x = -alrgnum;
+    float min_y = alrgnum, max_y = -alrgnum;
+    for(const auto & point : BB.points){
+        if(point.x < min_x) min_x = point.x;
+        if(point.x > max_x) max_x = point.x;
+        if(point.y < min_y) min_y = point.y;
+        if(point.y > max_y) max_y = point.y;
+    }
+    if((min_x == alrgnum) || (min_y == alrgnum) || (max_x == -alrgnum) || (max_y == -alrgnum)){
+        FUNCERR("Unable to find a reasonable bounding box around this contour");
+    }
+
+    //Now cycle through every pixel in the plane. This is kind of a shit way to do this, but then again this entire program is basically
+    // a shit way to do it. I would like to have had more time to properly fix/plan/think about what I've got here...  -h
+    for(long int i=0; i<img.rows; ++i)  for(long int j=0; j<img.columns; ++j){
+        const auto pos = img.position(i,j);
+        const float X = pos.x, Y = pos.y;
+
+        //Check if it is outside the bounding box.
+        if(!isininc(min_x,X,max_x) || !isininc(min_y,Y,max_y)) continue;
+
+        bool is_in_the_polygon = false;
+        auto p_j = std::prev(c.points.end());
+        for(auto p_i = c.points.begin(); p_i != c.points.end(); p_j = (p_i++)){
+            //If the points cross a line, we simply toggle the 'bool is_in_the_polygon.'
+            if( ((p_i->y <= Y) && (Y < p_j->y)) || ((p_j->y <= Y) && (Y < p_i->y)) ){ 
+                const auto B = (p_j->x - p_i->x)*(Y - p_i->y)/(p_j->y - p_i->y);
+                if(X < (B + p_i->x)){
+                    is_in_the_polygon = !is_in_the_polygon;
+                }
+            }
+        }
+
+        if(is_in_the_polygon) f(i, j, pos);
+    }
+    return;
+}
+
 void Drover::Bounded_Dose_General( std::list<double> *pixel_doses, 
                                    drover_bnded_dose_bulk_doses_map_t *bulk_doses, //NOTE: similar to pixel_doses but not all grouped together...
                                    drover_bnded_dose_mean_dose_map_t *mean_doses, 
@@ -1528,119 +1664,49 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
             for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
 
                 for(auto c_it = cc_it->contours.begin(); c_it != cc_it->contours.end(); ++c_it){
-                    if(c_it->points.size() < 3) continue;
-
-                    const auto filtering_avg_point = c_it->First_N_Point_Avg(3); //Average_Point(); //Just need a point at the correct height, somewhere inside contour.
-                    if(!i_it->sandwiches_point_within_top_bottom_planes(filtering_avg_point)) continue;
- 
-                    //Now we have a contour of points and pixel data (note: we can ignore the z components for both) 
-                    // which may or may not lie within the contour. This is called the 'Point-in-polygon' problem and is
-                    // a well-known problem. Unfortunately, it can be a costly problem to solve. We will bound the contour with
-                    // a cartesian bounding box (in the XY plane) and poll each point. We can immediately ignore points outside the box.
-                    // This will save a considerable amount of time for small contours within a large volume, and probably won't greatly
-                    // slow the large contour/large volume case too much.
-                    //
-                    // We then examine line crossings. For a regular polygon, whether or not the number of line crossings (from the point
-                    // to infinity (in this case - the edge of the box)) is even or odd will determine whether or not the point is within
-                    // the contour. I *believe* there would be an issue if the contour would wrap around and touch exactly on some segment
-                    // (like a "C" where the two sharp edges touch to form an "O".) ***BEWARE*** that this is most likely the case!
-                    //
-                    // See http://www.visibone.com/inpoly/ (Accessed Jan 2012,) 
-                    //     http://paulbourke.net/geometry/insidepoly/ (January 2012,)
-                    //     http://stackoverflow.com/questions/217578/point-in-polygon-aka-hit-test (January 2012).
-                    //     NOTE: Some web servers/web applications used to have to implement this routine to deal with image maps. 
-                    //           Check their sources for leads if looking/scrounging for code. I would like a fully 3D version!
-                    //
-                    //     |---------------------|
-                    //     | /-----\  /--------\ |
-                    //     | |     |__|        / |
-                    //     |/                 /  |
-                    //     ||   X            /   |
-                    //     | \______________/    |
-                    //     |---------------------|
-                    //
-                    const contour_of_points<double> BB(c_it->Bounding_Box_Along(vec3<double>(1.0,0.0,0.0)));
-                    const float alrgnum(1E30);
-                    float min_x = alrgnum, max_x = -alrgnum;
-                    float min_y = alrgnum, max_y = -alrgnum;
-                    for(const auto & point : BB.points){
-                        if(point.x < min_x) min_x = point.x;
-                        if(point.x > max_x) max_x = point.x;
-                        if(point.y < min_y) min_y = point.y;
-                        if(point.y > max_y) max_y = point.y;
-                    }
-                    if((min_x == alrgnum) || (min_y == alrgnum) || (max_x == -alrgnum) || (max_y == -alrgnum)){
-                        FUNCERR("Unable to find a reasonable bounding box around this contour");
-                    }
-    
-                    //Now cycle through every pixel in the plane. This is kind of a shit way to do this, but then again this entire program is basically
-                    // a shit way to do it. I would like to have had more time to properly fix/plan/think about what I've got here...  -h
-                    for(long int i=0; i<i_it->rows; ++i)  for(long int j=0; j<i_it->columns; ++j){
-                        const auto pos = i_it->position(i,j);
-                        const float X = pos.x, Y = pos.y;
-    
-                        //Check if it is outside the bounding box.
-                        if(!isininc(min_x,X,max_x) || !isininc(min_y,Y,max_y)) continue;
-    
-                        bool is_in_the_polygon = false;
-                        auto p_j = --(c_it->points.end());
-                        for(auto p_i = c_it->points.begin(); p_i != c_it->points.end(); p_j = (p_i++)){
-                            //If the points cross a line, we simply toggle the 'bool is_in_the_polygon.'
-                            if( ((p_i->y <= Y) && (Y < p_j->y)) || ((p_j->y <= Y) && (Y < p_i->y)) ){ 
-                                const auto B = (p_j->x - p_i->x)*(Y - p_i->y)/(p_j->y - p_i->y);
-                                if(X < (B + p_i->x)){
-                                    is_in_the_polygon = !is_in_the_polygon;
-                                }
-                            }
+                    For_Each_Bounded_Voxel(*i_it, *c_it, [&](long int i, long int j, const vec3<double> &pos) -> void {
+                        //-----------------------------------------------------------------------------------------------------------------------
+                        //NOTE: Remember: this is some integer representing dose. If we want a clamped [0:1] 
+                        // value, we would use the clamped_channel(...) member instead!
+                        const auto pointval = static_cast<int64_t>(i_it->value(i,j,0)); //Greyscale or R channel. We assume the channels satisfy: R = G = B.
+                        const auto pointdose = static_cast<double>(pointval); 
+
+                        if(mean_doses != nullptr){
+                            accumulated_dose[cc_it].first  += pointval;
+                            accumulated_dose[cc_it].second += 1;
+                        }
+                        if(bulk_doses != nullptr){
+                            (*bulk_doses)[cc_it].push_back(pointdose);
                         }
 
-                        if(is_in_the_polygon){
-                            //-----------------------------------------------------------------------------------------------------------------------
-                            //FUNCINFO("Bounding box (x,y)min (x,y)max = (" << min_x << "," << min_y << ") (" << max_x << "," << max_y << ")");
-                            //FUNCINFO("Point has (X,Y) = " << X << " " << Y);
-
-                            //NOTE: Remember: this is some integer representing dose. If we want a clamped [0:1] 
-                            // value, we would use the clamped_channel(...) member instead!
-                            const auto pointval = static_cast<int64_t>(i_it->value(i,j,0)); //Greyscale or R channel. We assume the channels satisfy: R = G = B.
-                            const auto pointdose = static_cast<double>(pointval); 
-
-                            if(mean_doses != nullptr){
-                                accumulated_dose[cc_it].first  += pointval;
-                                accumulated_dose[cc_it].second += 1;
-                            }
-                            if(bulk_doses != nullptr){
-                                (*bulk_doses)[cc_it].push_back(pointdose);
-                            }
-
-                            if(pixel_doses != nullptr){
-                                pixel_doses->push_back(pointdose); 
-                            }
+                        if(pixel_doses != nullptr){
+                            pixel_doses->push_back(pointdose); 
+                        }
 
-                            if(min_max_doses != nullptr){
-                                if(pointdose < (*min_max_doses)[cc_it].first)  (*min_max_doses)[cc_it].first  = pointdose; //min.
-                                if(pointdose > (*min_max_doses)[cc_it].second) (*min_max_doses)[cc_it].second = pointdose; //max.
-                            }
+                        if(min_max_doses != nullptr){
+                            if(pointdose < (*min_max_doses)[cc_it].first)  (*min_max_doses)[cc_it].first  = pointdose; //min.
+                            if(pointdose > (*min_max_doses)[cc_it].second) (*min_max_doses)[cc_it].second = pointdose; //max.
+                        }
 
-                            if(pos_doses != nullptr){
-                                const vec3<double> r_dx = i_it->row_unit*i_it->pxl_dx*0.5;
-                                const vec3<double> r_dy = i_it->col_unit*i_it->pxl_dy*0.5;
-                                const auto tup = std::make_tuple(pos, r_dx, r_dy, pointdose, i, j);
+                        if(pos_doses != nullptr){
+                            const vec3<double> r_dx = i_it->row_unit*i_it->pxl_dx*0.5;
+                            const vec3<double> r_dy = i_it->col_unit*i_it->pxl_dy*0.5;
+                            const auto tup = std::make_tuple(pos, r_dx, r_dy, pointdose, i, j);
 
-                                if(Fselection(tup)) (*pos_doses)[cc_it].push_back(std::move(tup));
-                            }
-                            if(cent_moms != nullptr){ //Centralized moments. This routine requires a centroid for each cc.
-                                const auto cc_centroid = cc_centroids[cc_it];
-                                for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
-                                    //const std::array<int,3> triplet = {p,q,r};
-                                    const auto spatial = pow(pos.x-cc_centroid.x,p)*pow(pos.y-cc_centroid.y,q)*pow(pos.z-cc_centroid.z,r);
-                                    const auto grid_factor = i_it->pxl_dx * i_it->pxl_dy * i_it->pxl_dz;
-                                    (*cent_moms)[cc_it][{p,q,r}] += spatial*pointdose*grid_factor;
-                                }
+                            if(Fselection(tup)) (*pos_doses)[cc_it].push_back(std::move(tup));
+                        }
+                        if(cent_moms != nullptr){ //Centralized moments. This routine requires a centroid for each cc.
+                            const auto cc_centroid = cc_centroids[cc_it];
+                            for(int p = 0; p < 5; ++p) for(int q = 0; q < 5; ++q) for(int r = 0; r < 5; ++r){
+                                //const std::array<int,3> triplet = {p,q,r};
+                                const auto spatial = pow(pos.x-cc_centroid.x,p)*pow(pos.y-cc_centroid.y,q)*pow(pos.z-cc_centroid.z,r);
+                                const auto grid_factor = i_it->pxl_dx * i_it->pxl_dy * i_it->pxl_dz;
+                                (*cent_moms)[cc_it][{p,q,r}] += spatial*pointdose*grid_factor;
                             }
-
-                            //-----------------------------------------------------------------------------------------------------------------------
                         }
-                    }
+
+                        //-----------------------------------------------------------------------------------------------------------------------
+                    });
                 }
             }
         }
@@ -1686,6 +1752,51 @@ void Drover::Bounded_Dose_General( std::list<double> *pixel_doses,
     return;
 }
 
+drover_bnded_dose_stats_map_t Drover::Bounded_Dose_Statistics(const voxel_statistics &prototype) const {
+    //This routine computes summary statistics (moments, extrema, quantiles, and any additive per-voxel terms configured
+    // in the prototype) for the voxels bounded by each contour collection. Voxels are selected exactly as in
+    // Drover::Bounded_Dose_General(), but only a fixed amount of storage is used for each contour collection, regardless
+    // of the number of voxels.
+    //
+    //NOTE: Quantiles (including the median) are derived from the voxel_statistics histogram, so they are only accurate
+    //      to within one bin. Use Drover::Bounded_Dose_Min_Mean_Median_Max() if an exact median is needed.
+    //
+    //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
+    //
+    //NOTE: Multiple dose arrays are melded prior to computation.
+    auto d = Isolate_Dose_Data(*this);
+    if(!d.Has_Contour_Data() || !d.Has_Image_Data()){
+        FUNCERR("Attempted to use bounded dose routine, but we do not have contours and/or dose");
+    }
+
+    std::list<std::shared_ptr<Image_Array>> dose_data_to_use(d.image_data);
+    if(d.image_data.size() > 1){
+        dose_data_to_use = Meld_Image_Data(d.image_data);
+        if(dose_data_to_use.size() != 1){
+            FUNCERR("This routine cannot handle multiple dose data which cannot be melded. This has " << dose_data_to_use.size());
+        }
+    }
+
+    auto outgoing = drover_bnded_dose_stats_map_factory();
+    for(auto cc_it = this->contour_data->ccs.begin(); cc_it != this->contour_data->ccs.end(); ++cc_it){
+        auto &stats = outgoing.emplace(cc_it, prototype).first->second;
+
+        for(auto & dd_it : dose_data_to_use){
+            for(const auto &img : dd_it->imagecoll.images){
+                for(const auto &c : cc_it->contours){
+                    For_Each_Bounded_Voxel(img, c, [&](long int i, long int j, const vec3<double> &) -> void {
+                        //NOTE: Doses are truncated to integers, matching Drover::Bounded_Dose_General().
+                        const auto val = img.value(i,j,0);
+                        if(!std::isfinite(val)) return;
+                        stats.digest( static_cast<double>(static_cast<int64_t>(val)) );
+                    });
+                }
+            }
+        }
+    }
+    return outgoing;
+}
+
 std::list<double> Drover::Bounded_Dose_Bulk_Values(void) const {
     std::list<double> outgoing;
     this->Bounded_Dose_General(&outgoing,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr);
@@ -1708,35 +1819,42 @@ drover_bnded_dose_min_max_dose_map_t Drover::Bounded_Dose_Min_Max(void) const {
     //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
     //
     //NOTE: The map returns a pair. The first is min, the second is max.
+    //
+    //NOTE: As in Drover::Bounded_Dose_General(), contour collections that do not bound any voxels are reported with the
+    //      impossible pair (1E99, -1E99).
     auto outgoing = drover_bnded_dose_min_max_dose_map_factory();
-    this->Bounded_Dose_General(nullptr,nullptr,nullptr,&outgoing,nullptr,nullptr,nullptr);
+    for(const auto & it : this->Bounded_Dose_Statistics()){
+        if(it.second.count == 0){
+            FUNCWARN("No voxels were found within a contour collection. Unable to determine min/max doses");
+            outgoing[it.first] = std::make_pair(1E99, -1E99);
+        }else{
+            outgoing[it.first] = std::make_pair(it.second.min, it.second.max);
+        }
+    }
     return outgoing;
 }
 
 drover_bnded_dose_min_mean_max_dose_map_t Drover::Bounded_Dose_Min_Mean_Max(void) const {
     //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
+    //
+    //NOTE: Contour collections that do not bound any voxels are reported as having zero dose.
     auto outgoing = drover_bnded_dose_min_mean_max_dose_map_factory();
-
-    auto means   = drover_bnded_dose_mean_dose_map_factory();
-    auto minmaxs = drover_bnded_dose_min_max_dose_map_factory();
-    this->Bounded_Dose_General(nullptr,nullptr,&means,&minmaxs,nullptr,nullptr,nullptr);
-
-    if(means.size() != minmaxs.size()){
-        FUNCERR("Number of means did not match number of min/maxs. Must have encountered a computational error");
-    }
-
-    for(auto & it : means){
-        const auto theiter = it.first;
-        const auto min    = minmaxs[theiter].first;
-        const auto mean   = it.second;
-        const auto max    = minmaxs[theiter].second;
-        outgoing[theiter] = std::make_tuple(min, mean, max); 
+    for(const auto & it : this->Bounded_Dose_Statistics()){
+        if(it.second.count == 0){
+            outgoing[it.first] = std::make_tuple(0.0, 0.0, 0.0);
+        }else{
+            outgoing[it.first] = std::make_tuple(it.second.min, it.second.get_mean(), it.second.max);
+        }
     }
     return outgoing;
 }
 
 drover_bnded_dose_min_mean_median_max_dose_map_t Drover::Bounded_Dose_Min_Mean_Median_Max(void) const {
     //NOTE: See note in Drover::Bounded_Dose_Means() regarding invalidation of this map.
+    //
+    //NOTE: The median is exact, so every bounded voxel dose is retained and memory grows with the number of voxels.
+    //      Drover::Bounded_Dose_Statistics() uses a fixed amount of memory and provides a median accurate to within one
+    //      histogram bin.
     auto outgoing = drover_bnded_dose_min_mean_median_max_dose_map_factory();
 
     auto means   = drover_bnded_dose_mean_dose_map_factory();
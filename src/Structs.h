@@ -14,6 +14,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
@@ -27,6 +28,10 @@
 #include "YgorMath.h"
 #include "YgorPlot.h"
 
+#include "Contour_Index.h"
+#include "Mesh_Attributes.h"
+#include "Voxel_Statistics.h"
+
 class Image_Array;
 
 //This is a wrapper around the YgorMath.h class "contour_of_points." It holds an instance of a contour_of_points, but also provides some meta information
@@ -164,6 +169,27 @@ std::unique_ptr<Contour_Data> Split_Per_Volume_Along_Transverse_Plane(void) cons
 //        std::unique_ptr<Contour_Data> Get_Contours_With_Names(set of std::string &in) const;
 //        std::unique_ptr<Contour_Data> Get_Contours_On_Side_..... ?
 
+        //--- Spatial queries. ---
+        //Returns a snapshot of a spatial index over all contours. The index is refreshed when the contours have been
+        // marked as modified, or when contours have been added or removed, since the previous access. Only contours
+        // that were added or altered are re-indexed.
+        //
+        // Snapshots are never altered, but they hold pointers into ccs. A snapshot must therefore be discarded as soon
+        // as ccs is altered in any way (e.g., contours erased or spliced, or vertices moved) and a new one fetched.
+        // Use contour_index::index::matches() to check a snapshot that may have been invalidated.
+        std::shared_ptr<const contour_index::index> Get_Index(void) const;
+
+        //Signals that the contours have been altered. Because vertices can be altered in-place, which Get_Index() cannot
+        // cheaply detect, this must be called after doing so and before the index is next accessed. Debug builds
+        // assert that it was. The operation dispatcher calls it after every operation.
+        void Mark_Modified(void);
+
+    private:
+        //The index is a cache, so it is neither copied nor serialized.
+        uint64_t generation = 0;
+        mutable uint64_t spatial_index_generation = 0;
+        mutable std::shared_ptr<contour_index::index> spatial_index;
+        mutable std::mutex spatial_index_mutex;
 };
 
 
@@ -204,17 +230,18 @@ class Surface_Mesh {
 
         fv_surface_mesh<double, uint64_t> meshes;
 
-        // Used for defining attributes at run-time.
-        // The std::any can be replaced by something like std::map<size_t, double> but doesn't have to.
-        std::map< std::string, std::any > vertex_attributes; 
-        std::map< std::string, std::any > face_attributes; 
+        // Used for defining attributes at run-time. Columns are indexed the same as meshes.vertices and meshes.faces.
+        mesh_attributes::attribute_store vertex_attributes;
+        mesh_attributes::attribute_store face_attributes;
 
         //Constructor/Destructors.
         Surface_Mesh();
         Surface_Mesh(const Surface_Mesh &rhs); //Performs a deep copy (unless copying self).
+        Surface_Mesh(Surface_Mesh &&rhs) noexcept;
 
         //Member functions.
         Surface_Mesh & operator=(const Surface_Mesh &rhs); //Performs a deep copy (unless copying self).
+        Surface_Mesh & operator=(Surface_Mesh &&rhs) noexcept;
 };
 
 
@@ -418,6 +445,7 @@ typedef std::map<bnded_dose_map_key_t,std::tuple<double,double,double,double>,
 typedef std::tuple<vec3<double>,vec3<double>,vec3<double>,double,long int,long int> bnded_dose_pos_dose_tup_t;
 typedef std::map<bnded_dose_map_key_t,std::list<bnded_dose_pos_dose_tup_t>,         bnded_dose_map_cmp_func_t>  drover_bnded_dose_pos_dose_map_t; 
 typedef std::map<bnded_dose_map_key_t,std::map<std::array<int,3>,double>,           bnded_dose_map_cmp_func_t>  drover_bnded_dose_stat_moments_map_t;
+typedef std::map<bnded_dose_map_key_t,voxel_statistics,                                bnded_dose_map_cmp_func_t>  drover_bnded_dose_stats_map_t;
 
 drover_bnded_dose_mean_dose_map_t                drover_bnded_dose_mean_dose_map_factory(void);
 drover_bnded_dose_centroid_map_t                 drover_bnded_dose_centroid_map_factory(void);
@@ -428,6 +456,7 @@ drover_bnded_dose_min_mean_max_dose_map_t        drover_bnded_dose_min_mean_max_
 drover_bnded_dose_min_mean_median_max_dose_map_t drover_bnded_dose_min_mean_median_max_dose_map_factory(void);
 drover_bnded_dose_pos_dose_map_t                 drover_bnded_dose_pos_dose_map_factory(void);
 drover_bnded_dose_stat_moments_map_t             drover_bnded_dose_stat_moments_map_factory(void);
+drover_bnded_dose_stats_map_t                    drover_bnded_dose_stats_map_factory(void);
 
 class Drover {
     public:
@@ -458,6 +487,7 @@ class Drover {
         drover_bnded_dose_min_max_dose_map_t Bounded_Dose_Min_Max(void) const;  //Get the min & max dose for each contour collection. See note in source.
         drover_bnded_dose_min_mean_max_dose_map_t Bounded_Dose_Min_Mean_Max(void) const;  // " " " " ...
         drover_bnded_dose_min_mean_median_max_dose_map_t Bounded_Dose_Min_Mean_Median_Max(void) const; // " " " " ...
+        drover_bnded_dose_stats_map_t Bounded_Dose_Statistics(const voxel_statistics &prototype = voxel_statistics()) const; //Single pass; see note in source.
         drover_bnded_dose_stat_moments_map_t Bounded_Dose_Centralized_Moments(void) const;
         drover_bnded_dose_stat_moments_map_t Bounded_Dose_Normalized_Cent_Moments(void) const;
     
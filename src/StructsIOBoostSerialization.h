@@ -86,9 +86,8 @@ template<typename Archive>
 void serialize(Archive &a, Surface_Mesh &p, const unsigned int version){
     if(false){
     }else if(version == 0){
-        // Note: No dynamic surface_mesh attributes are saved in version 0 due to use of std::any.
-        //       Until a suitable reflection mechanism is located, we are stuck ignoring members
-        //       that make use of std::any.
+        // Note: No dynamic surface_mesh attributes are saved in version 0. They can be exported alongside the mesh
+        //       using the PLY format instead.
         a & boost::serialization::make_nvp("meshes",p.meshes);
     }else{
         FUNCWARN("Surface_Mesh archives with version " << version << " are not recognized");
@@ -16,6 +16,8 @@
 #include <mutex>
 #include <limits>
 #include <cmath>
+#include <numeric>
+#include <cstdint>
 
 #include <getopt.h>           //Needed for 'getopts' argument parsing.
 #include <cstdlib>            //Needed for exit() calls.
@@ -123,6 +125,7 @@
 #include "Explicator.h"       //Needed for Explicator class.
 
 #include "Structs.h"
+#include "Thread_Pool.h"
 
 #include "YgorImages_Functors/Grouping/Misc_Functors.h"
 #include "YgorImages_Functors/Processing/Partitioned_Image_Voxel_Visitor_Mutator.h"
@@ -612,10 +615,6 @@ Marching_Cubes_Implementation(
 
     const auto GridZ = grid_imgs.front().get().image_plane().N_0;
 
-    const vec3<double> zero3( static_cast<double>(0),
-                              static_cast<double>(0),
-                              static_cast<double>(0) );
-
     planar_image_adjacency<float,double> img_adj( grid_imgs, {}, GridZ );
 
     // ============================================== Marching Cubes ================================================
@@ -921,238 +920,265 @@ Marching_Cubes_Implementation(
            { -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1, -1, -1,   -1 }
     } };
 
-    // Convert an edge index to the corner vertex indices for a cube.
-    const std::array< std::array<int32_t, 2>, 12> a2iEdgeConnection { {
-        {0, 1}, {1, 2}, {2, 3}, {3, 0},  // Bottom face.
-        {4, 5}, {5, 6}, {6, 7}, {7, 4},  // Top face.
-        {0, 4}, {1, 5}, {2, 6}, {3, 7}   // Side faces.
+    // Corner lattice offsets (row, column, image) for each cube corner.
+    const std::array< std::array<int32_t, 3>, 8> a2iCornerOffset { {
+        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+        {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
     } };
 
-    // Storage used for the final mesh triangle vertices and faces.
-    std::vector<Kernel::Point_3> mesh_triangle_verts;
-    std::vector< std::array<size_t, 3> > mesh_triangle_faces;
-
-    std::mutex saver_printer; // Thread synchro lock for saving shared data, logging, and counter iterating.
-    long int completed = 0;
-    const long int img_count = grid_imgs.size();
+    // Each cube edge expressed as a canonical lattice edge: the tail lattice point offset (row, column, image) and the
+    // axis (0 = row, 1 = column, 2 = image) along which it extends. Canonical edges always point in the positive
+    // direction, so the same edge is identified (and interpolated) identically by every cube that shares it.
+    const std::array< std::array<int32_t, 4>, 12> a2iLatticeEdge { {
+        {0, 0, 0, 0}, {1, 0, 0, 1}, {0, 1, 0, 0}, {0, 0, 0, 1},  // Bottom face.
+        {0, 0, 1, 0}, {1, 0, 1, 1}, {0, 1, 1, 0}, {0, 0, 1, 1},  // Top face.
+        {0, 0, 0, 2}, {1, 0, 0, 2}, {1, 1, 0, 2}, {0, 1, 0, 2}   // Side faces.
+    } };
 
-    // Iterate over all voxels, traversing the images in order of adjacency for consistency.
-    //
-    // NOTE: The order of traversal must reflect image adjacency. This requirement could be relaxed if candidate
-    //       vertices (below) were indexed, but even this would involve extra memory usage for little gain.
+    // The images, in order of adjacency. Lattice plane k coincides with the voxel centres of image k.
+    std::vector<std::reference_wrapper<planar_image<float,double>>> imgs;
     for(const auto &img_ptr : img_adj.int_to_img){
-        const auto img_refw = std::ref( *img_ptr );
+        imgs.emplace_back( std::ref( *img_ptr ) );
+    }
+    const auto N_imgs = static_cast<long int>(imgs.size());
+    const auto N_rows = imgs.front().get().rows;
+    const auto N_cols = imgs.front().get().columns;
+
+    // Lattice point positions are computed from the plane origin and in-plane unit vectors. The plane beyond the last
+    // image is extrapolated using the last image's thickness, which is where cubes abutting the last image terminate.
+    std::vector<vec3<double>> plane_origin;
+    std::vector<vec3<double>> plane_row_step;
+    std::vector<vec3<double>> plane_col_step;
+    for(long int k = 0; k < N_imgs; ++k){
+        const auto &img = imgs[k].get();
+        plane_origin.emplace_back( img.position(0, 0) );
+        plane_row_step.emplace_back( img.row_unit.unit() * img.pxl_dx );
+        plane_col_step.emplace_back( img.col_unit.unit() * img.pxl_dy );
+    }
+    {
+        const auto &img = imgs.back().get();
+        const auto img_unit = img.row_unit.Cross(img.col_unit).unit();
+        plane_origin.emplace_back( plane_origin.back() + img_unit * img.pxl_dz );
+        plane_row_step.emplace_back( plane_row_step.back() );
+        plane_col_step.emplace_back( plane_col_step.back() );
+    }
 
-        const auto pxl_dx = img_refw.get().pxl_dx;
-        const auto pxl_dy = img_refw.get().pxl_dy;
-        const auto pxl_dz = img_refw.get().pxl_dz;
+    const auto lattice_value = [&](long int row, long int col, long int k) -> double {
+        if( (N_rows <= row) || (N_cols <= col) || (N_imgs <= k) ) return ExteriorVal;
+        return imgs[k].get().value(row, col, 0);
+    };
+    const auto lattice_position = [&](long int row, long int col, long int k) -> vec3<double> {
+        return plane_origin[k] + plane_row_step[k] * static_cast<double>(row)
+                               + plane_col_step[k] * static_cast<double>(col);
+    };
 
-        const auto row_unit = img_refw.get().row_unit.unit();
-        const auto col_unit = img_refw.get().col_unit.unit();
-        const auto img_unit = row_unit.Cross(col_unit).unit();
+    // Mesh vertices are keyed by the lattice edge they lie on, so vertices shared by adjacent cubes are welded exactly
+    // without any spatial tolerance. Vertices that coincide with a lattice point (i.e., where a voxel value equals the
+    // threshold exactly) are keyed by the lattice point instead so that all edges meeting there share a single vertex.
+    //
+    // Keys encode (plane, row, column, slot) where slots 0-2 denote the edge axis and slot 3 denotes the point.
+    const auto N_keys_per_plane = static_cast<uint64_t>(N_rows + 1) * static_cast<uint64_t>(N_cols + 1) * 4UL;
+    const auto lattice_key = [&](long int row, long int col, long int k, int32_t slot) -> uint64_t {
+        return ( ( static_cast<uint64_t>(k) * static_cast<uint64_t>(N_rows + 1) + static_cast<uint64_t>(row) )
+                   * static_cast<uint64_t>(N_cols + 1) + static_cast<uint64_t>(col) ) * 4UL + static_cast<uint64_t>(slot);
+    };
 
-        // Tolerance for deciding if meshed vertices are identical. If too lax, then topological inconsistencies may
-        // result; if too tight, then the mesh will either be non-watertight, non-manifold, or will be constructed in an
-        // invalid way by the mesher.
-        //
-        // The following tolerance was estimated with a Gaussian-smoothed spherical phantom.
-        // If these tolerances are increased, meshing will 'wobble' around the boundary and possibly create zero-area
-        // needles and surface crossovers. However, merely setting the tolerance to zero will likely cause meshing to
-        // fail outright.
-        constexpr auto machine_eps = std::numeric_limits<double>::epsilon();
-        const auto dvec3_tol = std::max(
-                                   std::min( { pxl_dx, pxl_dy, pxl_dz } ) * 1E-4,
-                                   std::sqrt(machine_eps) * 100.0 ); // Guard against pxl_dz = 0.
-
-        // List of Marching Cube voxel corner positions relative to image voxel centre.
-        //
-        // Note that the Marching cube and image voxels are not the same. They are offset such that
-        // the corner of the Marching Cube voxel is at the centre of the image voxel. This is done
-        // to avoid surface discontinuties that would arise from sampling the boundary of border
-        // voxels; numerical instability could potentially lead to random fluctuation by 1 voxel width on
-        // straight borders.
-        const std::array< vec3<double>, 8> a2fVertexOffset { {
-            (zero3),
-            (zero3 + row_unit * pxl_dx),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy),
-            (zero3 + col_unit * pxl_dy),
-
-            (zero3 + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + img_unit * pxl_dz),
-            (zero3 + row_unit * pxl_dx + col_unit * pxl_dy + img_unit * pxl_dz),
-            (zero3 + col_unit * pxl_dy + img_unit * pxl_dz)
-        } };
-
-        // The vector needed to translate from tail to head for each edge.
-        const std::array< vec3<double>, 12> a2fEdgeDirection { {
-            row_unit * pxl_dx, // Bottom face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            row_unit * pxl_dx, // Top face.
-            col_unit * pxl_dy,
-            row_unit * -pxl_dx,
-            col_unit * -pxl_dy,
-
-            img_unit * pxl_dz, // Side faces.
-            img_unit * pxl_dz,
-            img_unit * pxl_dz,
-            img_unit * pxl_dz
-        } };
-
-
-        const auto img_num = img_adj.image_to_index( img_refw );
-        const auto img_num_p1 = img_num + 1;
-        const auto img_is_adj = img_adj.index_present(img_num_p1);
-        const auto img_p1 = (img_is_adj) ? img_adj.index_to_image(img_num_p1) : img_refw;
-
-        const auto N_rows = img_refw.get().rows;
-        const auto N_cols = img_refw.get().columns;
-        for(long int row = 0; row < N_rows; ++row){
-            for(long int col = 0; col < N_cols; ++col){
-                const auto pos = img_refw.get().position(row, col);
-
-                // Sample voxel corner values.
-                std::array<double, 8> afCubeValue;
-                //
-                // Option A: Interpolate. This way is slow but extremely flexible.
-                //for(int32_t corner = 0; corner < 8; ++corner){
-                //    afCubeValue[corner] = surface_oracle(pos + a2fVertexOffset[corner]);
-                //}
-                //
-                // Option B: Align Marching Cube voxel corners with image voxel centres. This way is fast.
-                {
-                    const auto row_p1 = (row+1);
-                    const auto row_is_adj = (row_p1 < N_rows);
-
-                    const auto col_p1 = (col+1);
-                    const auto col_is_adj = (col_p1 < N_cols);
-
-                    afCubeValue[0] = img_refw.get().value(row, col, 0);
-                    afCubeValue[1] = (row_is_adj)                             ? img_refw.get().value(row_p1, col, 0)    : ExteriorVal;
-                    afCubeValue[2] = (row_is_adj && col_is_adj)               ? img_refw.get().value(row_p1, col_p1, 0) : ExteriorVal;
-                    afCubeValue[3] = (col_is_adj)                             ? img_refw.get().value(row, col_p1, 0)    : ExteriorVal;
-                    afCubeValue[4] = (img_is_adj)                             ? img_p1.get().value(row, col, 0)         : ExteriorVal;
-                    afCubeValue[5] = (row_is_adj && img_is_adj)               ? img_p1.get().value(row_p1, col, 0)      : ExteriorVal;
-                    afCubeValue[6] = (row_is_adj && col_is_adj && img_is_adj) ? img_p1.get().value(row_p1, col_p1, 0)   : ExteriorVal;
-                    afCubeValue[7] = (col_is_adj && img_is_adj)               ? img_p1.get().value(row, col_p1, 0)      : ExteriorVal;
-                }
+    // Each slab comprises the cubes spanning image k and image k+1. Slabs are processed independently, so the only
+    // vertices that two slabs can share are those on their common lattice plane.
+    struct mc_slab {
+        std::unordered_map<uint64_t, uint32_t> key_to_local;
+        std::vector<uint64_t> keys;
+        std::vector<vec3<double>> verts;
+        std::vector< std::array<uint32_t, 3> > tris;
+
+        std::vector<uint8_t> owned;   // Whether this slab is responsible for emitting each vertex.
+        std::vector<size_t> global;   // The final vertex index of each vertex.
+        size_t N_owned = 0;
+        size_t offset = 0;
+    };
+    std::vector<mc_slab> slabs(N_imgs);
 
-                // Convert vertex inclusion to a bitmask.
-                int32_t iFlagIndex = 0;
-                for(int32_t corner = 0; corner < 8; ++corner){
-                    if(below_is_interior){
-                        if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }else{
-                        if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
-                    }
-                }
+    std::mutex saver_printer; // Thread synchro lock for logging and counter iterating.
+    long int completed = 0;
+    const long int img_count = N_imgs;
 
-                // Convert vertex inclusion into a list of 'involved' edges that cross the ROI surface.
-                const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < N_imgs; ++k){
+            tp.submit_task([&,k](void) -> void {
+                auto &slab = slabs[k];
+
+                const auto get_vertex = [&](long int row, long int col, long int k_tail, int32_t axis) -> uint32_t {
+                    const auto row_h = row + ((axis == 0) ? 1 : 0);
+                    const auto col_h = col + ((axis == 1) ? 1 : 0);
+                    const auto k_h   = k_tail + ((axis == 2) ? 1 : 0);
+
+                    const double value_A = lattice_value(row, col, k_tail);
+                    const double value_B = lattice_value(row_h, col_h, k_h);
+
+                    // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
+                    const double lin_interp = (inclusion_threshold - value_A) / (value_B - value_A);
+                    const double surf_dl = std::isfinite(lin_interp) ? std::clamp(lin_interp, 0.0, 1.0)
+                                                                     : static_cast<double>(0.5);
+
+                    const auto key = (surf_dl <= 0.0) ? lattice_key(row, col, k_tail, 3)
+                                   : (1.0 <= surf_dl) ? lattice_key(row_h, col_h, k_h, 3)
+                                                      : lattice_key(row, col, k_tail, axis);
+
+                    const auto it = slab.key_to_local.find(key);
+                    if(it != std::end(slab.key_to_local)) return it->second;
+
+                    const auto R_A = lattice_position(row, col, k_tail);
+                    const auto R_B = lattice_position(row_h, col_h, k_h);
+                    const auto R = (surf_dl <= 0.0) ? R_A
+                                 : (1.0 <= surf_dl) ? R_B
+                                                    : R_A + (R_B - R_A) * surf_dl;
+
+                    const auto local = static_cast<uint32_t>(slab.verts.size());
+                    slab.key_to_local.emplace(key, local);
+                    slab.keys.emplace_back(key);
+                    slab.verts.emplace_back(R);
+                    return local;
+                };
+
+                for(long int row = 0; row < N_rows; ++row){
+                    for(long int col = 0; col < N_cols; ++col){
+
+                        // Sample voxel corner values. Marching Cube voxel corners are aligned with image voxel centres.
+                        //
+                        // Note that the Marching cube and image voxels are not the same. They are offset such that
+                        // the corner of the Marching Cube voxel is at the centre of the image voxel. This is done
+                        // to avoid surface discontinuties that would arise from sampling the boundary of border
+                        // voxels; numerical instability could potentially lead to random fluctuation by 1 voxel width on
+                        // straight borders.
+                        std::array<double, 8> afCubeValue;
+                        for(int32_t corner = 0; corner < 8; ++corner){
+                            afCubeValue[corner] = lattice_value(row + a2iCornerOffset[corner][0],
+                                                                col + a2iCornerOffset[corner][1],
+                                                                k   + a2iCornerOffset[corner][2]);
+                        }
 
-                // If the cube is entirely inside or outside of the surface, then there will be no intersections.
-                if(iEdgeFlags == 0) continue;
+                        // Convert vertex inclusion to a bitmask.
+                        int32_t iFlagIndex = 0;
+                        for(int32_t corner = 0; corner < 8; ++corner){
+                            if(below_is_interior){
+                                if(afCubeValue[corner] <= inclusion_threshold) iFlagIndex |= (1 << corner);
+                            }else{
+                                if(afCubeValue[corner] >= inclusion_threshold) iFlagIndex |= (1 << corner);
+                            }
+                        }
 
-                // Find the point of intersection of the surface with each edge.
-                std::array<vec3<double>, 12> asEdgeVertex;
-                for(int32_t edge = 0; edge < 12; edge++){
-                    if(iEdgeFlags & (1 << edge)){ // continue iff involved.
+                        // Convert vertex inclusion into a list of 'involved' edges that cross the ROI surface.
+                        const int32_t iEdgeFlags = aiCubeEdgeFlags[iFlagIndex];
 
-                        const double value_A = afCubeValue[a2iEdgeConnection[edge][0]];
-                        const double value_B = afCubeValue[a2iEdgeConnection[edge][1]];
+                        // If the cube is entirely inside or outside of the surface, then there will be no intersections.
+                        if(iEdgeFlags == 0) continue;
 
-                        // Find the (approximate) point along the edge where the surface intersects, parameterized to [0:1].
-                        const double d_value = (value_B - value_A);
-                        const double inv_d_value = static_cast<double>(1.0)/d_value;
-                        const double lin_interp = (inclusion_threshold - value_A) * inv_d_value;
-                        const double surf_dl = std::isfinite(lin_interp) ? lin_interp : static_cast<double>(0.5);
-                        if(!isininc(0.0,surf_dl,1.0)){
-                            throw std::logic_error("Interpolation of surface-edge intersection failed. Refusing to continue");
+                        // Find (or create) the vertex where the surface intersects each involved edge.
+                        std::array<uint32_t, 12> asEdgeVertex;
+                        for(int32_t edge = 0; edge < 12; edge++){
+                            if(iEdgeFlags & (1 << edge)){ // continue iff involved.
+                                const auto &le = a2iLatticeEdge[edge];
+                                asEdgeVertex[edge] = get_vertex(row + le[0], col + le[1], k + le[2], le[3]);
+                            }
                         }
 
-                        asEdgeVertex[edge] = (a2fEdgeDirection[edge] * surf_dl);
-                        asEdgeVertex[edge] += a2fVertexOffset[a2iEdgeConnection[edge][0]];
-                        asEdgeVertex[edge] += pos;
-                    }
-                }
+                        // Process the triangles that were identified.
+                        for(int32_t tri = 0; tri < 5; tri++){
 
-                // Process the triangles that were identified.
-                for(int32_t tri = 0; tri < 5; tri++){
+                            // Stop when the first -1 index is encountered (signifying there are no further triangles).
+                            if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
 
-                    // Stop when the first -1 index is encountered (signifying there are no further triangles).
-                    if(a2iTriangleConnectionTable[iFlagIndex][3*tri] < 0) break;
+                            std::array<uint32_t, 3> vert_indices;
+                            for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
+                                const int32_t vert_idx = a2iTriangleConnectionTable[iFlagIndex][3*tri + tri_corner];
+                                vert_indices[tri_corner] = asEdgeVertex[vert_idx];
+                            }
 
-                    std::array<vec3<double>, 3> tri_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const int32_t vert_idx = a2iTriangleConnectionTable[iFlagIndex][3*tri + tri_corner];
-                        tri_verts[tri_corner] = asEdgeVertex[vert_idx];
-    
-                    }
-
-                    // Determine which vertices should be used; if there are existing vertices sufficiently nearby, use
-                    // them rather than adding a new (disconnected) vertex.
-                    //
-                    // Note: Existing vertices created for adjacent voxels are more likely to be placed near the back of
-                    //       the vector. Using reverse iterators for searching rather than forward iterators more than
-                    //       halves the time this entire routine takes. 
-                    //
-                    // TODO: Below we use a generic lookup that considers the last N vertices added where N is selected
-                    //       so that it will include all possibly-adjacent voxels (in the worst case). While this works
-                    //       to limit needless complexity when there are many voxels, it is wasteful and could be
-                    //       improved. For example, spatial indexing of some kind could be used to speed up dupe vertex
-                    //       searching, or this could be fully eliminated by exploiting the grid nature or keeping an
-                    //       explicit list of vertices still reachable.
-                    //
-                    //       Note that the last-N-only lookup below implicitly assumes images are ordered AND traversed
-                    //       in adjacent order. 
-                    const auto min_consider = static_cast<long int>( ( N_rows * N_cols + 1 + std::max(N_rows, N_cols) + 1 ) * 5 * 3 );
-
-                    std::array<size_t, 3> vert_indices;
-                    std::vector<Kernel::Point_3> new_verts;
-                    for(int32_t tri_corner = 0; tri_corner < 3; ++tri_corner){
-                        const auto N_verts = static_cast<long int>( mesh_triangle_verts.size() );
-                        const auto consider = std::min( min_consider, N_verts );
-                        const auto rend = std::next(std::rbegin(mesh_triangle_verts), consider);
-                        auto v_it = std::find_if( //std::execution::par_unseq,
-                                                  std::rbegin(mesh_triangle_verts),
-                                                  rend,
-                                                  [=]( const Kernel::Point_3 &cv ) -> bool {
-                                                      const vec3<double> v( cv[0], cv[1], cv[2] );
-                                                      return (tri_verts[tri_corner].sq_dist(v) < (dvec3_tol*dvec3_tol));
-                                                  } );
-                        
-                        if(v_it != std::rend(mesh_triangle_verts)){
-                            vert_indices[tri_corner] = mesh_triangle_verts.size() - std::distance(std::rbegin(mesh_triangle_verts), v_it) - 1;
-                        }else{
-                            new_verts.emplace_back( Kernel::Point_3( 
-                                    tri_verts[tri_corner].x, tri_verts[tri_corner].y, tri_verts[tri_corner].z ) );
-                            vert_indices[tri_corner] = (mesh_triangle_verts.size() + new_verts.size() - 1);
+                            // Vertices welded at a lattice point can collapse a triangle.
+                            if( (vert_indices[0] != vert_indices[1]) // IFF all three vertices are distinct from one another.
+                            &&  (vert_indices[0] != vert_indices[2])
+                            &&  (vert_indices[1] != vert_indices[2]) ){
+                                slab.tris.emplace_back(vert_indices);
+                            }
                         }
-                    }
-                    if( (vert_indices[0] != vert_indices[1]) // IFF all three vertices are distinct from one another.
-                    &&  (vert_indices[0] != vert_indices[2])
-                    &&  (vert_indices[1] != vert_indices[2]) ){
-                        mesh_triangle_faces.emplace_back(vert_indices);
-                        mesh_triangle_verts.insert( std::end(mesh_triangle_verts), 
-                                                    std::begin(new_verts), std::end(new_verts) );
-                    }else{
-                        FUNCWARN("Encountered a zero-area triangle face. Ignoring it");
+
+                    } // Loop over columns.
+                } // Loop over rows.
+
+                //Report operation progress.
+                {
+                    std::lock_guard<std::mutex> lock(saver_printer);
+                    ++completed;
+                    FUNCINFO("Completed " << completed << " of " << img_count
+                          << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    // Stitch the slabs together. A vertex on the plane shared with the following slab is emitted by the following slab
+    // if it also refers to the vertex, and otherwise by this slab.
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < N_imgs; ++k){
+            tp.submit_task([&,k](void) -> void {
+                auto &slab = slabs[k];
+                slab.owned.assign(slab.keys.size(), 1);
+                if((k + 1) < N_imgs){
+                    const auto &next = slabs[k + 1];
+                    for(size_t i = 0; i < slab.keys.size(); ++i){
+                        const auto plane = static_cast<long int>(slab.keys[i] / N_keys_per_plane);
+                        if( (plane != k) && (next.key_to_local.count(slab.keys[i]) != 0) ) slab.owned[i] = 0;
                     }
                 }
+                slab.N_owned = static_cast<size_t>(std::count(std::begin(slab.owned), std::end(slab.owned), 1));
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    size_t N_verts = 0;
+    size_t N_faces = 0;
+    for(auto &slab : slabs){
+        slab.offset = N_verts;
+        N_verts += slab.N_owned;
+        N_faces += slab.tris.size();
+    }
 
-            } // Loop over columns.
-        } // Loop over rows.
+    // Storage used for the final mesh triangle vertices and faces.
+    std::vector<Kernel::Point_3> mesh_triangle_verts(N_verts);
+    std::vector< std::array<size_t, 3> > mesh_triangle_faces;
+    mesh_triangle_faces.reserve(N_faces);
 
-        //Report operation progress.
-        {
-            std::lock_guard<std::mutex> lock(saver_printer);
-            ++completed;
-            FUNCINFO("Completed " << completed << " of " << img_count
-                  << " --> " << static_cast<int>(1000.0*(completed)/img_count)/10.0 << "% done");
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < N_imgs; ++k){
+            tp.submit_task([&,k](void) -> void {
+                auto &slab = slabs[k];
+                slab.global.assign(slab.keys.size(), 0);
+                size_t n = slab.offset;
+                for(size_t i = 0; i < slab.keys.size(); ++i){
+                    if(slab.owned[i] == 0) continue;
+                    const auto &v = slab.verts[i];
+                    mesh_triangle_verts[n] = Kernel::Point_3( v.x, v.y, v.z );
+                    slab.global[i] = n++;
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    for(long int k = 0; k < N_imgs; ++k){
+        auto &slab = slabs[k];
+        for(size_t i = 0; i < slab.keys.size(); ++i){
+            if(slab.owned[i] != 0) continue;
+            const auto &next = slabs[k + 1];
+            slab.global[i] = next.global[ next.key_to_local.at(slab.keys[i]) ];
         }
-    } // Loop over images.
+        for(const auto &t : slab.tris){
+            mesh_triangle_faces.push_back( {{ slab.global[t[0]], slab.global[t[1]], slab.global[t[2]] }} );
+        }
+        slab = mc_slab();
+    }
 
     FUNCINFO("Orienting face normals..");
     CGAL::Polygon_mesh_processing::orient_polygon_soup(mesh_triangle_verts, mesh_triangle_faces);
@@ -1571,6 +1597,39 @@ FVSMeshToPolyhedron(
     return output_mesh;
 }
 
+
+// Convert from CGAL's Polyhedron class to fv_surface_mesh.
+//
+// Vertex coordinates are copied directly, so no precision is lost. Facets retain their original vertex ordering and
+// are not triangulated.
+fv_surface_mesh<double, uint64_t>
+PolyhedronToFVSMesh(
+        const Polyhedron &in ){
+
+    fv_surface_mesh<double, uint64_t> out;
+    out.vertices.reserve(in.size_of_vertices());
+    out.faces.reserve(in.size_of_facets());
+
+    std::unordered_map<const void*, uint64_t> vert_index;
+    vert_index.reserve(in.size_of_vertices());
+    for(auto v_it = in.vertices_begin(); v_it != in.vertices_end(); ++v_it){
+        const auto &p = v_it->point();
+        vert_index[ static_cast<const void*>(&(*v_it)) ] = static_cast<uint64_t>(out.vertices.size());
+        out.vertices.emplace_back( static_cast<double>(CGAL::to_double(p.x())),
+                                   static_cast<double>(CGAL::to_double(p.y())),
+                                   static_cast<double>(CGAL::to_double(p.z())) );
+    }
+    for(auto f_it = in.facets_begin(); f_it != in.facets_end(); ++f_it){
+        out.faces.emplace_back();
+        auto &f = out.faces.back();
+        auto h_it = f_it->facet_begin();
+        do{
+            f.emplace_back( vert_index.at( static_cast<const void*>(&(*(h_it->vertex()))) ) );
+        }while(++h_it != f_it->facet_begin());
+    }
+    return out;
+}
+
 } // namespace dcma_surface_meshes.
 
 
@@ -2075,19 +2134,231 @@ Transform( Polyhedron &output_mesh,
     return;
 }
 
-// This routine returns contours generated by slicing a mesh along the given planes.
-contour_collection<double> Slice_Polyhedron(
+// Slices an indexed triangle soup with a family of parallel planes that share the unit normal 'N'. The planes are
+// given by their offsets along N. One contour_collection is produced per plane, in the order the offsets are given.
+//
+// Vertices are projected onto N once. Triangles are then sorted by their lowest projection and a single sweep across
+// the sorted planes assigns each triangle to every plane it spans. Planes are then sliced independently, in parallel.
+// Vertices lying exactly on a plane are treated as lying above it, so every spanning triangle crosses the plane along
+// exactly two of its edges. Crossings are identified by mesh edge, so segments are joined exactly (i.e., without a
+// distance tolerance) and the output does not depend on the order in which triangles are visited.
+static
+std::vector<contour_collection<double>>
+Slice_Triangles_Parallel_Planes( const std::vector<vec3<double>> &verts,
+                                 const std::vector<std::array<size_t,3>> &tris,
+                                 const vec3<double> &N,
+                                 const std::vector<double> &offsets ){
+
+    using edge_key_t = std::pair<size_t,size_t>; // Vertex indices, lowest first.
+    struct segment {
+        edge_key_t from;
+        edge_key_t to;
+    };
+
+    const auto N_planes = offsets.size();
+    std::vector<contour_collection<double>> out(N_planes);
+    if(N_planes == 0) return out;
+
+    std::vector<double> heights;
+    heights.reserve(verts.size());
+    for(const auto &v : verts) heights.emplace_back( N.Dot(v) );
+
+    std::vector<size_t> plane_order(N_planes);
+    std::iota(std::begin(plane_order), std::end(plane_order), static_cast<size_t>(0));
+    std::stable_sort(std::begin(plane_order), std::end(plane_order),
+                     [&](size_t a, size_t b){ return offsets[a] < offsets[b]; });
+
+    // Sort the triangles by their span along the normal.
+    std::vector<std::pair<double,double>> spans;
+    spans.reserve(tris.size());
+    for(const auto &t : tris){
+        const auto h0 = heights[t[0]];
+        const auto h1 = heights[t[1]];
+        const auto h2 = heights[t[2]];
+        spans.emplace_back( std::min({h0, h1, h2}), std::max({h0, h1, h2}) );
+    }
+    std::vector<size_t> tri_order(tris.size());
+    std::iota(std::begin(tri_order), std::end(tri_order), static_cast<size_t>(0));
+    std::sort(std::begin(tri_order), std::end(tri_order),
+              [&](size_t a, size_t b){ return spans[a].first < spans[b].first; });
+
+    // Sweep once across the planes, maintaining the set of triangles that span the current plane. A triangle spans a
+    // plane at offset 'o' when min < o <= max.
+    std::vector<std::vector<size_t>> spanning(N_planes);
+    {
+        std::vector<size_t> active;
+        auto next_tri = std::begin(tri_order);
+        for(const auto &p : plane_order){
+            const auto o = offsets[p];
+            while( (next_tri != std::end(tri_order))
+            &&     (spans[*next_tri].first < o) ){
+                active.emplace_back(*next_tri);
+                ++next_tri;
+            }
+            active.erase( std::remove_if(std::begin(active), std::end(active),
+                                         [&](size_t t){ return (spans[t].second < o); }),
+                          std::end(active) );
+            spanning[p] = active;
+        }
+    }
+
+    // Slice each plane independently.
+    {
+        asio_thread_pool tp;
+        for(size_t p = 0; p < N_planes; ++p){
+            if(spanning[p].empty()) continue;
+            tp.submit_task([&,p](void) -> void {
+                const auto o = offsets[p];
+
+                // Emit one directed segment per spanning triangle. Following the triangle's winding, the segment
+                // joins the edge that crosses the plane going downward to the edge that crosses going upward. Adjacent
+                // triangles traverse their shared edge in opposite directions, so segments chain head-to-tail. For
+                // outward-oriented meshes, outer boundaries will be counter-clockwise when viewed along the normal.
+                std::vector<segment> segs;
+                segs.reserve(spanning[p].size());
+                for(const auto &t : spanning[p]){
+                    const auto &tri = tris[t];
+                    edge_key_t up;
+                    edge_key_t down;
+                    for(size_t i = 0; i < 3; ++i){
+                        const auto A = tri[i];
+                        const auto B = tri[(i + 1) % 3];
+                        const bool A_below = (heights[A] < o);
+                        const bool B_below = (heights[B] < o);
+                        if(A_below && !B_below) up = std::minmax(A, B);
+                        if(!A_below && B_below) down = std::minmax(A, B);
+                    }
+                    segs.push_back( { down, up } );
+                }
+                std::sort(std::begin(segs), std::end(segs),
+                          [](const segment &a, const segment &b){ return a.from < b.from; });
+
+                const auto intersection = [&](const edge_key_t &e) -> vec3<double> {
+                    const auto h_A = heights[e.first];
+                    const auto h_B = heights[e.second];
+                    if(h_A == o) return verts[e.first];
+                    if(h_B == o) return verts[e.second];
+                    const auto t = (o - h_A) / (h_B - h_A);
+                    return verts[e.first] + (verts[e.second] - verts[e.first]) * t;
+                };
+
+                // Locates an unused segment starting at the given edge, if any.
+                std::vector<uint8_t> used(segs.size(), 0);
+                const auto find_next = [&](const edge_key_t &e) -> size_t {
+                    auto it = std::lower_bound(std::begin(segs), std::end(segs), e,
+                                               [](const segment &s, const edge_key_t &k){ return s.from < k; });
+                    for( ; (it != std::end(segs)) && (it->from == e); ++it){
+                        const auto i = static_cast<size_t>(std::distance(std::begin(segs), it));
+                        if(used[i] == 0) return i;
+                    }
+                    return segs.size();
+                };
+
+                // Chains are seeded first from segments with no predecessor (which only occur when the mesh has a
+                // boundary) and then from any remaining segments, which form closed loops.
+                std::vector<edge_key_t> heads;
+                heads.reserve(segs.size());
+                for(const auto &s : segs) heads.emplace_back(s.to);
+                std::sort(std::begin(heads), std::end(heads));
+
+                std::vector<size_t> seeds;
+                for(size_t i = 0; i < segs.size(); ++i){
+                    if(!std::binary_search(std::begin(heads), std::end(heads), segs[i].from)) seeds.emplace_back(i);
+                }
+                for(size_t i = 0; i < segs.size(); ++i) seeds.emplace_back(i);
+
+                for(const auto &seed : seeds){
+                    if(used[seed] != 0) continue;
+
+                    contour_of_points<double> c;
+                    c.closed = false;
+                    c.points.emplace_back( intersection(segs[seed].from) );
+                    for(auto i = seed; i < segs.size(); i = find_next(segs[i].to)){
+                        used[i] = 1;
+                        if(segs[i].to == segs[seed].from){
+                            c.closed = true;
+                            break;
+                        }
+                        c.points.emplace_back( intersection(segs[i].to) );
+                    }
+
+                    // Vertices lying exactly on the plane are reached via multiple edges.
+                    c.points.erase( std::unique(std::begin(c.points), std::end(c.points)), std::end(c.points) );
+                    if( c.closed
+                    &&  (2 <= c.points.size())
+                    &&  (c.points.front() == c.points.back()) ){
+                        c.points.pop_back();
+                    }
+                    if(c.points.size() < 3) continue; // Disregard degenerate cases.
+
+                    out[p].contours.emplace_back( std::move(c) );
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    return out;
+}
+
+std::vector<contour_collection<double>>
+Slice_Polyhedron_Per_Plane(
         const Polyhedron &mesh,
-        std::list<plane<double>> planes ){
+        const std::list<plane<double>> &planes ){
+
+    std::vector<contour_collection<double>> out;
+    if(planes.empty()) return out;
+
+    // Determine whether all planes share a common normal. Anti-parallel normals describe the same family of planes.
+    const auto N = planes.front().N_0.unit();
+    bool parallel = N.isfinite();
+    for(const auto &aplane : planes){
+        parallel = parallel && (aplane.N_0.unit().Cross(N).length() < 1.0E-6);
+    }
+
+    if(parallel){
+        // Convert to an indexed triangle soup. Non-triangular facets are fan-triangulated.
+        std::vector<vec3<double>> verts;
+        std::vector<std::array<size_t,3>> tris;
+        std::unordered_map<const void*, size_t> vert_index;
+        verts.reserve(mesh.size_of_vertices());
+        tris.reserve(mesh.size_of_facets());
+        vert_index.reserve(mesh.size_of_vertices());
+        for(auto v_it = mesh.vertices_begin(); v_it != mesh.vertices_end(); ++v_it){
+            const auto &p = v_it->point();
+            vert_index[ static_cast<const void*>(&(*v_it)) ] = verts.size();
+            verts.emplace_back( static_cast<double>(CGAL::to_double(p.x())),
+                                static_cast<double>(CGAL::to_double(p.y())),
+                                static_cast<double>(CGAL::to_double(p.z())) );
+        }
+        for(auto f_it = mesh.facets_begin(); f_it != mesh.facets_end(); ++f_it){
+            std::vector<size_t> f_verts;
+            auto h_it = f_it->facet_begin();
+            do{
+                f_verts.emplace_back( vert_index.at( static_cast<const void*>(&(*(h_it->vertex()))) ) );
+            }while(++h_it != f_it->facet_begin());
+            for(size_t i = 2; i < f_verts.size(); ++i){
+                tris.push_back( {{ f_verts[0], f_verts[i-1], f_verts[i] }} );
+            }
+        }
+
+        std::vector<double> offsets;
+        offsets.reserve(planes.size());
+        for(const auto &aplane : planes) offsets.emplace_back( N.Dot(aplane.R_0) );
+
+        return Slice_Triangles_Parallel_Planes(verts, tris, N, offsets);
+    }
 
+    // Fall back on slicing each plane individually. The slicer's AABB tree is constructed only once.
     using Plane_3 = Kernel::Plane_3;
     using Polyline = std::vector<Kernel::Point_3>;
     using Polylines = std::list<Polyline>;
 
     CGAL::Polygon_mesh_slicer<Polyhedron, Kernel> slicer(mesh); 
-    contour_collection<double> cc;
 
-    for(auto &aplane : planes){
+    for(const auto &aplane : planes){
+        out.emplace_back();
+        auto &cc = out.back();
+
         const auto a = aplane.N_0.x;
         const auto b = aplane.N_0.y;
         const auto c = aplane.N_0.z;
@@ -2098,21 +2369,31 @@ contour_collection<double> Slice_Polyhedron(
         slicer(p3, std::back_inserter(polylines));
 
         // Convert any polylines found and insert them into the contour_collection.
-        if(!polylines.empty()){
-            for(auto &apl : polylines){
-                if(apl.size() < 3) continue; // Disregard degenerate cases.
-
-                cc.contours.emplace_back();
-                cc.contours.back().closed = true;
-                for(auto &v : apl){
-                    const vec3<double> p( static_cast<double>(CGAL::to_double(v.x())), 
-                                          static_cast<double>(CGAL::to_double(v.y())),
-                                          static_cast<double>(CGAL::to_double(v.z())) );
-                    cc.contours.back().points.emplace_back(p);
-                }
+        for(auto &apl : polylines){
+            if(apl.size() < 3) continue; // Disregard degenerate cases.
+
+            cc.contours.emplace_back();
+            cc.contours.back().closed = true;
+            for(auto &v : apl){
+                const vec3<double> p( static_cast<double>(CGAL::to_double(v.x())), 
+                                      static_cast<double>(CGAL::to_double(v.y())),
+                                      static_cast<double>(CGAL::to_double(v.z())) );
+                cc.contours.back().points.emplace_back(p);
             }
         }
     }
+    return out;
+}
+
+// This routine returns contours generated by slicing a mesh along the given planes.
+contour_collection<double> Slice_Polyhedron(
+        const Polyhedron &mesh,
+        std::list<plane<double>> planes ){
+
+    contour_collection<double> cc;
+    for(auto &plane_cc : Slice_Polyhedron_Per_Plane(mesh, planes)){
+        cc.contours.splice( std::end(cc.contours), plane_cc.contours );
+    }
 
 /*    
     // Write the contours to a file.
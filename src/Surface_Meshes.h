@@ -130,6 +130,10 @@ Polyhedron
 FVSMeshToPolyhedron(
         const fv_surface_mesh<double, uint64_t> &mesh );
 
+fv_surface_mesh<double, uint64_t>
+PolyhedronToFVSMesh(
+        const Polyhedron &mesh );
+
 
 } // namespace dcma_surface_meshes
 
@@ -192,6 +196,13 @@ Slice_Polyhedron(
         const Polyhedron &mesh,
         std::list<plane<double>> planes );
 
+// Slice a polyhedron, producing one contour_collection per plane (in the order the planes are given). Parallel planes
+// are sliced together in a single sweep along their common normal.
+std::vector<contour_collection<double>>
+Slice_Polyhedron_Per_Plane(
+        const Polyhedron &mesh,
+        const std::list<plane<double>> &planes );
+
 double
 Volume(const Polyhedron &mesh);
 
@@ -0,0 +1,198 @@
+//Voxel_Statistics.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Voxel_Statistics.h"
+
+
+static long int floor_div2(long int x){
+    return (x < 0) ? -((-x + 1) / 2) : (x / 2);
+}
+
+// Merges pairs of adjacent bins, doubling the bin width.
+static void halve_resolution(voxel_statistics &vs){
+    if(!vs.bins.empty()){
+        const auto new_offset = floor_div2(vs.bin_offset);
+        const auto new_end = floor_div2(vs.bin_offset + static_cast<long int>(vs.bins.size()) - 1) + 1;
+        std::vector<uint64_t> merged(static_cast<std::size_t>(new_end - new_offset), 0);
+        for(std::size_t j = 0; j < vs.bins.size(); ++j){
+            const auto i = floor_div2(vs.bin_offset + static_cast<long int>(j));
+            merged[static_cast<std::size_t>(i - new_offset)] += vs.bins[j];
+        }
+        vs.bins.swap(merged);
+        vs.bin_offset = new_offset;
+    }
+    vs.bin_width *= 2.0;
+    return;
+}
+
+// Merges bins until bins spanning [lo, hi) (in units of the current bin width) would fit.
+static void coarsen_bins(voxel_statistics &vs, long int &lo, long int &hi){
+    while(std::max<std::size_t>(vs.max_bins, 1) < static_cast<std::size_t>(hi - lo)){
+        halve_resolution(vs);
+        lo = floor_div2(lo);
+        hi = floor_div2(hi - 1) + 1;
+    }
+    return;
+}
+
+// Ensures bins [lo, hi) exist, in units of the current bin width. Returns false if the bins were coarsened instead, in
+// which case bin indices must be recomputed.
+static bool reserve_bins(voxel_statistics &vs, long int lo, long int hi){
+    if(!vs.bins.empty()){
+        lo = std::min(lo, vs.bin_offset);
+        hi = std::max(hi, vs.bin_offset + static_cast<long int>(vs.bins.size()));
+    }
+    if(std::max<std::size_t>(vs.max_bins, 1) < static_cast<std::size_t>(hi - lo)){
+        coarsen_bins(vs, lo, hi);
+        return false;
+    }
+
+    if(vs.bins.empty()){
+        vs.bins.assign(static_cast<std::size_t>(hi - lo), 0);
+        vs.bin_offset = lo;
+        return true;
+    }
+    if(lo < vs.bin_offset){
+        vs.bins.insert(std::begin(vs.bins), static_cast<std::size_t>(vs.bin_offset - lo), 0);
+        vs.bin_offset = lo;
+    }
+    vs.bins.resize(static_cast<std::size_t>(hi - lo), 0);
+    return true;
+}
+
+static long int bin_index(const voxel_statistics &vs, double v){
+    return static_cast<long int>(std::floor(v / vs.bin_width));
+}
+
+
+void voxel_statistics::digest(double v){
+    if(!std::isfinite(v)) return;
+
+    if(this->term_sums.size() != this->terms.size()) this->term_sums.resize(this->terms.size(), 0.0);
+    for(std::size_t i = 0; i < this->terms.size(); ++i) this->term_sums[i] += this->terms[i](v);
+
+    // Welford's update.
+    this->count += 1;
+    this->sum += v;
+    const auto delta = v - this->mean;
+    this->mean += delta / static_cast<double>(this->count);
+    this->M2 += delta * (v - this->mean);
+    this->min = std::min(this->min, v);
+    this->max = std::max(this->max, v);
+
+    while(1.0E15 < std::abs(v / this->bin_width)) halve_resolution(*this); // Keep bin indices representable.
+    auto i = bin_index(*this, v);
+    if(!reserve_bins(*this, i, i + 1)){
+        i = bin_index(*this, v);
+        reserve_bins(*this, i, i + 1);
+    }
+    this->bins[static_cast<std::size_t>(i - this->bin_offset)] += 1;
+    return;
+}
+
+void voxel_statistics::merge(const voxel_statistics &other){
+    if(other.count == 0) return;
+    if(this->terms.size() != other.terms.size()){
+        throw std::invalid_argument("Refusing to merge voxel statistics with differing terms.");
+    }
+
+    // Bring both histograms to a common bin width. Widths only ever differ by powers of two.
+    voxel_statistics o = other;
+    const auto widen = [](voxel_statistics &vs, double width){
+        while(vs.bin_width < width) halve_resolution(vs);
+    };
+    if(this->count == 0){
+        o.max_bins = this->max_bins;
+        *this = o;
+        return;
+    }
+    widen(*this, o.bin_width);
+    widen(o, this->bin_width);
+
+    const auto o_end = o.bin_offset + static_cast<long int>(o.bins.size());
+    if(!reserve_bins(*this, o.bin_offset, o_end)){
+        widen(o, this->bin_width);
+        reserve_bins(*this, o.bin_offset, o.bin_offset + static_cast<long int>(o.bins.size()));
+    }
+    for(std::size_t j = 0; j < o.bins.size(); ++j){
+        this->bins[static_cast<std::size_t>(o.bin_offset - this->bin_offset) + j] += o.bins[j];
+    }
+
+    // Chan et al.'s pairwise update.
+    const auto n_a = static_cast<double>(this->count);
+    const auto n_b = static_cast<double>(o.count);
+    const auto n = n_a + n_b;
+    const auto delta = o.mean - this->mean;
+    this->mean += delta * (n_b / n);
+    this->M2 += o.M2 + delta * delta * (n_a * n_b / n);
+    this->count += o.count;
+    this->sum += o.sum;
+    this->min = std::min(this->min, o.min);
+    this->max = std::max(this->max, o.max);
+
+    if(this->term_sums.size() != this->terms.size()) this->term_sums.resize(this->terms.size(), 0.0);
+    for(std::size_t i = 0; i < o.term_sums.size(); ++i) this->term_sums[i] += o.term_sums[i];
+    return;
+}
+
+double voxel_statistics::get_mean(void) const {
+    return (this->count == 0) ? std::numeric_limits<double>::quiet_NaN() : this->mean;
+}
+
+double voxel_statistics::get_unbiased_variance(void) const {
+    return (this->count < 2) ? std::numeric_limits<double>::quiet_NaN()
+                             : this->M2 / static_cast<double>(this->count - 1);
+}
+
+double voxel_statistics::get_stddev(void) const {
+    return std::sqrt(this->get_unbiased_variance());
+}
+
+double voxel_statistics::get_quantile(double q) const {
+    if(this->count == 0) return std::numeric_limits<double>::quiet_NaN();
+    q = std::clamp(q, 0.0, 1.0);
+
+    // Estimates the k-th (zero-based) order statistic.
+    const auto order_statistic = [&](uint64_t k) -> double {
+        uint64_t below = 0;
+        for(std::size_t j = 0; j < this->bins.size(); ++j){
+            const auto n = this->bins[j];
+            if(k < (below + n)){
+                const auto lower = this->bin_width * static_cast<double>(this->bin_offset + static_cast<long int>(j));
+                const auto frac = (static_cast<double>(k - below) + 0.5) / static_cast<double>(n);
+                return std::clamp(lower + frac * this->bin_width, this->min, this->max);
+            }
+            below += n;
+        }
+        return this->max;
+    };
+
+    const auto rank = q * static_cast<double>(this->count - 1);
+    const auto k_lo = static_cast<uint64_t>(std::floor(rank));
+    const auto k_hi = static_cast<uint64_t>(std::ceil(rank));
+    const auto v_lo = order_statistic(k_lo);
+    if(k_lo == k_hi) return v_lo;
+    const auto v_hi = order_statistic(k_hi);
+    return v_lo + (v_hi - v_lo) * (rank - static_cast<double>(k_lo));
+}
+
+double voxel_statistics::get_median(void) const {
+    return this->get_quantile(0.5);
+}
+
+
+std::function<double(double)> voxel_statistics_power_term(double exponent){
+    return [exponent](double v) -> double {
+        const auto x = std::pow(v, exponent);
+        return std::isfinite(x) ? x : 0.0;
+    };
+}
+
@@ -0,0 +1,68 @@
+//Voxel_Statistics.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// Summary statistics for a stream of voxel values, computed in a single pass using memory that does not depend on the
+// number of voxels.
+//
+// Moments and extrema are exact. Quantiles are estimated from a fixed-width histogram and are accurate to within one
+// bin width. If the histogram would grow too large, adjacent bins are repeatedly merged (doubling the bin width), so
+// memory remains bounded even for unexpectedly wide ranges. Arbitrary additive per-voxel terms (e.g., gEUD or LKB power
+// sums, or threshold counts) can also be tracked.
+//
+// Aggregators can be filled independently (e.g., one per task) and merged afterward. Merged aggregators must have been
+// configured identically.
+struct voxel_statistics {
+
+    // -----------------------------
+    // Configuration. These should be set before any voxels are digested.
+
+    // The initial histogram bin width used for estimating quantiles, in the same units as the voxel values.
+    double bin_width = 0.01;
+
+    // The maximum number of histogram bins.
+    std::size_t max_bins = (1UL << 20);
+
+    // Per-voxel terms whose sums are tracked. term_sums[i] is the sum of terms[i](v) over all digested values v.
+    std::vector<std::function<double(double)>> terms;
+
+    // -----------------------------
+    // Running state.
+    std::size_t count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double M2 = 0.0;   // Sum of squared deviations from the mean.
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    std::vector<double> term_sums;
+
+    long int bin_offset = 0;   // bins[i] covers [bin_width*(i + bin_offset), bin_width*(i + bin_offset + 1)).
+    std::vector<uint64_t> bins;
+
+    // -----------------------------
+    // Adds a single value. Non-finite values are ignored.
+    void digest(double v);
+
+    // Adds the contents of another aggregator.
+    void merge(const voxel_statistics &other);
+
+    // Derived quantities. These are NaN when no values have been digested (or, for the variance, fewer than two).
+    double get_mean(void) const;
+    double get_unbiased_variance(void) const;
+    double get_stddev(void) const;
+
+    // Estimates the quantile q in [0,1] via linear interpolation between order statistics, where each order statistic
+    // is estimated by distributing the values in each bin uniformly across the bin.
+    double get_quantile(double q) const;
+    double get_median(void) const;
+};
+
+// Returns a per-voxel term computing v^exponent, where non-finite results contribute nothing.
+std::function<double(double)> voxel_statistics_power_term(double exponent);
+
@@ -6,9 +6,14 @@
 #include <functional>
 #include <list>
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "AccumulatePixelDistributions.h"
 #include "YgorImages.h"
@@ -38,6 +43,11 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
     //
     // This routine does not modify the images it uses to compute ROIs, so there is no need to create copies.
     //
+    // Groups of spatially overlapping images are processed in parallel. Summary statistics from each group are folded
+    // into a single aggregator per ROI as soon as the group is complete, so at most one partial aggregator per ROI is
+    // held for each task in flight. (Moments may therefore differ in the last few bits between runs.) Retained voxels
+    // are combined in group order, so the accumulated distributions do not depend on scheduling.
+    //
 
     //We require a valid AccumulatePixelDistributionsUserData struct packed into the user_data.
     AccumulatePixelDistributionsUserData *user_data_s;
@@ -60,11 +70,10 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
     }
 
     //Generate a comprehensive list of iterators to all as-of-yet-unused images. This list will be
-    // pruned after images have been successfully operated on.
+    // pruned after images have been successfully grouped.
     auto all_images = imagecoll.get_all_images();
+    std::vector<decltype(all_images)> groups;
     while(!all_images.empty()){
-        FUNCINFO("Images still to be processed: " << all_images.size());
-
         // Find the images which spatially overlap with this image.
         auto curr_img_it = all_images.front();
         auto selected_imgs = GroupSpatiallyOverlappingImages(curr_img_it, std::ref(imagecoll));
@@ -97,108 +106,165 @@ bool AccumulatePixelDistributions(planar_image_collection<float,double> &imageco
         for(auto &an_img_it : selected_imgs){
              all_images.remove(an_img_it); //std::list::remove() erases all elements equal to input value.
         }
+        groups.emplace_back(selected_imgs);
+    }
+
+    // Retained voxels for each group, combined in group order after all groups have been processed.
+    std::vector<std::map<std::string, std::vector<double>>> group_voxels(groups.size());
+    std::map<std::string, voxel_statistics> aggregated;
+    bool missing_metadata = false;
+
+    {
+        asio_thread_pool tp;
+        std::mutex saver;
+        size_t completed = 0;
+        for(size_t g = 0; g < groups.size(); ++g){
+            tp.submit_task([&,g](void) -> void {
+                const auto &selected_imgs = groups[g];
+                auto &voxels = group_voxels[g];
+                std::map<std::string, voxel_statistics> stats;
 
-        planar_image<float,double> &img = std::ref(*selected_imgs.front());
-        //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
-        const auto row_unit   = img.row_unit;
-        const auto col_unit   = img.col_unit;
-        const auto ortho_unit = row_unit.Cross( col_unit ).unit();
+                planar_image<float,double> &img = std::ref(*selected_imgs.front());
+                //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
+                const auto row_unit   = img.row_unit;
+                const auto col_unit   = img.col_unit;
+                const auto ortho_unit = row_unit.Cross( col_unit ).unit();
     
-        //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
-        //for(const auto &roi : rois){
-        for(auto &ccs : ccsl){
-            for(auto & contour : ccs.get().contours){
-                if(contour.points.empty()) continue;
-                if(! img.encompasses_contour_of_points(contour)) continue;
+                //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
+                //for(const auto &roi : rois){
+                for(auto &ccs : ccsl){
+                    for(auto & contour : ccs.get().contours){
+                        if(contour.points.empty()) continue;
+                        if(! img.encompasses_contour_of_points(contour)) continue;
     
-                const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
-                if(!ROIName){
-                    FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
-                    return false;
-                }
+                        const auto ROIName =  contour.GetMetadataValueAs<std::string>("ROIName");
+                        if(!ROIName){
+                            std::lock_guard<std::mutex> lock(saver);
+                            missing_metadata = true;
+                            return;
+                        }
                 
-        /*
-                //Construct a bounding box to reduce computational demand of checking every voxel.
-                auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
-                auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
-                auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
-                const bool BBoxAlreadyProjected = true;
-        */
+                /*
+                        //Construct a bounding box to reduce computational demand of checking every voxel.
+                        auto BBox = roi_it->Bounding_Box_Along(row_unit, 1.0);
+                        auto BBoxBestFitPlane = BBox.Least_Squares_Best_Fit_Plane(vec3<double>(0.0,0.0,1.0));
+                        auto BBoxProjectedContour = BBox.Project_Onto_Plane_Orthogonally(BBoxBestFitPlane);
+                        const bool BBoxAlreadyProjected = true;
+                */
         
-                //Prepare a contour for fast is-point-within-the-polygon checking.
-                auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-                auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-                const bool AlreadyProjected = true;
+                        //Prepare a contour for fast is-point-within-the-polygon checking.
+                        auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
+                        auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
+                        const bool AlreadyProjected = true;
         
-                for(auto row = 0; row < img.rows; ++row){
-                    for(auto col = 0; col < img.columns; ++col){
-                        //Figure out the spatial location of the present voxel.
-                        const auto point = img.position(row,col);
+                        for(auto row = 0; row < img.rows; ++row){
+                            for(auto col = 0; col < img.columns; ++col){
+                                //Figure out the spatial location of the present voxel.
+                                const auto point = img.position(row,col);
         
-        /*
-                        //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
-                        auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
-                                                                                            BBoxProjectedPoint,
-                                                                                            BBoxAlreadyProjected)) continue;
-        */
+                /*
+                                //Check if within the bounding box. It will generally be cheaper than the full contour (4 points vs. ? points).
+                                auto BBoxProjectedPoint = BBoxBestFitPlane.Project_Onto_Plane_Orthogonally(point);
+                                if(!BBoxProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BBoxBestFitPlane,
+                                                                                                    BBoxProjectedPoint,
+                                                                                                    BBoxAlreadyProjected)) continue;
+                */
         
-                        //Perform a more detailed check to see if we are in the ROI.
-                        auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                        if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                       ProjectedPoint,
-                                                                                       AlreadyProjected)){
-                            for(auto chan = 0; chan < img.channels; ++chan){
-                                //Cycle over the grouped images, accumulating the voxel intensity.
-                                double combined_voxel_intensity = 0.0;
-                                for(auto & img_it : selected_imgs){
-
-                                    //Collect the datum of voxels and nearby voxels for an average.
-                                    std::list<double> in_pixs;
-                                    const auto boxr = 0;
-                                    const auto min_datum = 1;
-                                    for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
-                                        for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
-                                            //Check if the coordinates are legal and in the ROI.
-                                            if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
+                                //Perform a more detailed check to see if we are in the ROI.
+                                auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
+                                if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
+                                                                                               ProjectedPoint,
+                                                                                               AlreadyProjected)){
+                                    for(auto chan = 0; chan < img.channels; ++chan){
+                                        //Cycle over the grouped images, accumulating the voxel intensity.
+                                        double combined_voxel_intensity = 0.0;
+                                        for(auto & img_it : selected_imgs){
+
+                                            //Collect the datum of voxels and nearby voxels for an average.
+                                            std::list<double> in_pixs;
+                                            const auto boxr = 0;
+                                            const auto min_datum = 1;
+                                            for(auto lrow = (row-boxr); lrow <= (row+boxr); ++lrow){
+                                                for(auto lcol = (col-boxr); lcol <= (col+boxr); ++lcol){
+                                                    //Check if the coordinates are legal and in the ROI.
+                                                    if( !isininc(0,lrow,img_it->rows-1) || !isininc(0,lcol,img_it->columns-1) ) continue;
         
-                                            //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
-                                            //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
-                                            const auto neighbourpoint = img.position(lrow,lcol);
-                                            auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                            if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                            ProjectedNeighbourPoint,
-                                                                                                            AlreadyProjected)) continue;
-                                            const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
-                                            in_pixs.push_back(val);
+                                                    //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
+                                                    //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
+                                                    const auto neighbourpoint = img.position(lrow,lcol);
+                                                    auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
+                                                    if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
+                                                                                                                    ProjectedNeighbourPoint,
+                                                                                                                    AlreadyProjected)) continue;
+                                                    const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
+                                                    in_pixs.push_back(val);
+                                                }
+                                            }
+                                            if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
+                                            const auto combined_val = Stats::Sum(in_pixs);
+                                            combined_voxel_intensity += combined_val;
                                         }
-                                    }
-                                    if(in_pixs.size() < min_datum) continue; //If contours are too narrow so that there is too few datum for meaningful results.
-                                    const auto combined_val = Stats::Sum(in_pixs);
-                                    combined_voxel_intensity += combined_val;
-                                }
         
-                                // --------------- Incorporate the data into the user_data struct ------------------
-                                user_data_s->accumulated_voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
+                                        // --------------- Incorporate the data into the user_data struct ------------------
+                                        if(user_data_s->retain_voxels){
+                                            voxels[ ROIName.value() ].emplace_back(combined_voxel_intensity);
+                                        }
+                                        auto s_it = stats.find( ROIName.value() );
+                                        if(s_it == stats.end()){
+                                            s_it = stats.emplace( ROIName.value(), user_data_s->prototype ).first;
+                                        }
+                                        s_it->second.digest(combined_voxel_intensity);
         
-                                // ----------------------------------------------------------------------------
+                                        // ----------------------------------------------------------------------------
         
-                            }//Loop over channels.
+                                    }//Loop over channels.
         
-                        //If we're in the bounding box but not the ROI, do something.
-                        }else{
-                            //for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                            //    const auto curr_val = working.value(row, col, chan);
-                            //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
-                            //                              "You will need to run the functor individually on the overlapping ROIs.");
-                            //    working.reference(row, col, chan) = static_cast<float>(10);
-                            //}
-                        } // If is in ROI or ROI bbox.
-                    } //Loop over cols
-                } //Loop over rows
-            } //Loop over ROIs.
-        } //Loop over contour_collections.
+                                //If we're in the bounding box but not the ROI, do something.
+                                }else{
+                                    //for(auto chan = 0; chan < first_img_it->channels; ++chan){
+                                    //    const auto curr_val = working.value(row, col, chan);
+                                    //    if(curr_val != 0) FUNCERR("There are overlapping ROI bboxes. This code currently cannot handle this. "
+                                    //                              "You will need to run the functor individually on the overlapping ROIs.");
+                                    //    working.reference(row, col, chan) = static_cast<float>(10);
+                                    //}
+                                } // If is in ROI or ROI bbox.
+                            } //Loop over cols
+                        } //Loop over rows
+                    } //Loop over ROIs.
+                } //Loop over contour_collections.
 
+                std::lock_guard<std::mutex> lock(saver);
+                for(auto &p : stats){
+                    auto s_it = aggregated.find(p.first);
+                    if(s_it == aggregated.end()){
+                        aggregated.emplace(p.first, std::move(p.second));
+                    }else{
+                        s_it->second.merge(p.second);
+                    }
+                }
+                ++completed;
+                FUNCINFO("Completed " << completed << " of " << groups.size() << " groups of images");
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    if(missing_metadata){
+        FUNCWARN("Missing necessary tags for reporting analysis results. Cannot continue");
+        return false;
+    }
+
+    for(auto &voxels : group_voxels){
+        for(auto &p : voxels){
+            auto &v = user_data_s->accumulated_voxels[p.first];
+            v.insert(std::end(v), std::begin(p.second), std::end(p.second));
+        }
+    }
+    for(auto &p : aggregated){
+        auto s_it = user_data_s->aggregated_voxels.find(p.first);
+        if(s_it == user_data_s->aggregated_voxels.end()){
+            s_it = user_data_s->aggregated_voxels.emplace(p.first, user_data_s->prototype).first;
+        }
+        s_it->second.merge(p.second);
     }
 
     return true;
@@ -14,12 +14,22 @@
 #include "YgorMath.h"
 #include "YgorMisc.h"
 
+#include "../../Voxel_Statistics.h"
+
 template <class T, class R> class planar_image_collection;
 template <class T> class contour_collection;
 
 
 struct AccumulatePixelDistributionsUserData {
+    // Whether the individual voxel values should be retained. If only summary statistics are needed, disabling this
+    // keeps memory use independent of the number of voxels.
+    bool retain_voxels = true;
     std::map<std::string, std::vector<double>> accumulated_voxels; // key: RawROIName.
+
+    // Summary statistics are always accumulated. New entries are copied from the prototype, so any per-voxel terms or
+    // histogram settings should be configured there.
+    voxel_statistics prototype;
+    std::map<std::string, voxel_statistics> aggregated_voxels; // key: RawROIName.
 };
 
 bool AccumulatePixelDistributions(planar_image_collection<float,double> &,
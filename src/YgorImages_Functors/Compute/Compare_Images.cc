@@ -2,6 +2,7 @@
 
 #include <exception>
 #include <any>
+#include <cmath>
 #include <optional>
 #include <functional>
 #include <list>
@@ -10,6 +11,8 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <mutex>
+#include <vector>
 
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
@@ -23,6 +26,270 @@
 #include "YgorClustering.hpp"
 
 
+// A flattened, indexed view of a rectilinear reference image array.
+//
+// This is used by the accelerated gamma search to avoid per-sample image lookups. Voxels are addressed using
+// (row, column, slice) triplets, where slices are ordered along the image normal.
+struct compare_images_ref_grid {
+    std::vector<const planar_image<float,double> *> imgs;
+
+    vec3<double> origin;   // The centre of voxel (0,0) in the first slice.
+    vec3<double> row_unit;
+    vec3<double> col_unit;
+    vec3<double> img_unit;
+
+    double pxl_dx = 1.0;
+    double pxl_dy = 1.0;
+    double pxl_dz = 1.0;   // Slice separation, or the slice thickness if only a single slice is present.
+
+    long int rows = 0;
+    long int columns = 0;
+    long int channel = 0;
+
+    double lower_threshold = -(std::numeric_limits<double>::infinity());
+    double upper_threshold = std::numeric_limits<double>::infinity();
+
+    long int slices(void) const {
+        return static_cast<long int>(this->imgs.size());
+    }
+
+    // Returns the voxel value, or NaN if the voxel is not available or is excluded by the thresholds.
+    double voxel(long int row, long int col, long int slice) const {
+        if( !isininc(0L, row, this->rows - 1L)
+        ||  !isininc(0L, col, this->columns - 1L)
+        ||  !isininc(0L, slice, this->slices() - 1L) ){
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        const double val = this->imgs[slice]->value(row, col, this->channel);
+        if(!isininc(this->lower_threshold, val, this->upper_threshold)){
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return val;
+    }
+
+    // Converts a position to continuous (row, column, slice) coordinates, packed as (x, y, z).
+    vec3<double> fractional_index(const vec3<double> &P) const {
+        const auto dP = (P - this->origin);
+        return vec3<double>( dP.Dot(this->row_unit) / this->pxl_dx,
+                             dP.Dot(this->col_unit) / this->pxl_dy,
+                             dP.Dot(this->img_unit) / this->pxl_dz );
+    }
+
+    vec3<double> position(const vec3<double> &fi) const {
+        return this->origin + this->row_unit * (this->pxl_dx * fi.x)
+                            + this->col_unit * (this->pxl_dy * fi.y)
+                            + this->img_unit * (this->pxl_dz * fi.z);
+    }
+
+    // Trilinearly interpolates the grid at the given continuous coordinates.
+    //
+    // Samples within half a voxel of the outermost voxel centres are clamped. NaN is returned if the sample is outside
+    // the grid or any contributing voxel is not available.
+    double interpolate(const vec3<double> &fi) const {
+        const auto split_axis = [](double x, long int n, long int &i0, long int &i1, double &w) -> bool {
+            if( !std::isfinite(x)
+            ||  (x < -0.5)
+            ||  ((static_cast<double>(n) - 0.5) < x) ){
+                return false;
+            }
+            if(n == 1){
+                i0 = 0;
+                i1 = 0;
+                w = 0.0;
+                return true;
+            }
+            const auto xc = std::clamp(x, 0.0, static_cast<double>(n - 1));
+            i0 = std::min(static_cast<long int>(std::floor(xc)), n - 2L);
+            i1 = i0 + 1;
+            w = xc - static_cast<double>(i0);
+            return true;
+        };
+
+        long int r0, r1, c0, c1, k0, k1;
+        double wr, wc, wk;
+        if( !split_axis(fi.x, this->rows, r0, r1, wr)
+        ||  !split_axis(fi.y, this->columns, c0, c1, wc)
+        ||  !split_axis(fi.z, this->slices(), k0, k1, wk) ){
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        const auto v000 = this->voxel(r0, c0, k0);
+        const auto v100 = this->voxel(r1, c0, k0);
+        const auto v010 = this->voxel(r0, c1, k0);
+        const auto v110 = this->voxel(r1, c1, k0);
+        const auto v001 = this->voxel(r0, c0, k1);
+        const auto v101 = this->voxel(r1, c0, k1);
+        const auto v011 = this->voxel(r0, c1, k1);
+        const auto v111 = this->voxel(r1, c1, k1);
+
+        const auto v00 = v000 * (1.0 - wr) + v100 * wr;
+        const auto v10 = v010 * (1.0 - wr) + v110 * wr;
+        const auto v01 = v001 * (1.0 - wr) + v101 * wr;
+        const auto v11 = v011 * (1.0 - wr) + v111 * wr;
+
+        const auto v0 = v00 * (1.0 - wc) + v10 * wc;
+        const auto v1 = v01 * (1.0 - wc) + v11 * wc;
+
+        return v0 * (1.0 - wk) + v1 * wk; // Note: NaNs propagate.
+    }
+};
+
+// A voxel offset in the reference grid along with its physical length. Offsets are sorted by length so the search can
+// be abandoned as soon as the distance term alone precludes improvement.
+struct compare_images_search_offset {
+    long int d_row;
+    long int d_col;
+    long int d_slice;
+    double dist;
+};
+
+static
+std::vector<compare_images_search_offset>
+Generate_Sorted_Search_Offsets(const compare_images_ref_grid &grid,
+                               double max_dist){
+    std::vector<compare_images_search_offset> out;
+
+    const auto N_r = static_cast<long int>(std::ceil(max_dist / grid.pxl_dx));
+    const auto N_c = static_cast<long int>(std::ceil(max_dist / grid.pxl_dy));
+    const auto N_k = (grid.slices() == 1) ? 0L
+                                          : std::min( static_cast<long int>(std::ceil(max_dist / grid.pxl_dz)),
+                                                      grid.slices() );
+    for(long int k = -N_k; k <= N_k; ++k){
+        for(long int r = -N_r; r <= N_r; ++r){
+            for(long int c = -N_c; c <= N_c; ++c){
+                const auto dist = std::hypot( grid.pxl_dx * static_cast<double>(r),
+                                              grid.pxl_dy * static_cast<double>(c),
+                                              grid.pxl_dz * static_cast<double>(k) );
+                if(max_dist < dist) continue;
+                out.push_back( { r, c, k, dist } );
+            }
+        }
+    }
+    std::stable_sort(std::begin(out), std::end(out),
+                     [](const compare_images_search_offset &L, const compare_images_search_offset &R) -> bool {
+                         return (L.dist < R.dist);
+                     });
+    return out;
+}
+
+// Computes the gamma index for a single test voxel using a distance-ordered, pruned search followed by a
+// coarse-to-fine refinement with on-the-fly trilinear interpolation.
+//
+// Returns NaN if no reference voxels could be sampled. If the search was abandoned because gamma is necessarily >1,
+// the user-provided early termination value is returned.
+static
+double
+Accelerated_Gamma_Search(const compare_images_ref_grid &grid,
+                         const std::vector<compare_images_search_offset> &offsets,
+                         const std::function< double (const double &, const double &) > &estimate_discrepancy,
+                         const ComputeCompareImagesUserData &ud,
+                         const vec3<double> &pos,
+                         double edit_val){
+
+    const auto DTA_thres = ud.gamma_DTA_threshold;
+    const auto Dis_thres = ud.gamma_Dis_threshold;
+    const auto gamma_cap = (ud.gamma_terminate_when_max_exceeded) ? 1.0
+                                                                  : std::numeric_limits<double>::infinity();
+
+    const auto eval_gamma = [&](double dist, double ref_val) -> double {
+        const auto Disc = estimate_discrepancy(edit_val, ref_val);
+        return std::hypot( dist / DTA_thres, Disc / Dis_thres );
+    };
+
+    const auto fi_pos = grid.fractional_index(pos);
+    const auto R_row = static_cast<long int>(std::round(fi_pos.x));
+    const auto R_col = static_cast<long int>(std::round(fi_pos.y));
+    const auto R_slice = static_cast<long int>(std::round(fi_pos.z));
+
+    // The test voxel need not coincide with a reference voxel centre. All offsets are measured from the nearest
+    // reference voxel, so the triangle inequality provides a lower bound on the true distance.
+    const auto R_pos = grid.position( vec3<double>( static_cast<double>(R_row),
+                                                    static_cast<double>(R_col),
+                                                    static_cast<double>(R_slice) ) );
+    const auto R_sep = R_pos.distance(pos);
+
+    double best = std::numeric_limits<double>::infinity();
+    vec3<double> best_fi = fi_pos;
+    bool sampled = false;
+
+    // Consider the test position itself.
+    {
+        const auto ref_val = grid.interpolate(fi_pos);
+        if(std::isfinite(ref_val)){
+            sampled = true;
+            best = eval_gamma(0.0, ref_val);
+        }
+    }
+
+    // Coarse search: visit voxel centres in order of increasing distance.
+    for(const auto &o : offsets){
+        if(((o.dist - R_sep) / DTA_thres) >= std::min(best, gamma_cap)) break;
+
+        const auto l_row = R_row + o.d_row;
+        const auto l_col = R_col + o.d_col;
+        const auto l_slice = R_slice + o.d_slice;
+        const auto ref_val = grid.voxel(l_row, l_col, l_slice);
+        if(!std::isfinite(ref_val)) continue;
+        sampled = true;
+
+        const vec3<double> l_fi( static_cast<double>(l_row),
+                                 static_cast<double>(l_col),
+                                 static_cast<double>(l_slice) );
+        const auto dist = grid.position(l_fi).distance(pos);
+        if((dist / DTA_thres) >= best) continue;
+
+        const auto g = eval_gamma(dist, ref_val);
+        if(g < best){
+            best = g;
+            best_fi = l_fi;
+        }
+    }
+
+    if(!sampled) return std::numeric_limits<double>::quiet_NaN();
+    if(!std::isfinite(best) || (gamma_cap <= best)){
+        return (ud.gamma_terminate_when_max_exceeded) ? ud.gamma_terminated_early
+                                                      : best;
+    }
+
+    // Fine search: compass search along the 26 lattice directions with a step that halves every level. The reference
+    // images are interpolated at each sample, so the agreement position can be located between voxel centres.
+    const bool planar = (grid.slices() == 1);
+    double h = 0.5;
+    for(long int level = 0; (level < ud.gamma_refinement_levels) && (0.0 < best); ++level, h *= 0.5){
+        bool improved = true;
+        for(long int moves = 0; improved && (moves < 8); ++moves){
+            improved = false;
+            const auto centre_fi = best_fi;
+            for(long int k = -1; k <= 1; ++k){
+                if(planar && (k != 0)) continue;
+                for(long int i = -1; i <= 1; ++i){
+                    for(long int j = -1; j <= 1; ++j){
+                        if((i == 0) && (j == 0) && (k == 0)) continue;
+                        const auto l_fi = centre_fi + vec3<double>( h * static_cast<double>(i),
+                                                                    h * static_cast<double>(j),
+                                                                    h * static_cast<double>(k) );
+                        const auto dist = grid.position(l_fi).distance(pos);
+                        if((dist / DTA_thres) >= best) continue;
+
+                        const auto ref_val = grid.interpolate(l_fi);
+                        if(!std::isfinite(ref_val)) continue;
+
+                        const auto g = eval_gamma(dist, ref_val);
+                        if(g < best){
+                            best = g;
+                            best_fi = l_fi;
+                            improved = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+
 bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>> external_imgs,
                           std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -132,6 +399,60 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
         throw std::invalid_argument("Unknown discrepancy method requested. Cannot continue.");
     }
 
+    // Prepare the indexed reference grid and distance-sorted search offsets for the accelerated gamma search.
+    const bool use_accelerated_gamma = (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex)
+                                    && (user_data_s->gamma_engine == ComputeCompareImagesUserData::GammaEngine::Accelerated);
+    compare_images_ref_grid ref_grid;
+    std::vector<compare_images_search_offset> search_offsets;
+    if(use_accelerated_gamma){
+        if(external_imgs.front().get().images.empty()){
+            FUNCWARN("Reference image array contains no images. Cannot continue");
+            return false;
+        }
+        const auto ref_normal = external_imgs.front().get().images.front().image_plane().N_0.unit();
+        planar_image_adjacency<float,double> ref_adj( {}, external_imgs, ref_normal );
+        for(long int i = 0; ref_adj.index_present(i); ++i){
+            ref_grid.imgs.push_back( std::addressof( ref_adj.index_to_image(i).get() ) );
+        }
+        if(ref_grid.imgs.empty()){
+            FUNCWARN("Unable to order reference images. Cannot continue");
+            return false;
+        }
+        for(const auto &img_ptr : ref_grid.imgs){
+            if(img_ptr->channels <= ud_channel){
+                FUNCWARN("Reference images do not all support the specified channel. Cannot continue");
+                return false;
+            }
+        }
+
+        const auto &first = *(ref_grid.imgs.front());
+        ref_grid.origin   = first.position(0, 0);
+        ref_grid.row_unit = first.row_unit.unit();
+        ref_grid.col_unit = first.col_unit.unit();
+        ref_grid.img_unit = ref_normal;
+        ref_grid.pxl_dx   = first.pxl_dx;
+        ref_grid.pxl_dy   = first.pxl_dy;
+        ref_grid.pxl_dz   = first.pxl_dz;
+        if(1 < ref_grid.imgs.size()){
+            ref_grid.pxl_dz = std::abs( (ref_grid.imgs[1]->position(0, 0) - ref_grid.origin).Dot(ref_normal) );
+        }
+        ref_grid.pxl_dz   = std::max( ref_grid.pxl_dz, 10.0 * machine_eps );
+        ref_grid.rows     = first.rows;
+        ref_grid.columns  = first.columns;
+        ref_grid.channel  = ud_channel;
+        ref_grid.lower_threshold = user_data_s->ref_img_inc_lower_threshold;
+        ref_grid.upper_threshold = user_data_s->ref_img_inc_upper_threshold;
+
+        // The search can be bounded by the DTA threshold when gamma >1 need not be quantified. The half-diagonal
+        // accommodates the separation between the test voxel and the nearest reference voxel centre.
+        const auto half_diag = 0.5 * std::hypot(ref_grid.pxl_dx, ref_grid.pxl_dy, ref_grid.pxl_dz);
+        const auto search_radius = (user_data_s->gamma_terminate_when_max_exceeded)
+                                 ? std::min(user_data_s->DTA_max, user_data_s->gamma_DTA_threshold)
+                                 : user_data_s->DTA_max;
+        search_offsets = Generate_Sorted_Search_Offsets(ref_grid, search_radius + half_diag);
+        FUNCINFO("Accelerated gamma search will consider up to " << search_offsets.size() << " voxels per test voxel");
+    }
+
     Mutate_Voxels_Opts mv_opts;
     mv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
     mv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Centre;
@@ -168,6 +489,10 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
                                                                     : std::addressof(overlapping_img_refws.front().get());
             if(overlapping_img_refws.empty()) FUNCWARN("No wholly overlapping reference images found, using slower per-voxel sampling");
 
+            // Task-local gamma tallies for the accelerated search, merged after all voxels have been visited.
+            long int l_passed = 0;
+            long int l_count = 0;
+
 
             auto f_bounded = [&,img_refw](long int E_row, long int E_col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
                 if( !isininc( user_data_s->inc_lower_threshold, voxel_val, user_data_s->inc_upper_threshold) ){
@@ -246,6 +571,19 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
                     // Perform a discrepancy comparison.
                     const auto Disc = estimate_discrepancy(edit_val, ring_0_val);
 
+                    // Use the accelerated gamma search, if requested.
+                    if(use_accelerated_gamma){
+                        voxel_val = Accelerated_Gamma_Search( ref_grid, search_offsets, estimate_discrepancy,
+                                                              *user_data_s, pos, edit_val );
+                        if(std::isfinite(voxel_val)){
+                            l_count += 1;
+                            if(voxel_val < 1.0) l_passed += 1;
+                        }else{
+                            voxel_val = inaccessible_val;
+                        }
+                        break;
+                    }
+
                     // If computing the gamma index, check if we can avoid a costly DTA search.
                     if( (user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::GammaIndex) 
                     &&  (user_data_s->gamma_terminate_when_max_exceeded)
@@ -618,6 +956,12 @@ bool ComputeCompareImages(planar_image_collection<float,double> &imagecoll,
                                          mv_opts, 
                                          f_bounded );
 
+            if(use_accelerated_gamma){
+                std::lock_guard<std::mutex> lock(passing_counter);
+                user_data_s->passed += l_passed;
+                user_data_s->count += l_count;
+            }
+
             if(false){
             }else if(user_data_s->comparison_method == ComputeCompareImagesUserData::ComparisonMethod::Discrepancy){
                 UpdateImageDescription( img_refw, "Compared (discrepancy)" );
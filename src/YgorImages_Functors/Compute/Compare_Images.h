@@ -138,6 +138,26 @@ struct ComputeCompareImagesUserData {
     double gamma_terminate_when_max_exceeded = true;
     double gamma_terminated_early = std::nextafter(1.0, std::numeric_limits<double>::infinity());
 
+    // The search strategy to use for gamma comparisons.
+    //
+    // The exhaustive search grows a rectangular wavefront of reference voxels around each test voxel and interpolates
+    // only along voxel edges and in-plane diagonals.
+    //
+    // The accelerated search visits reference voxels in order of increasing distance and stops as soon as the distance
+    // term alone exceeds the best gamma found so far. The best voxel-centred candidate is then refined with a
+    // coarse-to-fine pattern search along the 26 lattice directions, sampling the reference images with on-the-fly
+    // trilinear interpolation. The accelerated search does not apply the discrepancy-based early termination, so every
+    // voxel within the inclusivity thresholds is counted towards the passing rate.
+    enum class
+    GammaEngine {
+        Exhaustive,
+        Accelerated,
+    } gamma_engine = GammaEngine::Exhaustive;
+
+    // The number of coarse-to-fine refinement levels used by the accelerated gamma search. Each level halves the
+    // sub-voxel step size, so the final step is (1/2)^levels of the reference voxel dimensions.
+    long int gamma_refinement_levels = 3;
+
     // Outgoing gamma passing counts.
     //
     // These can be read by the caller after performing a gamma analysis.
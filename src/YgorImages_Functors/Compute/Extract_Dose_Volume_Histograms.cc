@@ -2,6 +2,10 @@
 
 #include <exception>
 #include <any>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <functional>
 #include <list>
@@ -10,6 +14,8 @@
 #include <random>
 #include <ostream>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
@@ -23,6 +29,233 @@
 #include "YgorClustering.hpp"
 
 
+dvh_accumulator::dvh_accumulator(double dDose) : dDose(dDose) {}
+
+void dvh_accumulator::digest(double dose, double volume){
+    if( !std::isfinite(dose) || !(0.0 < volume) ) return;
+
+    // Find the bin such that dDose*i <= dose < dDose*(i+1), guarding against round-off in the division so that the
+    // bin edges agree exactly with the test doses reported later.
+    auto i = static_cast<long int>(std::floor(dose / this->dDose));
+    while(dose < this->dDose * static_cast<double>(i)) --i;
+    while(this->dDose * static_cast<double>(i + 1) <= dose) ++i;
+
+    // Verify the histogram would remain within bounds before allocating any bins.
+    const auto N_bins = static_cast<long int>(this->bin_volumes.size());
+    const auto lo = this->bin_volumes.empty() ? i : std::min(i, this->bin_offset);
+    const auto hi = this->bin_volumes.empty() ? (i + 1) : std::max(i + 1, this->bin_offset + N_bins);
+    if(std::max<size_t>(this->max_bins, 1) < static_cast<size_t>(hi - lo)){
+        throw std::runtime_error("Dose range is too large for the requested bin width. Cannot continue.");
+    }
+
+    if(this->bin_volumes.empty()){
+        this->bin_offset = i;
+    }
+    if(i < this->bin_offset){
+        const auto N_prepend = static_cast<size_t>(this->bin_offset - i);
+        this->bin_volumes.insert(std::begin(this->bin_volumes), N_prepend, 0.0);
+        this->bin_counts.insert(std::begin(this->bin_counts), N_prepend, 0);
+        this->bin_offset = i;
+    }else if((this->bin_offset + N_bins) <= i){
+        this->bin_volumes.resize(static_cast<size_t>(i - this->bin_offset + 1), 0.0);
+        this->bin_counts.resize(static_cast<size_t>(i - this->bin_offset + 1), 0);
+    }
+
+    const auto j = static_cast<size_t>(i - this->bin_offset);
+    this->bin_volumes[j] += volume;
+    this->bin_counts[j] += 1;
+
+    this->count += 1;
+    this->total_volume += volume;
+    this->dose_volume_sum += dose * volume;
+    this->min_dose = std::min(this->min_dose, dose);
+    this->max_dose = std::max(this->max_dose, dose);
+    return;
+}
+
+void dvh_accumulator::merge(const dvh_accumulator &other){
+    if(this->dDose != other.dDose){
+        throw std::invalid_argument("Refusing to merge histograms with differing bin widths.");
+    }
+    if(other.bin_volumes.empty()) return;
+    if(this->bin_volumes.empty()){
+        *this = other;
+        return;
+    }
+
+    const auto lo = std::min(this->bin_offset, other.bin_offset);
+    const auto hi = std::max(this->bin_offset + static_cast<long int>(this->bin_volumes.size()),
+                             other.bin_offset + static_cast<long int>(other.bin_volumes.size()));
+    if(std::max<size_t>(this->max_bins, 1) < static_cast<size_t>(hi - lo)){
+        throw std::runtime_error("Dose range is too large for the requested bin width. Cannot continue.");
+    }
+    if(lo < this->bin_offset){
+        const auto N_prepend = static_cast<size_t>(this->bin_offset - lo);
+        this->bin_volumes.insert(std::begin(this->bin_volumes), N_prepend, 0.0);
+        this->bin_counts.insert(std::begin(this->bin_counts), N_prepend, 0);
+        this->bin_offset = lo;
+    }
+    this->bin_volumes.resize(static_cast<size_t>(hi - lo), 0.0);
+    this->bin_counts.resize(static_cast<size_t>(hi - lo), 0);
+
+    const auto shift = static_cast<size_t>(other.bin_offset - lo);
+    for(size_t j = 0; j < other.bin_volumes.size(); ++j){
+        this->bin_volumes[j + shift] += other.bin_volumes[j];
+        this->bin_counts[j + shift] += other.bin_counts[j];
+    }
+
+    this->count += other.count;
+    this->total_volume += other.total_volume;
+    this->dose_volume_sum += other.dose_volume_sum;
+    this->min_dose = std::min(this->min_dose, other.min_dose);
+    this->max_dose = std::max(this->max_dose, other.max_dose);
+    return;
+}
+
+std::map<double, std::pair<double, double>> dvh_accumulator::cumulative(void) const {
+    std::map<double, std::pair<double, double>> out;
+    if(this->bin_volumes.empty()){
+        out[0.0] = std::make_pair(0.0, 0.0);
+        return out;
+    }
+
+    // The histogram always spans zero dose.
+    const auto N_bins = static_cast<long int>(this->bin_volumes.size());
+    const auto i_first = std::min(0L, this->bin_offset);
+    const auto i_last = std::max(0L, this->bin_offset + N_bins); // Exclusive; the first empty bin edge.
+
+    // Accumulate from the highest dose downward.
+    std::vector<double> cumulative_vol(static_cast<size_t>(i_last - i_first + 1), 0.0);
+    for(auto i = i_last - 1; i_first <= i; --i){
+        const auto j = i - this->bin_offset;
+        const auto bin_vol = ((0 <= j) && (j < N_bins)) ? this->bin_volumes[j] : 0.0;
+        cumulative_vol[i - i_first] = cumulative_vol[i - i_first + 1] + bin_vol;
+    }
+    for(auto i = i_first; i <= i_last; ++i){
+        const auto dose_abs = this->dDose * static_cast<double>(i);
+        const auto vol_abs = cumulative_vol[i - i_first];
+        const auto vol_rel = vol_abs / this->total_volume;
+        out[dose_abs] = std::make_pair(vol_abs, vol_rel);
+    }
+    return out;
+}
+
+
+// Estimates the fraction of each voxel's in-plane area that lies within the given contours by sampling a regular
+// sub-voxel grid. Interior sub-samples are located with scanlines, so each contour is visited once per row of
+// sub-samples. Voxel fractions are returned in row-major order, or an empty vector if no contours are relevant.
+static
+std::vector<double>
+Voxel_Coverage(const planar_image<float,double> &img,
+               const std::list<std::reference_wrapper<contour_collection<double>>> &ccsl,
+               Mutate_Voxels_Opts::ContourOverlap contouroverlap,
+               long int S){
+
+    const auto R = img.rows;
+    const auto C = img.columns;
+    const auto origin = img.position(0, 0);
+
+    // Express the relevant contours in continuous (row, column) pixel coordinates.
+    std::vector<std::vector<std::pair<double, double>>> polys;
+    std::vector<double> signed_areas;
+    double r_min = std::numeric_limits<double>::infinity();
+    double r_max = -std::numeric_limits<double>::infinity();
+    for(const auto &ccs : ccsl){
+        for(const auto &contour : ccs.get().contours){
+            if(contour.points.size() < 3) continue;
+            if(!img.encompasses_contour_of_points(contour)) continue;
+
+            polys.emplace_back();
+            for(const auto &p : contour.points){
+                const auto d = p - origin;
+                const auto r = d.Dot(img.row_unit) / img.pxl_dx;
+                const auto c = d.Dot(img.col_unit) / img.pxl_dy;
+                polys.back().emplace_back(r, c);
+                r_min = std::min(r_min, r);
+                r_max = std::max(r_max, r);
+            }
+
+            double A = 0.0;
+            const auto &poly = polys.back();
+            for(size_t i = 0; i < poly.size(); ++i){
+                const auto &a = poly[i];
+                const auto &b = poly[(i + 1) % poly.size()];
+                A += a.first * b.second - b.first * a.second;
+            }
+            signed_areas.push_back(0.5 * A);
+        }
+    }
+
+    std::vector<double> out;
+    if(polys.empty()) return out;
+    out.assign(static_cast<size_t>(R * C), 0.0);
+
+    // Sub-sample k along an axis (for all voxels) is located at pixel coordinate (k + 0.5)/S - 0.5.
+    const auto Sd = static_cast<double>(S);
+    const auto N_sub_cols = C * S;
+    const auto sub_index_at_or_above = [Sd](double x) -> long int {
+        return static_cast<long int>(std::ceil(Sd * (x + 0.5) - 0.5));
+    };
+    const auto sr_first = std::max(0L, sub_index_at_or_above(r_min));
+    const auto sr_last = std::min(R * S - 1, sub_index_at_or_above(r_max));
+    const auto sample_weight = 1.0 / (Sd * Sd);
+
+    // Overlapping contours are combined when overlap is ignored, and cancel pairwise for implicit orientations. When
+    // orientations are honoured, each contour contributes its orientation to a signed winding count and sub-samples
+    // with a positive net count are interior. Orientations are taken relative to the net orientation of all contours on
+    // the image, so the outermost contours count positively regardless of whether they wind clockwise or not.
+    const bool union_overlap = (contouroverlap == Mutate_Voxels_Opts::ContourOverlap::Ignore);
+    const bool signed_overlap = (contouroverlap == Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations);
+    double net_area = 0.0;
+    for(const auto &A : signed_areas) net_area += A;
+    std::vector<int> orientations;
+    for(const auto &A : signed_areas) orientations.push_back( ((A < 0.0) == (net_area < 0.0)) ? 1 : -1 );
+
+    std::vector<int> interior(static_cast<size_t>(N_sub_cols));
+    std::vector<double> crossings;
+    for(auto sr = sr_first; sr <= sr_last; ++sr){
+        const auto y = (static_cast<double>(sr) + 0.5) / Sd - 0.5;
+        std::fill(std::begin(interior), std::end(interior), 0);
+
+        bool any_interior = false;
+        for(size_t p = 0; p < polys.size(); ++p){
+            const auto &poly = polys[p];
+            crossings.clear();
+            const auto N = poly.size();
+            for(size_t i = 0; i < N; ++i){
+                const auto &a = poly[i];
+                const auto &b = poly[(i + 1) % N];
+                if((a.first <= y) == (b.first <= y)) continue;
+                crossings.push_back( a.second + (y - a.first) * (b.second - a.second) / (b.first - a.first) );
+            }
+            std::sort(std::begin(crossings), std::end(crossings));
+
+            for(size_t i = 0; (i + 1) < crossings.size(); i += 2){
+                const auto sc_begin = std::clamp(sub_index_at_or_above(crossings[i]), 0L, N_sub_cols);
+                const auto sc_end = std::clamp(sub_index_at_or_above(crossings[i + 1]), 0L, N_sub_cols);
+                for(auto sc = sc_begin; sc < sc_end; ++sc){
+                    if(union_overlap){
+                        interior[sc] = 1;
+                    }else if(signed_overlap){
+                        interior[sc] += orientations[p];
+                    }else{
+                        interior[sc] ^= 1;
+                    }
+                    any_interior = true;
+                }
+            }
+        }
+        if(!any_interior) continue;
+
+        double *out_row = out.data() + static_cast<size_t>((sr / S) * C);
+        for(long int sc = 0; sc < N_sub_cols; ++sc){
+            if(0 < interior[sc]) out_row[sc / S] += sample_weight;
+        }
+    }
+    return out;
+}
+
+
 bool ComputeExtractDoseVolumeHistograms(planar_image_collection<float,double> &imagecoll,
                       std::list<std::reference_wrapper<planar_image_collection<float,double>>> /*external_imgs*/,
                       std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
@@ -91,10 +324,18 @@ bool ComputeExtractDoseVolumeHistograms(planar_image_collection<float,double> &i
 
     // ----------------------------------------
 
-    std::map<std::string,                       // ROIName
-             std::pair<std::vector<float>,      // Dose/intensity samples.
-                       std::vector<float>>>     // Volume samples.
-                             named_distributions;
+    const auto dDose = user_data_s->dDose;
+    const auto supersample = user_data_s->supersample;
+    if( !std::isfinite(dDose) || (dDose <= 0.0) ){
+        FUNCWARN("Invalid dose bin width. Cannot continue with computation");
+        return false;
+    }
+    if(supersample < 1){
+        FUNCWARN("Invalid supersampling factor. Cannot continue with computation");
+        return false;
+    }
+
+    std::map<std::string, dvh_accumulator> named_dvhs; // ROIName.
 
     { // Scope for thread pool.
         asio_thread_pool tp;
@@ -117,49 +358,57 @@ bool ComputeExtractDoseVolumeHistograms(planar_image_collection<float,double> &i
 
                     // Create task-local storage (i.e., thread-local, but not actually std::thread_local_storage) that can later
                     // be merged.
-                    std::vector<float> doses;
-                    doses.reserve(100*100); // An arbitrary guess.
-                    std::vector<float> volumes;
-                    volumes.reserve(100*100); // An arbitrary guess.
-
-                    auto f_bounded = [&](long int /*E_row*/, 
-                                         long int /*E_col*/,
-                                         long int channel,
-                                         std::reference_wrapper<planar_image<float,double>> /*l_img_refw*/,
-                                         float &voxel_val) {
-
-                        // No-op if this is the wrong channel.
-                        if( (user_data_s->channel >= 0) && (channel != user_data_s->channel) ){
-                            return;
-                        }
+                    dvh_accumulator dvh(dDose);
+
+                    if(supersample == 1){
+                        auto f_bounded = [&](long int /*E_row*/, 
+                                             long int /*E_col*/,
+                                             long int channel,
+                                             std::reference_wrapper<planar_image<float,double>> /*l_img_refw*/,
+                                             float &voxel_val) {
 
-                        volumes.emplace_back(pxl_vol);
-                        doses.emplace_back(voxel_val);
-                        return;
-                    };
+                            // No-op if this is the wrong channel.
+                            if( (user_data_s->channel >= 0) && (channel != user_data_s->channel) ){
+                                return;
+                            }
 
-                    Mutate_Voxels<float,double>( img_refw,
-                                                 { img_refw },
-                                                 named_ccsl.second, 
-                                                 user_data_s->mutation_opts, 
-                                                 f_bounded );
+                            dvh.digest(voxel_val, pxl_vol);
+                            return;
+                        };
+
+                        Mutate_Voxels<float,double>( img_refw,
+                                                     { img_refw },
+                                                     named_ccsl.second, 
+                                                     user_data_s->mutation_opts, 
+                                                     f_bounded );
+
+                    }else{
+                        const auto &l_img = img_refw.get();
+                        const auto coverage = Voxel_Coverage(l_img, named_ccsl.second,
+                                                             user_data_s->mutation_opts.contouroverlap, supersample);
+                        if(!coverage.empty()){
+                            for(long int row = 0; row < l_img.rows; ++row){
+                                for(long int col = 0; col < l_img.columns; ++col){
+                                    const auto f = coverage[row * l_img.columns + col];
+                                    if(f <= 0.0) continue;
+                                    for(long int chan = 0; chan < l_img.channels; ++chan){
+                                        if( (user_data_s->channel >= 0) && (chan != user_data_s->channel) ) continue;
+                                        dvh.digest(l_img.value(row, col, chan), pxl_vol * f);
+                                    }
+                                }
+                            }
+                        }
+                    }
 
                     // If there were any voxels within the contours, merge the results.
-                    if(!doses.empty()){
+                    if(dvh.count != 0){
                         std::lock_guard<std::mutex> lock(saver_printer);
-
-                        // Ensure the vectors are instantiated for this ROI.
-                        std::reference_wrapper<std::vector<float>> dose_dist( std::ref( named_distributions[ named_ccsl.first ].first ) );
-                        std::reference_wrapper<std::vector<float>> vol_dist( std::ref( named_distributions[ named_ccsl.first ].second ) );
-
-                        dose_dist.get().insert( std::end(dose_dist.get()),
-                                                std::begin(doses),
-                                                std::end(doses) );
-
-                        vol_dist.get().insert( std::end(vol_dist.get()),
-                                               std::begin(volumes),
-                                               std::end(volumes) );
-
+                        auto dvh_it = named_dvhs.find(named_ccsl.first);
+                        if(dvh_it == named_dvhs.end()){
+                            named_dvhs.emplace(named_ccsl.first, std::move(dvh));
+                        }else{
+                            dvh_it->second.merge(dvh);
+                        }
                     }
 
                 } // Loop over all named ccs.
@@ -178,72 +427,28 @@ bool ComputeExtractDoseVolumeHistograms(planar_image_collection<float,double> &i
     }
     // Wait for the thread pool to complete.
 
-    FUNCINFO("Generated voxel distributions for " << named_distributions.size() << " distinct ROIs");
-
-    // Generate histograms from the paired dose-volume distributions.
-    {
-        for(const auto &named_dists : named_distributions){
-            const auto key = named_dists.first;
-
-            if( named_dists.second.first.size() != named_dists.second.second.size() ){
-                throw std::logic_error("Voxel dose is not in correspondence with voxel volume. Cannot continue.");
-            }
-
-            if(named_dists.second.first.empty()){
-                FUNCWARN("Asked to compute DVH when no voxels appear to have any dose. This is physically possible, but please be sure it is what you expected");
-                //Could be due to:
-                // -contours being too small (much smaller than voxel size).
-                // -dose and contours not aligning properly. Maybe due to incorrect offsets/rotations/coordinate system?
-                // -dose/contours not being present. Maybe accidentally?
-                user_data_s->dvhs[key][0.0] = std::make_pair(0.0, 0.0); //Nothing over 0Gy is delivered to any voxel (0% of volume).
-
-                user_data_s->min_dose[key]  = std::numeric_limits<double>::quiet_NaN();
-                user_data_s->mean_dose[key] = std::numeric_limits<double>::quiet_NaN();
-                user_data_s->max_dose[key]  = std::numeric_limits<double>::quiet_NaN();
-
-            }else{
-                const auto D_min = std::min( 0.0f, Stats::Min(named_dists.second.first) );
-                const auto N_vox = named_dists.second.first.size();
-                const auto N = static_cast<double>(N_vox);
-                const auto V_total = Stats::Sum(named_dists.second.second);
-
-                // Compute DVHs.
-                //
-                // TODO: Compute differential histogram instead, then convert to cumulative via samples_1D integration.
-                //       This should be *much* faster. (Is it possible with varying voxel volumes?) TODO
-                for(size_t i = 0;  ; ++i){
-                    const double test_dose = D_min + (user_data_s->dDose * static_cast<double>(i));
-                    double cumulative_vol = 0.0; // Volume of voxels.
-                    double cumulative_cnt = 0.0; // Number of voxels.
-
-                    for(size_t j = 0; j < N_vox; ++j){
-                        const auto l_dose = named_dists.second.first[j];
-                        if(l_dose >= test_dose){
-                            const auto l_vol = named_dists.second.second[j];
-                            cumulative_vol += l_vol;
-                            cumulative_cnt += 1.0;
-                        }
-                    }
-
-                    const auto dose_abs = test_dose; // No scaling.
-                    const auto vol_abs = cumulative_vol;
-                    const auto vol_rel = cumulative_vol / V_total;
-                    user_data_s->dvhs[key][dose_abs] = std::make_pair(vol_abs, vol_rel);
-                    if(cumulative_cnt < 0.5) break; // Terminate the loop if nothing will change for future iterations.
-                }
-
-                // Compute some basic statistics in case they are needed.
-                user_data_s->min_dose[key] = Stats::Min(named_dists.second.first);
-                user_data_s->max_dose[key] = Stats::Max(named_dists.second.first);
-
-                auto dose_x_vol = named_dists.second.first;
-                for(size_t i = 0; i < N_vox; ++i) dose_x_vol[i] *= named_dists.second.second[i];
-                const auto sum_dose_x_vol = Stats::Sum(dose_x_vol);
-                const auto sum_vol = Stats::Sum(named_dists.second.second);
-                user_data_s->mean_dose[key] = sum_dose_x_vol / sum_vol;
-            }
+    FUNCINFO("Generated voxel distributions for " << named_dvhs.size() << " distinct ROIs");
+
+    // Generate cumulative histograms.
+    for(const auto &named_ccsl : named_ccsls){
+        const auto key = named_ccsl.first;
+        const auto dvh_it = named_dvhs.find(key);
+        if(dvh_it == named_dvhs.end()){
+            FUNCWARN("No voxels were found within ROI '" << key << "'. A DVH will not be generated for it");
+            //Could be due to:
+            // -contours being too small (much smaller than voxel size).
+            // -dose and contours not aligning properly. Maybe due to incorrect offsets/rotations/coordinate system?
+            // -dose/contours not being present. Maybe accidentally?
+            continue;
         }
 
+        const auto &dvh = dvh_it->second;
+        user_data_s->dvhs[key] = dvh.cumulative();
+
+        // Compute some basic statistics in case they are needed.
+        user_data_s->min_dose[key] = dvh.min_dose;
+        user_data_s->max_dose[key] = dvh.max_dose;
+        user_data_s->mean_dose[key] = dvh.dose_volume_sum / dvh.total_volume;
     }
 
     FUNCINFO("Completed DVH generation for " << user_data_s->dvhs.size() << " ROIs");
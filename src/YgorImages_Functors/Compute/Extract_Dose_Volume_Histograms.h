@@ -37,6 +37,15 @@ struct ComputeExtractDoseVolumeHistogramsUserData {
     //
     double dDose = 1.0;
 
+    // -----------------------------
+    // The number of sub-samples along each in-plane voxel axis used to estimate the fraction of each voxel that lies
+    // within the ROI. Voxels are weighted by this fraction, which reduces partial-volume errors for small ROIs.
+    //
+    // Note: A value of 1 disables supersampling. Each voxel is then either fully inside or fully outside of the ROI
+    //       according to the mutation_opts inclusivity criteria.
+    //
+    long int supersample = 1;
+
     // -----------------------------
     // The channel to consider. 
     //
@@ -67,6 +76,41 @@ struct ComputeExtractDoseVolumeHistogramsUserData {
 
 };
 
+// A streaming, fixed-width dose-volume histogram.
+//
+// Doses are binned into bins of width dDose anchored at zero dose, so memory scales with the dose range rather than
+// the number of voxels. Accumulators can be filled independently (e.g., one per task) and merged afterward.
+struct dvh_accumulator {
+    double dDose = 1.0;
+
+    // Bin i covers doses [dDose*(i + bin_offset), dDose*(i + bin_offset + 1)).
+    long int bin_offset = 0;
+    std::vector<double> bin_volumes;
+    std::vector<size_t> bin_counts;
+
+    // The largest number of bins permitted (about 16 MB per accumulator). Digesting a dose that would require more bins
+    // throws rather than allocating.
+    size_t max_bins = 1'000'000;
+
+    size_t count = 0;
+    double total_volume = 0.0;
+    double dose_volume_sum = 0.0;
+    double min_dose = std::numeric_limits<double>::infinity();
+    double max_dose = -std::numeric_limits<double>::infinity();
+
+    explicit dvh_accumulator(double dDose);
+
+    // Adds a voxel with the given dose and (possibly fractional) volume. Non-finite doses and empty volumes are ignored.
+    void digest(double dose, double volume);
+
+    // Adds the contents of another accumulator, which must have the same bin width.
+    void merge(const dvh_accumulator &other);
+
+    // Produces the cumulative DVH as (dose, (absolute volume, relative volume)). The first dose is the bin edge at or
+    // below min(0, min_dose), and the last dose is the first bin edge with no voxels at or above it.
+    std::map<double, std::pair<double, double>> cumulative(void) const;
+};
+
 bool ComputeExtractDoseVolumeHistograms(planar_image_collection<float,double> &,
                           std::list<std::reference_wrapper<planar_image_collection<float,double>>>,
                           std::list<std::reference_wrapper<contour_collection<double>>>,
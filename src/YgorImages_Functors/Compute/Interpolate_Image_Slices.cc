@@ -14,6 +14,7 @@
 #include "../../Thread_Pool.h"
 #include "../Grouping/Misc_Functors.h"
 #include "../ConvenienceRoutines.h"
+#include "../Grid_Resampling.h"
 #include "Interpolate_Image_Slices.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
@@ -87,22 +88,13 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
     };
 */
 
-    // Ensure the images form a regular grid.
-    std::list<std::reference_wrapper<planar_image<float,double>>> all_imgs;
-    for(auto &img : imagecoll.images){
-        all_imgs.push_back( std::ref(img) );
-    }
-
     std::list<std::reference_wrapper<planar_image<float,double>>> reference_imgs;
     for(auto &pic_refw : external_imgs){
         for(auto &img : pic_refw.get().images){
             reference_imgs.push_back( std::ref(img) );
-            all_imgs.push_back( std::ref(img) );
         }
     }
 
-    const bool ImagesAreRectilinear = Images_Form_Rectilinear_Grid(all_imgs);
-
     if(reference_imgs.empty()){
         FUNCWARN("No images are available to interpolate. Cannot continue");
         return false;
@@ -123,7 +115,15 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
     planar_image_adjacency<float,double> img_adj( reference_imgs, {}, N_0 );
 */
 
+    // If the reference images form a rectilinear grid, images aligned with it can be resampled using precomputed
+    // per-axis interpolation tables, which avoids re-deriving the geometry for every voxel.
+    const auto ref_grid = grid_resampling::Make_Rectilinear_Grid(reference_imgs);
 
+    grid_resampling::resample_opts rs_opts;
+    rs_opts.method  = grid_resampling::kernel::Linear;
+    rs_opts.inplane = grid_resampling::extrapolation::Fill;
+    rs_opts.slices  = grid_resampling::extrapolation::Clamp;
+    rs_opts.channel = ud_channel;
 
     asio_thread_pool tp;
     std::mutex saver_printer; // Who gets to save generated contours, print to the console, and iterate the counter.
@@ -185,37 +185,14 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
             };
 
             
-            // If all images are rectilinear, then no in-plane interpolation is needed and we can avoid adjacency lookup
-            // for each voxel.
-            if(ImagesAreRectilinear){
-                const auto v_pos = img_refw.get().position(0, 0); // Pick any point...
-                identify_nearest_adjacent_neighbours(v_pos);
-
-                if( ( (nearest_below != nullptr) && (nearest_below->data.size() != img_refw.get().data.size()) )
-                ||  ( (nearest_above != nullptr) && (nearest_above->data.size() != img_refw.get().data.size()) ) ){
-                    throw std::logic_error("Non-rectilinear images found after rectilinearity check. Verify implementation.");
-                }
-
-                if(false){
-                }else if( (nearest_above != nullptr) && (nearest_below != nullptr) ){
-                    const auto N_elem = img_refw.get().data.size();
-                    for(size_t i = 0; i < N_elem; ++i){
-                        img_refw.get().data[i] = ( nearest_above->data[i] * below_dist
-                                                 + nearest_below->data[i] * above_dist ) / total_dist;  
-                    }
-
-                }else if( (nearest_above == nullptr) && (nearest_below != nullptr) ){
-                    img_refw.get().data = nearest_below->data;
-
-                }else if( (nearest_above != nullptr) && (nearest_below == nullptr) ){
-                    img_refw.get().data = nearest_above->data;
-
-                }else{
-                    std::logic_error("No neighbouring planes found. Cannot interpolate. Cannot continue.");
-                }
-
-            // If all images are NOT rectilinear, then in-plane interpolation is needed because the voxel
-            // coordinates will differ in general..
+            // If the reference images are rectilinear and this image is aligned with them, interpolation is separable
+            // and can be performed using the precomputed tables.
+            if( ref_grid
+            &&  grid_resampling::Resample_Aligned_Image(ref_grid.value(), img_refw.get(), rs_opts) ){
+                // Nothing else to do.
+
+            // Otherwise, in-plane interpolation is needed for each voxel because the voxel coordinates will differ in
+            // general.
             }else{
                 for(auto row = 0; row < N_rows; ++row){
                     for(auto col = 0; col < N_columns; ++col){
@@ -249,7 +226,7 @@ bool ComputeInterpolateImageSlices(planar_image_collection<float,double> &imagec
                             if(false){
                             }else if( (nearest_above != nullptr) && (nearest_below != nullptr) ){
                                 const auto val_a = project_and_interpolate(nearest_above,v_pos);
-                                const auto val_b = project_and_interpolate(nearest_above,v_pos);
+                                const auto val_b = project_and_interpolate(nearest_below,v_pos);
                                 newval = ( val_a * below_dist
                                          + val_b * above_dist ) / total_dist;  // Note: Not a typo! Weights should be anti-paired.
                                 
@@ -0,0 +1,314 @@
+//Connected_Components.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Connected_Components.h"
+#include "Grid_Resampling.h"
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+
+namespace connected_components {
+
+// A disjoint set forest over contiguous integer labels.
+//
+// Path halving is used during lookups, and unions always attach to the smaller root so that the root of every set is
+// its smallest member. This makes the final label numbering independent of how the volume was partitioned.
+struct disjoint_sets {
+    std::vector<uint32_t> parent;
+
+    uint32_t make_set(void){
+        const auto n = static_cast<uint32_t>(this->parent.size());
+        this->parent.push_back(n);
+        return n;
+    }
+
+    uint32_t find(uint32_t x){
+        while(this->parent[x] != x){
+            this->parent[x] = this->parent[ this->parent[x] ];
+            x = this->parent[x];
+        }
+        return x;
+    }
+
+    void unite(uint32_t a, uint32_t b){
+        a = this->find(a);
+        b = this->find(b);
+        if(a < b){
+            this->parent[b] = a;
+        }else if(b < a){
+            this->parent[a] = b;
+        }
+        return;
+    }
+};
+
+struct neighbour_offset {
+    long int dk;
+    long int dr;
+    long int dc;
+};
+
+// Returns the neighbours that precede a voxel in raster order, which are the only neighbours that will already have
+// been labelled when the voxel is visited.
+static std::vector<neighbour_offset> preceding_neighbours(connectivity conn){
+    const long int max_taxicab = (conn == connectivity::Six)      ? 1L
+                               : (conn == connectivity::Eighteen) ? 2L
+                                                                  : 3L;
+    std::vector<neighbour_offset> out;
+    for(long int dk = -1; dk <= 0; ++dk){
+        for(long int dr = -1; dr <= 1; ++dr){
+            for(long int dc = -1; dc <= 1; ++dc){
+                const bool precedes = (dk < 0)
+                                   || ((dk == 0) && (dr < 0))
+                                   || ((dk == 0) && (dr == 0) && (dc < 0));
+                if(!precedes) continue;
+                if(max_taxicab < (std::abs(dk) + std::abs(dr) + std::abs(dc))) continue;
+                out.push_back( { dk, dr, dc } );
+            }
+        }
+    }
+    return out;
+}
+
+
+label_volume
+Label_Mask(const mask_volume &mv, connectivity conn){
+    label_volume out;
+    out.rows = mv.rows;
+    out.columns = mv.columns;
+    out.slices = mv.slices;
+
+    const auto R = mv.rows;
+    const auto C = mv.columns;
+    const auto S = mv.slices;
+    if( (R <= 0) || (C <= 0) || (S <= 0) ) return out;
+
+    const auto N = static_cast<std::size_t>(R) * static_cast<std::size_t>(C) * static_cast<std::size_t>(S);
+    if(mv.mask.size() != N){
+        throw std::invalid_argument("Mask does not match the specified dimensions. Cannot continue.");
+    }
+    if( (std::numeric_limits<uint32_t>::max() / 2U) <= N ){
+        throw std::invalid_argument("Mask is too large to label. Cannot continue.");
+    }
+    out.labels.assign(N, 0U);
+
+    const auto index = [R,C](long int k, long int r, long int c) -> std::size_t {
+        return static_cast<std::size_t>((k * R + r) * C + c);
+    };
+    const auto nbrs = preceding_neighbours(conn);
+
+    // Partition the volume into slabs of contiguous slices.
+    const long int N_slabs = std::clamp<long int>(static_cast<long int>(std::thread::hardware_concurrency()), 1L, S);
+    std::vector<long int> slab_begin(N_slabs + 1);
+    for(long int s = 0; s <= N_slabs; ++s) slab_begin[s] = (S * s) / N_slabs;
+    std::vector<disjoint_sets> slab_sets(N_slabs);
+
+    // Pass 1: provisionally label each slab independently, using slab-local labels.
+    {
+        asio_thread_pool tp;
+        for(long int s = 0; s < N_slabs; ++s){
+            tp.submit_task([&,s](void) -> void {
+                auto &ds = slab_sets[s];
+                ds.make_set(); // Label 0 is reserved for the background.
+
+                const auto k_begin = slab_begin[s];
+                const auto k_end = slab_begin[s + 1];
+                for(long int k = k_begin; k < k_end; ++k){
+                    for(long int r = 0; r < R; ++r){
+                        for(long int c = 0; c < C; ++c){
+                            const auto i = index(k, r, c);
+                            if(mv.mask[i] == 0) continue;
+
+                            uint32_t l = 0U;
+                            for(const auto &n : nbrs){
+                                const auto kk = k + n.dk;
+                                const auto rr = r + n.dr;
+                                const auto cc = c + n.dc;
+                                if( (kk < k_begin) || (rr < 0) || (R <= rr) || (cc < 0) || (C <= cc) ) continue;
+
+                                const auto nl = out.labels[ index(kk, rr, cc) ];
+                                if(nl == 0U) continue;
+                                if(l == 0U){
+                                    l = nl;
+                                }else if(nl != l){
+                                    ds.unite(l, nl);
+                                }
+                            }
+                            if(l == 0U) l = ds.make_set();
+                            out.labels[i] = l;
+                        }
+                    }
+                }
+
+                // Flatten the forest so every label refers directly to its root.
+                const auto N_labels = static_cast<uint32_t>(ds.parent.size());
+                for(uint32_t l = 0; l < N_labels; ++l) ds.parent[l] = ds.find(l);
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    // Pass 2: merge labels across slab boundaries using a single forest over all slab-local labels.
+    std::vector<uint32_t> slab_offset(N_slabs + 1, 0U);
+    for(long int s = 0; s < N_slabs; ++s){
+        slab_offset[s + 1] = slab_offset[s] + static_cast<uint32_t>(slab_sets[s].parent.size());
+    }
+    disjoint_sets global;
+    global.parent.resize(slab_offset.back());
+    for(long int s = 0; s < N_slabs; ++s){
+        const auto &p = slab_sets[s].parent;
+        for(std::size_t l = 0; l < p.size(); ++l) global.parent[slab_offset[s] + l] = slab_offset[s] + p[l];
+    }
+
+    for(long int s = 1; s < N_slabs; ++s){
+        const auto k = slab_begin[s];
+        for(long int r = 0; r < R; ++r){
+            for(long int c = 0; c < C; ++c){
+                const auto l = out.labels[ index(k, r, c) ];
+                if(l == 0U) continue;
+                for(const auto &n : nbrs){
+                    if(n.dk != -1L) continue;
+                    const auto rr = r + n.dr;
+                    const auto cc = c + n.dc;
+                    if( (rr < 0) || (R <= rr) || (cc < 0) || (C <= cc) ) continue;
+
+                    const auto nl = out.labels[ index(k - 1L, rr, cc) ];
+                    if(nl == 0U) continue;
+                    global.unite(slab_offset[s] + l, slab_offset[s - 1] + nl);
+                }
+            }
+        }
+    }
+
+    // Pass 3: assign compact labels. Since roots are the smallest members, components are numbered in the raster order
+    // of their first voxel.
+    std::vector<uint32_t> final_label(global.parent.size(), 0U);
+    uint32_t N_components = 0U;
+    for(long int s = 0; s < N_slabs; ++s){
+        for(uint32_t g = slab_offset[s] + 1U; g < slab_offset[s + 1]; ++g){
+            const auto root = global.find(g);
+            if(final_label[root] == 0U) final_label[root] = ++N_components;
+            final_label[g] = final_label[root];
+        }
+    }
+
+    {
+        asio_thread_pool tp;
+        for(long int s = 0; s < N_slabs; ++s){
+            tp.submit_task([&,s](void) -> void {
+                const auto i_begin = index(slab_begin[s], 0L, 0L);
+                const auto i_end = index(slab_begin[s + 1], 0L, 0L);
+                const auto offset = slab_offset[s];
+                for(auto i = i_begin; i < i_end; ++i){
+                    auto &l = out.labels[i];
+                    if(l != 0U) l = final_label[offset + l];
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    // Gather per-component statistics.
+    out.components.resize(N_components);
+    for(uint32_t l = 0; l < N_components; ++l) out.components[l].label = l + 1U;
+    for(long int k = 0; k < S; ++k){
+        for(long int r = 0; r < R; ++r){
+            for(long int c = 0; c < C; ++c){
+                const auto l = out.labels[ index(k, r, c) ];
+                if(l == 0U) continue;
+
+                auto &comp = out.components[l - 1U];
+                ++comp.voxels;
+                comp.index_min[0] = std::min(comp.index_min[0], r);
+                comp.index_min[1] = std::min(comp.index_min[1], c);
+                comp.index_min[2] = std::min(comp.index_min[2], k);
+                comp.index_max[0] = std::max(comp.index_max[0], r);
+                comp.index_max[1] = std::max(comp.index_max[1], c);
+                comp.index_max[2] = std::max(comp.index_max[2], k);
+            }
+        }
+    }
+    return out;
+}
+
+
+mask_volume
+Threshold_Mask(const grid_resampling::rectilinear_grid &grid, long int channel, double lower, double upper){
+    if( (channel < 0) || (grid.channels <= channel) ){
+        throw std::invalid_argument("Requested channel is not present. Cannot continue.");
+    }
+
+    mask_volume out;
+    out.rows = grid.rows;
+    out.columns = grid.columns;
+    out.slices = grid.slices();
+    const auto N_per_slice = static_cast<std::size_t>(out.rows) * static_cast<std::size_t>(out.columns);
+    out.mask.assign(N_per_slice * static_cast<std::size_t>(out.slices), 0);
+
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < out.slices; ++k){
+            tp.submit_task([&,k](void) -> void {
+                const auto &data = grid.imgs[k]->data;
+                const auto N_chns = static_cast<std::size_t>(grid.channels);
+                uint8_t *m = out.mask.data() + N_per_slice * static_cast<std::size_t>(k);
+                for(std::size_t i = 0; i < N_per_slice; ++i){
+                    const double v = data[i * N_chns + static_cast<std::size_t>(channel)];
+                    m[i] = ((lower <= v) && (v <= upper)) ? 1 : 0; // NaNs fail both comparisons.
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    return out;
+}
+
+
+label_volume
+Label_Components(const grid_resampling::rectilinear_grid &grid,
+                 long int channel,
+                 double lower,
+                 double upper,
+                 connectivity conn){
+
+    auto out = Label_Mask( Threshold_Mask(grid, channel, lower, upper), conn );
+
+    // Add the physical volume and centroid of each component.
+    const auto R = out.rows;
+    const auto C = out.columns;
+    const auto S = out.slices;
+    std::vector<vec3<double>> weighted_sum(out.components.size(), vec3<double>(0.0, 0.0, 0.0));
+    for(long int k = 0; k < S; ++k){
+        const auto voxel_volume = grid.pxl_dx * grid.pxl_dy * grid.imgs[k]->pxl_dz;
+        const auto slice_pos = grid.origin + grid.img_unit * grid.slice_offsets[k];
+        for(long int r = 0; r < R; ++r){
+            const auto row_pos = slice_pos + grid.row_unit * (grid.pxl_dx * static_cast<double>(r));
+            for(long int c = 0; c < C; ++c){
+                const auto l = out.labels[ static_cast<std::size_t>((k * R + r) * C + c) ];
+                if(l == 0U) continue;
+
+                const auto pos = row_pos + grid.col_unit * (grid.pxl_dy * static_cast<double>(c));
+                out.components[l - 1U].volume += voxel_volume;
+                weighted_sum[l - 1U] += pos * voxel_volume;
+            }
+        }
+    }
+    for(std::size_t i = 0; i < out.components.size(); ++i){
+        auto &comp = out.components[i];
+        if(0.0 < comp.volume) comp.centroid = weighted_sum[i] * (1.0 / comp.volume);
+    }
+    return out;
+}
+
+} // namespace connected_components
+
@@ -0,0 +1,84 @@
+//Connected_Components.h.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+#include "Grid_Resampling.h"
+
+
+// This module labels connected components in 3D voxel masks.
+//
+// Labelling is performed with a union-find (disjoint set) structure. The volume is partitioned into slabs of
+// contiguous slices which are labelled concurrently, after which labels that touch across slab boundaries are merged.
+// The result is a dense label volume and per-component statistics, all computed in a linear number of operations.
+namespace connected_components {
+
+enum class connectivity {
+    Six,          // Voxels sharing a face.
+    Eighteen,     // Voxels sharing a face or an edge.
+    TwentySix,    // Voxels sharing a face, an edge, or a corner.
+};
+
+// A mask volume. Voxels are stored slice-major, then row-major: index = (slice * rows + row) * columns + column.
+// Nonzero bytes mark foreground voxels.
+struct mask_volume {
+    long int rows = 0;
+    long int columns = 0;
+    long int slices = 0;
+    std::vector<uint8_t> mask;
+};
+
+struct component {
+    uint32_t label = 0;
+    std::size_t voxels = 0;
+
+    // Physical properties. These are only available when the labels were derived from images.
+    double volume = 0.0;                   // In DICOM units (mm^3).
+    vec3<double> centroid;                 // The mean position of voxel centres, weighted by voxel volume.
+
+    // Inclusive bounding box in (row, column, slice) index space.
+    std::array<long int, 3> index_min = {{ std::numeric_limits<long int>::max(),
+                                           std::numeric_limits<long int>::max(),
+                                           std::numeric_limits<long int>::max() }};
+    std::array<long int, 3> index_max = {{ -1L, -1L, -1L }};
+};
+
+struct label_volume {
+    long int rows = 0;
+    long int columns = 0;
+    long int slices = 0;
+
+    // Labels share the mask's layout. Background voxels are labelled 0, components are labelled 1, 2, 3, etc.
+    std::vector<uint32_t> labels;
+
+    // Component statistics, where components[i].label == i + 1.
+    std::vector<component> components;
+};
+
+// Labels the components of a mask. Only voxel counts and bounding boxes are computed.
+label_volume
+Label_Mask(const mask_volume &mv, connectivity conn);
+
+// Creates a mask from a rectilinear image volume. Voxels with values within [lower, upper] (inclusive) in the given
+// channel are foreground. NaNs are always background.
+mask_volume
+Threshold_Mask(const grid_resampling::rectilinear_grid &grid, long int channel, double lower, double upper);
+
+// Labels the components of a rectilinear image volume, including physical volumes and centroids.
+label_volume
+Label_Components(const grid_resampling::rectilinear_grid &grid,
+                 long int channel,
+                 double lower,
+                 double upper,
+                 connectivity conn);
+
+} // namespace connected_components
+
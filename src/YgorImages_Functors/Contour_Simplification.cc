@@ -0,0 +1,351 @@
+//Contour_Simplification.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Contour_Simplification.h"
+#include "YgorMath.h"
+
+
+namespace contour_simplification {
+
+namespace {
+
+constexpr auto npos = std::numeric_limits<size_t>::max();
+
+struct pt2 {
+    double x = 0.0;
+    double y = 0.0;
+};
+
+// Twice the signed area of the triangle (a, b, c).
+double orient(const pt2 &a, const pt2 &b, const pt2 &c){
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Assumes c is collinear with segment (a, b).
+bool within_bounds(const pt2 &a, const pt2 &b, const pt2 &c){
+    return (std::min(a.x, b.x) <= c.x) && (c.x <= std::max(a.x, b.x))
+        && (std::min(a.y, b.y) <= c.y) && (c.y <= std::max(a.y, b.y));
+}
+
+// Whether closed segments (a, b) and (c, d) share any point.
+bool segments_intersect(const pt2 &a, const pt2 &b, const pt2 &c, const pt2 &d){
+    const auto d1 = orient(c, d, a);
+    const auto d2 = orient(c, d, b);
+    const auto d3 = orient(a, b, c);
+    const auto d4 = orient(a, b, d);
+    if( ( ((0.0 < d1) && (d2 < 0.0)) || ((d1 < 0.0) && (0.0 < d2)) )
+    &&  ( ((0.0 < d3) && (d4 < 0.0)) || ((d3 < 0.0) && (0.0 < d4)) ) ){
+        return true;
+    }
+    return ( (d1 == 0.0) && within_bounds(c, d, a) )
+        || ( (d2 == 0.0) && within_bounds(c, d, b) )
+        || ( (d3 == 0.0) && within_bounds(a, b, c) )
+        || ( (d4 == 0.0) && within_bounds(a, b, d) );
+}
+
+
+// A binary min-heap of vertex costs that tracks where each vertex resides, so arbitrary vertices can be re-ranked or
+// withdrawn in O(log n).
+class indexed_min_heap {
+    std::vector<size_t> heap; // Vertex indices.
+    std::vector<size_t> pos;  // Position of each vertex within the heap, or npos if absent.
+    std::vector<double> cost;
+
+    bool less(size_t i, size_t j) const {
+        return (this->cost[this->heap[i]] < this->cost[this->heap[j]]);
+    }
+    void swap_entries(size_t i, size_t j){
+        std::swap(this->heap[i], this->heap[j]);
+        this->pos[this->heap[i]] = i;
+        this->pos[this->heap[j]] = j;
+    }
+    void sift_up(size_t i){
+        while(0 < i){
+            const auto parent = (i - 1) / 2;
+            if(!this->less(i, parent)) break;
+            this->swap_entries(i, parent);
+            i = parent;
+        }
+    }
+    void sift_down(size_t i){
+        const auto N = this->heap.size();
+        while(true){
+            const auto l = 2 * i + 1;
+            const auto r = l + 1;
+            auto m = i;
+            if((l < N) && this->less(l, m)) m = l;
+            if((r < N) && this->less(r, m)) m = r;
+            if(m == i) break;
+            this->swap_entries(i, m);
+            i = m;
+        }
+    }
+
+  public:
+    explicit indexed_min_heap(size_t N) : pos(N, npos), cost(N, 0.0) {
+        this->heap.reserve(N);
+    }
+
+    bool empty() const {
+        return this->heap.empty();
+    }
+    size_t top() const {
+        return this->heap.front();
+    }
+    double cost_of(size_t v) const {
+        return this->cost[v];
+    }
+
+    // Inserts the vertex, or re-ranks it if already present.
+    void set(size_t v, double c){
+        this->cost[v] = c;
+        if(this->pos[v] == npos){
+            this->pos[v] = this->heap.size();
+            this->heap.emplace_back(v);
+        }
+        this->sift_up(this->pos[v]);
+        this->sift_down(this->pos[v]);
+    }
+
+    void remove(size_t v){
+        const auto i = this->pos[v];
+        if(i == npos) return;
+        const auto last = this->heap.size() - 1;
+        if(i != last) this->swap_entries(i, last);
+        this->heap.pop_back();
+        this->pos[v] = npos;
+        if(i != last){
+            this->sift_up(i);
+            this->sift_down(i);
+        }
+    }
+};
+
+
+// A sparse uniform grid of contour edges. Each edge is recorded in every cell it passes through. Edges that vanish due
+// to simplification are not purged eagerly; callers recognize stale entries and purge them during queries.
+class edge_grid {
+    using cell_t = std::vector<std::pair<size_t,size_t>>;
+
+    double cell = 1.0;
+    std::unordered_map<uint64_t, cell_t> cells;
+
+    int64_t index(double x) const {
+        return static_cast<int64_t>(std::floor(x / this->cell));
+    }
+    static uint64_t key(int64_t i, int64_t j){
+        return (static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) | static_cast<uint64_t>(static_cast<uint32_t>(j));
+    }
+
+    // Visits every cell that the segment passes through, column by column.
+    template <class F>
+    void visit_cells(pt2 a, pt2 b, bool create, F f){
+        if(b.x < a.x) std::swap(a, b);
+        const auto eps = 1.0E-6 * this->cell;
+        const auto i_lo = this->index(a.x);
+        const auto i_hi = this->index(b.x);
+        const auto dx = b.x - a.x;
+        for(auto i = i_lo; i <= i_hi; ++i){
+            double y0 = a.y;
+            double y1 = b.y;
+            if(0.0 < dx){
+                const auto x0 = (i == i_lo) ? a.x : static_cast<double>(i) * this->cell;
+                const auto x1 = (i == i_hi) ? b.x : static_cast<double>(i + 1) * this->cell;
+                y0 = a.y + (b.y - a.y) * ((x0 - a.x) / dx);
+                y1 = a.y + (b.y - a.y) * ((x1 - a.x) / dx);
+            }
+            const auto j_lo = this->index(std::min(y0, y1) - eps);
+            const auto j_hi = this->index(std::max(y0, y1) + eps);
+            for(auto j = j_lo; j <= j_hi; ++j){
+                if(create){
+                    f(this->cells[key(i, j)]);
+                }else{
+                    auto it = this->cells.find(key(i, j));
+                    if(it != std::end(this->cells)) f(it->second);
+                }
+            }
+        }
+    }
+
+  public:
+    // Cells should be comparable in size to the edges they hold.
+    explicit edge_grid(double cell_size) : cell(cell_size) {}
+
+    void insert(const std::vector<pt2> &pts, size_t u, size_t v){
+        this->visit_cells(pts[u], pts[v], true, [&](cell_t &c){
+            c.emplace_back(u, v);
+        });
+    }
+
+    template <class F>
+    void query(const pt2 &a, const pt2 &b, F f){
+        this->visit_cells(a, b, false, f);
+    }
+};
+
+} // namespace
+
+
+contour_of_points<double>
+Simplify_Visvalingam(const contour_of_points<double> &c,
+                     const parameters &p){
+
+    std::vector<vec3<double>> verts(std::begin(c.points), std::end(c.points));
+    const auto N = verts.size();
+    const size_t min_verts = (c.closed) ? 3 : 2;
+    if(N <= min_verts) return c;
+
+    // Project into the plane of the contour. Newell's method provides a normal that is robust to concavities.
+    vec3<double> normal(0.0, 0.0, 0.0);
+    for(size_t i = 0; i < N; ++i){
+        normal += verts[i].Cross(verts[(i + 1) % N]);
+    }
+    normal = normal.unit();
+    if(!normal.isfinite()) normal = vec3<double>(0.0, 0.0, 1.0);
+    auto u_axis = (std::abs(normal.x) < 0.9) ? normal.Cross(vec3<double>(1.0, 0.0, 0.0))
+                                             : normal.Cross(vec3<double>(0.0, 1.0, 0.0));
+    u_axis = u_axis.unit();
+    const auto v_axis = normal.Cross(u_axis).unit();
+
+    std::vector<pt2> pts;
+    pts.reserve(N);
+    for(const auto &v : verts) pts.push_back( { u_axis.Dot(v), v_axis.Dot(v) } );
+
+    // Doubly-linked list of surviving vertices.
+    std::vector<size_t> prev(N);
+    std::vector<size_t> next(N);
+    std::vector<uint8_t> alive(N, 1);
+    for(size_t i = 0; i < N; ++i){
+        prev[i] = (i == 0) ? ((c.closed) ? N - 1 : npos) : i - 1;
+        next[i] = (i + 1 == N) ? ((c.closed) ? 0 : npos) : i + 1;
+    }
+
+    const auto is_removable = [&](size_t v) -> bool {
+        return (prev[v] != npos) && (next[v] != npos);
+    };
+    const auto area = [&](size_t v) -> double {
+        return 0.5 * std::abs( orient(pts[prev[v]], pts[v], pts[next[v]]) );
+    };
+
+    // Whether every vertex between the neighbours of v, including v and any vertices removed earlier, would lie within
+    // the maximum deviation of the chord joining the neighbours. Checking the whole span ensures the bound holds for
+    // the simplified contour as a whole, not merely for each chord at the time of removal.
+    const auto within_deviation = [&](size_t v) -> bool {
+        if(!std::isfinite(p.max_deviation)) return true;
+        const auto &a = pts[prev[v]];
+        const auto &b = pts[next[v]];
+        const auto dx = b.x - a.x;
+        const auto dy = b.y - a.y;
+        const auto chord_sq = dx * dx + dy * dy;
+        const auto max_sq = p.max_deviation * p.max_deviation;
+        for(auto i = (prev[v] + 1) % N; i != next[v]; i = (i + 1) % N){
+            auto t = (0.0 < chord_sq) ? ((pts[i].x - a.x) * dx + (pts[i].y - a.y) * dy) / chord_sq : 0.0;
+            t = std::clamp(t, 0.0, 1.0);
+            const auto ex = pts[i].x - (a.x + t * dx);
+            const auto ey = pts[i].y - (a.y + t * dy);
+            if(max_sq < (ex * ex + ey * ey)) return false;
+        }
+        return true;
+    };
+
+    // The edge grid is rebuilt whenever the number of vertices halves, so cells track the growing edge lengths.
+    std::optional<edge_grid> grid;
+    size_t grid_verts = 0;
+    const auto build_grid = [&](size_t remaining) -> void {
+        double total_length = 0.0;
+        size_t count = 0;
+        for(size_t i = 0; i < N; ++i){
+            if( (alive[i] == 0) || (next[i] == npos) ) continue;
+            total_length += std::hypot(pts[next[i]].x - pts[i].x, pts[next[i]].y - pts[i].y);
+            ++count;
+        }
+        const auto mean_length = (0 < count) ? total_length / static_cast<double>(count) : 0.0;
+        grid.emplace( (0.0 < mean_length) ? 2.0 * mean_length : 1.0 );
+        for(size_t i = 0; i < N; ++i){
+            if( (alive[i] != 0) && (next[i] != npos) ) grid->insert(pts, i, next[i]);
+        }
+        grid_verts = remaining;
+    };
+    if(p.prevent_self_intersection) build_grid(N);
+
+    // Whether replacing the vertex by the chord joining its neighbours would cross any other edge.
+    const auto chord_intersects = [&](size_t v) -> bool {
+        const auto a = prev[v];
+        const auto b = next[v];
+        bool intersects = false;
+        grid->query(pts[a], pts[b], [&](std::vector<std::pair<size_t,size_t>> &cell){
+            for(size_t i = 0; (i < cell.size()) && !intersects; ){
+                const auto s = cell[i].first;
+                const auto t = cell[i].second;
+                if( (alive[s] == 0) || (alive[t] == 0) || (next[s] != t) ){
+                    // Purge stale entries as they are encountered.
+                    cell[i] = cell.back();
+                    cell.pop_back();
+                    continue;
+                }
+                ++i;
+                if( (s == a) || (s == b) || (s == v) || (t == a) || (t == b) || (t == v) ) continue; // Adjacent.
+                intersects = segments_intersect(pts[a], pts[b], pts[s], pts[t]);
+            }
+        });
+        return intersects;
+    };
+
+    indexed_min_heap heap(N);
+    for(size_t i = 0; i < N; ++i){
+        if(is_removable(i)) heap.set(i, area(i));
+    }
+
+    double total = 0.0;
+    size_t remaining = N;
+    while( !heap.empty() && (min_verts < remaining) ){
+        const auto v = heap.top();
+        const auto cost = heap.cost_of(v);
+        if(p.area_tolerance < (total + cost)) break;
+
+        // Vertices that cannot currently be removed are withdrawn. They are reconsidered whenever a neighbour is
+        // removed, since that alters their cost and surroundings.
+        heap.remove(v);
+        if(!within_deviation(v)) continue;
+        if(p.prevent_self_intersection && chord_intersects(v)) continue;
+
+        const auto a = prev[v];
+        const auto b = next[v];
+        alive[v] = 0;
+        next[a] = b;
+        prev[b] = a;
+        total += cost;
+        --remaining;
+        if(p.prevent_self_intersection){
+            if(2 * remaining <= grid_verts){
+                build_grid(remaining);
+            }else{
+                grid->insert(pts, a, b);
+            }
+        }
+
+        for(const auto &n : { a, b }){
+            if(is_removable(n)) heap.set(n, area(n));
+        }
+    }
+
+    contour_of_points<double> out(c);
+    out.points.clear();
+    for(size_t i = 0; i < N; ++i){
+        if(alive[i] != 0) out.points.emplace_back(verts[i]);
+    }
+    return out;
+}
+
+} // namespace contour_simplification
+
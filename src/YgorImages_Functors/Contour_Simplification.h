@@ -0,0 +1,42 @@
+//Contour_Simplification.h.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+#include "YgorMath.h"
+
+
+// This module simplifies planar contours by removing vertices, following Visvalingam and Whyatt.
+//
+// Each vertex is assigned a cost, the area of the triangle it forms with its current neighbours, and the least costly
+// vertex is repeatedly removed. Costs are kept in an indexed min-heap so that only the two neighbours of a removed
+// vertex need to be re-ranked, which makes simplification O(n log n) in the number of vertices. Removals that would
+// cause a contour to intersect itself are detected using a uniform grid of edges and are deferred until a neighbouring
+// removal changes the vertex's surroundings.
+namespace contour_simplification {
+
+struct parameters {
+    // The maximum total area that simplification may add or remove. Each removal contributes the area of the triangle
+    // that the vertex formed with its neighbours, so this bounds the area of the region between the original and
+    // simplified contours.
+    double area_tolerance = 0.0;
+
+    // The maximum distance between any removed vertex and the simplified contour. Each removal is checked against
+    // every original vertex that the new chord replaces, including those removed earlier, so the bound holds for the
+    // final contour. This check is proportional to the number of vertices spanned, so it is skipped when unbounded.
+    double max_deviation = std::numeric_limits<double>::infinity();
+
+    // Whether to reject removals that would cause the contour to intersect itself.
+    bool prevent_self_intersection = true;
+};
+
+// Returns a simplified copy of the contour. Vertices are only removed, never moved, and metadata is retained.
+// Endpoints of open contours are never removed, and closed contours retain at least three vertices.
+contour_of_points<double>
+Simplify_Visvalingam(const contour_of_points<double> &c,
+                     const parameters &p);
+
+} // namespace contour_simplification
+
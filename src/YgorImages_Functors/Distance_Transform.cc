@@ -0,0 +1,217 @@
+//Distance_Transform.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Connected_Components.h"
+#include "Distance_Transform.h"
+
+
+namespace distance_transform {
+
+namespace {
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+// The cost of a displacement d along one axis is kn*d^2 for d < 0 and kp*d^2 for d > 0. A direction with zero extent
+// has an infinite coefficient, so any displacement in that direction is unreachable.
+struct axis_cost {
+    double kn = 0.0;
+    double kp = 0.0;
+
+    double operator()(double d) const {
+        if(d == 0.0) return 0.0;
+        return (d < 0.0) ? this->kn * d * d : this->kp * d * d;
+    }
+};
+
+axis_cost make_axis_cost(const axis_extent &e, double spacing){
+    const auto k = [&](double extent) -> double {
+        if(!std::isfinite(extent) || (extent < 0.0)){
+            throw std::invalid_argument("Structuring element extents must be finite and non-negative");
+        }
+        // Work in units of voxels so the envelope arithmetic involves modest numbers.
+        const auto e_vox = extent / spacing;
+        return (0.0 < e_vox) ? 1.0 / (e_vox * e_vox) : inf;
+    };
+    return { k(e.negative), k(e.positive) };
+}
+
+// Returns the position s at which the cost centred at q2 takes over from the cost centred at q1, where q1 < q2 and both
+// offsets are finite. The cost centred at q2 is no greater for all x >= s. Since the cost is convex, the difference
+// between the two is monotonic in x and there is a single crossing.
+double intersection(const axis_cost &f, double q1, double g1, double q2, double g2){
+    const auto L = q2 - q1;
+    const auto G = g2 - g1;
+
+    // Left of both centres only the negative branches are involved, and right of both only the positive branches are.
+    // In both cases the difference is linear in x. Neither case can arise when the relevant branch is infinite.
+    const auto h_q1 = g1 - (f(q1 - q2) + g2);
+    if(0.0 <= h_q1){
+        return 0.5 * (q1 + q2) + G / (2.0 * f.kn * L);
+    }
+    const auto h_q2 = (f(L) + g1) - g2;
+    if(h_q2 < 0.0){
+        return 0.5 * (q1 + q2) + G / (2.0 * f.kp * L);
+    }
+
+    // Between the centres the positive branch of q1 meets the negative branch of q2. If either is infinite, the
+    // crossing occurs immediately beside the corresponding centre.
+    if(!std::isfinite(f.kp)) return std::nextafter(q1, inf);
+    if(!std::isfinite(f.kn)) return q2;
+
+    //   kp*u^2 - kn*(L - u)^2 = G  where u = x - q1 lies within [0, L].
+    const auto a = f.kp - f.kn;
+    const auto b = 2.0 * f.kn * L;
+    const auto c = -(f.kn * L * L + G);
+    double u = 0.0;
+    if(std::abs(a) <= 1.0E-12 * std::max(f.kp, f.kn)){
+        u = -c / b;
+    }else{
+        const auto disc = std::max(0.0, b * b - 4.0 * a * c);
+        const auto t = -0.5 * (b + std::sqrt(disc)); // b is positive, so this avoids cancellation.
+        const auto u1 = t / a;
+        const auto u2 = (t != 0.0) ? c / t : u1;
+        const auto in_range = [&](double v){ return (-1.0E-9 * L <= v) && (v <= L * (1.0 + 1.0E-9)); };
+        u = in_range(u1) ? u1 : u2;
+    }
+    return q1 + std::clamp(u, 0.0, L);
+}
+
+// Computes out[i] = min_j ( f(i - j) + in[j] ) over a line of N samples using the lower envelope of the translated
+// cost functions. Samples with infinite input do not contribute. Scratch buffers are supplied by the caller.
+void transform_line(const axis_cost &f,
+                    const double *in,
+                    double *out,
+                    long int N,
+                    std::vector<long int> &v,
+                    std::vector<double> &z){
+    v.resize(N);
+    z.resize(N + 1);
+
+    long int k = -1;
+    for(long int q = 0; q < N; ++q){
+        const auto gq = in[q];
+        if(!std::isfinite(gq)) continue;
+        if(k < 0){
+            k = 0;
+            v[0] = q;
+            z[0] = -inf;
+            z[1] = inf;
+            continue;
+        }
+        // The first envelope segment extends to negative infinity, so the new centre always survives.
+        auto s = intersection(f, static_cast<double>(v[k]), in[v[k]], static_cast<double>(q), gq);
+        while(s <= z[k]){
+            --k;
+            s = intersection(f, static_cast<double>(v[k]), in[v[k]], static_cast<double>(q), gq);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = inf;
+    }
+
+    if(k < 0){
+        std::fill(out, out + N, inf);
+        return;
+    }
+    long int j = 0;
+    for(long int i = 0; i < N; ++i){
+        const auto x = static_cast<double>(i);
+        while(z[j + 1] <= x) ++j;
+        out[i] = f(x - static_cast<double>(v[j])) + in[v[j]];
+    }
+}
+
+} // namespace
+
+
+std::vector<float>
+Anisotropic_Distance_Transform(const connected_components::mask_volume &mv,
+                               const std::array<double,3> &spacing,
+                               const std::array<axis_extent,3> &extents){
+    const long int C = mv.columns;
+    const long int R = mv.rows;
+    const long int S = mv.slices;
+    if( (C <= 0) || (R <= 0) || (S <= 0) ){
+        throw std::invalid_argument("Mask volume is empty");
+    }
+    const auto N = static_cast<std::size_t>(C) * static_cast<std::size_t>(R) * static_cast<std::size_t>(S);
+    if(mv.mask.size() != N){
+        throw std::invalid_argument("Mask volume dimensions are inconsistent");
+    }
+    for(const auto &d : spacing){
+        if(!std::isfinite(d) || (d <= 0.0)){
+            throw std::invalid_argument("Voxel spacing must be finite and positive");
+        }
+    }
+    const std::array<axis_cost,3> costs = {{ make_axis_cost(extents[0], spacing[0]),
+                                             make_axis_cost(extents[1], spacing[1]),
+                                             make_axis_cost(extents[2], spacing[2]) }};
+
+    std::vector<double> vals(N);
+    for(std::size_t i = 0; i < N; ++i) vals[i] = (mv.mask[i] != 0) ? 0.0 : inf;
+
+    // Each pass transforms every line along one axis. Lines are gathered into contiguous buffers so that strided axes
+    // can share the same implementation.
+    const auto pass = [&](const axis_cost &f,
+                          long int N_line,         // Number of samples along the line.
+                          std::size_t stride,      // Distance between samples along the line.
+                          long int N_outer,        // Number of line groups, each handled by one task.
+                          std::size_t outer_stride,
+                          long int N_inner,        // Number of lines in each group.
+                          std::size_t inner_stride) -> void {
+        std::vector<std::exception_ptr> errors(N_outer);
+        {
+            asio_thread_pool tp;
+            for(long int o = 0; o < N_outer; ++o){
+                tp.submit_task([&,o](void) -> void {
+                    try{
+                        std::vector<double> in(N_line);
+                        std::vector<double> out(N_line);
+                        std::vector<long int> v;
+                        std::vector<double> z;
+                        for(long int l = 0; l < N_inner; ++l){
+                            const auto base = outer_stride * static_cast<std::size_t>(o)
+                                            + inner_stride * static_cast<std::size_t>(l);
+                            for(long int i = 0; i < N_line; ++i) in[i] = vals[base + stride * static_cast<std::size_t>(i)];
+                            transform_line(f, in.data(), out.data(), N_line, v, z);
+                            for(long int i = 0; i < N_line; ++i) vals[base + stride * static_cast<std::size_t>(i)] = out[i];
+                        }
+                    }catch(const std::exception &){
+                        errors[o] = std::current_exception();
+                    }
+                }); // thread pool task closure.
+            }
+        } // Wait for all tasks to complete.
+        for(const auto &e : errors){
+            if(e) std::rethrow_exception(e);
+        }
+    };
+
+    const auto slice_size = static_cast<std::size_t>(R) * static_cast<std::size_t>(C);
+    const auto row_size = static_cast<std::size_t>(C);
+
+    // Along columns and rows, each task handles one slice. Along slices, each task handles one row of lines.
+    pass(costs[0], C, 1, S, slice_size, R, row_size);
+    pass(costs[1], R, row_size, S, slice_size, C, 1);
+    if(1 < S) pass(costs[2], S, slice_size, R, row_size, C, 1);
+
+    std::vector<float> out(N);
+    for(std::size_t i = 0; i < N; ++i){
+        out[i] = std::isfinite(vals[i]) ? static_cast<float>(vals[i]) : std::numeric_limits<float>::infinity();
+    }
+    return out;
+}
+
+} // namespace distance_transform
+
@@ -0,0 +1,46 @@
+//Distance_Transform.h.
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Connected_Components.h"
+
+
+// This module computes exact, anisotropic Euclidean distance transforms of 3D voxel masks.
+//
+// The transform is separable: a 1D transform is applied along columns, then rows, then slices. Each 1D transform
+// computes the lower envelope of parabolas (following Felzenszwalb and Huttenlocher) and so requires a linear number
+// of operations. Lines are processed concurrently.
+//
+// Distances are measured relative to a structuring element whose extent may differ along each axis and in each
+// direction, i.e., an ellipsoid with a separate semi-axis in each octant. This permits margins that differ, for
+// example, superiorly and inferiorly.
+namespace distance_transform {
+
+// The extent of the structuring element along an axis. 'negative' is the reach towards decreasing indices and
+// 'positive' towards increasing indices. Extents are in DICOM units and must be non-negative.
+struct axis_extent {
+    double negative = 0.0;
+    double positive = 0.0;
+};
+
+// Computes, for every voxel p, the minimum over foreground voxels q of
+//
+//     sum over axes of ( (p - q)_axis / extent_axis )^2,
+//
+// where displacements are physical (i.e., index differences multiplied by spacing) and the extent for each axis is
+// selected by the sign of the displacement. Voxels with values <= 1 are therefore within the dilation of the mask by
+// the structuring element. The square root of the value is a normalized distance.
+//
+// Spacing and extents are ordered column, row, slice. Along an axis with zero extent in some direction, the mask does
+// not spread in that direction. Voxels that cannot be reached from any foreground voxel are assigned infinity. Values
+// share the mask's layout.
+std::vector<float>
+Anisotropic_Distance_Transform(const connected_components::mask_volume &mv,
+                               const std::array<double,3> &spacing,
+                               const std::array<axis_extent,3> &extents);
+
+} // namespace distance_transform
+
@@ -0,0 +1,193 @@
+//Dose_Transform.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include "Dose_Transform.h"
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+namespace dose_transform {
+
+double voxel_transform::operator()(double D) const {
+    if(!(0.0 < D) && !this->alter_nonpositive) return D;
+    if(this->general) return this->general(D);
+    const auto y = D * (this->quad_a * D + this->quad_b);
+    return (this->root_scale == 0.0) ? y : this->root_scale * (std::sqrt(1.0 + this->root_k * y) - 1.0);
+}
+
+voxel_transform Identity_Transform(void){
+    return voxel_transform();
+}
+
+voxel_transform Scale_Transform(double factor){
+    voxel_transform t;
+    t.quad_b = factor;
+    return t;
+}
+
+voxel_transform LQ_BED_Transform(double alpha_beta, double n){
+    if( !(0.0 < alpha_beta) || !(0.0 < n) ){
+        throw std::invalid_argument("Alpha/beta and number of fractions must be positive.");
+    }
+    // BED = D * (1 + D / (n * abr)).
+    voxel_transform t;
+    t.quad_a = 1.0 / (n * alpha_beta);
+    t.quad_b = 1.0;
+    return t;
+}
+
+voxel_transform LQ_EQD_Transform(double alpha_beta, double n, double d){
+    if( !(0.0 < alpha_beta) || !(0.0 < n) || !(0.0 < d) ){
+        throw std::invalid_argument("Alpha/beta, number of fractions, and dose per fraction must be positive.");
+    }
+    // EQDd = D * (D / n + abr) / (d + abr).
+    voxel_transform t;
+    t.quad_a = 1.0 / (n * (d + alpha_beta));
+    t.quad_b = alpha_beta / (d + alpha_beta);
+    return t;
+}
+
+voxel_transform LQ_Pinned_EQD_Transform(double alpha_beta, double n, double n_eff){
+    if( !(0.0 < alpha_beta) || !(0.0 < n) || !(0.0 < n_eff) ){
+        throw std::invalid_argument("Alpha/beta and numbers of fractions must be positive.");
+    }
+    // The BED for n fractions is inverted for n_eff fractions: D' = 0.5 n_eff abr (sqrt(1 + 4 BED / (n_eff abr)) - 1).
+    voxel_transform t = LQ_BED_Transform(alpha_beta, n);
+    t.root_scale = 0.5 * n_eff * alpha_beta;
+    t.root_k = 4.0 / (n_eff * alpha_beta);
+    return t;
+}
+
+
+tissue_map
+Build_Tissue_Map(const planar_image<float,double> &img,
+                 const std::vector<std::list<std::reference_wrapper<contour_collection<double>>>> &rois_by_priority,
+                 const Mutate_Voxels_Opts &opts){
+    if(255 < rois_by_priority.size()){
+        throw std::invalid_argument("Too many ROI groups; at most 255 are supported.");
+    }
+
+    tissue_map tm;
+    tm.rows = img.rows;
+    tm.columns = img.columns;
+    tm.labels.assign(static_cast<size_t>(img.rows) * static_cast<size_t>(img.columns), 0);
+
+    // Rasterize into a single-channel scratch image so the original is never touched. Lower-priority groups only claim
+    // voxels that remain unlabeled.
+    planar_image<float,double> scratch = img;
+    scratch.init_buffer(img.rows, img.columns, 1);
+
+    Mutate_Voxels_Opts l_opts = opts;
+    l_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+
+    for(size_t g = 0; g < rois_by_priority.size(); ++g){
+        if(rois_by_priority[g].empty()) continue;
+        const auto label = static_cast<uint8_t>(g + 1);
+
+        auto f_bounded = [&](long int row, long int col, long int /*channel*/,
+                             std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &/*voxel_val*/) {
+            auto &l = tm.labels[static_cast<size_t>(row) * static_cast<size_t>(tm.columns) + static_cast<size_t>(col)];
+            if(l == 0) l = label;
+            return;
+        };
+
+        Mutate_Voxels<float,double>( std::ref(scratch),
+                                     { std::ref(scratch) },
+                                     rois_by_priority[g],
+                                     l_opts,
+                                     f_bounded );
+    }
+    return tm;
+}
+
+
+void
+Apply_Transforms(planar_image<float,double> &img,
+                 long int channel,
+                 const tissue_map &tm,
+                 const std::vector<voxel_transform> &transforms){
+    if( (tm.rows != img.rows) || (tm.columns != img.columns) ){
+        throw std::invalid_argument("Tissue map does not match the image dimensions.");
+    }
+    if(img.channels <= channel){
+        throw std::invalid_argument("Requested channel is not present in the image.");
+    }
+    if(transforms.empty()){
+        throw std::invalid_argument("No transformations provided.");
+    }
+    for(const auto &l : tm.labels){
+        if(transforms.size() <= static_cast<size_t>(l)){
+            throw std::invalid_argument("No transformation was provided for a tissue label.");
+        }
+    }
+
+    const auto N_chns = static_cast<size_t>(img.channels);
+    const auto N_voxels = tm.labels.size();
+    const auto c_begin = (channel < 0) ? static_cast<size_t>(0) : static_cast<size_t>(channel);
+    const auto c_end = (channel < 0) ? N_chns : static_cast<size_t>(channel) + 1;
+    float *data = img.data.data();
+    const uint8_t *labels = tm.labels.data();
+
+    bool any_general = false;
+    for(const auto &t : transforms) any_general = any_general || static_cast<bool>(t.general);
+
+    if(any_general){
+        for(size_t i = 0; i < N_voxels; ++i){
+            const auto &t = transforms[labels[i]];
+            for(size_t c = c_begin; c < c_end; ++c){
+                auto &v = data[i * N_chns + c];
+                v = static_cast<float>( t(static_cast<double>(v)) );
+            }
+        }
+        return;
+    }
+
+    // Gather coefficients into flat tables so the loop body is branch-free and amenable to vectorization.
+    const auto N_t = transforms.size();
+    std::vector<double> qa(N_t), qb(N_t), rs(N_t), rk(N_t);
+    std::vector<uint8_t> has_root(N_t), alter_all(N_t);
+    for(size_t k = 0; k < N_t; ++k){
+        qa[k] = transforms[k].quad_a;
+        qb[k] = transforms[k].quad_b;
+        rs[k] = transforms[k].root_scale;
+        rk[k] = transforms[k].root_k;
+        has_root[k] = (transforms[k].root_scale != 0.0) ? 1 : 0;
+        alter_all[k] = (transforms[k].alter_nonpositive) ? 1 : 0;
+    }
+    bool any_root = false;
+    for(const auto &h : has_root) any_root = any_root || (h != 0);
+
+    for(size_t c = c_begin; c < c_end; ++c){
+        if(any_root){
+            for(size_t i = 0; i < N_voxels; ++i){
+                const auto l = labels[i];
+                auto &v = data[i * N_chns + c];
+                const auto D = static_cast<double>(v);
+                const auto y = D * (qa[l] * D + qb[l]);
+                const auto r = rs[l] * (std::sqrt(std::max(0.0, 1.0 + rk[l] * y)) - 1.0);
+                const auto out = (has_root[l] != 0) ? r : y;
+                v = ((0.0 < D) || (alter_all[l] != 0)) ? static_cast<float>(out) : v;
+            }
+        }else{
+            for(size_t i = 0; i < N_voxels; ++i){
+                const auto l = labels[i];
+                auto &v = data[i * N_chns + c];
+                const auto D = static_cast<double>(v);
+                const auto y = D * (qa[l] * D + qb[l]);
+                v = ((0.0 < D) || (alter_all[l] != 0)) ? static_cast<float>(y) : v;
+            }
+        }
+    }
+    return;
+}
+
+} // namespace dose_transform
+
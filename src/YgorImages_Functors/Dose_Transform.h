@@ -0,0 +1,84 @@
+//Dose_Transform.h.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// This module applies radiobiological dose transformations (e.g., BED, EQDd, and dose decay) to whole images in a
+// single pass.
+//
+// Rather than visiting voxels once per ROI, ROIs are first rasterized into a per-voxel tissue label map. Labels are
+// assigned in priority order, so voxels within overlapping ROIs are assigned to the highest-priority ROI only. Each
+// label selects a transformation (e.g., with a tissue-specific alpha/beta and fractionation) and all voxels are then
+// transformed in a single pass over the contiguous voxel array.
+namespace dose_transform {
+
+// A per-voxel transformation of dose D.
+//
+// Most linear-quadratic transformations can be expressed as y = quad_a * D^2 + quad_b * D, optionally followed by
+// root_scale * (sqrt(1 + root_k * y) - 1) when root_scale is non-zero. These are evaluated without branching.
+// Transformations outside this family can instead be provided as a general function, which takes precedence.
+//
+// By default, voxels with non-positive dose are not altered, as is appropriate for the linear-quadratic conversions.
+// Transformations that must also apply to non-positive dose (e.g., dose decay) should set alter_nonpositive.
+struct voxel_transform {
+    double quad_a = 0.0;
+    double quad_b = 1.0;
+    double root_scale = 0.0;
+    double root_k = 0.0;
+
+    std::function<double(double)> general;
+
+    bool alter_nonpositive = false;
+
+    double operator()(double D) const;
+};
+
+// Leaves dose unaltered.
+voxel_transform Identity_Transform(void);
+
+// Scales dose by a constant factor.
+voxel_transform Scale_Transform(double factor);
+
+// Converts dose delivered in n fractions to BED using the simple linear-quadratic model.
+voxel_transform LQ_BED_Transform(double alpha_beta, double n);
+
+// Converts dose delivered in n fractions to EQDd using the simple linear-quadratic model.
+voxel_transform LQ_EQD_Transform(double alpha_beta, double n, double d);
+
+// Converts dose delivered in n fractions to the dose that would give the same BED if delivered in n_eff fractions.
+voxel_transform LQ_Pinned_EQD_Transform(double alpha_beta, double n, double n_eff);
+
+
+// Per-voxel tissue labels for a single image. Label zero denotes voxels outside of all ROIs, and label k denotes
+// voxels within the (k-1)th ROI group. Labels are stored row-major: labels[row * columns + column].
+struct tissue_map {
+    long int rows = 0;
+    long int columns = 0;
+    std::vector<uint8_t> labels;
+};
+
+// Rasterizes ROI groups into a label map for the given image. Groups are listed in priority order; a voxel within
+// several groups is assigned to the first. At most 255 groups are supported.
+tissue_map
+Build_Tissue_Map(const planar_image<float,double> &img,
+                 const std::vector<std::list<std::reference_wrapper<contour_collection<double>>>> &rois_by_priority,
+                 const Mutate_Voxels_Opts &opts);
+
+// Transforms the voxels of the given channel (or all channels if negative) in a single pass. transforms[k] is applied
+// to voxels with label k, so one transformation must be provided for every label present.
+void
+Apply_Transforms(planar_image<float,double> &img,
+                 long int channel,
+                 const tissue_map &tm,
+                 const std::vector<voxel_transform> &transforms);
+
+} // namespace dose_transform
+
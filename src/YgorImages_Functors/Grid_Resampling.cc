@@ -0,0 +1,494 @@
+//Grid_Resampling.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Grid_Resampling.h"
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+
+namespace grid_resampling {
+
+// Tolerances for orientation (dot products of unit vectors) and for deciding that a continuous coordinate lies on a
+// voxel centre. Snapping to voxel centres ensures that co-located grids reproduce the source values exactly.
+static const double eps_dir = 1.0E-5;
+static const double eps_snap = 1.0E-6;
+
+static long int taps_for(kernel k){
+    if(k == kernel::Nearest) return 1L;
+    if(k == kernel::Linear) return 2L;
+    return 4L;
+}
+
+// Computes the source taps and weights for a single continuous coordinate.
+//
+// Returns false if the sample lies outside the source and should receive the fill value.
+static bool axis_taps(kernel k, extrapolation e, long int N, double x, long int *idx, float *w){
+    if( !std::isfinite(x) || (N <= 0) ) return false;
+
+    const auto N_R = static_cast<double>(N);
+    if( (e == extrapolation::Fill)
+    &&  ((x < -0.5) || ((N_R - 0.5) < x)) ){
+        return false;
+    }
+
+    const auto x_r = std::round(x);
+    if(std::abs(x - x_r) < eps_snap) x = x_r;
+    x = std::clamp(x, 0.0, N_R - 1.0);
+
+    const auto clamp_index = [N](long int i) -> long int {
+        return std::clamp<long int>(i, 0L, N - 1L);
+    };
+
+    if(k == kernel::Nearest){
+        idx[0] = clamp_index(static_cast<long int>(std::lround(x)));
+        w[0] = 1.0f;
+
+    }else if(k == kernel::Linear){
+        const auto i0 = static_cast<long int>(std::floor(x));
+        const auto t = x - static_cast<double>(i0);
+        idx[0] = clamp_index(i0);
+        idx[1] = clamp_index(i0 + 1L);
+        w[0] = static_cast<float>(1.0 - t);
+        w[1] = static_cast<float>(t);
+
+    }else{
+        // Catmull-Rom cubic convolution (i.e., Keys' kernel with a = -0.5). The outermost voxels are replicated.
+        const auto i0 = static_cast<long int>(std::floor(x));
+        const auto t = x - static_cast<double>(i0);
+        const auto t2 = t * t;
+        const auto t3 = t2 * t;
+        for(long int j = 0; j < 4; ++j) idx[j] = clamp_index(i0 - 1L + j);
+        w[0] = static_cast<float>(-0.5 * t3 + t2 - 0.5 * t);
+        w[1] = static_cast<float>( 1.5 * t3 - 2.5 * t2 + 1.0);
+        w[2] = static_cast<float>(-1.5 * t3 + 2.0 * t2 + 0.5 * t);
+        w[3] = static_cast<float>( 0.5 * t3 - 0.5 * t2);
+        if(t == 0.0){
+            // Exactly on a voxel centre; avoid propagating NaNs from neighbours via zero weights.
+            w[0] = 0.0f;
+            w[1] = 1.0f;
+            w[2] = 0.0f;
+            w[3] = 0.0f;
+        }
+    }
+    return true;
+}
+
+static bool channels_compatible(const rectilinear_grid &src,
+                                const planar_image<float,double> &target,
+                                long int channel){
+    if(channel < 0) return (src.channels == target.channels);
+    return (channel < src.channels) && (channel < target.channels);
+}
+
+static void fill_voxel(planar_image<float,double> &target, long int row, long int col, const resample_opts &opts){
+    const auto N_chns = target.channels;
+    float *out = target.data.data() + (row * target.columns + col) * N_chns;
+    if(opts.channel < 0){
+        for(long int chn = 0; chn < N_chns; ++chn) out[chn] = opts.fill;
+    }else{
+        out[opts.channel] = opts.fill;
+    }
+    return;
+}
+
+
+long int rectilinear_grid::slices(void) const {
+    return static_cast<long int>(this->imgs.size());
+}
+
+double rectilinear_grid::slice_fraction(double z) const {
+    const auto N = this->slices();
+    if(N <= 0) return std::numeric_limits<double>::quiet_NaN();
+    if(N == 1) return z / this->pxl_dz;
+
+    const auto &o = this->slice_offsets;
+    if(this->uniform_slices){
+        return z * static_cast<double>(N - 1) / o.back();
+    }
+    if(z <= o.front()){
+        return (z - o[0]) / (o[1] - o[0]);
+    }
+    if(o.back() <= z){
+        return static_cast<double>(N - 1) + (z - o[N-1]) / (o[N-1] - o[N-2]);
+    }
+    const auto it = std::upper_bound(std::begin(o), std::end(o), z);
+    const auto i1 = static_cast<long int>(std::distance(std::begin(o), it));
+    const auto i0 = i1 - 1L;
+    return static_cast<double>(i0) + (z - o[i0]) / (o[i1] - o[i0]);
+}
+
+
+std::optional<rectilinear_grid>
+Make_Rectilinear_Grid(const std::list<std::reference_wrapper<planar_image<float,double>>> &imgs){
+    if(imgs.empty()) return {};
+
+    const auto &first = imgs.front().get();
+    if( (first.rows <= 0) || (first.columns <= 0) || (first.channels <= 0) ) return {};
+
+    rectilinear_grid grid;
+    grid.row_unit = first.row_unit.unit();
+    grid.col_unit = first.col_unit.unit();
+    grid.img_unit = first.image_plane().N_0.unit();
+    grid.pxl_dx = first.pxl_dx;
+    grid.pxl_dy = first.pxl_dy;
+    grid.pxl_dz = first.pxl_dz;
+    grid.rows = first.rows;
+    grid.columns = first.columns;
+    grid.channels = first.channels;
+
+    const auto eps_dx = 1.0E-4 * grid.pxl_dx;
+    const auto eps_dy = 1.0E-4 * grid.pxl_dy;
+    const auto P_ref = first.position(0, 0);
+
+    std::vector<std::pair<double, const planar_image<float,double> *>> ordered;
+    ordered.reserve(imgs.size());
+    for(const auto &img_refw : imgs){
+        const auto &img = img_refw.get();
+        if( (img.rows != grid.rows)
+        ||  (img.columns != grid.columns)
+        ||  (img.channels != grid.channels)
+        ||  (eps_dx < std::abs(img.pxl_dx - grid.pxl_dx))
+        ||  (eps_dy < std::abs(img.pxl_dy - grid.pxl_dy))
+        ||  (img.row_unit.unit().Dot(grid.row_unit) < (1.0 - eps_dir))
+        ||  (img.col_unit.unit().Dot(grid.col_unit) < (1.0 - eps_dir)) ){
+            return {};
+        }
+
+        const auto dP = img.position(0, 0) - P_ref;
+        if( (eps_dx < std::abs(dP.Dot(grid.row_unit)))
+        ||  (eps_dy < std::abs(dP.Dot(grid.col_unit))) ){
+            return {};
+        }
+        ordered.emplace_back( dP.Dot(grid.img_unit), std::addressof(img) );
+    }
+    std::sort(std::begin(ordered), std::end(ordered),
+              [](const auto &A, const auto &B){ return (A.first < B.first); });
+
+    grid.origin = ordered.front().second->position(0, 0);
+    for(const auto &p : ordered){
+        grid.imgs.push_back( p.second );
+        grid.slice_offsets.push_back( p.first - ordered.front().first );
+    }
+
+    // Overlapping slices cannot be interpolated between.
+    const auto N = grid.slices();
+    const auto eps_dz = 1.0E-4 * std::max(grid.pxl_dz, grid.pxl_dx);
+    for(long int i = 1; i < N; ++i){
+        if((grid.slice_offsets[i] - grid.slice_offsets[i-1]) <= eps_dz) return {};
+    }
+
+    if(1 < N){
+        const auto mean_dz = grid.slice_offsets.back() / static_cast<double>(N - 1);
+        for(long int i = 1; i < N; ++i){
+            const auto dz = grid.slice_offsets[i] - grid.slice_offsets[i-1];
+            if((1.0E-3 * mean_dz) < std::abs(dz - mean_dz)){
+                grid.uniform_slices = false;
+                break;
+            }
+        }
+    }
+    return grid;
+}
+
+
+axis_table
+Make_Axis_Table(kernel k, extrapolation e, long int N_src, const std::vector<double> &coords){
+    axis_table out;
+    out.taps = taps_for(k);
+    out.index.resize(coords.size() * out.taps, -1L);
+    out.weight.resize(coords.size() * out.taps, 0.0f);
+
+    for(std::size_t i = 0; i < coords.size(); ++i){
+        long int *idx = out.index.data() + i * out.taps;
+        float *w = out.weight.data() + i * out.taps;
+        if(!axis_taps(k, e, N_src, coords[i], idx, w)){
+            std::fill(idx, idx + out.taps, -1L);
+            std::fill(w, w + out.taps, 0.0f);
+        }
+    }
+    return out;
+}
+
+
+bool
+Resample_Aligned_Image(const rectilinear_grid &src,
+                       planar_image<float,double> &target,
+                       const resample_opts &opts){
+
+    if( src.imgs.empty()
+    ||  (target.rows <= 0)
+    ||  (target.columns <= 0)
+    ||  !channels_compatible(src, target, opts.channel) ){
+        return false;
+    }
+
+    const auto row_align = target.row_unit.unit().Dot(src.row_unit);
+    const auto col_align = target.col_unit.unit().Dot(src.col_unit);
+    if( (std::abs(row_align) < (1.0 - eps_dir))
+    ||  (std::abs(col_align) < (1.0 - eps_dir)) ){
+        return false;
+    }
+
+    const auto t_rows = target.rows;
+    const auto t_cols = target.columns;
+    const auto t_chns = target.channels;
+    const auto s_cols = src.columns;
+    const auto s_chns = src.channels;
+    const auto s_row_len = static_cast<std::size_t>(s_cols * s_chns);
+
+    // Build the per-axis tables. Each is computed once and shared by all voxels.
+    const auto dP = target.position(0, 0) - src.origin;
+
+    std::vector<double> coords;
+    coords.reserve(t_rows);
+    {
+        const auto r0 = dP.Dot(src.row_unit) / src.pxl_dx;
+        const auto dr = target.pxl_dx * row_align / src.pxl_dx;
+        for(long int r = 0; r < t_rows; ++r) coords.push_back( r0 + dr * static_cast<double>(r) );
+    }
+    const auto rt = Make_Axis_Table(opts.method, opts.inplane, src.rows, coords);
+
+    coords.clear();
+    coords.reserve(t_cols);
+    {
+        const auto c0 = dP.Dot(src.col_unit) / src.pxl_dy;
+        const auto dc = target.pxl_dy * col_align / src.pxl_dy;
+        for(long int c = 0; c < t_cols; ++c) coords.push_back( c0 + dc * static_cast<double>(c) );
+    }
+    const auto ct = Make_Axis_Table(opts.method, opts.inplane, src.columns, coords);
+
+    const auto st = Make_Axis_Table(opts.method, opts.slices, src.slices(),
+                                    { src.slice_fraction(dP.Dot(src.img_unit)) });
+
+    const auto fill_all = [&](void) -> void {
+        for(long int r = 0; r < t_rows; ++r){
+            for(long int c = 0; c < t_cols; ++c) fill_voxel(target, r, c, opts);
+        }
+    };
+    if(!st.valid(0)){
+        fill_all();
+        return true;
+    }
+
+    // Only the source rows that contribute need to be blended.
+    long int r_min = src.rows;
+    long int r_max = -1;
+    for(std::size_t i = 0; i < rt.index.size(); ++i){
+        if( (0 <= rt.index[i]) && (rt.weight[i] != 0.0f) ){
+            r_min = std::min(r_min, rt.index[i]);
+            r_max = std::max(r_max, rt.index[i]);
+        }
+    }
+    if(r_max < 0){
+        fill_all();
+        return true;
+    }
+    const auto plane_len = static_cast<std::size_t>(r_max - r_min + 1) * s_row_len;
+
+    // Blend the contributing slices into a single plane. If a single slice contributes it is referred to directly.
+    std::vector<std::pair<const float *, float>> s_taps;
+    for(long int t = 0; t < st.taps; ++t){
+        if(st.weight[t] == 0.0f) continue;
+        s_taps.emplace_back( src.imgs[ st.index[t] ]->data.data() + r_min * s_row_len, st.weight[t] );
+    }
+
+    std::vector<float> plane_buf;
+    const float *plane = nullptr;
+    if( (s_taps.size() == 1) && (s_taps.front().second == 1.0f) ){
+        plane = s_taps.front().first;
+    }else{
+        plane_buf.assign(plane_len, 0.0f);
+        float *p = plane_buf.data();
+        for(const auto &tap : s_taps){
+            const float *s = tap.first;
+            const float w = tap.second;
+            for(std::size_t i = 0; i < plane_len; ++i) p[i] += w * s[i];
+        }
+        plane = plane_buf.data();
+    }
+
+    // Stream the output rows. Each is a weighted sum of contiguous source rows followed by a column gather.
+    std::vector<float> row_buf(s_row_len);
+    const long int c_taps = ct.taps;
+    for(long int r = 0; r < t_rows; ++r){
+        if(!rt.valid(r)){
+            for(long int c = 0; c < t_cols; ++c) fill_voxel(target, r, c, opts);
+            continue;
+        }
+
+        std::array<std::pair<const float *, float>, 4> r_taps;
+        std::size_t N_r_taps = 0;
+        for(long int t = 0; t < rt.taps; ++t){
+            const auto w = rt.weight[r * rt.taps + t];
+            if(w == 0.0f) continue;
+            r_taps[N_r_taps++] = { plane + (rt.index[r * rt.taps + t] - r_min) * s_row_len, w };
+        }
+
+        const float *row = nullptr;
+        if( (N_r_taps == 1) && (r_taps[0].second == 1.0f) ){
+            row = r_taps[0].first;
+        }else{
+            float *b = row_buf.data();
+            {
+                const float *s = r_taps[0].first;
+                const float w = r_taps[0].second;
+                for(std::size_t i = 0; i < s_row_len; ++i) b[i] = w * s[i];
+            }
+            for(std::size_t t = 1; t < N_r_taps; ++t){
+                const float *s = r_taps[t].first;
+                const float w = r_taps[t].second;
+                for(std::size_t i = 0; i < s_row_len; ++i) b[i] += w * s[i];
+            }
+            row = row_buf.data();
+        }
+
+        float *out = target.data.data() + r * t_cols * t_chns;
+        const long int chn_lo = (opts.channel < 0) ? 0L : opts.channel;
+        const long int chn_hi = (opts.channel < 0) ? (t_chns - 1L) : opts.channel;
+        for(long int c = 0; c < t_cols; ++c){
+            if(!ct.valid(c)){
+                fill_voxel(target, r, c, opts);
+                continue;
+            }
+            const long int *idx = ct.index.data() + c * c_taps;
+            const float *w = ct.weight.data() + c * c_taps;
+            for(long int chn = chn_lo; chn <= chn_hi; ++chn){
+                float acc = 0.0f;
+                for(long int t = 0; t < c_taps; ++t){
+                    if(w[t] == 0.0f) continue;
+                    acc += w[t] * row[idx[t] * s_chns + chn];
+                }
+                out[c * t_chns + chn] = acc;
+            }
+        }
+    }
+    return true;
+}
+
+
+bool
+Resample_Mapped_Image(const rectilinear_grid &src,
+                      planar_image<float,double> &target,
+                      const std::function<vec3<double>(const vec3<double> &)> &inverse_map,
+                      const resample_opts &opts){
+
+    if( src.imgs.empty()
+    ||  (target.rows <= 0)
+    ||  (target.columns <= 0)
+    ||  !channels_compatible(src, target, opts.channel) ){
+        return false;
+    }
+
+    const auto t_rows = target.rows;
+    const auto t_cols = target.columns;
+    const auto t_chns = target.channels;
+    const auto s_cols = src.columns;
+    const auto s_chns = src.channels;
+
+    // Since the mapping is affine, the source-space position of every voxel is a linear combination of per-row and
+    // per-column steps. Coordinates are converted to (row, column) index space, and an offset along img_unit.
+    const auto to_index_space = [&](const vec3<double> &dQ) -> vec3<double> {
+        return vec3<double>( dQ.Dot(src.row_unit) / src.pxl_dx,
+                             dQ.Dot(src.col_unit) / src.pxl_dy,
+                             dQ.Dot(src.img_unit) );
+    };
+    const auto P00 = target.position(0, 0);
+    const auto Q00 = inverse_map(P00);
+    const auto f00 = to_index_space(Q00 - src.origin);
+    const auto df_r = to_index_space(inverse_map(P00 + target.row_unit * target.pxl_dx) - Q00);
+    const auto df_c = to_index_space(inverse_map(P00 + target.col_unit * target.pxl_dy) - Q00);
+
+    const auto N_taps = taps_for(opts.method);
+    std::array<long int, 4> ri, ci, si;
+    std::array<float, 4> rw, cw, sw;
+
+    const long int chn_lo = (opts.channel < 0) ? 0L : opts.channel;
+    const long int chn_hi = (opts.channel < 0) ? (t_chns - 1L) : opts.channel;
+    for(long int r = 0; r < t_rows; ++r){
+        float *out = target.data.data() + r * t_cols * t_chns;
+        for(long int c = 0; c < t_cols; ++c){
+            const auto f = f00 + df_r * static_cast<double>(r) + df_c * static_cast<double>(c);
+            if( !axis_taps(opts.method, opts.inplane, src.rows, f.x, ri.data(), rw.data())
+            ||  !axis_taps(opts.method, opts.inplane, src.columns, f.y, ci.data(), cw.data())
+            ||  !axis_taps(opts.method, opts.slices, src.slices(), src.slice_fraction(f.z), si.data(), sw.data()) ){
+                fill_voxel(target, r, c, opts);
+                continue;
+            }
+
+            for(long int chn = chn_lo; chn <= chn_hi; ++chn){
+                float acc = 0.0f;
+                for(long int a = 0; a < N_taps; ++a){
+                    if(sw[a] == 0.0f) continue;
+                    const float *s = src.imgs[ si[a] ]->data.data();
+                    for(long int b = 0; b < N_taps; ++b){
+                        if(rw[b] == 0.0f) continue;
+                        const float w_ab = sw[a] * rw[b];
+                        const float *s_row = s + ri[b] * s_cols * s_chns;
+                        for(long int d = 0; d < N_taps; ++d){
+                            if(cw[d] == 0.0f) continue;
+                            acc += w_ab * cw[d] * s_row[ci[d] * s_chns + chn];
+                        }
+                    }
+                }
+                out[c * t_chns + chn] = acc;
+            }
+        }
+    }
+    return true;
+}
+
+
+static bool
+resample_in_parallel(std::list<std::reference_wrapper<planar_image<float,double>>> targets,
+                     const std::function<bool(planar_image<float,double> &)> &f){
+    std::mutex saver_printer;
+    bool all_succeeded = true;
+    {
+        asio_thread_pool tp;
+        for(auto &img_refw : targets){
+            tp.submit_task([&,img_refw](void) -> void {
+                const auto res = f(img_refw.get());
+                if(!res){
+                    std::lock_guard<std::mutex> lock(saver_printer);
+                    all_succeeded = false;
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    return all_succeeded;
+}
+
+bool
+Resample_Aligned(const rectilinear_grid &src,
+                 std::list<std::reference_wrapper<planar_image<float,double>>> targets,
+                 const resample_opts &opts){
+    return resample_in_parallel(targets, [&](planar_image<float,double> &img) -> bool {
+        return Resample_Aligned_Image(src, img, opts);
+    });
+}
+
+bool
+Resample_Mapped(const rectilinear_grid &src,
+                std::list<std::reference_wrapper<planar_image<float,double>>> targets,
+                const std::function<vec3<double>(const vec3<double> &)> &inverse_map,
+                const resample_opts &opts){
+    return resample_in_parallel(targets, [&](planar_image<float,double> &img) -> bool {
+        return Resample_Mapped_Image(src, img, inverse_map, opts);
+    });
+}
+
+} // namespace grid_resampling
+
@@ -0,0 +1,130 @@
+//Grid_Resampling.h.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <optional>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+// This module resamples rectilinear image volumes onto other image geometries.
+//
+// Two strategies are provided. When the target images are aligned with the source grid (i.e., their row and column
+// axes are parallel, but spacing, extent, and slice positions may differ), interpolation is separable. Index and
+// weight tables are computed once per axis and slices are then produced by streaming contiguous weighted sums of
+// source rows, which the compiler can vectorize. When the target images are related to the source grid by a general
+// affine mapping, per-row and per-column steps in source index space are computed once per image so each voxel only
+// requires kernel weight evaluation.
+namespace grid_resampling {
+
+enum class kernel {
+    Nearest,   // Nearest-neighbour (1 tap per axis).
+    Linear,    // Linear (2 taps per axis). Separably applied this is trilinear interpolation.
+    Cubic,     // Catmull-Rom cubic convolution (4 taps per axis).
+};
+
+// How samples beyond the outermost voxel centres are handled along an axis.
+enum class extrapolation {
+    Fill,      // Samples within half a voxel of the outermost centre are clamped, others receive the fill value.
+    Clamp,     // All samples are clamped to the outermost voxel, regardless of distance.
+};
+
+struct resample_opts {
+    kernel method = kernel::Linear;
+
+    extrapolation inplane = extrapolation::Fill;
+    extrapolation slices  = extrapolation::Fill;
+
+    float fill = std::numeric_limits<float>::quiet_NaN();
+
+    // The channel to resample. Negative values select all channels, in which case the source and target images must
+    // have the same number of channels. Unselected channels are not altered.
+    long int channel = -1;
+};
+
+// The geometry of a rectilinear source volume.
+//
+// Images share rows, columns, channels, in-plane spacing, orientation, and in-plane alignment. Slices need not be
+// evenly spaced, but must be distinct.
+struct rectilinear_grid {
+    std::vector<const planar_image<float,double> *> imgs; // Ordered along img_unit.
+    std::vector<double> slice_offsets;  // Offset of each image along img_unit, relative to the first image.
+
+    vec3<double> origin;   // The centre of voxel (0,0) in the first image.
+    vec3<double> row_unit;
+    vec3<double> col_unit;
+    vec3<double> img_unit;
+
+    double pxl_dx = 1.0;
+    double pxl_dy = 1.0;
+    double pxl_dz = 1.0;   // Slice thickness; only used when a single image is present.
+
+    long int rows = 0;
+    long int columns = 0;
+    long int channels = 0;
+
+    bool uniform_slices = true;
+
+    long int slices(void) const;
+
+    // Converts an offset along img_unit (relative to the origin) to a continuous slice coordinate.
+    double slice_fraction(double z) const;
+};
+
+// Returns a grid if the images form a rectilinear volume. The images must outlive the grid.
+std::optional<rectilinear_grid>
+Make_Rectilinear_Grid(const std::list<std::reference_wrapper<planar_image<float,double>>> &imgs);
+
+
+// Per-axis interpolation table. Output sample i uses source indices index[i*taps + t] with weights
+// weight[i*taps + t]. Samples that receive the fill value have all indices set to -1.
+struct axis_table {
+    long int taps = 1;
+    std::vector<long int> index;
+    std::vector<float> weight;
+
+    std::size_t size(void) const { return this->index.size() / static_cast<std::size_t>(this->taps); }
+    bool valid(std::size_t i) const { return (0 <= this->index[i * this->taps]); }
+};
+
+// Builds a table for the given continuous source coordinates (e.g., 2.5 lies midway between source samples 2 and 3).
+axis_table
+Make_Axis_Table(kernel k, extrapolation e, long int N_src, const std::vector<double> &coords);
+
+
+// Resamples the source onto a single target image whose row and column axes are parallel (or anti-parallel) to the
+// source grid's. Only the target's voxel values are altered. Returns false if the target is not aligned or the
+// channels are incompatible.
+bool
+Resample_Aligned_Image(const rectilinear_grid &src,
+                       planar_image<float,double> &target,
+                       const resample_opts &opts);
+
+// Resamples the source onto a single target image of arbitrary orientation. The inverse_map transforms target-space
+// positions into source-space positions and must be affine. Returns false if the channels are incompatible.
+bool
+Resample_Mapped_Image(const rectilinear_grid &src,
+                      planar_image<float,double> &target,
+                      const std::function<vec3<double>(const vec3<double> &)> &inverse_map,
+                      const resample_opts &opts);
+
+// Parallel variants that process each target image in a separate task. Returns false if any target was rejected.
+bool
+Resample_Aligned(const rectilinear_grid &src,
+                 std::list<std::reference_wrapper<planar_image<float,double>>> targets,
+                 const resample_opts &opts);
+
+bool
+Resample_Mapped(const rectilinear_grid &src,
+                std::list<std::reference_wrapper<planar_image<float,double>>> targets,
+                const std::function<vec3<double>(const vec3<double> &)> &inverse_map,
+                const resample_opts &opts);
+
+} // namespace grid_resampling
+
@@ -0,0 +1,166 @@
+//Mesh_Attribute_Transfer.cc.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "../Mesh_Attributes.h"
+#include "../Thread_Pool.h"
+#include "Mesh_Attribute_Transfer.h"
+#include "Mesh_BVH.h"
+#include "YgorMath.h"
+
+
+namespace mesh_attribute_transfer {
+
+// The source vertices surrounding a projected point, and their barycentric weights.
+struct vertex_sample {
+    std::array<size_t, 3> verts = {{ 0, 0, 0 }};
+    std::array<double, 3> weights = {{ 1.0, 0.0, 0.0 }};
+};
+
+// Identifies which fan triangle of the face the BVH triangle was derived from, and computes barycentric weights of the
+// point within it.
+static vertex_sample sample_triangle(const fv_surface_mesh<double, uint64_t> &mesh,
+                                     const mesh_bvh::bvh_triangle &t,
+                                     const vec3<double> &P){
+    const auto &face = mesh.faces.at(t.face);
+    const auto v1 = t.v0 + t.e1;
+    const auto v2 = t.v0 + t.e2;
+    size_t j_best = 2;
+    double d_best = std::numeric_limits<double>::infinity();
+    for(size_t j = 2; j < face.size(); ++j){
+        const auto d = mesh.vertices[face[j - 1]].sq_dist(v1) + mesh.vertices[face[j]].sq_dist(v2);
+        if(d < d_best){
+            d_best = d;
+            j_best = j;
+        }
+    }
+
+    vertex_sample s;
+    s.verts = {{ static_cast<size_t>(face[0]), static_cast<size_t>(face[j_best - 1]), static_cast<size_t>(face[j_best]) }};
+
+    const auto R = P - t.v0;
+    const auto d00 = t.e1.Dot(t.e1);
+    const auto d01 = t.e1.Dot(t.e2);
+    const auto d11 = t.e2.Dot(t.e2);
+    const auto d20 = R.Dot(t.e1);
+    const auto d21 = R.Dot(t.e2);
+    const auto denom = d00 * d11 - d01 * d01;
+    if(0.0 < denom){
+        const auto u = std::clamp((d11 * d20 - d01 * d21) / denom, 0.0, 1.0);
+        const auto v = std::clamp((d00 * d21 - d01 * d20) / denom, 0.0, 1.0 - u);
+        s.weights = {{ 1.0 - u - v, u, v }};
+    }
+    return s;
+}
+
+void
+Transfer_Attributes(const fv_surface_mesh<double, uint64_t> &src_mesh,
+                    const mesh_attributes::attribute_store &src_vertex_attributes,
+                    const mesh_attributes::attribute_store &src_face_attributes,
+                    const fv_surface_mesh<double, uint64_t> &dst_mesh,
+                    mesh_attributes::attribute_store &dst_vertex_attributes,
+                    mesh_attributes::attribute_store &dst_face_attributes){
+
+    const bool has_vert_attrs = !src_vertex_attributes.empty();
+    const bool has_face_attrs = !src_face_attributes.empty();
+    dst_vertex_attributes.clear();
+    dst_face_attributes.clear();
+    if(!has_vert_attrs && !has_face_attrs) return;
+
+    if( (has_vert_attrs && (src_vertex_attributes.size() != src_mesh.vertices.size()))
+    ||  (has_face_attrs && (src_face_attributes.size() != src_mesh.faces.size())) ){
+        throw std::invalid_argument("Attributes do not match the source mesh. Cannot transfer attributes.");
+    }
+
+    const auto bvh = mesh_bvh::Build_BVH(src_mesh);
+    if(bvh.empty()){
+        throw std::invalid_argument("Source mesh has no faces. Cannot transfer attributes.");
+    }
+
+    const auto N_verts = dst_mesh.vertices.size();
+    const auto N_faces = dst_mesh.faces.size();
+    std::vector<vertex_sample> vert_samples( (has_vert_attrs) ? N_verts : 0 );
+    std::vector<size_t> nearest_vert( vert_samples.size() );
+    std::vector<size_t> nearest_face( (has_face_attrs) ? N_faces : 0 );
+
+    // Locate the nearest source surface points in parallel.
+    const auto N_tasks = std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4;
+    std::vector<std::exception_ptr> errors(N_tasks);
+    {
+        asio_thread_pool tp;
+        for(size_t n = 0; n < N_tasks; ++n){
+            tp.submit_task([&,n](void) -> void {
+                try{
+                    for(size_t i = n; i < vert_samples.size(); i += N_tasks){
+                        const auto cp = mesh_bvh::Closest_Point(bvh, dst_mesh.vertices[i]);
+                        if(!cp) throw std::runtime_error("Unable to locate nearest point on source mesh.");
+                        auto &s = vert_samples[i];
+                        s = sample_triangle(src_mesh, bvh.triangles[cp->triangle], cp->point);
+                        const auto k = std::distance(std::begin(s.weights),
+                                                     std::max_element(std::begin(s.weights), std::end(s.weights)));
+                        nearest_vert[i] = s.verts[k];
+                    }
+                    for(size_t i = n; i < nearest_face.size(); i += N_tasks){
+                        const auto &face = dst_mesh.faces[i];
+                        if(face.empty()) throw std::invalid_argument("Destination mesh contains an empty face.");
+                        vec3<double> centroid(0.0, 0.0, 0.0);
+                        for(const auto &v : face) centroid += dst_mesh.vertices.at(v);
+                        centroid = centroid / static_cast<double>(face.size());
+                        const auto cp = mesh_bvh::Closest_Point(bvh, centroid);
+                        if(!cp) throw std::runtime_error("Unable to locate nearest point on source mesh.");
+                        nearest_face[i] = static_cast<size_t>(cp->face);
+                    }
+                }catch(const std::exception &){
+                    errors[n] = std::current_exception();
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    for(const auto &e : errors){
+        if(e) std::rethrow_exception(e);
+    }
+
+    if(has_face_attrs){
+        dst_face_attributes = src_face_attributes.gather(nearest_face);
+    }
+
+    if(has_vert_attrs){
+        // Integer attributes take the value of the nearest vertex, which the floating-point attributes then replace
+        // with interpolated values.
+        dst_vertex_attributes = src_vertex_attributes.gather(nearest_vert);
+        for(const auto &p : src_vertex_attributes.get_columns()){
+            if(mesh_attributes::Is_Geometry_Cache(p.first)) continue;
+            std::visit([&](const auto &src){
+                using T = typename std::decay_t<decltype(src)>::value_type;
+                if constexpr (!std::is_floating_point_v<T>){
+                    return;
+                }else{
+                    auto dst = dst_vertex_attributes.get<T>(p.first).value();
+                    for(size_t i = 0; i < N_verts; ++i){
+                        const auto &s = vert_samples[i];
+                        double v = 0.0;
+                        for(size_t k = 0; k < 3; ++k) v += s.weights[k] * static_cast<double>(src[s.verts[k]]);
+                        dst[i] = static_cast<T>(v);
+                    }
+                }
+            }, p.second);
+        }
+        mesh_attributes::Refresh_Geometry_Caches(dst_mesh, dst_vertex_attributes);
+    }
+    return;
+}
+
+} // namespace mesh_attribute_transfer
+
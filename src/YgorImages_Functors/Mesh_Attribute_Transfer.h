@@ -0,0 +1,32 @@
+//Mesh_Attribute_Transfer.h.
+
+#pragma once
+
+#include <cstdint>
+
+#include "YgorMath.h"
+
+#include "../Mesh_Attributes.h"
+
+
+// This module carries mesh attributes across operations that alter mesh connectivity, such as remeshing,
+// simplification, and subdivision, where vertices and faces cannot be matched by index.
+//
+// Each vertex of the new mesh is projected onto the nearest point of the original surface, located using a bounding
+// volume hierarchy. Floating-point attributes are interpolated barycentrically within the original triangle, whereas
+// integer attributes are copied from the nearest of the triangle's vertices. Each new face takes the attributes of the
+// original face nearest its centroid. Queries are distributed across a thread pool.
+namespace mesh_attribute_transfer {
+
+// Resamples attributes defined on the source mesh onto the destination mesh. Geometry caches are not resampled, but
+// are recomputed on the destination mesh if they were present on the source.
+void
+Transfer_Attributes(const fv_surface_mesh<double, uint64_t> &src_mesh,
+                    const mesh_attributes::attribute_store &src_vertex_attributes,
+                    const mesh_attributes::attribute_store &src_face_attributes,
+                    const fv_surface_mesh<double, uint64_t> &dst_mesh,
+                    mesh_attributes::attribute_store &dst_vertex_attributes,
+                    mesh_attributes::attribute_store &dst_face_attributes);
+
+} // namespace mesh_attribute_transfer
+
@@ -0,0 +1,618 @@
+//Mesh_BVH.cc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Mesh_BVH.h"
+#include "YgorMath.h"
+
+
+namespace mesh_bvh {
+
+using bounds_t = std::array<std::array<double, 3>, 2>;
+
+static bounds_t empty_bounds(void){
+    const auto inf = std::numeric_limits<double>::infinity();
+    return {{ {{ inf, inf, inf }}, {{ -inf, -inf, -inf }} }};
+}
+
+static void grow(bounds_t &b, const std::array<double, 3> &p){
+    for(size_t a = 0; a < 3; ++a){
+        b[0][a] = std::min(b[0][a], p[a]);
+        b[1][a] = std::max(b[1][a], p[a]);
+    }
+    return;
+}
+
+static void grow(bounds_t &b, const bounds_t &o){
+    grow(b, o[0]);
+    grow(b, o[1]);
+    return;
+}
+
+static double half_area(const bounds_t &b){
+    const auto dx = b[1][0] - b[0][0];
+    const auto dy = b[1][1] - b[0][1];
+    const auto dz = b[1][2] - b[0][2];
+    if( !(0.0 <= dx) || !(0.0 <= dy) || !(0.0 <= dz) ) return 0.0; // Empty bounds.
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static std::array<double, 3> as_array(const vec3<double> &v){
+    return {{ v.x, v.y, v.z }};
+}
+
+// Scratch data used during construction. Subtrees operate on disjoint ranges of 'order', so they can be built
+// concurrently.
+struct build_state {
+    std::vector<bounds_t> tri_bounds;
+    std::vector<std::array<double, 3>> centroids;
+    std::vector<uint32_t> order;
+    size_t max_leaf_size = 4;
+};
+
+struct pending_subtree {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+    size_t depth;
+    std::vector<bvh_node> nodes;
+};
+
+static constexpr size_t N_bins = 16;
+
+// Beyond this depth, nodes are split at the median so that the tree depth (and thus the traversal stack) is bounded.
+static constexpr size_t max_sah_depth = 24;
+static constexpr size_t max_stack_depth = 64;
+
+// Recursively builds the subtree spanning order[begin, end) and returns the index of its root in 'nodes'. If 'pending'
+// is provided, ranges no larger than 'grain' are deferred: a placeholder node is emitted and recorded for later.
+static uint32_t build_subtree(build_state &bs,
+                              std::vector<bvh_node> &nodes,
+                              uint32_t begin,
+                              uint32_t end,
+                              size_t depth,
+                              std::vector<pending_subtree> *pending,
+                              size_t grain){
+    const auto node_idx = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    bounds_t b = empty_bounds();
+    bounds_t cb = empty_bounds();
+    for(auto i = begin; i < end; ++i){
+        grow(b, bs.tri_bounds[bs.order[i]]);
+        grow(cb, bs.centroids[bs.order[i]]);
+    }
+    nodes[node_idx].lo = b[0];
+    nodes[node_idx].hi = b[1];
+
+    const auto N = static_cast<size_t>(end - begin);
+    const auto make_leaf = [&](void) -> uint32_t {
+        nodes[node_idx].first = begin;
+        nodes[node_idx].count = static_cast<uint32_t>(N);
+        return node_idx;
+    };
+
+    if(N <= bs.max_leaf_size) return make_leaf();
+    if( (pending != nullptr) && (N <= grain) ){
+        pending->push_back( pending_subtree{ node_idx, begin, end, depth, {} } );
+        return node_idx;
+    }
+
+    // Split along the axis with the largest centroid extent.
+    size_t axis = 0;
+    for(size_t a = 1; a < 3; ++a){
+        if( (cb[1][axis] - cb[0][axis]) < (cb[1][a] - cb[0][a]) ) axis = a;
+    }
+    const auto c_lo = cb[0][axis];
+    const auto c_ext = cb[1][axis] - c_lo;
+
+    uint32_t mid = begin;
+    if( (0.0 < c_ext) && (depth < max_sah_depth) ){
+        // Bin centroids and evaluate the SAH at each bin boundary.
+        std::array<size_t, N_bins> bin_counts;
+        std::array<bounds_t, N_bins> bin_bounds;
+        bin_counts.fill(0);
+        bin_bounds.fill(empty_bounds());
+        const auto bin_of = [&](uint32_t t) -> size_t {
+            const auto f = (bs.centroids[t][axis] - c_lo) / c_ext;
+            return std::min(static_cast<size_t>(f * static_cast<double>(N_bins)), N_bins - 1);
+        };
+        for(auto i = begin; i < end; ++i){
+            const auto t = bs.order[i];
+            const auto k = bin_of(t);
+            bin_counts[k] += 1;
+            grow(bin_bounds[k], bs.tri_bounds[t]);
+        }
+
+        std::array<double, N_bins> right_cost;
+        {
+            bounds_t rb = empty_bounds();
+            size_t rn = 0;
+            for(size_t k = N_bins - 1; 0 < k; --k){
+                grow(rb, bin_bounds[k]);
+                rn += bin_counts[k];
+                right_cost[k] = half_area(rb) * static_cast<double>(rn);
+            }
+        }
+        double best_cost = std::numeric_limits<double>::infinity();
+        size_t best_split = 0;
+        {
+            bounds_t lb = empty_bounds();
+            size_t ln = 0;
+            for(size_t k = 1; k < N_bins; ++k){
+                grow(lb, bin_bounds[k-1]);
+                ln += bin_counts[k-1];
+                if( (ln == 0) || (ln == N) ) continue;
+                const auto cost = half_area(lb) * static_cast<double>(ln) + right_cost[k];
+                if(cost < best_cost){
+                    best_cost = cost;
+                    best_split = k;
+                }
+            }
+        }
+
+        if(best_split != 0){
+            const auto it = std::partition(std::begin(bs.order) + begin, std::begin(bs.order) + end,
+                                           [&](uint32_t t){ return bin_of(t) < best_split; });
+            mid = static_cast<uint32_t>(std::distance(std::begin(bs.order), it));
+        }
+    }
+
+    // Fall back to a median split if binning could not separate the triangles (e.g., coincident centroids).
+    if( (mid == begin) || (mid == end) ){
+        mid = begin + static_cast<uint32_t>(N / 2);
+        std::nth_element(std::begin(bs.order) + begin, std::begin(bs.order) + mid, std::begin(bs.order) + end,
+                         [&](uint32_t A, uint32_t B){ return bs.centroids[A][axis] < bs.centroids[B][axis]; });
+    }
+
+    const auto first = build_subtree(bs, nodes, begin, mid, depth + 1, pending, grain);
+    const auto second = build_subtree(bs, nodes, mid, end, depth + 1, pending, grain);
+    nodes[node_idx].first = first;
+    nodes[node_idx].second = second;
+    nodes[node_idx].count = 0;
+    nodes[node_idx].axis = static_cast<uint32_t>(axis);
+    return node_idx;
+}
+
+
+triangle_bvh
+Build_BVH(const fv_surface_mesh<double, uint64_t> &mesh,
+          size_t max_leaf_size){
+
+    triangle_bvh bvh;
+    const auto N_verts = static_cast<uint64_t>(mesh.vertices.size());
+
+    // Fan-triangulate the faces.
+    for(size_t f = 0; f < mesh.faces.size(); ++f){
+        const auto &face = mesh.faces[f];
+        if(face.size() < 3) continue;
+        for(const auto &i : face){
+            if(N_verts <= i) throw std::invalid_argument("Mesh face references a non-existent vertex.");
+        }
+        const auto &v0 = mesh.vertices[face[0]];
+        for(size_t j = 2; j < face.size(); ++j){
+            bvh_triangle t;
+            t.v0 = v0;
+            t.e1 = mesh.vertices[face[j-1]] - v0;
+            t.e2 = mesh.vertices[face[j]] - v0;
+            t.face = static_cast<uint64_t>(f);
+            bvh.triangles.push_back(t);
+        }
+    }
+    if(bvh.triangles.empty()) return bvh;
+    if(static_cast<size_t>(std::numeric_limits<uint32_t>::max() / 2) < bvh.triangles.size()){
+        throw std::invalid_argument("Mesh contains too many faces.");
+    }
+
+    const auto N = bvh.triangles.size();
+    build_state bs;
+    bs.max_leaf_size = std::max<size_t>(max_leaf_size, 1);
+    bs.tri_bounds.resize(N);
+    bs.centroids.resize(N);
+    bs.order.resize(N);
+    for(size_t i = 0; i < N; ++i){
+        const auto &t = bvh.triangles[i];
+        bounds_t b = empty_bounds();
+        grow(b, as_array(t.v0));
+        grow(b, as_array(t.v0 + t.e1));
+        grow(b, as_array(t.v0 + t.e2));
+        bs.tri_bounds[i] = b;
+        for(size_t a = 0; a < 3; ++a) bs.centroids[i][a] = 0.5 * (b[0][a] + b[1][a]);
+        bs.order[i] = static_cast<uint32_t>(i);
+    }
+
+    // Build the upper levels serially, deferring subtrees small enough to be handed to individual tasks.
+    const auto N_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    const auto grain = std::max<size_t>(N / (8 * N_threads), 1024);
+    std::vector<pending_subtree> pending;
+    build_subtree(bs, bvh.nodes, 0, static_cast<uint32_t>(N), 0, &pending, grain);
+
+    {
+        asio_thread_pool tp;
+        for(auto &p : pending){
+            tp.submit_task([&](void) -> void {
+                build_subtree(bs, p.nodes, p.begin, p.end, p.depth, nullptr, 0);
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    // Splice the subtrees into place. Each subtree root replaces its placeholder and the remaining nodes are appended.
+    for(auto &p : pending){
+        const auto offset = static_cast<uint32_t>(bvh.nodes.size()) - 1;
+        for(auto &n : p.nodes){
+            if(n.count == 0){
+                n.first += offset;
+                n.second += offset;
+            }
+        }
+        bvh.nodes[p.node] = p.nodes.front();
+        bvh.nodes.insert(std::end(bvh.nodes), std::next(std::begin(p.nodes)), std::end(p.nodes));
+    }
+
+    // Reorder triangles so leaves reference contiguous runs.
+    std::vector<bvh_triangle> ordered;
+    ordered.reserve(N);
+    for(const auto &i : bs.order) ordered.push_back(bvh.triangles[i]);
+    bvh.triangles.swap(ordered);
+    return bvh;
+}
+
+
+// Precomputed per-ray quantities for box tests.
+struct ray_ctx {
+    std::array<double, 3> o;
+    std::array<double, 3> inv;
+    double t_min;
+    double t_max;
+};
+
+static ray_ctx make_ctx(const ray &r){
+    ray_ctx c;
+    c.o = as_array(r.origin);
+    c.inv = {{ 1.0 / r.dir.x, 1.0 / r.dir.y, 1.0 / r.dir.z }};
+    c.t_min = r.t_min;
+    c.t_max = r.t_max;
+    return c;
+}
+
+// Slab test. NaNs arising from rays lying within a slab plane are discarded by the min/max ordering.
+static bool hits_box(const bvh_node &n, const ray_ctx &c, double t_max){
+    double t0 = c.t_min;
+    double t1 = t_max;
+    for(size_t a = 0; a < 3; ++a){
+        const auto ta = (n.lo[a] - c.o[a]) * c.inv[a];
+        const auto tb = (n.hi[a] - c.o[a]) * c.inv[a];
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+    }
+    return (t0 <= t1);
+}
+
+// Moller-Trumbore ray-triangle intersection.
+static bool hits_triangle(const bvh_triangle &tri, const ray &r, double t_min, double t_max, double &t){
+    const auto pvec = r.dir.Cross(tri.e2);
+    const auto det = tri.e1.Dot(pvec);
+    if( !(std::numeric_limits<double>::min() < std::abs(det)) ) return false;
+    const auto inv_det = 1.0 / det;
+
+    const auto tvec = r.origin - tri.v0;
+    const auto u = tvec.Dot(pvec) * inv_det;
+    if( (u < 0.0) || (1.0 < u) ) return false;
+
+    const auto qvec = tvec.Cross(tri.e1);
+    const auto v = r.dir.Dot(qvec) * inv_det;
+    if( (v < 0.0) || (1.0 < (u + v)) ) return false;
+
+    t = tri.e2.Dot(qvec) * inv_det;
+    return (t_min <= t) && (t <= t_max);
+}
+
+static ray_hit make_hit(const triangle_bvh &bvh, const ray &r, size_t i, double t){
+    ray_hit h;
+    h.t = t;
+    h.point = r.origin + r.dir * t;
+    h.triangle = i;
+    h.face = bvh.triangles[i].face;
+    return h;
+}
+
+// Visits leaves whose boxes the ray passes through, nearest child first. The visitor returns the (possibly reduced)
+// upper bound on t; returning NaN terminates the traversal.
+template <class F>
+static void traverse(const triangle_bvh &bvh, const ray &r, F &&visit_leaf){
+    if(bvh.nodes.empty()) return;
+    const auto c = make_ctx(r);
+    const std::array<bool, 3> neg = {{ (r.dir.x < 0.0), (r.dir.y < 0.0), (r.dir.z < 0.0) }};
+    double t_max = r.t_max;
+
+    uint32_t stack[max_stack_depth];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while(depth != 0){
+        const auto &n = bvh.nodes[stack[--depth]];
+        if(!hits_box(n, c, t_max)) continue;
+        if(n.count != 0){
+            t_max = visit_leaf(n, t_max);
+            if(std::isnan(t_max)) return;
+            continue;
+        }
+        if(max_stack_depth < (depth + 2)) throw std::runtime_error("BVH is too deep to traverse.");
+        // Push the far child first so the near child is visited first.
+        if(neg[n.axis]){
+            stack[depth++] = n.first;
+            stack[depth++] = n.second;
+        }else{
+            stack[depth++] = n.second;
+            stack[depth++] = n.first;
+        }
+    }
+    return;
+}
+
+std::optional<ray_hit>
+Nearest_Intersection(const triangle_bvh &bvh, const ray &r){
+    std::optional<ray_hit> out;
+    traverse(bvh, r, [&](const bvh_node &n, double t_max) -> double {
+        for(auto i = n.first; i < (n.first + n.count); ++i){
+            double t = 0.0;
+            if(hits_triangle(bvh.triangles[i], r, r.t_min, t_max, t)){
+                t_max = t;
+                out = make_hit(bvh, r, i, t);
+            }
+        }
+        return t_max;
+    });
+    return out;
+}
+
+bool
+Any_Intersection(const triangle_bvh &bvh, const ray &r){
+    bool found = false;
+    traverse(bvh, r, [&](const bvh_node &n, double t_max) -> double {
+        for(auto i = n.first; i < (n.first + n.count); ++i){
+            double t = 0.0;
+            if(hits_triangle(bvh.triangles[i], r, r.t_min, t_max, t)){
+                found = true;
+                return std::numeric_limits<double>::quiet_NaN();
+            }
+        }
+        return t_max;
+    });
+    return found;
+}
+
+std::vector<ray_hit>
+All_Intersections(const triangle_bvh &bvh, const ray &r){
+    std::vector<ray_hit> out;
+    traverse(bvh, r, [&](const bvh_node &n, double t_max) -> double {
+        for(auto i = n.first; i < (n.first + n.count); ++i){
+            double t = 0.0;
+            if(hits_triangle(bvh.triangles[i], r, r.t_min, t_max, t)){
+                out.push_back( make_hit(bvh, r, i, t) );
+            }
+        }
+        return t_max;
+    });
+    std::sort(std::begin(out), std::end(out), [](const ray_hit &A, const ray_hit &B){ return (A.t < B.t); });
+    return out;
+}
+
+std::vector<std::optional<ray_hit>>
+Nearest_Intersections(const triangle_bvh &bvh, const std::vector<ray> &rays){
+    std::vector<std::optional<ray_hit>> out(rays.size());
+    if(bvh.nodes.empty()) return out;
+
+    constexpr size_t packet_size = 16;
+    constexpr size_t packets_per_task = 64;
+    const auto N_rays = rays.size();
+
+    // Traverses the tree once for a packet of rays. A node is entered if any ray in the packet passes through it.
+    const auto trace_packet = [&](size_t p_begin, size_t p_end) -> void {
+        std::array<ray_ctx, packet_size> ctx;
+        std::array<double, packet_size> t_best;
+        const auto N = p_end - p_begin;
+        for(size_t j = 0; j < N; ++j){
+            ctx[j] = make_ctx(rays[p_begin + j]);
+            t_best[j] = rays[p_begin + j].t_max;
+        }
+        const auto &r0 = rays[p_begin];
+        const std::array<bool, 3> neg = {{ (r0.dir.x < 0.0), (r0.dir.y < 0.0), (r0.dir.z < 0.0) }};
+
+        uint32_t stack[max_stack_depth];
+        size_t depth = 0;
+        stack[depth++] = 0;
+        while(depth != 0){
+            const auto &n = bvh.nodes[stack[--depth]];
+            bool any = false;
+            for(size_t j = 0; (j < N) && !any; ++j){
+                any = hits_box(n, ctx[j], t_best[j]);
+            }
+            if(!any) continue;
+
+            if(n.count != 0){
+                for(auto i = n.first; i < (n.first + n.count); ++i){
+                    for(size_t j = 0; j < N; ++j){
+                        const auto &r = rays[p_begin + j];
+                        double t = 0.0;
+                        if(hits_triangle(bvh.triangles[i], r, r.t_min, t_best[j], t)){
+                            t_best[j] = t;
+                            out[p_begin + j] = make_hit(bvh, r, i, t);
+                        }
+                    }
+                }
+                continue;
+            }
+            if(max_stack_depth < (depth + 2)) throw std::runtime_error("BVH is too deep to traverse.");
+            if(neg[n.axis]){
+                stack[depth++] = n.first;
+                stack[depth++] = n.second;
+            }else{
+                stack[depth++] = n.second;
+                stack[depth++] = n.first;
+            }
+        }
+    };
+
+    {
+        asio_thread_pool tp;
+        const auto task_size = packet_size * packets_per_task;
+        for(size_t t_begin = 0; t_begin < N_rays; t_begin += task_size){
+            tp.submit_task([&,t_begin](void) -> void {
+                const auto t_end = std::min(N_rays, t_begin + task_size);
+                for(size_t p = t_begin; p < t_end; p += packet_size){
+                    trace_packet(p, std::min(t_end, p + packet_size));
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    return out;
+}
+
+
+// Closest point on a triangle to P. Adapted from Ericson's 'Real-Time Collision Detection' (2005), section 5.1.5.
+static vec3<double> closest_on_triangle(const bvh_triangle &tri, const vec3<double> &P){
+    const auto &a = tri.v0;
+    const auto &ab = tri.e1;
+    const auto &ac = tri.e2;
+    const auto ap = P - a;
+    const auto d1 = ab.Dot(ap);
+    const auto d2 = ac.Dot(ap);
+    if( (d1 <= 0.0) && (d2 <= 0.0) ) return a;
+
+    const auto bp = ap - ab;
+    const auto d3 = ab.Dot(bp);
+    const auto d4 = ac.Dot(bp);
+    if( (0.0 <= d3) && (d4 <= d3) ) return a + ab;
+
+    const auto vc = d1 * d4 - d3 * d2;
+    if( (vc <= 0.0) && (0.0 <= d1) && (d3 <= 0.0) ) return a + ab * (d1 / (d1 - d3));
+
+    const auto cp = ap - ac;
+    const auto d5 = ab.Dot(cp);
+    const auto d6 = ac.Dot(cp);
+    if( (0.0 <= d6) && (d5 <= d6) ) return a + ac;
+
+    const auto vb = d5 * d2 - d1 * d6;
+    if( (vb <= 0.0) && (0.0 <= d2) && (d6 <= 0.0) ) return a + ac * (d2 / (d2 - d6));
+
+    const auto va = d3 * d6 - d5 * d4;
+    if( (va <= 0.0) && (0.0 <= (d4 - d3)) && (0.0 <= (d5 - d6)) ){
+        const auto w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return a + ab + (ac - ab) * w;
+    }
+
+    const auto denom = 1.0 / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+static double sq_dist_to_box(const bvh_node &n, const vec3<double> &P){
+    const auto p = as_array(P);
+    double d = 0.0;
+    for(size_t a = 0; a < 3; ++a){
+        const auto e = std::max({ n.lo[a] - p[a], 0.0, p[a] - n.hi[a] });
+        d += e * e;
+    }
+    return d;
+}
+
+std::optional<closest_point>
+Closest_Point(const triangle_bvh &bvh,
+              const vec3<double> &P,
+              double max_distance){
+    std::optional<closest_point> out;
+    if(bvh.nodes.empty()) return out;
+    double best = (max_distance < std::numeric_limits<double>::infinity()) ? max_distance * max_distance
+                                                                           : std::numeric_limits<double>::infinity();
+
+    uint32_t stack[max_stack_depth];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while(depth != 0){
+        const auto &n = bvh.nodes[stack[--depth]];
+        if(best < sq_dist_to_box(n, P)) continue;
+        if(n.count != 0){
+            for(auto i = n.first; i < (n.first + n.count); ++i){
+                const auto C = closest_on_triangle(bvh.triangles[i], P);
+                const auto d = (C - P).Dot(C - P);
+                if(d <= best){
+                    best = d;
+                    out = closest_point{ C, std::sqrt(d), i, bvh.triangles[i].face };
+                }
+            }
+            continue;
+        }
+        if(max_stack_depth < (depth + 2)) throw std::runtime_error("BVH is too deep to traverse.");
+        // Visit the nearer child first so the bound tightens quickly.
+        const auto d_first = sq_dist_to_box(bvh.nodes[n.first], P);
+        const auto d_second = sq_dist_to_box(bvh.nodes[n.second], P);
+        if(d_first < d_second){
+            stack[depth++] = n.second;
+            stack[depth++] = n.first;
+        }else{
+            stack[depth++] = n.first;
+            stack[depth++] = n.second;
+        }
+    }
+    return out;
+}
+
+
+bool
+Is_Inside(const triangle_bvh &bvh, const vec3<double> &P){
+    if(bvh.nodes.empty()) return false;
+
+    // Directions are deliberately not aligned with the axes or each other to avoid grazing axis-aligned features.
+    const std::array<vec3<double>, 3> dirs = {{ vec3<double>( 0.5773502692,  0.5812381937,  0.5734623444),
+                                                vec3<double>(-0.6324555320,  0.3162277660,  0.7071067812),
+                                                vec3<double>( 0.2672612419, -0.8017837257,  0.5345224838) }};
+    size_t votes = 0;
+    for(size_t k = 0; k < dirs.size(); ++k){
+        ray r;
+        r.origin = P;
+        r.dir = dirs[k];
+        const auto hits = All_Intersections(bvh, r);
+
+        // Discard duplicates from rays passing through shared edges or vertices.
+        size_t crossings = 0;
+        double last_t = -std::numeric_limits<double>::infinity();
+        for(const auto &h : hits){
+            if(1.0E-9 * std::max(1.0, std::abs(h.t)) < (h.t - last_t)) ++crossings;
+            last_t = h.t;
+        }
+        if((crossings % 2) == 1) ++votes;
+        if( (votes == 2) || ((votes + (dirs.size() - k - 1)) < 2) ) break; // Verdict is settled.
+    }
+    return (2 <= votes);
+}
+
+std::vector<uint8_t>
+Are_Inside(const triangle_bvh &bvh, const std::vector<vec3<double>> &points){
+    std::vector<uint8_t> out(points.size(), 0);
+    constexpr size_t task_size = 1024;
+    {
+        asio_thread_pool tp;
+        for(size_t begin = 0; begin < points.size(); begin += task_size){
+            tp.submit_task([&,begin](void) -> void {
+                const auto end = std::min(points.size(), begin + task_size);
+                for(size_t i = begin; i < end; ++i){
+                    out[i] = Is_Inside(bvh, points[i]) ? 1 : 0;
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    return out;
+}
+
+} // namespace mesh_bvh
+
@@ -0,0 +1,596 @@
+//Pixel_Kernels.cc.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define DCMA_PIXEL_KERNELS_AVX2 1
+    #define DCMA_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define DCMA_PIXEL_KERNELS_NEON 1
+#endif
+
+#include "Pixel_Kernels.h"
+#include "YgorImages.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+template <class T> class contour_collection;
+
+
+namespace pixel_kernels {
+
+// ------------------------------------------- Instruction set selection ------------------------------------------
+
+enum class isa_t {
+    scalar,
+    avx2,
+    neon,
+};
+
+static isa_t detect_isa(void){
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return isa_t::avx2;
+    return isa_t::scalar;
+#elif defined(DCMA_PIXEL_KERNELS_NEON)
+    return isa_t::neon; // NEON is mandatory on AArch64.
+#else
+    return isa_t::scalar;
+#endif
+}
+
+static isa_t active_isa(void){
+    static const isa_t isa = detect_isa();
+    return isa;
+}
+
+const char *
+Active_Instruction_Set(void){
+    switch(active_isa()){
+        case isa_t::avx2: return "avx2";
+        case isa_t::neon: return "neon";
+        default: break;
+    }
+    return "scalar";
+}
+
+pixel_buffer
+Pixel_Buffer(planar_image<float,double> &img,
+             long int channel,
+             const std::vector<uint8_t> *mask){
+    pixel_buffer out;
+    out.data = img.data.data();
+    out.pixels = static_cast<std::size_t>(img.rows) * static_cast<std::size_t>(img.columns);
+    out.channels = static_cast<std::size_t>(img.channels);
+    out.channel = channel;
+    if(mask != nullptr){
+        if(mask->size() != out.pixels){
+            throw std::invalid_argument("Mask does not match image dimensions. Refusing to continue.");
+        }
+        out.mask = mask->data();
+    }
+    if(img.data.size() != (out.pixels * out.channels)){
+        throw std::logic_error("Image buffer does not match image dimensions. Refusing to continue.");
+    }
+    return out;
+}
+
+
+// ------------------------------------------- Element-wise operations --------------------------------------------
+// Each operation provides a scalar implementation along with vectorized implementations that produce identical results.
+
+struct op_scale_offset {
+    float scale;
+    float offset;
+
+    float scalar(float v) const {
+        return v * this->scale + this->offset;
+    }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 v) const {
+        return _mm256_add_ps( _mm256_mul_ps(v, _mm256_set1_ps(this->scale)), _mm256_set1_ps(this->offset) );
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t v) const {
+        return vaddq_f32( vmulq_f32(v, vdupq_n_f32(this->scale)), vdupq_n_f32(this->offset) );
+    }
+#endif
+};
+
+struct op_clamp {
+    float lower;
+    float upper;
+
+    float scalar(float v) const {
+        // Note: NaNs are propagated.
+        if(v < this->lower) return this->lower;
+        if(this->upper < v) return this->upper;
+        return v;
+    }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 v) const {
+        // Note: min/max return the second operand when either is NaN, so NaNs are propagated.
+        return _mm256_min_ps( _mm256_set1_ps(this->upper), _mm256_max_ps(_mm256_set1_ps(this->lower), v) );
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t v) const {
+        return vminq_f32( vmaxq_f32(v, vdupq_n_f32(this->lower)), vdupq_n_f32(this->upper) );
+    }
+#endif
+};
+
+struct op_threshold_replace {
+    float lower;
+    float low_val;
+    float upper;
+    float high_val;
+
+    float scalar(float v) const {
+        float r = v;
+        if(!(this->lower < v)) r = this->low_val;
+        if(!(v < this->upper)) r = this->high_val;
+        return r;
+    }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 v) const {
+        const __m256 keep_l = _mm256_cmp_ps(_mm256_set1_ps(this->lower), v, _CMP_LT_OQ);
+        const __m256 keep_u = _mm256_cmp_ps(v, _mm256_set1_ps(this->upper), _CMP_LT_OQ);
+        const __m256 r = _mm256_blendv_ps(_mm256_set1_ps(this->low_val), v, keep_l);
+        return _mm256_blendv_ps(_mm256_set1_ps(this->high_val), r, keep_u);
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t v) const {
+        const uint32x4_t keep_l = vcltq_f32(vdupq_n_f32(this->lower), v);
+        const uint32x4_t keep_u = vcltq_f32(v, vdupq_n_f32(this->upper));
+        const float32x4_t r = vbslq_f32(keep_l, v, vdupq_n_f32(this->low_val));
+        return vbslq_f32(keep_u, r, vdupq_n_f32(this->high_val));
+    }
+#endif
+};
+
+struct op_replace_nonfinite {
+    float replacement;
+
+    float scalar(float v) const {
+        return std::isfinite(v) ? v : this->replacement;
+    }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 v) const {
+        // (v - v) is zero for finite v, and NaN otherwise.
+        const __m256 finite = _mm256_cmp_ps(_mm256_sub_ps(v, v), _mm256_setzero_ps(), _CMP_EQ_OQ);
+        return _mm256_blendv_ps(_mm256_set1_ps(this->replacement), v, finite);
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t v) const {
+        const uint32x4_t finite = vceqq_f32(vsubq_f32(v, v), vdupq_n_f32(0.0f));
+        return vbslq_f32(finite, v, vdupq_n_f32(this->replacement));
+    }
+#endif
+};
+
+struct op_add {
+    float scalar(float a, float b) const { return a + b; }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 a, __m256 b) const { return _mm256_add_ps(a, b); }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t a, float32x4_t b) const { return vaddq_f32(a, b); }
+#endif
+};
+
+struct op_subtract {
+    float scalar(float a, float b) const { return a - b; }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 a, __m256 b) const { return _mm256_sub_ps(a, b); }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t a, float32x4_t b) const { return vsubq_f32(a, b); }
+#endif
+};
+
+struct op_multiply {
+    float scalar(float a, float b) const { return a * b; }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 a, __m256 b) const { return _mm256_mul_ps(a, b); }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t a, float32x4_t b) const { return vmulq_f32(a, b); }
+#endif
+};
+
+// Note: the element-wise min/max take the source value only when it compares favourably, so NaNs in the source are
+//       ignored and NaNs in the destination are retained.
+struct op_min {
+    float scalar(float a, float b) const { return (b < a) ? b : a; }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 a, __m256 b) const {
+        return _mm256_blendv_ps(a, b, _mm256_cmp_ps(b, a, _CMP_LT_OQ));
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t a, float32x4_t b) const { return vbslq_f32(vcltq_f32(b, a), b, a); }
+#endif
+};
+
+struct op_max {
+    float scalar(float a, float b) const { return (a < b) ? b : a; }
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+    DCMA_TARGET_AVX2 __m256 avx2(__m256 a, __m256 b) const {
+        return _mm256_blendv_ps(a, b, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+    }
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+    float32x4_t neon(float32x4_t a, float32x4_t b) const { return vbslq_f32(vcltq_f32(a, b), b, a); }
+#endif
+};
+
+
+// ------------------------------------------- Contiguous drivers -------------------------------------------------
+
+template <class Op>
+static void unary_scalar(float *d, std::size_t N, const uint8_t *mask, const Op &op){
+    for(std::size_t i = 0; i < N; ++i){
+        if((mask == nullptr) || (mask[i] != 0)) d[i] = op.scalar(d[i]);
+    }
+    return;
+}
+
+template <class Op>
+static void binary_scalar(float *d, const float *s, std::size_t N, const uint8_t *mask, const Op &op){
+    for(std::size_t i = 0; i < N; ++i){
+        if((mask == nullptr) || (mask[i] != 0)) d[i] = op.scalar(d[i], s[i]);
+    }
+    return;
+}
+
+static void min_max_scalar(const float *d, std::size_t N, const uint8_t *mask, min_max &mm){
+    for(std::size_t i = 0; i < N; ++i){
+        if((mask != nullptr) && (mask[i] == 0)) continue;
+        const auto v = d[i];
+        if(v < mm.min) mm.min = v;
+        if(mm.max < v) mm.max = v;
+    }
+    return;
+}
+
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+// Expands 8 mask bytes into a lane mask.
+DCMA_TARGET_AVX2 static inline __m256 avx2_load_mask(const uint8_t *m){
+    const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(m));
+    const __m256i w = _mm256_cvtepu8_epi32(b);
+    return _mm256_castsi256_ps( _mm256_cmpgt_epi32(w, _mm256_setzero_si256()) );
+}
+
+template <class Op>
+DCMA_TARGET_AVX2 static void unary_avx2(float *d, std::size_t N, const uint8_t *mask, const Op &op){
+    std::size_t i = 0;
+    for( ; (i + 8) <= N; i += 8){
+        const __m256 v = _mm256_loadu_ps(d + i);
+        __m256 r = op.avx2(v);
+        if(mask != nullptr) r = _mm256_blendv_ps(v, r, avx2_load_mask(mask + i));
+        _mm256_storeu_ps(d + i, r);
+    }
+    unary_scalar(d + i, N - i, (mask == nullptr) ? nullptr : (mask + i), op);
+    return;
+}
+
+template <class Op>
+DCMA_TARGET_AVX2 static void binary_avx2(float *d, const float *s, std::size_t N, const uint8_t *mask, const Op &op){
+    std::size_t i = 0;
+    for( ; (i + 8) <= N; i += 8){
+        const __m256 a = _mm256_loadu_ps(d + i);
+        const __m256 b = _mm256_loadu_ps(s + i);
+        __m256 r = op.avx2(a, b);
+        if(mask != nullptr) r = _mm256_blendv_ps(a, r, avx2_load_mask(mask + i));
+        _mm256_storeu_ps(d + i, r);
+    }
+    binary_scalar(d + i, s + i, N - i, (mask == nullptr) ? nullptr : (mask + i), op);
+    return;
+}
+
+DCMA_TARGET_AVX2 static void min_max_avx2(const float *d, std::size_t N, const uint8_t *mask, min_max &mm){
+    const __m256 pinf = _mm256_set1_ps( std::numeric_limits<float>::infinity() );
+    const __m256 ninf = _mm256_set1_ps( -std::numeric_limits<float>::infinity() );
+    __m256 acc_min = pinf;
+    __m256 acc_max = ninf;
+    std::size_t i = 0;
+    for( ; (i + 8) <= N; i += 8){
+        __m256 v_min = _mm256_loadu_ps(d + i);
+        __m256 v_max = v_min;
+        if(mask != nullptr){
+            const __m256 m = avx2_load_mask(mask + i);
+            v_min = _mm256_blendv_ps(pinf, v_min, m);
+            v_max = _mm256_blendv_ps(ninf, v_max, m);
+        }
+        // Note: min/max return the second operand when either is NaN, so NaNs are ignored.
+        acc_min = _mm256_min_ps(v_min, acc_min);
+        acc_max = _mm256_max_ps(v_max, acc_max);
+    }
+    alignas(32) float l_min[8];
+    alignas(32) float l_max[8];
+    _mm256_store_ps(l_min, acc_min);
+    _mm256_store_ps(l_max, acc_max);
+    for(std::size_t j = 0; j < 8; ++j){
+        if(l_min[j] < mm.min) mm.min = l_min[j];
+        if(mm.max < l_max[j]) mm.max = l_max[j];
+    }
+    min_max_scalar(d + i, N - i, (mask == nullptr) ? nullptr : (mask + i), mm);
+    return;
+}
+#endif // DCMA_PIXEL_KERNELS_AVX2
+
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+// Expands 4 mask bytes into a lane mask.
+static inline uint32x4_t neon_load_mask(const uint8_t *m){
+    const uint32_t w[4] = { (m[0] != 0) ? 0xFFFFFFFFU : 0U,
+                            (m[1] != 0) ? 0xFFFFFFFFU : 0U,
+                            (m[2] != 0) ? 0xFFFFFFFFU : 0U,
+                            (m[3] != 0) ? 0xFFFFFFFFU : 0U };
+    return vld1q_u32(w);
+}
+
+template <class Op>
+static void unary_neon(float *d, std::size_t N, const uint8_t *mask, const Op &op){
+    std::size_t i = 0;
+    for( ; (i + 4) <= N; i += 4){
+        const float32x4_t v = vld1q_f32(d + i);
+        float32x4_t r = op.neon(v);
+        if(mask != nullptr) r = vbslq_f32(neon_load_mask(mask + i), r, v);
+        vst1q_f32(d + i, r);
+    }
+    unary_scalar(d + i, N - i, (mask == nullptr) ? nullptr : (mask + i), op);
+    return;
+}
+
+template <class Op>
+static void binary_neon(float *d, const float *s, std::size_t N, const uint8_t *mask, const Op &op){
+    std::size_t i = 0;
+    for( ; (i + 4) <= N; i += 4){
+        const float32x4_t a = vld1q_f32(d + i);
+        const float32x4_t b = vld1q_f32(s + i);
+        float32x4_t r = op.neon(a, b);
+        if(mask != nullptr) r = vbslq_f32(neon_load_mask(mask + i), r, a);
+        vst1q_f32(d + i, r);
+    }
+    binary_scalar(d + i, s + i, N - i, (mask == nullptr) ? nullptr : (mask + i), op);
+    return;
+}
+
+static void min_max_neon(const float *d, std::size_t N, const uint8_t *mask, min_max &mm){
+    const float32x4_t pinf = vdupq_n_f32( std::numeric_limits<float>::infinity() );
+    const float32x4_t ninf = vdupq_n_f32( -std::numeric_limits<float>::infinity() );
+    float32x4_t acc_min = pinf;
+    float32x4_t acc_max = ninf;
+    std::size_t i = 0;
+    for( ; (i + 4) <= N; i += 4){
+        float32x4_t v_min = vld1q_f32(d + i);
+        float32x4_t v_max = v_min;
+        if(mask != nullptr){
+            const uint32x4_t m = neon_load_mask(mask + i);
+            v_min = vbslq_f32(m, v_min, pinf);
+            v_max = vbslq_f32(m, v_max, ninf);
+        }
+        // Note: the 'nm' variants return the numeric operand when one operand is NaN, so NaNs are ignored.
+        acc_min = vminnmq_f32(acc_min, v_min);
+        acc_max = vmaxnmq_f32(acc_max, v_max);
+    }
+    const float l_min = vminvq_f32(acc_min);
+    const float l_max = vmaxvq_f32(acc_max);
+    if(l_min < mm.min) mm.min = l_min;
+    if(mm.max < l_max) mm.max = l_max;
+    min_max_scalar(d + i, N - i, (mask == nullptr) ? nullptr : (mask + i), mm);
+    return;
+}
+#endif // DCMA_PIXEL_KERNELS_NEON
+
+
+// ------------------------------------------- Layout dispatch ----------------------------------------------------
+// Buffers with a single channel, or where every channel of every pixel is altered, are contiguous and can be
+// vectorized. Other layouts (i.e., a single channel of a multi-channel image, or masked multi-channel images) are
+// processed with a strided scalar loop.
+
+static bool buffer_is_trivial(const pixel_buffer &buf){
+    return (buf.data == nullptr)
+        || (buf.pixels == 0)
+        || ( (0 <= buf.channel) && (static_cast<std::size_t>(buf.channel) >= buf.channels) );
+}
+
+static bool buffer_is_contiguous(const pixel_buffer &buf){
+    return (buf.channels == 1)
+        || ( (buf.channel < 0) && (buf.mask == nullptr) );
+}
+
+template <class F>
+static void for_each_strided(const pixel_buffer &buf, F f){
+    for(std::size_t p = 0; p < buf.pixels; ++p){
+        if((buf.mask != nullptr) && (buf.mask[p] == 0)) continue;
+        for(std::size_t c = 0; c < buf.channels; ++c){
+            if((0 <= buf.channel) && (static_cast<std::size_t>(buf.channel) != c)) continue;
+            f(p * buf.channels + c);
+        }
+    }
+    return;
+}
+
+template <class Op>
+static void apply_unary(const pixel_buffer &buf, const Op &op){
+    if(buffer_is_trivial(buf)) return;
+
+    if(buffer_is_contiguous(buf)){
+        const auto N = buf.pixels * buf.channels;
+        switch(active_isa()){
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+            case isa_t::avx2: unary_avx2(buf.data, N, buf.mask, op); return;
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+            case isa_t::neon: unary_neon(buf.data, N, buf.mask, op); return;
+#endif
+            default: break;
+        }
+        unary_scalar(buf.data, N, buf.mask, op);
+        return;
+    }
+
+    for_each_strided(buf, [&](std::size_t i){
+        buf.data[i] = op.scalar(buf.data[i]);
+    });
+    return;
+}
+
+template <class Op>
+static void apply_binary(const pixel_buffer &buf, const float *src, const Op &op){
+    if(buffer_is_trivial(buf)) return;
+    if(src == nullptr){
+        throw std::invalid_argument("No source buffer provided. Refusing to continue.");
+    }
+
+    if(buffer_is_contiguous(buf)){
+        const auto N = buf.pixels * buf.channels;
+        switch(active_isa()){
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+            case isa_t::avx2: binary_avx2(buf.data, src, N, buf.mask, op); return;
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+            case isa_t::neon: binary_neon(buf.data, src, N, buf.mask, op); return;
+#endif
+            default: break;
+        }
+        binary_scalar(buf.data, src, N, buf.mask, op);
+        return;
+    }
+
+    for_each_strided(buf, [&](std::size_t i){
+        buf.data[i] = op.scalar(buf.data[i], src[i]);
+    });
+    return;
+}
+
+
+// ------------------------------------------- Public interface ---------------------------------------------------
+
+void Scale_Offset(pixel_buffer buf, float scale, float offset){
+    apply_unary(buf, op_scale_offset{ scale, offset });
+}
+
+void Clamp(pixel_buffer buf, float lower, float upper){
+    apply_unary(buf, op_clamp{ lower, upper });
+}
+
+void Threshold_Replace(pixel_buffer buf, float lower, float low_val, float upper, float high_val){
+    apply_unary(buf, op_threshold_replace{ lower, low_val, upper, high_val });
+}
+
+void Replace_Nonfinite(pixel_buffer buf, float replacement){
+    apply_unary(buf, op_replace_nonfinite{ replacement });
+}
+
+void Log(pixel_buffer buf){
+    // Note: there is no portable vectorized logarithm, so this kernel relies on the scalar path. The branch-free form
+    //       permits auto-vectorization when a vector math library is available.
+    if(buffer_is_trivial(buf)) return;
+    const auto f = [](float v) -> float {
+        return (0.0f < v) ? std::log(v) : std::numeric_limits<float>::quiet_NaN();
+    };
+    if(buffer_is_contiguous(buf)){
+        const auto N = buf.pixels * buf.channels;
+        for(std::size_t i = 0; i < N; ++i){
+            if((buf.mask == nullptr) || (buf.mask[i] != 0)) buf.data[i] = f(buf.data[i]);
+        }
+        return;
+    }
+    for_each_strided(buf, [&](std::size_t i){
+        buf.data[i] = f(buf.data[i]);
+    });
+    return;
+}
+
+void Add(pixel_buffer dst, const float *src){
+    apply_binary(dst, src, op_add{});
+}
+
+void Subtract(pixel_buffer dst, const float *src){
+    apply_binary(dst, src, op_subtract{});
+}
+
+void Multiply(pixel_buffer dst, const float *src){
+    apply_binary(dst, src, op_multiply{});
+}
+
+void Elementwise_Min(pixel_buffer dst, const float *src){
+    apply_binary(dst, src, op_min{});
+}
+
+void Elementwise_Max(pixel_buffer dst, const float *src){
+    apply_binary(dst, src, op_max{});
+}
+
+min_max Min_Max(pixel_buffer buf){
+    min_max mm;
+    if(buffer_is_trivial(buf)) return mm;
+
+    if(buffer_is_contiguous(buf)){
+        const auto N = buf.pixels * buf.channels;
+        switch(active_isa()){
+#if defined(DCMA_PIXEL_KERNELS_AVX2)
+            case isa_t::avx2: min_max_avx2(buf.data, N, buf.mask, mm); return mm;
+#endif
+#if defined(DCMA_PIXEL_KERNELS_NEON)
+            case isa_t::neon: min_max_neon(buf.data, N, buf.mask, mm); return mm;
+#endif
+            default: break;
+        }
+        min_max_scalar(buf.data, N, buf.mask, mm);
+        return mm;
+    }
+
+    for_each_strided(buf, [&](std::size_t i){
+        const auto v = buf.data[i];
+        if(v < mm.min) mm.min = v;
+        if(mm.max < v) mm.max = v;
+    });
+    return mm;
+}
+
+std::vector<uint8_t>
+ROI_Mask(planar_image<float,double> &img,
+         std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+         Mutate_Voxels_Opts mv_opts){
+
+    std::vector<uint8_t> mask( static_cast<std::size_t>(img.rows) * static_cast<std::size_t>(img.columns), 0 );
+    if(ccsl.empty()) return mask;
+
+    // Voxel values are only visited, never altered.
+    mv_opts.editstyle = Mutate_Voxels_Opts::EditStyle::InPlace;
+    mv_opts.maskmod   = Mutate_Voxels_Opts::MaskMod::Noop;
+
+    const auto columns = img.columns;
+    auto f_bounded = [&](long int row, long int col, long int, std::reference_wrapper<planar_image<float,double>>, float &) {
+        mask[ static_cast<std::size_t>(row * columns + col) ] = 1;
+        return;
+    };
+
+    std::reference_wrapper<planar_image<float,double>> img_refw( std::ref(img) );
+    Mutate_Voxels<float,double>( img_refw,
+                                 { img_refw },
+                                 ccsl,
+                                 mv_opts,
+                                 f_bounded );
+    return mask;
+}
+
+} // namespace pixel_kernels
+
@@ -0,0 +1,102 @@
+//Pixel_Kernels.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+template <class T> class contour_collection;
+
+
+// This module provides bulk arithmetic kernels that operate directly on planar_image pixel buffers.
+//
+// Kernels are vectorized with AVX2 (x86) or NEON (ARM) when available, with a scalar fallback. On x86 the instruction
+// set is selected at runtime, so binaries remain portable. Kernels operate in-place and can be restricted to a single
+// channel and/or to pixels selected by a per-pixel mask.
+//
+// Note: NaN handling matches the per-voxel routines these kernels replace. In particular, NaNs are ignored by the
+//       min/max reductions and are propagated by clamping.
+namespace pixel_kernels {
+
+// A view of a planar_image's pixel buffer.
+//
+// Pixels are stored contiguously with interleaved channels. The mask, if provided, holds one byte per pixel (i.e.,
+// rows*columns bytes, not one per channel); nonzero bytes mark pixels that should be altered.
+struct pixel_buffer {
+    float *data = nullptr;
+    std::size_t pixels = 0;          // rows * columns.
+    std::size_t channels = 1;
+    long int channel = -1;           // The channel to operate on. Negative values select all channels.
+    const uint8_t *mask = nullptr;   // Optional per-pixel mask.
+};
+
+// Creates a view of the given image. The image (and mask, if provided) must outlive the view.
+pixel_buffer
+Pixel_Buffer(planar_image<float,double> &img,
+             long int channel = -1,
+             const std::vector<uint8_t> *mask = nullptr);
+
+// Returns the name of the instruction set that will be used by the kernels ("avx2", "neon", or "scalar").
+const char *
+Active_Instruction_Set(void);
+
+
+// ------------------------------------------- Unary, in-place kernels --------------------------------------------
+
+// v = v * scale + offset.
+void Scale_Offset(pixel_buffer buf, float scale, float offset);
+
+// v = clamp(v, lower, upper).
+void Clamp(pixel_buffer buf, float lower, float upper);
+
+// v = low_val if !(lower < v); then v = high_val if !(v < upper). This matches the ThresholdImages operation.
+void Threshold_Replace(pixel_buffer buf, float lower, float low_val, float upper, float high_val);
+
+// v = replacement if v is NaN or infinite.
+void Replace_Nonfinite(pixel_buffer buf, float replacement);
+
+// v = log(v) if 0 < v, otherwise NaN.
+void Log(pixel_buffer buf);
+
+
+// ------------------------------------------- Pairwise, in-place kernels -----------------------------------------
+// The source buffer must share the destination buffer's layout. The destination's channel and mask are honoured.
+
+void Add(pixel_buffer dst, const float *src);
+void Subtract(pixel_buffer dst, const float *src);
+void Multiply(pixel_buffer dst, const float *src);
+void Elementwise_Min(pixel_buffer dst, const float *src);
+void Elementwise_Max(pixel_buffer dst, const float *src);
+
+
+// ------------------------------------------- Reductions ----------------------------------------------------------
+
+struct min_max {
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+
+    bool valid(void) const { return (this->min <= this->max); }
+};
+
+// Finds the extrema, ignoring NaNs. The channel and mask are honoured.
+min_max Min_Max(pixel_buffer buf);
+
+
+// ------------------------------------------- Masks ---------------------------------------------------------------
+
+// Rasterizes the given ROIs onto the image using the same inclusivity and contour overlap semantics as Mutate_Voxels.
+// Each pixel with any bounded voxel is marked with a nonzero byte.
+std::vector<uint8_t>
+ROI_Mask(planar_image<float,double> &img,
+         std::list<std::reference_wrapper<contour_collection<double>>> ccsl,
+         Mutate_Voxels_Opts mv_opts);
+
+} // namespace pixel_kernels
+
@@ -5,6 +5,7 @@
 #include <list>
 
 #include "../ConvenienceRoutines.h"
+#include "../Pixel_Kernels.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
@@ -26,22 +27,17 @@ bool CTNaNsToAir(planar_image_collection<float,double>::images_list_it_t first_i
         return false;
     }
 
+    //Replace non-finite values in all channels of all pixels in bulk.
+    const auto buf = pixel_kernels::Pixel_Buffer(*first_img_it);
+    pixel_kernels::Replace_Nonfinite(buf, -1024.0f);
+
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
-
-    //Loop over the rows, columns, channels, and finally selected_images in the time course.
-    for(auto row = 0; row < first_img_it->rows; ++row){
-        for(auto col = 0; col < first_img_it->columns; ++col){
-            for(auto chan = 0; chan < first_img_it->channels; ++chan){
-
-                const auto val = first_img_it->value(row, col, chan);
-                const auto newval = std::isfinite(val) ? val : -1024.0f;
-                first_img_it->reference(row, col, chan) = newval;
-                minmax_pixel.Digest(newval);
-
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+    const auto mm = pixel_kernels::Min_Max(buf);
+    if(mm.valid()){
+        minmax_pixel.Digest(mm.min);
+        minmax_pixel.Digest(mm.max);
+    }
 
     UpdateImageDescription( std::ref(*first_img_it), "NaN Pixel Filtered" );
     UpdateImageWindowCentreWidth( std::ref(*first_img_it), minmax_pixel );
@@ -7,6 +7,7 @@
 
 #include "../../BED_Conversion.h"
 #include "../ConvenienceRoutines.h"
+#include "../Dose_Transform.h"
 #include "DecayDoseOverTime.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -66,30 +67,20 @@ bool DecayDoseOverTime(planar_image_collection<float,double>::images_list_it_t f
 
     //Record the min and max (outgoing) pixel values for windowing purposes.
     Mutate_Voxels_Opts ebv_opts;
-    ebv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace; // Note: the mask scheme below requires in-place in order to decay with a single pass.
+    ebv_opts.editstyle      = Mutate_Voxels_Opts::EditStyle::InPlace;
     ebv_opts.inclusivity    = Mutate_Voxels_Opts::Inclusivity::Inclusive;
     ebv_opts.contouroverlap = Mutate_Voxels_Opts::ContourOverlap::HonourOppositeOrientations;
     ebv_opts.aggregate      = Mutate_Voxels_Opts::Aggregate::Mean;
     ebv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
     ebv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
-    auto f_bounded = [=](long int row, long int col, long int channel, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
+    dose_transform::voxel_transform t_decay;
+    if(false){
+    }else if(user_data_s->model == DecayDoseOverTimeMethod::Halve){
+        t_decay = dose_transform::Scale_Transform(0.5);
 
-        // First, check if the mask is set for this voxel. If it is, do NOT re-process.
-        // It means the voxel has been processed in a previous decay operation (e.g., for another overlapping ROI) and
-        // should not be decayed again.
-        const auto mask_val = first_img_it->value(row, col, 1);
-        if(mask_val != 0.0) return;
-
-        // If the voxel is in the mask channel, disregard it.
-        if(channel == 1) return;
-
-        // Otherwise, perform the decay and then mark the mask.
-        if(false){
-        }else if(user_data_s->model == DecayDoseOverTimeMethod::Halve){
-            voxel_val *= 0.5;
-
-        }else if(user_data_s->model == DecayDoseOverTimeMethod::Jones_and_Grant_2014){
+    }else if(user_data_s->model == DecayDoseOverTimeMethod::Jones_and_Grant_2014){
+        t_decay.general = [=](double voxel_val) -> double {
             const auto BED_abr_c1 = BEDabr_from_n_D_abr(user_data_s->Course1NumberOfFractions, 
                                                         voxel_val,
                                                         user_data_s->AlphaBetaRatio);
@@ -103,36 +94,38 @@ bool DecayDoseOverTime(planar_image_collection<float,double>::images_list_it_t f
 
                 const auto D_c1_eff = D_from_n_BEDabr(user_data_s->Course1NumberOfFractions,
                                                       BED_abr_c1_eff);
-                voxel_val = D_c1_eff;
-
-                //Debugging/validation:
-                //if( ((row == 0) && (col == 19)) || ( (row == 9) && (col == 9)) ){
-                //    FUNCINFO("BED_abr_tol    = " << BED_abr_tol.val);
-                //    FUNCINFO("r              = " << r);
-                //    FUNCINFO("r_exp          = " << r_exp);
-                //    FUNCINFO("Dincoming      = " << voxel_val);
-                //    FUNCINFO("BED_abr_c1     = " << BED_abr_c1.val);
-                //    FUNCINFO("BED_ratio      = " << BED_ratio);
-                //    FUNCINFO("BED_C1_eff     = " << BED_abr_c1_eff.val);
-                //    FUNCINFO("Doutgoing      = " << D_c1_eff);
-                //}
+                return D_c1_eff;
             }
+            return voxel_val;
+        };
+
+    }else{
+        throw std::logic_error("Provided an invalid model. Cannot continue.");
+    }
+    t_decay.alter_nonpositive = true; // Decay applies to every bounded voxel, regardless of dose.
+
+    //Label the voxels bounded by the ROIs once, so overlapping ROIs do not cause voxels to be decayed repeatedly.
+    // Voxels already marked in the mask channel (i.e., decayed by a previous operation) are also excluded.
+    auto tm = dose_transform::Build_Tissue_Map(*first_img_it, { ccsl }, ebv_opts);
+    for(long int row = 0; row < tm.rows; ++row){
+        for(long int col = 0; col < tm.columns; ++col){
+            auto &l = tm.labels[row * tm.columns + col];
+            if(first_img_it->value(row, col, 1) != 0.0) l = 0;
+        }
+    }
 
-        }else{
-            throw std::logic_error("Provided an invalid model. Cannot continue.");
+    //Decay the dose in a single pass. The mask channel is disregarded.
+    for(long int chan = 0; chan < first_img_it->channels; ++chan){
+        if(chan == 1) continue;
+        dose_transform::Apply_Transforms(*first_img_it, chan, tm, { dose_transform::Identity_Transform(), t_decay });
+    }
+
+    //Mark the mask.
+    for(long int row = 0; row < tm.rows; ++row){
+        for(long int col = 0; col < tm.columns; ++col){
+            if(tm.labels[row * tm.columns + col] != 0) first_img_it->reference(row, col, 1) = 1.0;
         }
-        first_img_it->reference(row, col, 1) = 1.0;
-        return;
-    };
-
-    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-    for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
-
-    Mutate_Voxels<float,double>( std::ref(*first_img_it),
-                                 selected_imgs, 
-                                 ccsl, 
-                                 ebv_opts, 
-                                 f_bounded );
+    }
 
     //Alter the first image's metadata to reflect that averaging has occurred. You might want to consider
     // a selective whitelist approach so that unique IDs are not duplicated accidentally.
@@ -9,6 +9,7 @@
 
 #include "../../BED_Conversion.h"
 #include "../ConvenienceRoutines.h"
+#include "../Dose_Transform.h"
 #include "EQDConversion.h"
 #include "YgorImages.h"
 #include "YgorMisc.h"
@@ -51,8 +52,8 @@ bool EQDConversion(planar_image_collection<float,double>::images_list_it_t first
     ebv_opts.adjacency      = Mutate_Voxels_Opts::Adjacency::SingleVoxel;
     ebv_opts.maskmod        = Mutate_Voxels_Opts::MaskMod::Noop;
 
-    std::function< void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &) > f_bounded;
-    std::function< void(long int, long int, long int, std::reference_wrapper<planar_image<float,double>>, float &) > f_unbounded;
+    dose_transform::voxel_transform t_bounded;
+    dose_transform::voxel_transform t_unbounded;
 
     if(false){
     }else if(user_data_s->model == EQDConversionUserData::Model::SimpleLinearQuadratic){
@@ -67,27 +68,12 @@ bool EQDConversion(planar_image_collection<float,double>::images_list_it_t first
             throw std::invalid_argument("AlphaBetaRatioNormal not specified or invalid.");
         }
 
-        f_bounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto numer = D_voxel * ( (D_voxel / user_data_s->NumberOfFractions) + user_data_s->AlphaBetaRatioTumour );
-            const auto denom = (user_data_s->TargetDosePerFraction + user_data_s->AlphaBetaRatioTumour );
-            const auto EQD = numer / denom;
-            voxel_val = EQD;
-            return;
-        };
-
-        f_unbounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            const auto D_voxel = voxel_val;
-            const auto numer = D_voxel * ( (D_voxel / user_data_s->NumberOfFractions) + user_data_s->AlphaBetaRatioNormal );
-            const auto denom = (user_data_s->TargetDosePerFraction + user_data_s->AlphaBetaRatioNormal );
-            const auto EQD = numer / denom;
-            voxel_val = EQD;
-            return;
-        };
+        t_unbounded = dose_transform::LQ_EQD_Transform(user_data_s->AlphaBetaRatioNormal,
+                                                       user_data_s->NumberOfFractions,
+                                                       user_data_s->TargetDosePerFraction);
+        t_bounded = dose_transform::LQ_EQD_Transform(user_data_s->AlphaBetaRatioTumour,
+                                                     user_data_s->NumberOfFractions,
+                                                     user_data_s->TargetDosePerFraction);
 
         first_img_it->metadata["EQD_NumberOfFractions"] = std::to_string(user_data_s->NumberOfFractions);
         first_img_it->metadata["EQD_Model"] = "Pinned LQ";
@@ -127,27 +113,12 @@ bool EQDConversion(planar_image_collection<float,double>::images_list_it_t first
             EQD_n = EQD_D / user_data_s->TargetDosePerFraction;
         }
 
-        f_bounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            BEDabr BED_voxel;
-            BED_voxel = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions,
-                                            voxel_val,
-                                            user_data_s->AlphaBetaRatioTumour);
-            voxel_val = D_from_n_BEDabr(EQD_n, BED_voxel);
-            return;
-        };
-
-        f_unbounded = [=](long int /*row*/, long int /*col*/, long int /*channel*/, std::reference_wrapper<planar_image<float,double>> /*img_refw*/, float &voxel_val) {
-            if(voxel_val <= 0.0) return; // No-op if there is no dose.
-
-            BEDabr BED_voxel;
-            BED_voxel = BEDabr_from_n_D_abr(user_data_s->NumberOfFractions,
-                                            voxel_val,
-                                            user_data_s->AlphaBetaRatioNormal);
-            voxel_val = D_from_n_BEDabr(EQD_n, BED_voxel);
-            return;
-        };
+        t_unbounded = dose_transform::LQ_Pinned_EQD_Transform(user_data_s->AlphaBetaRatioNormal,
+                                                              user_data_s->NumberOfFractions,
+                                                              EQD_n);
+        t_bounded = dose_transform::LQ_Pinned_EQD_Transform(user_data_s->AlphaBetaRatioTumour,
+                                                            user_data_s->NumberOfFractions,
+                                                            EQD_n);
 
         first_img_it->metadata["EQD_PrescriptionDose"] = std::to_string(user_data_s->PrescriptionDose);
         first_img_it->metadata["EQD_NumberOfFractions"] = std::to_string(user_data_s->NumberOfFractions);
@@ -162,15 +133,9 @@ bool EQDConversion(planar_image_collection<float,double>::images_list_it_t first
         throw std::invalid_argument("Model not specified or invalid.");
     }
 
-    std::list<std::reference_wrapper<planar_image<float,double>>> selected_imgs;
-    for(auto &img_it : selected_img_its) selected_imgs.push_back( std::ref(*img_it) );
-
-    Mutate_Voxels<float,double>( std::ref(*first_img_it),
-                                 selected_imgs, 
-                                 ccsl, 
-                                 ebv_opts, 
-                                 f_bounded,
-                                 f_unbounded );
+    //Label the voxels bounded by the ROIs once, and then transform all voxels in a single pass.
+    const auto tm = dose_transform::Build_Tissue_Map(*first_img_it, { ccsl }, ebv_opts);
+    dose_transform::Apply_Transforms(*first_img_it, -1, tm, { t_unbounded, t_bounded });
 
     //Alter the first image's metadata to reflect that averaging has occurred. You might want to consider
     // a selective whitelist approach so that unique IDs are not duplicated accidentally.
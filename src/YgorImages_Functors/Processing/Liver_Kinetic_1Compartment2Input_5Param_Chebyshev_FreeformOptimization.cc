@@ -27,6 +27,7 @@
 #include "../../Common_Plotting.h"
 #include "../../KineticModel_1Compartment2Input_5Param_Chebyshev_Common.h"
 #include "../../KineticModel_1Compartment2Input_5Param_Chebyshev_FreeformOptimization.h"
+#include "../../Contour_Index.h"
 #include "../ConvenienceRoutines.h"
 #include "Liver_Kinetic_1Compartment2Input_5Param_Chebyshev_Common.h"
 #include "Liver_Kinetic_1Compartment2Input_5Param_Chebyshev_FreeformOptimization.h"
@@ -166,10 +167,11 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
     }
 
 
+    //Index the contours so point-in-polygon checks only visit the edges near each voxel.
+    contour_index::index cindex;
+    cindex.refresh(cc_ROIs);
+
     //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
-    const auto row_unit   = first_img_it->row_unit;
-    const auto col_unit   = first_img_it->col_unit;
-    const auto ortho_unit = row_unit.Cross( col_unit ).unit();
 
     size_t Minimization_Failure_Count = 0;
 
@@ -186,8 +188,10 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
     //
     // NOTE: We expect optimization to take far longer than cycling through the contours and images.
     double Expected_Operation_Count = 0.0;
+    size_t entry_n = 0;
     for(auto &ccs : cc_ROIs){
         for(auto & contour : ccs.get().contours){
+            const auto &e = cindex.get_entries().at(entry_n++);
             if(contour.points.empty()) continue;
             if(! first_img_it->encompasses_contour_of_points(contour)) continue;
 
@@ -205,10 +209,6 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
             const bool BBoxAlreadyProjected = true;
     */
     
-            //Prepare a contour for fast is-point-within-the-polygon checking.
-            auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-            auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
     
             for(auto row = 0; row < first_img_it->rows; ++row){
                 for(auto col = 0; col < first_img_it->columns; ++col){
@@ -224,10 +224,7 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
     */
     
                     //Perform a more detailed check to see if we are in the ROI.
-                    auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                   ProjectedPoint,
-                                                                                   AlreadyProjected)){
+                    if(e.encloses(point, std::numeric_limits<double>::infinity())){
                         for(auto chan = 0; chan < first_img_it->channels; ++chan){
    
                             Expected_Operation_Count += 1.0;
@@ -253,8 +250,10 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
     //for(const auto &roi : rois){
     boost::posix_time::ptime start_t = boost::posix_time::microsec_clock::local_time();
     double Actual_Operation_Count = 0.0;
+    entry_n = 0;
     for(auto &ccs : cc_ROIs){
         for(auto & contour : ccs.get().contours){
+            const auto &e = cindex.get_entries().at(entry_n++);
             if(contour.points.empty()) continue;
             //if(first_img_it->encompasses_contour_of_points(*it)) rois.push_back(it);
 
@@ -275,10 +274,6 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
             const bool BBoxAlreadyProjected = true;
     */
     
-            //Prepare a contour for fast is-point-within-the-polygon checking.
-            auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-            auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
     
             for(auto row = 0; row < first_img_it->rows; ++row){
                 for(auto col = 0; col < first_img_it->columns; ++col){
@@ -294,10 +289,7 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
     */
     
                     //Perform a more detailed check to see if we are in the ROI.
-                    auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                   ProjectedPoint,
-                                                                                   AlreadyProjected)){
+                    if(e.encloses(point, std::numeric_limits<double>::infinity())){
                         for(auto chan = 0; chan < first_img_it->channels; ++chan){
 
                             //Provide a prediction time.
@@ -332,10 +324,7 @@ KineticModel_Liver_1C2I_5Param_Chebyshev_FreeformOptimization(planar_image_colle
                                         //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
                                         //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
                                         const auto neighbourpoint = first_img_it->position(lrow,lcol);
-                                        auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                        if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                        ProjectedNeighbourPoint,
-                                                                                                        AlreadyProjected)) continue;
+                                        if(!e.encloses(neighbourpoint, std::numeric_limits<double>::infinity())) continue;
                                         const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
                                         in_pixs.push_back(val);
                                     }
@@ -7,6 +7,7 @@
 #include <stdexcept>
 
 #include "../ConvenienceRoutines.h"
+#include "../Pixel_Kernels.h"
 #include "YgorImages.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
 
@@ -24,23 +25,17 @@ bool LogScalePixels(planar_image_collection<float,double>::images_list_it_t firs
 
     if(selected_img_its.size() != 1) throw std::invalid_argument("This routine operates on individual images only");
 
-    //Record the min and max (outgoing) pixel values for windowing purposes.
-    Stats::Running_MinMax<float> minmax_pixel;
+    //Scale all channels of all pixels in bulk. Non-positive pixels become NaN.
+    const auto buf = pixel_kernels::Pixel_Buffer(*first_img_it);
+    pixel_kernels::Log(buf);
 
-    //Loop over the rows, columns, and channels.
-    for(auto row = 0; row < first_img_it->rows; ++row){
-        for(auto col = 0; col < first_img_it->columns; ++col){
-            for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                const auto pixel_val = first_img_it->value(row, col, chan);
-                first_img_it->reference(row, col, chan) = std::numeric_limits<float>::quiet_NaN();
-                if(pixel_val > static_cast<float>(0)){
-                    const auto newval = std::log(pixel_val);
-                    first_img_it->reference(row, col, chan) = newval;
-                    minmax_pixel.Digest(newval);
-                }
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+    //Record the min and max (outgoing) pixel values for windowing purposes. NaNs are ignored.
+    Stats::Running_MinMax<float> minmax_pixel;
+    const auto mm = pixel_kernels::Min_Max(buf);
+    if(mm.valid()){
+        minmax_pixel.Digest(mm.min);
+        minmax_pixel.Digest(mm.max);
+    }
 
     UpdateImageDescription( std::ref(*first_img_it), "Log-Scaled" );
     UpdateImageWindowCentreWidth( std::ref(*first_img_it), minmax_pixel );
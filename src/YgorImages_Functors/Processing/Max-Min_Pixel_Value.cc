@@ -3,10 +3,12 @@
 #include <algorithm>
 #include <functional>
 #include <list>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
 #include "../ConvenienceRoutines.h"
+#include "../Pixel_Kernels.h"
 #include "Max-Min_Pixel_Value.h"
 #include "YgorImages.h"
 #include "YgorStats.h"       //Needed for Stats:: namespace.
@@ -22,28 +24,43 @@ bool CondenseMaxMinPixel(planar_image_collection<float,double>::images_list_it_t
     //This routine replaces pixels with the (max)-(min), which is useful for finding low-contrast structures
     // or structures with dynamic pixel values (e.g., movement, contrast enhancement).
 
+    if(selected_img_its.empty()) throw std::invalid_argument("No images provided. Cannot continue");
+
+    //All images must share a layout so that pixel buffers can be combined directly.
+    for(auto &an_img_it : selected_img_its){
+        if( (an_img_it->rows != first_img_it->rows)
+        ||  (an_img_it->columns != first_img_it->columns)
+        ||  (an_img_it->channels != first_img_it->channels) ){
+            throw std::invalid_argument("Images do not share a common layout. Cannot continue");
+        }
+    }
+
+    //Accumulate the element-wise extrema over the time course in bulk.
+    std::vector<float> maxs = selected_img_its.front()->data;
+    std::vector<float> mins = maxs;
+
+    pixel_kernels::pixel_buffer maxs_buf;
+    maxs_buf.data = maxs.data();
+    maxs_buf.pixels = static_cast<std::size_t>(first_img_it->rows) * static_cast<std::size_t>(first_img_it->columns);
+    maxs_buf.channels = static_cast<std::size_t>(first_img_it->channels);
+
+    auto mins_buf = maxs_buf;
+    mins_buf.data = mins.data();
+
+    for(auto &an_img_it : selected_img_its){
+        pixel_kernels::Elementwise_Max(maxs_buf, an_img_it->data.data());
+        pixel_kernels::Elementwise_Min(mins_buf, an_img_it->data.data());
+    }
+    pixel_kernels::Subtract(maxs_buf, mins.data());
+    first_img_it->data = std::move(maxs);
+
     //Record the min and max actual pixel values for windowing purposes.
     Stats::Running_MinMax<float> minmax_pixel;
-
-    //Loop over the rows, columns, channels, and finally selected_images in the time course.
-    for(auto row = 0; row < first_img_it->rows; ++row){
-        for(auto col = 0; col < first_img_it->columns; ++col){
-            for(auto chan = 0; chan < first_img_it->channels; ++chan){
-                std::vector<float> pixel_vals;
-                pixel_vals.reserve(selected_img_its.size());
-                for(auto &an_img_it : selected_img_its){
-                    const auto pixel_val = an_img_it->value(row, col, chan);
-                    pixel_vals.push_back( pixel_val );
-                }
-
-                const auto theminmax = std::minmax_element(pixel_vals.begin(), pixel_vals.end());
-                const auto newval = (*theminmax.second) - (*theminmax.first);
-                first_img_it->reference(row, col, chan) = newval;
-                minmax_pixel.Digest(newval);
-
-            }//Loop over channels.
-        } //Loop over cols
-    } //Loop over rows
+    const auto mm = pixel_kernels::Min_Max( pixel_kernels::Pixel_Buffer(*first_img_it) );
+    if(mm.valid()){
+        minmax_pixel.Digest(mm.min);
+        minmax_pixel.Digest(mm.max);
+    }
 
     UpdateImageDescription( std::ref(*first_img_it), "Max-Min(pixel) Map" );
     UpdateImageWindowCentreWidth( std::ref(*first_img_it), minmax_pixel );
@@ -4,9 +4,11 @@
 #include <any>
 #include <optional>
 #include <functional>
+#include <limits>
 #include <list>
 #include <map>
 
+#include "../../Contour_Index.h"
 #include "../ConvenienceRoutines.h"
 #include "Per_ROI_Time_Courses.h"
 #include "YgorImages.h"
@@ -71,15 +73,18 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
     //Paint all pixels black.
     working.fill_pixels(static_cast<float>(0));
 
+    //Index the contours so point-in-polygon checks only visit the edges near each voxel.
+    contour_index::index cindex;
+    cindex.refresh(ccsl);
+
     //Loop over the rois, rows, columns, channels, and finally any selected images (if applicable).
-    const auto row_unit   = first_img_it->row_unit;
-    const auto col_unit   = first_img_it->col_unit;
-    const auto ortho_unit = row_unit.Cross( col_unit ).unit();
 
     //Loop over the ccsl, rois, rows, columns, channels, and finally any selected images (if applicable).
     //for(const auto &roi : rois){
+    size_t entry_n = 0;
     for(auto &ccs : ccsl){
         for(auto & contour : ccs.get().contours){
+            const auto &e = cindex.get_entries().at(entry_n++);
             if(contour.points.empty()) continue;
             //if(first_img_it->encompasses_contour_of_points(*it)) rois.push_back(it);
 
@@ -118,10 +123,6 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
             const bool BBoxAlreadyProjected = true;
     */
     
-            //Prepare a contour for fast is-point-within-the-polygon checking.
-            auto BestFitPlane = contour.Least_Squares_Best_Fit_Plane(ortho_unit);
-            auto ProjectedContour = contour.Project_Onto_Plane_Orthogonally(BestFitPlane);
-            const bool AlreadyProjected = true;
     
             for(auto row = 0; row < first_img_it->rows; ++row){
                 for(auto col = 0; col < first_img_it->columns; ++col){
@@ -137,10 +138,7 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
     */
     
                     //Perform a more detailed check to see if we are in the ROI.
-                    auto ProjectedPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(point);
-                    if(ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                   ProjectedPoint,
-                                                                                   AlreadyProjected)){
+                    if(e.encloses(point, std::numeric_limits<double>::infinity())){
                         for(auto chan = 0; chan < first_img_it->channels; ++chan){
                             //Check if another ROI has already written to this voxel. Bail if so.
                             {
@@ -167,10 +165,7 @@ bool PerROITimeCourses(planar_image_collection<float,double>::images_list_it_t f
                                         //const auto boxpoint = first_img_it->spatial_location(row,col);  //For standard contours(?).
                                         //const auto neighbourpoint = vec3<double>(lrow*1.0, lcol*1.0, SliceLocation*1.0);  //For the pixel integer contours.
                                         const auto neighbourpoint = first_img_it->position(lrow,lcol);
-                                        auto ProjectedNeighbourPoint = BestFitPlane.Project_Onto_Plane_Orthogonally(neighbourpoint);
-                                        if(!ProjectedContour.Is_Point_In_Polygon_Projected_Orthogonally(BestFitPlane,
-                                                                                                        ProjectedNeighbourPoint,
-                                                                                                        AlreadyProjected)) continue;
+                                        if(!e.encloses(neighbourpoint, std::numeric_limits<double>::infinity())) continue;
                                         const auto val = static_cast<double>(img_it->value(lrow, lcol, chan));
                                         in_pixs.push_back(val);
                                     }
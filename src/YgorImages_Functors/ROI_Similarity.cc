@@ -0,0 +1,353 @@
+//ROI_Similarity.cc.
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Connected_Components.h"
+#include "Distance_Transform.h"
+#include "Grid_Resampling.h"
+#include "ROI_Similarity.h"
+#include "YgorMath.h"
+
+
+namespace roi_similarity {
+
+packed_mask::packed_mask(long int rows, long int columns, long int slices)
+    : rows(rows), columns(columns), slices(slices), words_per_row((columns + 63) / 64) {
+    if( (rows < 0) || (columns < 0) || (slices < 0) ){
+        throw std::invalid_argument("Mask dimensions must be non-negative");
+    }
+    this->words.assign( static_cast<size_t>(this->words_per_row)
+                      * static_cast<size_t>(rows)
+                      * static_cast<size_t>(slices), 0 );
+}
+
+const uint64_t *packed_mask::row(long int slice, long int row) const {
+    return this->words.data() + (static_cast<size_t>(slice) * static_cast<size_t>(this->rows)
+                                 + static_cast<size_t>(row)) * static_cast<size_t>(this->words_per_row);
+}
+
+uint64_t *packed_mask::row(long int slice, long int row){
+    return this->words.data() + (static_cast<size_t>(slice) * static_cast<size_t>(this->rows)
+                                 + static_cast<size_t>(row)) * static_cast<size_t>(this->words_per_row);
+}
+
+bool packed_mask::get(long int slice, long int row, long int column) const {
+    return ((this->row(slice, row)[column / 64] >> (column % 64)) & 1U) != 0;
+}
+
+uint64_t packed_mask::count(void) const {
+    uint64_t n = 0;
+    for(const auto &w : this->words) n += std::bitset<64>(w).count();
+    return n;
+}
+
+
+// Sets bits [c0, c1) of a row.
+static void set_span(uint64_t *row, long int c0, long int c1){
+    while(c0 < c1){
+        const auto b = c0 % 64;
+        const auto n = std::min<long int>(64 - b, c1 - c0);
+        const uint64_t m = (n == 64) ? ~static_cast<uint64_t>(0)
+                                     : (((static_cast<uint64_t>(1) << n) - 1) << b);
+        row[c0 / 64] |= m;
+        c0 += n;
+    }
+}
+
+// A contour projected into continuous (column, row) index coordinates on a single image.
+struct projected_contour {
+    std::vector<std::array<double,2>> verts;
+    double row_min = std::numeric_limits<double>::infinity();
+    double row_max = -std::numeric_limits<double>::infinity();
+};
+
+packed_mask
+Rasterize_ROI(const grid_resampling::rectilinear_grid &grid,
+              const std::list<std::reference_wrapper<contour_collection<double>>> &ccs){
+
+    const auto N_slices = grid.slices();
+    packed_mask out(grid.rows, grid.columns, N_slices);
+    if(N_slices <= 0) return out;
+
+    // Assign each contour to the nearest image.
+    std::vector<std::vector<projected_contour>> per_slice(N_slices);
+    for(const auto &cc_refw : ccs){
+        for(const auto &c : cc_refw.get().contours){
+            if(c.points.size() < 3) continue;
+
+            vec3<double> centre(0.0, 0.0, 0.0);
+            for(const auto &p : c.points) centre += p;
+            centre = centre / static_cast<double>(c.points.size());
+            const auto z = (centre - grid.origin).Dot(grid.img_unit);
+
+            const auto &o = grid.slice_offsets;
+            auto it = std::lower_bound(std::begin(o), std::end(o), z);
+            if( (it == std::end(o))
+            ||  ((it != std::begin(o)) && ((z - *std::prev(it)) < (*it - z))) ){
+                --it;
+            }
+            const auto k = static_cast<size_t>(std::distance(std::begin(o), it));
+            if((0.5 * grid.imgs[k]->pxl_dz) < std::abs(z - *it)) continue;
+
+            projected_contour pc;
+            pc.verts.reserve(c.points.size());
+            for(const auto &p : c.points){
+                const auto dP = p - grid.origin;
+                const auto r = dP.Dot(grid.row_unit) / grid.pxl_dx;
+                pc.verts.push_back({{ dP.Dot(grid.col_unit) / grid.pxl_dy, r }});
+                pc.row_min = std::min(pc.row_min, r);
+                pc.row_max = std::max(pc.row_max, r);
+            }
+            per_slice[k].emplace_back(std::move(pc));
+        }
+    }
+
+    // Fill voxel centres along each row using the crossings of every contour edge.
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < N_slices; ++k){
+            if(per_slice[k].empty()) continue;
+            tp.submit_task([&,k](void) -> void {
+                std::vector<double> xs;
+                for(const auto &pc : per_slice[k]){
+                    const auto r_lo = std::max<long int>(0L, static_cast<long int>(std::ceil(pc.row_min)));
+                    const auto r_hi = std::min<long int>(grid.rows - 1, static_cast<long int>(std::floor(pc.row_max)));
+                    const auto N_verts = pc.verts.size();
+                    for(long int r = r_lo; r <= r_hi; ++r){
+                        const auto y = static_cast<double>(r);
+                        xs.clear();
+                        for(size_t i = 0; i < N_verts; ++i){
+                            const auto &a = pc.verts[i];
+                            const auto &b = pc.verts[(i + 1) % N_verts];
+                            if((y < a[1]) != (y < b[1])){
+                                xs.push_back( a[0] + (y - a[1]) * (b[0] - a[0]) / (b[1] - a[1]) );
+                            }
+                        }
+                        std::sort(std::begin(xs), std::end(xs));
+
+                        auto *row = out.row(k, r);
+                        for(size_t i = 0; (i + 1) < xs.size(); i += 2){
+                            const auto c0 = std::max<long int>(0L, static_cast<long int>(std::ceil(xs[i])));
+                            const auto c1 = std::min<long int>(grid.columns, static_cast<long int>(std::ceil(xs[i + 1])));
+                            set_span(row, c0, c1);
+                        }
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    return out;
+}
+
+
+packed_mask
+Surface_Voxels(const packed_mask &m){
+    packed_mask out(m.rows, m.columns, m.slices);
+    const auto W = m.words_per_row;
+
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < m.slices; ++k){
+            tp.submit_task([&,k](void) -> void {
+                for(long int r = 0; r < m.rows; ++r){
+                    const auto *cur  = m.row(k, r);
+                    const auto *up   = (0 < r)              ? m.row(k, r - 1) : nullptr;
+                    const auto *down = ((r + 1) < m.rows)   ? m.row(k, r + 1) : nullptr;
+                    const auto *prev = (0 < k)              ? m.row(k - 1, r) : nullptr;
+                    const auto *next = ((k + 1) < m.slices) ? m.row(k + 1, r) : nullptr;
+                    auto *s = out.row(k, r);
+
+                    for(long int w = 0; w < W; ++w){
+                        const auto M = cur[w];
+                        if(M == 0) continue;
+
+                        // Bit c of each neighbour word holds the state of the neighbour of column c. Voxels beyond
+                        // the grid, including padding bits, are background.
+                        const uint64_t L = (M << 1) | ((0 < w) ? (cur[w - 1] >> 63) : 0);
+                        const uint64_t R = (M >> 1) | (((w + 1) < W) ? (cur[w + 1] << 63) : 0);
+                        const uint64_t U = (up   != nullptr) ? up[w]   : 0;
+                        const uint64_t D = (down != nullptr) ? down[w] : 0;
+                        const uint64_t P = (prev != nullptr) ? prev[w] : 0;
+                        const uint64_t N = (next != nullptr) ? next[w] : 0;
+                        s[w] = M & ~(L & R & U & D & P & N);
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    return out;
+}
+
+
+double overlap_stats::Dice_Coefficient(void) const {
+    if( (this->A_voxels == 0) && (this->B_voxels == 0) ) return std::numeric_limits<double>::quiet_NaN();
+    return (2.0 * this->overlap_voxels) / ( (1.0 * this->A_voxels) + (1.0 * this->B_voxels) );
+}
+
+double overlap_stats::Jaccard_Coefficient(void) const {
+    if( (this->A_voxels == 0) && (this->B_voxels == 0) ) return std::numeric_limits<double>::quiet_NaN();
+    return (1.0 * this->overlap_voxels) / ( (1.0 * this->A_voxels) + (1.0 * this->B_voxels) - (1.0 * this->overlap_voxels) );
+}
+
+static void check_compatible(const packed_mask &A, const packed_mask &B){
+    if( (A.rows != B.rows) || (A.columns != B.columns) || (A.slices != B.slices) ){
+        throw std::invalid_argument("Masks do not share a grid. Cannot compare them.");
+    }
+}
+
+overlap_stats
+Compute_Overlap(const packed_mask &A, const packed_mask &B){
+    check_compatible(A, B);
+
+    overlap_stats out;
+    const auto N = A.words.size();
+    for(size_t i = 0; i < N; ++i){
+        const auto a = A.words[i];
+        const auto b = B.words[i];
+        out.A_voxels += std::bitset<64>(a).count();
+        out.B_voxels += std::bitset<64>(b).count();
+        out.overlap_voxels += std::bitset<64>(a & b).count();
+    }
+    return out;
+}
+
+
+// Inclusive index bounds, ordered column, row, slice.
+struct index_box {
+    std::array<long int,3> lo = {{ std::numeric_limits<long int>::max(),
+                                   std::numeric_limits<long int>::max(),
+                                   std::numeric_limits<long int>::max() }};
+    std::array<long int,3> hi = {{ -1L, -1L, -1L }};
+
+    bool empty(void) const { return (this->hi[0] < this->lo[0]); }
+};
+
+static long int lowest_bit(uint64_t w){
+    long int i = 0;
+    while(((w >> i) & 1U) == 0) ++i;
+    return i;
+}
+
+static long int highest_bit(uint64_t w){
+    long int i = 63;
+    while(((w >> i) & 1U) == 0) --i;
+    return i;
+}
+
+static void expand_box(const packed_mask &m, index_box &box){
+    for(long int k = 0; k < m.slices; ++k){
+        for(long int r = 0; r < m.rows; ++r){
+            const auto *row = m.row(k, r);
+            long int w_lo = 0;
+            while( (w_lo < m.words_per_row) && (row[w_lo] == 0) ) ++w_lo;
+            if(w_lo == m.words_per_row) continue;
+            long int w_hi = m.words_per_row - 1;
+            while(row[w_hi] == 0) --w_hi;
+
+            box.lo[0] = std::min(box.lo[0], w_lo * 64 + lowest_bit(row[w_lo]));
+            box.hi[0] = std::max(box.hi[0], w_hi * 64 + highest_bit(row[w_hi]));
+            box.lo[1] = std::min(box.lo[1], r);
+            box.hi[1] = std::max(box.hi[1], r);
+            box.lo[2] = std::min(box.lo[2], k);
+            box.hi[2] = std::max(box.hi[2], k);
+        }
+    }
+}
+
+// Computes the distances from each voxel of 'from' to the nearest voxel of 'to', within the box.
+static std::vector<double> directed_distances(const packed_mask &from,
+                                              const packed_mask &to,
+                                              const index_box &box,
+                                              const std::array<double,3> &spacing){
+    connected_components::mask_volume mv;
+    mv.columns = box.hi[0] - box.lo[0] + 1;
+    mv.rows    = box.hi[1] - box.lo[1] + 1;
+    mv.slices  = box.hi[2] - box.lo[2] + 1;
+    mv.mask.assign( static_cast<size_t>(mv.columns) * static_cast<size_t>(mv.rows) * static_cast<size_t>(mv.slices), 0 );
+    const auto index = [&](long int c, long int r, long int k) -> size_t {
+        return ( static_cast<size_t>(k - box.lo[2]) * static_cast<size_t>(mv.rows)
+               + static_cast<size_t>(r - box.lo[1]) ) * static_cast<size_t>(mv.columns)
+               + static_cast<size_t>(c - box.lo[0]);
+    };
+    for(long int k = box.lo[2]; k <= box.hi[2]; ++k){
+        for(long int r = box.lo[1]; r <= box.hi[1]; ++r){
+            for(long int c = box.lo[0]; c <= box.hi[0]; ++c){
+                if(to.get(k, r, c)) mv.mask[index(c, r, k)] = 1;
+            }
+        }
+    }
+
+    // With unit extents the transform yields squared physical distances.
+    const distance_transform::axis_extent unit{ 1.0, 1.0 };
+    const auto sq_dist = distance_transform::Anisotropic_Distance_Transform(mv, spacing, {{ unit, unit, unit }});
+
+    std::vector<double> out;
+    for(long int k = box.lo[2]; k <= box.hi[2]; ++k){
+        for(long int r = box.lo[1]; r <= box.hi[1]; ++r){
+            for(long int c = box.lo[0]; c <= box.hi[0]; ++c){
+                if(from.get(k, r, c)) out.push_back( std::sqrt(static_cast<double>(sq_dist[index(c, r, k)])) );
+            }
+        }
+    }
+    return out;
+}
+
+static double percentile_95(std::vector<double> &v){
+    const auto n = static_cast<size_t>(std::ceil(0.95 * static_cast<double>(v.size())));
+    const auto it = std::next(std::begin(v), std::max<size_t>(n, 1) - 1);
+    std::nth_element(std::begin(v), it, std::end(v));
+    return *it;
+}
+
+surface_distance_stats
+Compute_Surface_Distances(const grid_resampling::rectilinear_grid &grid,
+                          const packed_mask &A_surface,
+                          const packed_mask &B_surface){
+    check_compatible(A_surface, B_surface);
+
+    surface_distance_stats out;
+    index_box box_A;
+    index_box box_B;
+    expand_box(A_surface, box_A);
+    expand_box(B_surface, box_B);
+    if(box_A.empty() || box_B.empty()) return out;
+
+    index_box box;
+    for(size_t i = 0; i < 3; ++i){
+        box.lo[i] = std::min(box_A.lo[i], box_B.lo[i]);
+        box.hi[i] = std::max(box_A.hi[i], box_B.hi[i]);
+    }
+
+    const auto N_slices = grid.slices();
+    const auto dz = (N_slices <= 1) ? grid.pxl_dz
+                                    : grid.slice_offsets.back() / static_cast<double>(N_slices - 1);
+    const std::array<double,3> spacing = {{ grid.pxl_dy, grid.pxl_dx, dz }};
+
+    auto d_AB = directed_distances(A_surface, B_surface, box, spacing);
+    auto d_BA = directed_distances(B_surface, A_surface, box, spacing);
+
+    double sum = 0.0;
+    for(const auto &d : d_AB) sum += d;
+    for(const auto &d : d_BA) sum += d;
+    out.mean = sum / static_cast<double>(d_AB.size() + d_BA.size());
+
+    out.hausdorff = std::max( *std::max_element(std::begin(d_AB), std::end(d_AB)),
+                              *std::max_element(std::begin(d_BA), std::end(d_BA)) );
+    out.hausdorff_95 = std::max( percentile_95(d_AB), percentile_95(d_BA) );
+    return out;
+}
+
+} // namespace roi_similarity
+
@@ -0,0 +1,89 @@
+//ROI_Similarity.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Grid_Resampling.h"
+
+
+// This module compares ROIs volumetrically on a shared rectilinear image grid.
+//
+// Each ROI is rasterized once into a packed binary mask with one bit per voxel, after which overlap between any pair of
+// ROIs is computed with bitwise operations and population counts. Surface distances are computed from exact Euclidean
+// distance transforms of the ROI surfaces, restricted to the bounding box of the pair being compared. Rasterization and
+// distance transforms are performed concurrently.
+namespace roi_similarity {
+
+// A binary mask with one bit per voxel. Bits are stored slice-major, then row-major, and each row is padded to a whole
+// number of 64-bit words. Padding bits are always zero.
+struct packed_mask {
+    long int rows = 0;
+    long int columns = 0;
+    long int slices = 0;
+    long int words_per_row = 0;
+    std::vector<uint64_t> words;
+
+    packed_mask() = default;
+    packed_mask(long int rows, long int columns, long int slices);
+
+    const uint64_t *row(long int slice, long int row) const;
+    uint64_t *row(long int slice, long int row);
+
+    bool get(long int slice, long int row, long int column) const;
+
+    // The number of foreground voxels.
+    uint64_t count(void) const;
+};
+
+// Rasterizes the contours onto the grid. A voxel is foreground if its centre lies within any contour on its image.
+// Contours are assigned to the image whose plane is nearest their centre, provided they lie within half the image's
+// thickness. Contours with self-intersections or holes are filled with the even-odd rule.
+packed_mask
+Rasterize_ROI(const grid_resampling::rectilinear_grid &grid,
+              const std::list<std::reference_wrapper<contour_collection<double>>> &ccs);
+
+// Returns a mask of the foreground voxels that are face-adjacent to a background voxel or to the edge of the grid.
+packed_mask
+Surface_Voxels(const packed_mask &m);
+
+
+struct overlap_stats {
+    uint64_t A_voxels = 0;
+    uint64_t B_voxels = 0;
+    uint64_t overlap_voxels = 0;
+
+    // Both coefficients are NaN when neither ROI contains any voxels.
+    double Dice_Coefficient(void) const;
+    double Jaccard_Coefficient(void) const;
+};
+
+overlap_stats
+Compute_Overlap(const packed_mask &A, const packed_mask &B);
+
+
+// Symmetric surface distances in DICOM units. The mean is taken over the distances from every surface voxel of each
+// ROI to the nearest surface voxel of the other. The 95th percentile and maximum (Hausdorff) distances are the larger
+// of the two directed values. All are NaN when either ROI is empty.
+struct surface_distance_stats {
+    double mean = std::numeric_limits<double>::quiet_NaN();
+    double hausdorff_95 = std::numeric_limits<double>::quiet_NaN();
+    double hausdorff = std::numeric_limits<double>::quiet_NaN();
+};
+
+// Compares two surface masks, e.g., as produced by Surface_Voxels(). Surface masks can be computed once per ROI and
+// reused for every pair. If the grid's slices are not uniformly spaced, the mean slice spacing is used.
+surface_distance_stats
+Compute_Surface_Distances(const grid_resampling::rectilinear_grid &grid,
+                          const packed_mask &A_surface,
+                          const packed_mask &B_surface);
+
+} // namespace roi_similarity
+
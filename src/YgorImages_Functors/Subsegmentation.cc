@@ -0,0 +1,242 @@
+//Subsegmentation.cc.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <list>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Grid_Resampling.h"
+#include "ROI_Similarity.h"
+#include "Subsegmentation.h"
+#include "YgorMath.h"
+#include "YgorMisc.h"
+
+
+namespace subsegmentation {
+
+bool slab::encompasses(const vec3<double> &p) const {
+    return this->lower.Is_Point_Above_Plane(p) && !this->upper.Is_Point_Above_Plane(p);
+}
+
+// Locates the planes for a batch of cleaves, each applied to its own contour collection. Every plane is located in a
+// separate task.
+static std::vector<slab>
+find_slabs(const std::vector<const contour_collection<double> *> &ccs,
+           const std::vector<cleave> &cleaves,
+           const bisection_opts &opts){
+
+    if(ccs.size() != cleaves.size()){
+        throw std::logic_error("Each cleave requires a contour collection.");
+    }
+    for(const auto &cc_ptr : ccs){
+        if(cc_ptr->contours.empty()) throw std::logic_error("Unable to split empty contour collection.");
+    }
+
+    const auto N = cleaves.size();
+    std::vector<plane<double>> planes(2 * N);
+    std::vector<size_t> iters(2 * N, 0);
+    std::vector<double> fracs(2 * N, 0.0);
+    std::vector<std::exception_ptr> errors(2 * N);
+    {
+        asio_thread_pool tp;
+        for(size_t i = 0; i < (2 * N); ++i){
+            tp.submit_task([&,i](void) -> void {
+                try{
+                    const auto &c = cleaves[i / 2];
+                    const auto frac = ((i % 2) == 0) ? c.lower : c.upper;
+                    ccs[i / 2]->Total_Area_Bisection_Along_Plane(c.normal,
+                                                                 frac,
+                                                                 opts.tolerance,
+                                                                 opts.max_iters,
+                                                                 &planes[i],
+                                                                 &iters[i],
+                                                                 &fracs[i]);
+                }catch(const std::exception &){
+                    errors[i] = std::current_exception();
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    for(const auto &e : errors){
+        if(e) std::rethrow_exception(e);
+    }
+
+    std::vector<slab> out;
+    out.reserve(N);
+    for(size_t j = 0; j < N; ++j){
+        for(size_t i = 2 * j; i < (2 * j + 2); ++i){
+            FUNCINFO("Bisection: planar area fraction"
+                     << " above " << (((i % 2) == 0) ? "LOWER" : "UPPER") << " plane with normal: " << cleaves[j].normal
+                     << " was " << fracs[i] << "."
+                     << " Requested: " << (((i % 2) == 0) ? cleaves[j].lower : cleaves[j].upper) << "."
+                     << " Iters: " << iters[i]);
+        }
+        out.push_back( slab{ planes[2 * j], planes[2 * j + 1] } );
+    }
+    return out;
+}
+
+slab
+Find_Slab(const contour_collection<double> &cc, const cleave &c, const bisection_opts &opts){
+    return find_slabs({ &cc }, { c }, opts).front();
+}
+
+// Splits a single contour along a plane, keeping only the pieces on the requested side.
+static void
+clip_along_plane(std::list<contour_of_points<double>> &pieces, const plane<double> &p, bool keep_above){
+    std::list<contour_of_points<double>> out;
+    for(const auto &c : pieces){
+        auto split = c.Split_Along_Plane(p);
+        for(auto it = std::begin(split); it != std::end(split); ){
+            const auto rough_center = it->First_N_Point_Avg(3); //Just need a point above or below.
+            if(p.Is_Point_Above_Plane(rough_center) == keep_above){
+                it->metadata = c.metadata;
+                out.splice(std::end(out), split, it++);
+            }else{
+                ++it;
+            }
+        }
+    }
+    pieces.swap(out);
+    return;
+}
+
+contour_collection<double>
+Clip_To_Slabs(const contour_collection<double> &cc, const std::vector<slab> &slabs){
+    std::vector<const contour_of_points<double> *> contours;
+    for(const auto &c : cc.contours) contours.push_back( &c );
+    const auto N_contours = contours.size();
+
+    std::vector<std::list<contour_of_points<double>>> clipped(N_contours);
+    const auto N_tasks = std::min<size_t>(std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4, N_contours);
+    std::vector<std::exception_ptr> errors(N_tasks);
+    {
+        asio_thread_pool tp;
+        for(size_t n = 0; n < N_tasks; ++n){
+            tp.submit_task([&,n](void) -> void {
+                try{
+                    for(size_t i = n; i < N_contours; i += N_tasks){
+                        auto &pieces = clipped[i];
+                        if(contours[i]->points.empty()) continue;
+                        pieces.push_back( *(contours[i]) );
+                        for(const auto &s : slabs){
+                            if(pieces.empty()) break;
+                            clip_along_plane(pieces, s.lower, true);
+                            clip_along_plane(pieces, s.upper, false);
+                        }
+                    }
+                }catch(const std::exception &){
+                    errors[n] = std::current_exception();
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+    for(const auto &e : errors){
+        if(e) std::rethrow_exception(e);
+    }
+
+    contour_collection<double> out;
+    for(auto &pieces : clipped) out.contours.splice(std::end(out.contours), pieces);
+    return out;
+}
+
+subsegment
+Subsegment_ROI(const contour_collection<double> &cc,
+               const std::vector<cleave> &cleaves,
+               method m,
+               const bisection_opts &opts){
+    subsegment out;
+
+    if(m == method::Compound){
+        // All planes are located using the original ROI, so every bisection can proceed at once, after which each
+        // contour is clipped only once.
+        std::vector<const contour_collection<double> *> ccs(cleaves.size(), &cc);
+        out.slabs = find_slabs(ccs, cleaves, opts);
+        out.contours = Clip_To_Slabs(cc, out.slabs);
+
+    }else if(m == method::Nested){
+        // Each cleave depends on the portion retained by the preceding cleaves, so the clipping must be interleaved.
+        const contour_collection<double> *running = &cc;
+        for(const auto &c : cleaves){
+            out.slabs.push_back( Find_Slab(*running, c, opts) );
+            out.contours = Clip_To_Slabs(*running, { out.slabs.back() });
+            running = &out.contours;
+        }
+        if(cleaves.empty()) out.contours = cc;
+
+    }else{
+        throw std::invalid_argument("Sub-segmentation method not understood.");
+    }
+
+    if(out.contours.contours.empty()){
+        FUNCWARN("Selection contains no contours. Try adjusting your criteria.");
+    }
+    return out;
+}
+
+std::vector<std::vector<double>>
+Gather_Voxel_Values(const grid_resampling::rectilinear_grid &grid,
+                    const roi_similarity::packed_mask &mask,
+                    const std::vector<std::vector<slab>> &subsegments,
+                    long int channel){
+
+    const auto N_slices = grid.slices();
+    if( (mask.rows != grid.rows)
+    ||  (mask.columns != grid.columns)
+    ||  (mask.slices != N_slices) ){
+        throw std::invalid_argument("Mask does not match the grid.");
+    }
+    if( (channel < 0) || (grid.channels <= channel) ){
+        throw std::invalid_argument("Requested channel is not present.");
+    }
+
+    const auto N_subsegs = subsegments.size();
+    std::vector<std::vector<std::vector<double>>> per_slice(N_slices, std::vector<std::vector<double>>(N_subsegs));
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < N_slices; ++k){
+            tp.submit_task([&,k](void) -> void {
+                const auto &img = *(grid.imgs[k]);
+                const auto slice_pos = grid.origin + grid.img_unit * grid.slice_offsets[k];
+                for(long int r = 0; r < grid.rows; ++r){
+                    const auto *row = mask.row(k, r);
+                    for(long int w = 0; w < mask.words_per_row; ++w){
+                        for(uint64_t bits = row[w]; bits != 0; bits &= (bits - 1)){
+                            // Visit only the foreground voxels by repeatedly clearing the lowest set bit.
+                            long int b = 0;
+                            while(((bits >> b) & 1) == 0) ++b;
+                            const auto c = w * 64 + b;
+
+                            const auto p = slice_pos + grid.row_unit * (grid.pxl_dx * static_cast<double>(r))
+                                                     + grid.col_unit * (grid.pxl_dy * static_cast<double>(c));
+                            const auto v = static_cast<double>(img.value(r, c, channel));
+                            for(size_t s = 0; s < N_subsegs; ++s){
+                                const auto &slabs = subsegments[s];
+                                const bool within = std::all_of(std::begin(slabs), std::end(slabs),
+                                                                [&](const slab &l){ return l.encompasses(p); });
+                                if(within) per_slice[k][s].push_back(v);
+                            }
+                        }
+                    }
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    std::vector<std::vector<double>> out(N_subsegs);
+    for(size_t s = 0; s < N_subsegs; ++s){
+        for(auto &vals : per_slice){
+            out[s].insert(std::end(out[s]), std::begin(vals[s]), std::end(vals[s]));
+        }
+    }
+    return out;
+}
+
+} // namespace subsegmentation
+
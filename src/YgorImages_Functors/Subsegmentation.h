@@ -0,0 +1,83 @@
+//Subsegmentation.h.
+
+#pragma once
+
+#include <vector>
+
+#include "YgorMath.h"
+
+#include "Grid_Resampling.h"
+#include "ROI_Similarity.h"
+
+
+// This module sub-segments ROIs by cleaving them with pairs of parallel planes.
+//
+// Each cleave selects a contiguous portion of an ROI in terms of the fractional planar area remaining above two planes
+// with a common normal. The bisections that locate the planes are performed concurrently, and contours are clipped
+// independently of one another in parallel, so no intermediate contour collections are produced. Because a sub-segment
+// is the intersection of the ROI with the slabs between each pair of planes, voxel membership can be tested directly
+// against the planes. A mask of the whole ROI therefore only needs to be rasterized once, and can be shared by any
+// number of its sub-segments.
+namespace subsegmentation {
+
+// A single cleave. The selection is given as the fractional planar area above each plane, so the lower fraction
+// should be greater than the upper fraction.
+struct cleave {
+    vec3<double> normal = vec3<double>(0.0, 0.0, 1.0);
+    double lower = 1.0;
+    double upper = 0.0;
+};
+
+enum class method {
+    Nested,    // The planes of each cleave are located using only the portion retained by the preceding cleaves.
+    Compound,  // The planes of every cleave are located using the original ROI.
+};
+
+// Stopping criteria for the planar area bisection.
+struct bisection_opts {
+    double tolerance = 0.001;
+    long int max_iters = 20;
+};
+
+// The region between two parallel planes. The retained portion lies above the lower plane and below the upper plane.
+struct slab {
+    plane<double> lower;
+    plane<double> upper;
+
+    bool encompasses(const vec3<double> &p) const;
+};
+
+// A sub-segment is the portion of an ROI within every slab.
+struct subsegment {
+    std::vector<slab> slabs;
+    contour_collection<double> contours;
+};
+
+// Locates the pair of planes for a single cleave. Both planes are located concurrently.
+slab
+Find_Slab(const contour_collection<double> &cc, const cleave &c, const bisection_opts &opts);
+
+// Retains only the portions of contours that lie within every slab. Contours are clipped concurrently and retain the
+// metadata of their parent contour.
+contour_collection<double>
+Clip_To_Slabs(const contour_collection<double> &cc, const std::vector<slab> &slabs);
+
+// Applies the cleaves, in order, to an ROI. Throws if a cleave is applied to an empty selection.
+subsegment
+Subsegment_ROI(const contour_collection<double> &cc,
+               const std::vector<cleave> &cleaves,
+               method m,
+               const bisection_opts &opts);
+
+// Gathers the voxel values within each sub-segment of a single ROI. The mask must be the whole ROI rasterized onto the
+// grid, e.g., by roi_similarity::Rasterize_ROI(). Sub-segment membership is then decided using only the slabs, so the
+// mask is shared by all sub-segments and sub-segment contours need not be rasterized. Slices are visited concurrently.
+// Values are ordered slice-major, then row-major.
+std::vector<std::vector<double>>
+Gather_Voxel_Values(const grid_resampling::rectilinear_grid &grid,
+                    const roi_similarity::packed_mask &mask,
+                    const std::vector<std::vector<slab>> &subsegments,
+                    long int channel = 0);
+
+} // namespace subsegmentation
+
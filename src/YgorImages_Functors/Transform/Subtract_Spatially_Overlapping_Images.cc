@@ -5,6 +5,7 @@
 #include <list>
 
 #include "../ConvenienceRoutines.h"
+#include "../Pixel_Kernels.h"
 #include "YgorImages.h"
 #include "YgorMath.h"
 
@@ -41,18 +42,14 @@ bool SubtractSpatiallyOverlappingImages(planar_image_collection<float,double>::i
             &&  (local_img_it->position(N_rows-1,0) == overlapping_img->position(N_rows-1,0)) 
             &&  (local_img_it->position(0,N_cols-1) == overlapping_img->position(0,N_cols-1)) ){
 
-                // TODO: just subtract the entire vectors instead of iterating over each?
-                for(auto row = 0; row < local_img_it->rows; ++row){
-                    for(auto col = 0; col < local_img_it->columns; ++col){
-                        for(auto chan = 0; chan < local_img_it->channels; ++chan){
-                            const auto Lval = local_img_it->value(row, col, chan);
-                            const auto Rval = overlapping_img->value(row, col, chan);
-                            const auto newval = (Lval - Rval);
-     
-                            local_img_it->reference(row, col, chan) = newval;
-                            minmax_pixel.Digest(newval);
-                        }
-                    }
+                // Since the layouts match, the pixel buffers can be subtracted directly.
+                const auto buf = pixel_kernels::Pixel_Buffer(*local_img_it);
+                pixel_kernels::Subtract(buf, overlapping_img->data.data());
+
+                const auto mm = pixel_kernels::Min_Max(buf);
+                if(mm.valid()){
+                    minmax_pixel.Digest(mm.min);
+                    minmax_pixel.Digest(mm.max);
                 }
 
             // For images that need to be interpolated because they don't exactly overlap.
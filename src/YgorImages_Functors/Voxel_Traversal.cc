@@ -0,0 +1,74 @@
+//Voxel_Traversal.cc.
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "../Thread_Pool.h"
+#include "Grid_Resampling.h"
+#include "Voxel_Traversal.h"
+#include "YgorImages.h"
+#include "YgorMath.h"
+
+
+namespace voxel_traversal {
+
+indexed_volume
+Make_Indexed_Volume(const grid_resampling::rectilinear_grid &grid,
+                    long int channel,
+                    const std::function<float(float)> &transform){
+    if( (channel < 0) || (grid.channels <= channel) ){
+        throw std::invalid_argument("Requested channel is not present in the volume.");
+    }
+
+    indexed_volume vol;
+    vol.origin = grid.origin;
+    vol.row_unit = grid.row_unit;
+    vol.col_unit = grid.col_unit;
+    vol.img_unit = grid.img_unit;
+    vol.rows = grid.rows;
+    vol.columns = grid.columns;
+    vol.slices = grid.slices();
+    vol.imgs = grid.imgs;
+    if(vol.slices <= 0) return vol;
+
+    // In-plane voxel boundaries are evenly spaced around the voxel centres.
+    for(long int i = 0; i <= vol.rows; ++i){
+        vol.bounds[0].push_back( (static_cast<double>(i) - 0.5) * grid.pxl_dx );
+    }
+    for(long int i = 0; i <= vol.columns; ++i){
+        vol.bounds[1].push_back( (static_cast<double>(i) - 0.5) * grid.pxl_dy );
+    }
+
+    // Slices are bounded midway between adjacent slices. The outermost slices extend by half their thickness.
+    const auto &o = grid.slice_offsets;
+    vol.bounds[2].push_back( o.front() - 0.5 * grid.imgs.front()->pxl_dz );
+    for(long int k = 1; k < vol.slices; ++k){
+        vol.bounds[2].push_back( 0.5 * (o[k-1] + o[k]) );
+    }
+    vol.bounds[2].push_back( o.back() + 0.5 * grid.imgs.back()->pxl_dz );
+
+    // Copy (and optionally transform) voxel values, one task per slice.
+    const auto N_per_slice = static_cast<std::size_t>(vol.rows) * static_cast<std::size_t>(vol.columns);
+    vol.values.resize(N_per_slice * static_cast<std::size_t>(vol.slices));
+    {
+        asio_thread_pool tp;
+        for(long int k = 0; k < vol.slices; ++k){
+            tp.submit_task([&,k](void) -> void {
+                const auto *img = vol.imgs[k];
+                const auto N_chns = static_cast<std::size_t>(img->channels);
+                float *out = vol.values.data() + N_per_slice * static_cast<std::size_t>(k);
+                for(std::size_t i = 0; i < N_per_slice; ++i){
+                    const auto val = img->data[i * N_chns + static_cast<std::size_t>(channel)];
+                    out[i] = transform ? transform(val) : val;
+                }
+            }); // thread pool task closure.
+        }
+    } // Wait for all tasks to complete.
+
+    return vol;
+}
+
+} // namespace voxel_traversal
+